@@ -0,0 +1,377 @@
+#include "gles30_clustered_lights.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "gles30_shader.hxx"
+#include "opengles30.hxx"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OM_CLUSTER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define OM_CLUSTER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace gles30
+{
+static constexpr std::uint32_t cluster_count =
+    clustered_lights::count_x * clustered_lights::count_y *
+    clustered_lights::count_z;
+static_assert(clustered_lights::count_x % 4 == 0,
+              "clusters are tested 4 at once inside one row");
+static_assert(cluster_count <= 0xFFFF && clustered_lights::max_lights <= 0xFFFF,
+              "cluster and light numbers are stored in 16 bits");
+
+static std::uint32_t create_data_texture(GLint   internal_format,
+                                         GLsizei width,
+                                         GLsizei height,
+                                         GLenum  format,
+                                         GLenum  type)
+{
+    std::uint32_t id = 0;
+    glGenTextures(1, &id);
+    gl_check();
+    glBindTexture(GL_TEXTURE_2D, id);
+    gl_check();
+    // integer and float32 textures can't be filtered, read with texelFetch
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 internal_format,
+                 width,
+                 height,
+                 0,
+                 format,
+                 type,
+                 nullptr);
+    gl_check();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return id;
+}
+
+/// sphere against 4 cluster AABBs starting at first, bit per touched cluster
+static unsigned sphere_mask4(const float*     min_x,
+                             const float*     min_y,
+                             const float*     min_z,
+                             const float*     max_x,
+                             const float*     max_y,
+                             const float*     max_z,
+                             const glm::vec3& center,
+                             float            radius)
+{
+#if defined(OM_CLUSTER_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    // distance from center to box along axis, 0 inside
+    auto axis = [zero](const float* lo, const float* hi, float c)
+    {
+        const __m128 p = _mm_set1_ps(c);
+        const __m128 d = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(lo), p),
+                                    _mm_sub_ps(p, _mm_loadu_ps(hi)));
+        const __m128 clamped = _mm_max_ps(d, zero);
+        return _mm_mul_ps(clamped, clamped);
+    };
+    const __m128 distance2 =
+        _mm_add_ps(_mm_add_ps(axis(min_x, max_x, center.x),
+                              axis(min_y, max_y, center.y)),
+                   axis(min_z, max_z, center.z));
+    return static_cast<unsigned>(_mm_movemask_ps(
+        _mm_cmple_ps(distance2, _mm_set1_ps(radius * radius))));
+#elif defined(OM_CLUSTER_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    auto axis = [zero](const float* lo, const float* hi, float c)
+    {
+        const float32x4_t p = vdupq_n_f32(c);
+        const float32x4_t d =
+            vmaxq_f32(vsubq_f32(vld1q_f32(lo), p), vsubq_f32(p, vld1q_f32(hi)));
+        const float32x4_t clamped = vmaxq_f32(d, zero);
+        return vmulq_f32(clamped, clamped);
+    };
+    const float32x4_t distance2 =
+        vaddq_f32(vaddq_f32(axis(min_x, max_x, center.x),
+                            axis(min_y, max_y, center.y)),
+                  axis(min_z, max_z, center.z));
+    const uint32x4_t bits = { 1, 2, 4, 8 };
+    const uint32x4_t inside =
+        vcleq_f32(distance2, vdupq_n_f32(radius * radius));
+    return vaddvq_u32(vandq_u32(inside, bits));
+#else
+    unsigned mask = 0;
+    for (unsigned lane = 0; lane < 4; ++lane)
+    {
+        const glm::vec3 lo(min_x[lane], min_y[lane], min_z[lane]);
+        const glm::vec3 hi(max_x[lane], max_y[lane], max_z[lane]);
+        const glm::vec3 d = glm::max(glm::max(lo - center, center - hi), 0.f);
+        if (glm::dot(d, d) <= radius * radius)
+        {
+            mask |= 1u << lane;
+        }
+    }
+    return mask;
+#endif
+}
+
+clustered_lights::clustered_lights()
+    : min_x(cluster_count)
+    , min_y(cluster_count)
+    , min_z(cluster_count)
+    , max_x(cluster_count)
+    , max_y(cluster_count)
+    , max_z(cluster_count)
+    , grid(cluster_count * 2)
+    , cursor(cluster_count)
+{
+    light_texture = create_data_texture(
+        GL_RGBA32F, 4, static_cast<GLsizei>(max_lights), GL_RGBA, GL_FLOAT);
+    grid_texture  = create_data_texture(GL_RG32UI,
+                                       static_cast<GLsizei>(count_x * count_y),
+                                       static_cast<GLsizei>(count_z),
+                                       GL_RG_INTEGER,
+                                       GL_UNSIGNED_INT);
+    index_texture =
+        create_data_texture(GL_R16UI,
+                            static_cast<GLsizei>(index_row),
+                            static_cast<GLsizei>(max_indexes / index_row),
+                            GL_RED_INTEGER,
+                            GL_UNSIGNED_SHORT);
+}
+
+clustered_lights::~clustered_lights()
+{
+    const std::uint32_t textures[] = { light_texture,
+                                       grid_texture,
+                                       index_texture };
+    glDeleteTextures(3, textures);
+}
+
+void clustered_lights::set_projection(float fovy_radians,
+                                      float aspect_,
+                                      float z_near_,
+                                      float z_far_)
+{
+    if (fovy == fovy_radians && aspect == aspect_ && z_near == z_near_ &&
+        z_far == z_far_)
+    {
+        return;
+    }
+    fovy   = fovy_radians;
+    aspect = aspect_;
+    z_near = z_near_;
+    z_far  = z_far_;
+
+    const float log_range = std::log(z_far / z_near);
+    z_scale = static_cast<float>(count_z) / log_range;
+    z_bias  = static_cast<float>(count_z) * std::log(z_near) / log_range;
+
+    build_cluster_bounds();
+}
+
+void clustered_lights::build_cluster_bounds()
+{
+    const float tan_y = std::tan(fovy * 0.5f);
+    const float tan_x = tan_y * aspect;
+    const float range = z_far / z_near;
+
+    std::uint32_t index = 0;
+    for (std::uint32_t z = 0; z < count_z; ++z)
+    {
+        const float near_depth =
+            z_near * std::pow(range, static_cast<float>(z) / count_z);
+        const float far_depth =
+            z_near * std::pow(range, static_cast<float>(z + 1) / count_z);
+        for (std::uint32_t y = 0; y < count_y; ++y)
+        {
+            const float y0 = -1.f + 2.f * static_cast<float>(y) / count_y;
+            const float y1 = -1.f + 2.f * static_cast<float>(y + 1) / count_y;
+            for (std::uint32_t x = 0; x < count_x; ++x, ++index)
+            {
+                const float x0 = -1.f + 2.f * static_cast<float>(x) / count_x;
+                const float x1 =
+                    -1.f + 2.f * static_cast<float>(x + 1) / count_x;
+                // tile side planes go through eye, box of both depth ends
+                min_x[index] =
+                    std::min(x0 * near_depth, x0 * far_depth) * tan_x;
+                max_x[index] =
+                    std::max(x1 * near_depth, x1 * far_depth) * tan_x;
+                min_y[index] =
+                    std::min(y0 * near_depth, y0 * far_depth) * tan_y;
+                max_y[index] =
+                    std::max(y1 * near_depth, y1 * far_depth) * tan_y;
+                // camera looks to -z
+                min_z[index] = -far_depth;
+                max_z[index] = -near_depth;
+            }
+        }
+    }
+}
+
+std::uint32_t clustered_lights::slice_of(float depth) const
+{
+    const float slice = std::log(depth) * z_scale - z_bias;
+    return static_cast<std::uint32_t>(
+        std::clamp(slice, 0.f, static_cast<float>(count_z - 1)));
+}
+
+void clustered_lights::update(std::span<const point_light> lights,
+                              const glm::mat4&             view) noexcept(false)
+{
+    if (lights.size() > max_lights)
+    {
+        throw std::runtime_error("error: clustered_lights supports " +
+                                 std::to_string(max_lights) + " lights, got " +
+                                 std::to_string(lights.size()));
+    }
+    stat = {};
+    pairs.clear();
+    light_data.resize(lights.size() * 4);
+
+    constexpr std::uint32_t slice_size = count_x * count_y;
+    for (std::size_t i = 0; i < lights.size(); ++i)
+    {
+        const point_light& light = lights[i];
+        light_data[i * 4 + 0]    = glm::vec4(light.position, light.radius);
+        light_data[i * 4 + 1]    = glm::vec4(light.ambient, light.constant);
+        light_data[i * 4 + 2]    = glm::vec4(light.diffuse, light.linear);
+        light_data[i * 4 + 3]    = glm::vec4(light.specular, light.quadratic);
+
+        const glm::vec3 center(view * glm::vec4(light.position, 1.f));
+        const float     depth = -center.z;
+        if (depth + light.radius < z_near || depth - light.radius > z_far)
+        {
+            continue;
+        }
+        ++stat.lights;
+
+        const std::uint32_t first =
+            slice_of(std::max(depth - light.radius, z_near));
+        const std::uint32_t last =
+            slice_of(std::min(depth + light.radius, z_far));
+        for (std::uint32_t c = first * slice_size; c < (last + 1) * slice_size;
+             c += 4)
+        {
+            unsigned mask = sphere_mask4(&min_x[c],
+                                         &min_y[c],
+                                         &min_z[c],
+                                         &max_x[c],
+                                         &max_y[c],
+                                         &max_z[c],
+                                         center,
+                                         light.radius);
+            while (mask != 0)
+            {
+                const auto lane = static_cast<std::uint32_t>(
+                    std::countr_zero(mask));
+                mask &= mask - 1;
+                pairs.push_back({ static_cast<std::uint16_t>(c + lane),
+                                  static_cast<std::uint16_t>(i) });
+            }
+        }
+    }
+
+    // counting sort of pairs by cluster, lists keep light order
+    std::fill(cursor.begin(), cursor.end(), 0u);
+    for (const light_in_cluster& p : pairs)
+    {
+        ++cursor[p.cluster];
+    }
+    std::uint32_t offset = 0;
+    for (std::uint32_t c = 0; c < cluster_count; ++c)
+    {
+        const std::uint32_t count = std::min(cursor[c], max_indexes - offset);
+        grid[c * 2 + 0]           = offset;
+        grid[c * 2 + 1]           = count;
+        cursor[c]                 = offset;
+        stat.max_per_cluster      = std::max(stat.max_per_cluster, count);
+        offset += count;
+    }
+    stat.indexes = offset;
+    stat.dropped = static_cast<std::uint32_t>(pairs.size()) - offset;
+
+    const std::uint32_t rows = (offset + index_row - 1) / index_row;
+    indexes.resize(rows * index_row);
+    for (const light_in_cluster& p : pairs)
+    {
+        std::uint32_t& next = cursor[p.cluster];
+        if (next < grid[p.cluster * 2] + grid[p.cluster * 2 + 1])
+        {
+            indexes[next++] = p.light;
+        }
+    }
+
+    if (!lights.empty())
+    {
+        glBindTexture(GL_TEXTURE_2D, light_texture);
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        0,
+                        0,
+                        4,
+                        static_cast<GLsizei>(lights.size()),
+                        GL_RGBA,
+                        GL_FLOAT,
+                        light_data.data());
+        gl_check();
+    }
+    glBindTexture(GL_TEXTURE_2D, grid_texture);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    0,
+                    0,
+                    static_cast<GLsizei>(count_x * count_y),
+                    static_cast<GLsizei>(count_z),
+                    GL_RG_INTEGER,
+                    GL_UNSIGNED_INT,
+                    grid.data());
+    gl_check();
+    if (rows > 0)
+    {
+        glBindTexture(GL_TEXTURE_2D, index_texture);
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        0,
+                        0,
+                        static_cast<GLsizei>(index_row),
+                        static_cast<GLsizei>(rows),
+                        GL_RED_INTEGER,
+                        GL_UNSIGNED_SHORT,
+                        indexes.data());
+        gl_check();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void clustered_lights::bind(shader&          program,
+                            std::uint32_t    first_unit,
+                            const glm::vec2& viewport_size) const
+{
+    const std::uint32_t textures[] = { light_texture,
+                                       grid_texture,
+                                       index_texture };
+    const char*         names[]    = { "light_data",
+                                       "cluster_grid",
+                                       "light_indexes" };
+    for (std::uint32_t i = 0; i < 3; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + first_unit + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        gl_check();
+        program.set_uniform(names[i],
+                            static_cast<std::int32_t>(first_unit + i));
+    }
+    program.set_uniform(
+        "cluster_scale",
+        glm::vec2(count_x, count_y) / viewport_size);
+    program.set_uniform("cluster_z_scale", z_scale);
+    program.set_uniform("cluster_z_bias", z_bias);
+    program.set_uniform("cluster_count_x", static_cast<std::int32_t>(count_x));
+    program.set_uniform("cluster_count_z", static_cast<std::int32_t>(count_z));
+}
+} // namespace gles30
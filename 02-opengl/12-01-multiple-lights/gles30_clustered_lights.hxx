@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace gles30
+{
+class shader;
+
+struct point_light
+{
+    glm::vec3 position;
+    /// light ends here, shader fades attenuation to zero at radius
+    float     radius = 10.f;
+
+    glm::vec3 ambient{ 0.f };
+    glm::vec3 diffuse{ 1.f };
+    glm::vec3 specular{ 1.f };
+
+    float constant  = 1.f;
+    float linear    = 0.09f;
+    float quadratic = 0.032f;
+};
+
+/// Clustered forward lighting. View frustum is split into count_x * count_y
+/// screen tiles and count_z depth slices (exponential, so clusters are
+/// close to cubes), every cluster gets list of point lights whose sphere
+/// touches it. Fragment shader finds its cluster from gl_FragCoord and view
+/// depth and loops only over that list, so cost per fragment depends on
+/// lights near fragment, not on total light count.
+///
+/// GLES 3.0 has no SSBO and 16KB UBO minimum, so lists are textures read
+/// with texelFetch:
+///     light_data    RGBA32F, 4 texels per light, row per light
+///     cluster_grid  RG32UI, (first index, count) per cluster
+///     light_indexes R16UI, all lists one after another
+class clustered_lights
+{
+public:
+    static constexpr std::uint32_t count_x     = 16;
+    static constexpr std::uint32_t count_y     = 9;
+    static constexpr std::uint32_t count_z     = 24;
+    static constexpr std::uint32_t max_lights  = 1024;
+    static constexpr std::uint32_t index_row   = 1024;
+    static constexpr std::uint32_t max_indexes = index_row * 64;
+
+    struct statistic
+    {
+        std::uint32_t lights;          ///< lights in view
+        std::uint32_t indexes;         ///< sum of all list sizes
+        std::uint32_t max_per_cluster; ///< longest list
+        std::uint32_t dropped;         ///< did not fit into max_indexes
+    };
+
+    clustered_lights();
+    ~clustered_lights();
+    clustered_lights(const clustered_lights&)            = delete;
+    clustered_lights& operator=(const clustered_lights&) = delete;
+
+    /// cluster bounds depend on projection only, rebuilt if values changed
+    void set_projection(float fovy_radians,
+                        float aspect,
+                        float z_near,
+                        float z_far);
+    /// assign lights to clusters in view space of camera, upload lists.
+    /// throw if lights.size() > max_lights
+    void update(std::span<const point_light> lights,
+                const glm::mat4&             view) noexcept(false);
+    /// bind textures to units first_unit, +1, +2 and set cluster uniforms
+    void bind(shader&          program,
+              std::uint32_t    first_unit,
+              const glm::vec2& viewport_size) const;
+
+    [[nodiscard]] statistic get_statistic() const { return stat; }
+
+private:
+    void          build_cluster_bounds();
+    std::uint32_t slice_of(float depth) const;
+
+    float fovy   = 0.f;
+    float aspect = 0.f;
+    float z_near = 0.f;
+    float z_far  = 0.f;
+    /// slice = log(depth) * z_scale - z_bias
+    float z_scale = 0.f;
+    float z_bias  = 0.f;
+
+    /// view space AABB of every cluster, x + y * count_x + z * count_x *
+    /// count_y, structure of arrays for SIMD test of 4 clusters at once
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+
+    struct light_in_cluster
+    {
+        std::uint16_t cluster;
+        std::uint16_t light;
+    };
+    std::vector<light_in_cluster> pairs;
+    std::vector<std::uint32_t>    grid; ///< offset, count per cluster
+    std::vector<std::uint32_t>    cursor;
+    std::vector<std::uint16_t>    indexes;
+    std::vector<glm::vec4>        light_data;
+
+    std::uint32_t light_texture = 0;
+    std::uint32_t grid_texture  = 0;
+    std::uint32_t index_texture = 0;
+
+    statistic stat{};
+};
+} // namespace gles30
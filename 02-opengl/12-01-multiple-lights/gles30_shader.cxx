@@ -258,6 +258,13 @@ void shader::set_uniform(std::string_view name, const glm::mat3& m)
     gl_check();
 }
 
+void shader::set_uniform(std::string_view name, const glm::vec2& v)
+{
+    GLint uniform_index = get_uniform_index(name, program_id);
+    glUniform2fv(uniform_index, 1, glm::value_ptr(v));
+    gl_check();
+}
+
 void shader::set_uniform(std::string_view name, const glm::vec3& v)
 {
     GLint uniform_index = get_uniform_index(name, program_id);
@@ -5,12 +5,14 @@
 #include <iostream>
 #include <memory>
 #include <numeric>
+#include <random>
 #include <ranges>
 #include <string>
 #include <type_traits>
 #include <vector>
 
 #include "fps_camera.hxx"
+#include "gles30_clustered_lights.hxx"
 #include "gles30_shader.hxx"
 #include "gles30_texture.hxx"
 #include "opengles30.hxx"
@@ -103,6 +105,53 @@ void update_vertex_attributes()
     glEnableVertexAttribArray(2);
 }
 
+/// 4 lesson lights and count small colored lights flying around random
+/// centers, center of every light in centers
+std::vector<gles30::point_light> create_point_lights(
+    size_t count, std::vector<glm::vec3>& centers)
+{
+    std::vector<gles30::point_light> lights{
+        { .position = { 0.7f, 0.2f, 2.0f } },
+        { .position = { 2.3f, -3.3f, -4.0f } },
+        { .position = { -4.0f, 2.0f, -12.0f } },
+        { .position = { 0.0f, 0.0f, -3.0f } },
+    };
+    for (gles30::point_light& light : lights)
+    {
+        light.radius   = 20.f;
+        light.ambient  = { 0.05f, 0.05f, 0.05f };
+        light.diffuse  = { 0.8f, 0.8f, 0.8f };
+        light.specular = { 1.0f, 1.0f, 1.0f };
+    }
+
+    std::mt19937                          generator(42); // same every run
+    std::uniform_real_distribution<float> x(-10.f, 10.f);
+    std::uniform_real_distribution<float> y(-3.2f, 5.f);
+    std::uniform_real_distribution<float> z(-20.f, 5.f);
+    std::uniform_real_distribution<float> color(0.1f, 1.f);
+    for (size_t i = 0; i < count; ++i)
+    {
+        gles30::point_light light;
+        light.position = { x(generator), y(generator), z(generator) };
+        light.radius   = 3.f;
+        light.ambient  = glm::vec3(0.f);
+        light.diffuse  = { color(generator),
+                           color(generator),
+                           color(generator) };
+        light.specular = light.diffuse;
+        // short range falloff, fade at radius hides the rest
+        light.linear    = 0.7f;
+        light.quadratic = 1.8f;
+        lights.push_back(light);
+    }
+
+    centers.clear();
+    std::ranges::transform(lights,
+                           std::back_inserter(centers),
+                           &gles30::point_light::position);
+    return lights;
+}
+
 static int main_impl();
 
 int main(int /*argc*/, char* /*argv*/[])
@@ -217,6 +266,11 @@ static int main_impl()
     gles30::shader light_shader(fs::path{ "./res/vertex_pos.vsh" },
                                 "./res/lamp_color.fsh");
 
+    gles30::clustered_lights         clustered;
+    std::vector<glm::vec3>           light_centers;
+    std::vector<gles30::point_light> point_lights;
+    glm::vec2                        viewport_size{ 640.f, 480.f };
+
     // Generate VAO VertexArrayState object to remember current VBO and
     // EBO(if any) with all attributes parameters stored in one object
     // called VAO think it is current VBO + EBO + attributes state in one
@@ -373,6 +427,15 @@ static int main_impl()
                         throw std::runtime_error(SDL_GetError());
                     }
                 }
+                else if (event.key.key == SDLK_7)
+                {
+                    const auto stat = clustered.get_statistic();
+                    clog << "point lights: " << point_lights.size()
+                         << " in view: " << stat.lights
+                         << " indexes: " << stat.indexes
+                         << " max per cluster: " << stat.max_per_cluster
+                         << " dropped: " << stat.dropped << endl;
+                }
             }
             else if (SDL_EVENT_WINDOW_RESIZED == event.type)
             {
@@ -382,6 +445,8 @@ static int main_impl()
                 // for window screen coordinate system
                 glViewport(0, 0, event.window.data1, event.window.data2);
                 gl_check();
+                viewport_size =
+                    glm::vec2(event.window.data1, event.window.data2);
                 print_view_port();
             }
         }
@@ -433,47 +498,35 @@ static int main_impl()
                 glm::vec3(1.5f, 0.2f, -1.5f),   glm::vec3(-1.3f, 1.0f, -1.5f)
             };
 
-            const std::array<glm::vec3, 4> pointLightPositions = {
-                glm::vec3(0.7f, 0.2f, 2.0f),
-                glm::vec3(2.3f, -3.3f, -4.0f),
-                glm::vec3(-4.0f, 2.0f, -12.0f),
-                glm::vec3(0.0f, 0.0f, -3.0f)
-            };
-
-            std::vector<std::string> names{
-                "pointLights[0].position",  "pointLights[0].ambient",
-                "pointLights[0].diffuse",   "pointLights[0].specular",
-                "pointLights[0].constant",  "pointLights[0].linear",
-                "pointLights[0].quadratic",
-            };
+            const auto light_count = static_cast<size_t>(std::clamp(
+                properties.get_float("point_light_count"),
+                0.f,
+                static_cast<float>(gles30::clustered_lights::max_lights - 4)));
+            if (point_lights.size() != light_count + 4)
+            {
+                point_lights = create_point_lights(light_count, light_centers);
+            }
+            // lesson lights stay, others circle around their centers
+            for (size_t i = 4; i < point_lights.size(); ++i)
+            {
+                const float phase = currentFrame + static_cast<float>(i);
+                point_lights[i].position =
+                    light_centers[i] +
+                    glm::vec3(std::cos(phase), 0.f, std::sin(phase));
+            }
 
             // directional light
             material.set_uniform("dirLight.direction", { -0.2f, -1.0f, -0.3f });
             material.set_uniform("dirLight.ambient", { 0.05f, 0.05f, 0.05f });
             material.set_uniform("dirLight.diffuse", { 0.4f, 0.4f, 0.4f });
             material.set_uniform("dirLight.specular", { 0.5f, 0.5f, 0.5f });
-            // point lights
-            std::array<size_t, 4> indexes;
-            std::ranges::iota(indexes, 0);
-            std::ranges::for_each(
-                indexes,
-                [&material, &pointLightPositions, &names](size_t index)
-                {
-                    char   i        = static_cast<char>('0' + index);
-                    size_t zero_pos = names.front().find('[') + 1;
-
-                    std::ranges::for_each(names,
-                                          [i, zero_pos](std::string& v)
-                                          { v[zero_pos] = i; });
-
-                    material.set_uniform(names[0], pointLightPositions[index]);
-                    material.set_uniform(names[1], { 0.05f, 0.05f, 0.05f });
-                    material.set_uniform(names[2], { 0.8f, 0.8f, 0.8f });
-                    material.set_uniform(names[3], { 1.0f, 1.0f, 1.0f });
-                    material.set_uniform(names[4], 1.0f);
-                    material.set_uniform(names[5], 0.09f);
-                    material.set_uniform(names[6], 0.032f);
-                });
+            // point lights, texture units 0 and 1 used by material
+            clustered.set_projection(glm::radians(camera.fovy()),
+                                     camera.aspect(),
+                                     camera.z_near(),
+                                     camera.z_far());
+            clustered.update(point_lights, view);
+            clustered.bind(material, 2, viewport_size);
 
             // spot light
             material.set_uniform("spot_light.position", camera.position());
@@ -511,6 +564,13 @@ static int main_impl()
                 gl_check();
             }
 
+            // floor under cubes, lit by small lights
+            model = glm::translate(glm::mat4(1.0f), { 0.f, -3.5f, -7.5f });
+            model = glm::scale(model, { 24.f, 0.2f, 30.f });
+            material.set_uniform("model", model);
+            glDrawElements(primitive_render_mode, 36, GL_UNSIGNED_INT, nullptr);
+            gl_check();
+
             // also draw the lamp object(s)
             light_shader.use();
             light_shader.set_uniform("projection", projection);
@@ -518,13 +578,14 @@ static int main_impl()
 
             // we now draw as many light bulbs as we have point lights.
             glBindVertexArray(light_VAO);
-            for (const auto& pointLightPosition : pointLightPositions)
+            for (const gles30::point_light& light : point_lights)
             {
                 model = glm::mat4(1.0f);
-                model = glm::translate(model, pointLightPosition);
+                model = glm::translate(model, light.position);
                 model = glm::scale(model,
                                    glm::vec3(0.2f)); // Make it a smaller cube
                 light_shader.set_uniform("model", model);
+                light_shader.set_uniform("lamp_color", light.diffuse);
                 glDrawArrays(GL_TRIANGLES, 0, 36);
             }
         }
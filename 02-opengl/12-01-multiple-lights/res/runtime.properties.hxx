@@ -5,7 +5,7 @@
 // also you can update during runtime this values with
 // properties_reader.hxx
 
-std::string title  = "1-triangles, 2-lines, 3-line-strip, 4-line-loop, 5,6-cam";
+std::string title  = "1-tri, 2-lines, 3-strip, 4-loop, 5,6-cam, 7-light stats";
 float       z_near = 0.1f;
 float       z_far  = 100.f;
 float       fovy   = 45.f;
@@ -25,3 +25,6 @@ float     material_shininess = 256.f;
 glm::vec3 light_ambient  = { 0.2f, 0.2f, 0.2f };
 glm::vec3 light_diffuse  = { 1.0f, 1.0f, 1.0f };
 glm::vec3 light_specular = { 1.0f, 1.0f, 1.0f };
+
+// small lights besides 4 lesson lights, try 1000
+float point_light_count = 256.f;
@@ -0,0 +1,407 @@
+#include "gles30_instancing.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OM_INSTANCING_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define OM_INSTANCING_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace gles30
+{
+
+glm::mat4 to_matrix(const instance& value)
+{
+    const glm::quat rotation(value.rotation.w,
+                             value.rotation.x,
+                             value.rotation.y,
+                             value.rotation.z);
+    glm::mat4 result = glm::translate(glm::mat4(1.0f), value.position);
+    result           = result * glm::mat4_cast(rotation);
+    return glm::scale(result, glm::vec3(value.scale));
+}
+
+std::array<glm::vec4, 6> extract_frustum(const glm::mat4& m)
+{
+    // Gribb, Hartmann: planes are sums of rows of matrix, glm is column
+    // major so row i is m[0][i], m[1][i], m[2][i], m[3][i]
+    const auto row = [&m](int i)
+    { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+
+    std::array<glm::vec4, 6> planes{ row(3) + row(0), row(3) - row(0),
+                                     row(3) + row(1), row(3) - row(1),
+                                     row(3) + row(2), row(3) - row(2) };
+    for (glm::vec4& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
+
+thread_pool::thread_pool(std::uint32_t threads)
+{
+    workers.reserve(threads > 0 ? threads - 1 : 0);
+    for (std::uint32_t i = 1; i < threads; ++i)
+    {
+        workers.emplace_back([this](std::stop_token stop) { worker(stop); });
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    for (std::jthread& thread : workers)
+    {
+        thread.request_stop();
+    }
+    wake.notify_all();
+    workers.clear(); // join
+}
+
+void thread_pool::parallel_for(std::size_t count_,
+                               std::size_t grain_,
+                               const task& body_)
+{
+    grain_ = std::max<std::size_t>(grain_, 1);
+    if (workers.empty() || count_ <= grain_)
+    {
+        body_(0, count_);
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        body   = &body_;
+        count  = count_;
+        grain  = grain_;
+        active = static_cast<std::uint32_t>(workers.size());
+        next.store(0, std::memory_order_relaxed);
+        ++generation;
+    }
+    wake.notify_all();
+
+    run_chunks();
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this] { return active == 0; });
+    body = nullptr;
+}
+
+void thread_pool::worker(std::stop_token stop)
+{
+    std::uint64_t seen_generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock lock(mutex);
+            if (!wake.wait(lock,
+                           stop,
+                           [&] { return generation != seen_generation; }))
+            {
+                return; // stop requested
+            }
+            seen_generation = generation;
+        }
+
+        run_chunks();
+
+        std::scoped_lock lock(mutex);
+        if (--active == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
+
+void thread_pool::run_chunks()
+{
+    for (;;)
+    {
+        const std::size_t begin =
+            next.fetch_add(grain, std::memory_order_relaxed);
+        if (begin >= count)
+        {
+            return;
+        }
+        (*body)(begin, std::min(begin + grain, count));
+    }
+}
+
+// sphere is visible if it is not fully behind any plane:
+// dot(plane.xyz, center) + plane.w + radius >= 0 for all 6 planes
+static bool is_visible(const std::array<glm::vec4, 6>& planes,
+                       const glm::vec3&                center,
+                       float                           radius)
+{
+    return std::all_of(planes.begin(),
+                       planes.end(),
+                       [&](const glm::vec4& p)
+                       {
+                           return glm::dot(glm::vec3(p), center) + p.w +
+                                      radius >=
+                                  0.0f;
+                       });
+}
+
+/// same test for 4 spheres, bit per visible sphere
+static unsigned visible_mask4(const std::array<glm::vec4, 6>& planes,
+                              const float*                    x,
+                              const float*                    y,
+                              const float*                    z,
+                              const float*                    radius)
+{
+    unsigned mask = 0b1111;
+#if defined(OM_INSTANCING_SSE2)
+    const __m128 px = _mm_loadu_ps(x);
+    const __m128 py = _mm_loadu_ps(y);
+    const __m128 pz = _mm_loadu_ps(z);
+    const __m128 pr = _mm_loadu_ps(radius);
+    for (const glm::vec4& p : planes)
+    {
+        const __m128 distance =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(p.x)),
+                                  _mm_mul_ps(py, _mm_set1_ps(p.y))),
+                       _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(p.z)),
+                                  _mm_add_ps(pr, _mm_set1_ps(p.w))));
+        mask &= static_cast<unsigned>(
+            _mm_movemask_ps(_mm_cmpge_ps(distance, _mm_setzero_ps())));
+        if (mask == 0)
+        {
+            break;
+        }
+    }
+#elif defined(OM_INSTANCING_NEON)
+    const float32x4_t px   = vld1q_f32(x);
+    const float32x4_t py   = vld1q_f32(y);
+    const float32x4_t pz   = vld1q_f32(z);
+    const float32x4_t pr   = vld1q_f32(radius);
+    const uint32x4_t  bits = { 1, 2, 4, 8 };
+    for (const glm::vec4& p : planes)
+    {
+        const float32x4_t distance =
+            vaddq_f32(vaddq_f32(vmulq_n_f32(px, p.x), vmulq_n_f32(py, p.y)),
+                      vaddq_f32(vmulq_n_f32(pz, p.z),
+                                vaddq_f32(pr, vdupq_n_f32(p.w))));
+        const uint32x4_t inside = vcgeq_f32(distance, vdupq_n_f32(0.0f));
+        mask &= vaddvq_u32(vandq_u32(inside, bits));
+        if (mask == 0)
+        {
+            break;
+        }
+    }
+#else
+    for (unsigned lane = 0; lane < 4; ++lane)
+    {
+        if (!is_visible(planes,
+                        glm::vec3(x[lane], y[lane], z[lane]),
+                        radius[lane]))
+        {
+            mask &= ~(1u << lane);
+        }
+    }
+#endif
+    return mask;
+}
+
+instanced_model::instanced_model(const model& geometry_, std::uint32_t threads)
+    : geometry{ geometry_ }
+    , pool{ threads != 0 ? threads
+                         : std::max(1u, std::thread::hardware_concurrency()) }
+{
+    glGenBuffers(1, &vbo);
+}
+
+instanced_model::~instanced_model()
+{
+    for (part& p : parts)
+    {
+        if (p.fence != nullptr)
+        {
+            glDeleteSync(p.fence);
+        }
+    }
+    glDeleteBuffers(1, &vbo);
+}
+
+void instanced_model::set_instances(std::vector<instance> values)
+{
+    instances = std::move(values);
+
+    const float model_radius = geometry.get_radius();
+    const auto  count        = instances.size();
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    radius.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        x[i]      = instances[i].position.x;
+        y[i]      = instances[i].position.y;
+        z[i]      = instances[i].position.z;
+        radius[i] = model_radius * instances[i].scale;
+    }
+}
+
+std::size_t instanced_model::cull(const std::array<glm::vec4, 6>& planes,
+                                  std::size_t                     begin,
+                                  std::size_t                     end,
+                                  instance*                       output) const
+{
+    std::size_t written = 0;
+    std::size_t i       = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        unsigned mask =
+            visible_mask4(planes, &x[i], &y[i], &z[i], &radius[i]);
+        while (mask != 0)
+        {
+            output[written++] = instances[i + std::countr_zero(mask)];
+            mask &= mask - 1; // clear lowest bit
+        }
+    }
+    for (; i < end; ++i)
+    {
+        if (is_visible(planes, instances[i].position, radius[i]))
+        {
+            output[written++] = instances[i];
+        }
+    }
+    return written;
+}
+
+instance* instanced_model::map_part(std::size_t count)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (count > capacity)
+    {
+        // orphan: driver frees old storage after GPU is done with it, so
+        // fences of old parts are not needed
+        capacity = count;
+        glBufferData(GL_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(capacity * sizeof(instance) *
+                                             parts.size()),
+                     nullptr,
+                     GL_STREAM_DRAW);
+        for (std::size_t i = 0; i < parts.size(); ++i)
+        {
+            parts[i].offset = i * capacity * sizeof(instance);
+            if (parts[i].fence != nullptr)
+            {
+                glDeleteSync(parts[i].fence);
+                parts[i].fence = nullptr;
+            }
+        }
+    }
+
+    part& current = parts[frame % parts.size()];
+    if (current.fence != nullptr)
+    {
+        // drawn 3 frames ago, usually finished long ago
+        GLenum status = GL_TIMEOUT_EXPIRED;
+        while (status == GL_TIMEOUT_EXPIRED)
+        {
+            status = glClientWaitSync(
+                current.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+        }
+        glDeleteSync(current.fence);
+        current.fence = nullptr;
+    }
+
+    // unsynchronized - driver does not wait for GPU, fence above did it
+    void* mapped = glMapBufferRange(
+        GL_ARRAY_BUFFER,
+        static_cast<GLintptr>(current.offset),
+        static_cast<GLsizeiptr>(count * sizeof(instance)),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+            GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped == nullptr)
+    {
+        throw std::runtime_error("error: can't map instance buffer");
+    }
+    return static_cast<instance*>(mapped);
+}
+
+void instanced_model::draw(shader& program, const glm::mat4& projection_view)
+{
+    visible                 = 0;
+    const std::size_t count = instances.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    const std::array<glm::vec4, 6> planes = extract_frustum(projection_view);
+    instance*                      mapped = map_part(count);
+
+    // few chunks per thread to balance load, every chunk is one draw call,
+    // multiple of 4 so SIMD loop covers all but last chunk
+    const std::size_t chunks = pool.get_thread_count() * 4;
+    grain = std::max<std::size_t>((count / chunks + 4) & ~std::size_t{ 3 },
+                                  4096);
+    chunk_visible.assign((count + grain - 1) / grain, 0);
+
+    // every chunk writes visible instances at its own place of part
+    pool.parallel_for(count,
+                      grain,
+                      [&](std::size_t begin, std::size_t end)
+                      {
+                          chunk_visible[begin / grain] =
+                              cull(planes, begin, end, mapped + begin);
+                      });
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
+    {
+        return; // buffer content lost (display mode change), next frame
+    }
+
+    part& current = parts[frame % parts.size()];
+    for (std::size_t chunk = 0; chunk < chunk_visible.size(); ++chunk)
+    {
+        if (chunk_visible[chunk] == 0)
+        {
+            continue;
+        }
+        const std::size_t offset =
+            current.offset + chunk * grain * sizeof(instance);
+        geometry.draw_instanced(
+            program,
+            chunk_visible[chunk],
+            [&]
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, vbo);
+                glEnableVertexAttribArray(3);
+                glVertexAttribPointer(3,
+                                      4,
+                                      GL_FLOAT,
+                                      GL_FALSE,
+                                      sizeof(instance),
+                                      reinterpret_cast<void*>(offset));
+                glEnableVertexAttribArray(4);
+                glVertexAttribPointer(
+                    4,
+                    4,
+                    GL_FLOAT,
+                    GL_FALSE,
+                    sizeof(instance),
+                    reinterpret_cast<void*>(offset +
+                                            offsetof(instance, rotation)));
+                glVertexAttribDivisor(3, 1);
+                glVertexAttribDivisor(4, 1);
+            });
+        visible += chunk_visible[chunk];
+    }
+
+    current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++frame;
+}
+
+} // namespace gles30
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gles30_model.hxx"
+#include "gles30_shader.hxx"
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+/// 32 bytes per instance instead of 64 of mat4, vertex shader builds
+/// transform from it (see res/instanced.vsh)
+struct instance
+{
+    glm::vec3 position;
+    float     scale;
+    glm::vec4 rotation; ///< unit quaternion x, y, z, w
+};
+static_assert(sizeof(instance) == 32);
+
+/// same transform as vertex shader, for non instanced draw
+glm::mat4 to_matrix(const instance& value);
+
+/// planes of projection * view, xyz - normal to inside, w - distance
+std::array<glm::vec4, 6> extract_frustum(const glm::mat4& projection_view);
+
+/// Fixed workers for data parallel loops. parallel_for() splits range in
+/// chunks of grain elements, workers and calling thread take chunks from
+/// shared atomic counter until range ends.
+class thread_pool
+{
+public:
+    using task = std::function<void(std::size_t begin, std::size_t end)>;
+
+    /// threads - total threads including caller of parallel_for()
+    explicit thread_pool(std::uint32_t threads);
+    thread_pool(const thread_pool&)            = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    ~thread_pool();
+
+    [[nodiscard]] std::uint32_t get_thread_count() const
+    {
+        return static_cast<std::uint32_t>(workers.size()) + 1u;
+    }
+
+    /// blocks until body called for every chunk of [0, count), body must
+    /// not throw
+    void parallel_for(std::size_t count, std::size_t grain, const task& body);
+
+private:
+    void worker(std::stop_token stop);
+    void run_chunks();
+
+    std::mutex                  mutex;
+    std::condition_variable_any wake;
+    std::condition_variable     done;
+    // current loop, written under mutex before generation changes
+    const task*               body  = nullptr;
+    std::size_t               count = 0;
+    std::size_t               grain = 1;
+    std::atomic<std::size_t>  next{ 0 };
+    std::uint64_t             generation = 0;
+    std::uint32_t             active     = 0; // workers in current loop
+    std::vector<std::jthread> workers;       // last, joined first
+};
+
+/// Many copies of one model. Every frame instances outside of view frustum
+/// culled on all cores (4 bounding spheres per SIMD instruction), visible
+/// ones written straight to mapped GPU buffer. Buffer has 3 parts, frame
+/// writes part GPU finished with (fence), so map never waits for GPU
+/// drawing previous frames. Buffer grows by orphaning (glBufferData).
+class instanced_model
+{
+public:
+    /// geometry must live longer than this object, threads == 0 - all cores
+    instanced_model(const model& geometry, std::uint32_t threads = 0);
+    ~instanced_model();
+    instanced_model(const instanced_model&)            = delete;
+    instanced_model& operator=(const instanced_model&) = delete;
+
+    void set_instances(std::vector<instance> values);
+    [[nodiscard]] const std::vector<instance>& get_instances() const
+    {
+        return instances;
+    }
+
+    /// cull, stream and draw visible instances with shader attributes:
+    /// location 3 - vec4(position, scale), location 4 - rotation
+    void draw(shader& program, const glm::mat4& projection_view);
+
+    /// instances drawn by last draw()
+    [[nodiscard]] std::size_t get_visible_count() const { return visible; }
+
+private:
+    /// buffer part used by one frame
+    struct part
+    {
+        std::size_t offset = 0; ///< bytes
+        GLsync      fence  = nullptr;
+    };
+
+    /// culls [begin, end) writing visible to output, returns their count
+    std::size_t cull(const std::array<glm::vec4, 6>& planes,
+                     std::size_t                     begin,
+                     std::size_t                     end,
+                     instance*                       output) const;
+    /// grow buffer if needed, wait part of this frame, map it
+    instance* map_part(std::size_t count);
+
+    const model&          geometry;
+    std::vector<instance> instances;
+    // structure of arrays copy for culling: one SIMD load - 4 instances
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    thread_pool pool;
+    /// instances written by chunk of last cull, chunk starts at
+    /// chunk * grain in part
+    std::vector<std::size_t> chunk_visible;
+    std::size_t              grain   = 0;
+    std::size_t              visible = 0;
+
+    std::uint32_t       vbo      = 0;
+    std::size_t         capacity = 0; ///< instances in one part
+    std::array<part, 3> parts;
+    std::size_t         frame = 0;
+};
+
+} // namespace gles30
@@ -1,5 +1,6 @@
 #include "gles30_mesh.hxx"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 
@@ -26,6 +27,7 @@ mesh::mesh(mesh&& other) noexcept
     std::swap(ebo, other.ebo);
     std::swap(vao, other.vao);
     std::swap(primitive_type, other.primitive_type);
+    std::swap(radius, other.radius);
 }
 
 void swap(mesh& l, mesh& r) noexcept
@@ -38,6 +40,7 @@ void swap(mesh& l, mesh& r) noexcept
     std::swap(l.vbo, r.vbo);
     std::swap(l.vao, r.vao);
     std::swap(l.primitive_type, r.primitive_type);
+    std::swap(l.radius, r.radius);
 }
 
 mesh& mesh::operator=(mesh&& other) noexcept
@@ -195,6 +198,11 @@ void mesh::setup()
     assert(ebo == 0);
     assert(vao == 0);
 
+    for (const vertex& v : vertices)
+    {
+        radius = std::max(radius, glm::length(v.position));
+    }
+
     glGenVertexArrays(1, &vao);
 
     glGenBuffers(1, &vbo);
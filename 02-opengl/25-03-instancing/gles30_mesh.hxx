@@ -50,6 +50,9 @@ public:
     void      set_primitive_type(primitive value);
     primitive get_primitive_type() const;
 
+    /// sphere around local origin containing all vertices
+    [[nodiscard]] float get_radius() const { return radius; }
+
 private:
     friend void swap(mesh& l, mesh& r) noexcept;
     void        setup();
@@ -63,6 +66,7 @@ private:
     uint32_t ebo{ 0 }; // element buffer object (index)
 
     primitive primitive_type{};
+    float     radius{};
 };
 
 inline mesh::mesh(std::vector<vertex>   a_vertices,
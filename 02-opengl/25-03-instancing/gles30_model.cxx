@@ -29,6 +29,16 @@ void model::draw_instanced(shader&               shader,
         { m.draw_instanced(shader, instance_count, bind_custom_buffer); });
 }
 
+float model::get_radius() const
+{
+    float radius = 0.f;
+    for (const mesh& m : meshes)
+    {
+        radius = std::max(radius, m.get_radius());
+    }
+    return radius;
+}
+
 static void                  process_node(const aiNode*      node,
                                           const aiScene*     scene,
                                           std::vector<mesh>& meshes,
@@ -14,6 +14,9 @@ public:
                         size_t                instance_count,
                         std::function<void()> bind_custom_buffer) const;
 
+    /// sphere around local origin containing all meshes
+    [[nodiscard]] float get_radius() const;
+
 private:
     void load_model(std::string_view path);
 
@@ -12,6 +12,7 @@
 
 #include "fps_camera.hxx"
 #include "gles30_framebuffer.hxx"
+#include "gles30_instancing.hxx"
 #include "gles30_model.hxx"
 #include "gles30_shader.hxx"
 #include "gles30_texture.hxx"
@@ -20,6 +21,8 @@
 #include <SDL3/SDL.h>
 #include <type_traits>
 
+#include <glm/gtc/quaternion.hpp>
+
 #include "res/runtime.properties.hxx"
 
 static fps_camera camera;
@@ -327,13 +330,12 @@ struct scene
     gles30::shader instanced_shader;
     gles30::shader planet_shader;
     gles30::mesh   quad;
-    uint32_t       instance_vbo;
     size_t         num_instances = 1000;
 
-    gles30::model          planet_mars;
-    gles30::model          rock;
-    std::vector<glm::mat4> rock_matrices;
-    bool                   use_instance_draw = false;
+    gles30::model           planet_mars;
+    gles30::model           rock;
+    gles30::instanced_model rocks;
+    bool                    use_instance_draw = false;
 };
 
 void scene::create_uniform_buffer(const void*            buffer_ptr,
@@ -399,6 +401,9 @@ void scene::pull_system_events(bool& continue_loop, int& current_effect)
             else if (event.key.key == SDLK_2)
             {
                 current_effect = 2;
+                std::cout << "visible instances: "
+                          << rocks.get_visible_count() << " of "
+                          << num_instances << std::endl;
             }
             else if (event.key.key == SDLK_3)
             {
@@ -444,13 +449,15 @@ void scene::pull_system_events(bool& continue_loop, int& current_effect)
 void scene::regenerate_rock_matrixes()
 {
     unsigned int amount = num_instances;
-    rock_matrices.resize(amount);
 
-    float radius = 50.0;
-    float offset = 2.5f;
+    std::vector<gles30::instance> rock_instances(amount);
+
+    float           radius = 50.0;
+    float           offset = 2.5f;
+    const glm::vec3 axis   = glm::normalize(glm::vec3(0.4f, 0.6f, 0.8f));
     for (unsigned int i = 0; i < amount; i++)
     {
-        glm::mat4 model = glm::mat4(1.0f);
+        gles30::instance& rock_instance = rock_instances[i];
         // 1. translation: displace along circle with 'radius' in range
         // [-offset, offset]
         float angle_rock = (float)i / (float)amount * 360.0f;
@@ -463,27 +470,20 @@ void scene::regenerate_rock_matrixes()
             0.4f; // keep height of field smaller compared to width of x and z
         displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
         float z      = cos(angle_rock) * radius + displacement;
-        model        = glm::translate(model, glm::vec3(x, y, z));
+        rock_instance.position = glm::vec3(x, y, z);
 
         // 2. scale: scale between 0.05 and 0.25f
-        float scale = (rand() % 20) / 100.0f + 0.05;
-        model       = glm::scale(model, glm::vec3(scale));
+        rock_instance.scale = (rand() % 20) / 100.0f + 0.05;
 
         // 3. rotation: add random rotation around a (semi)randomly picked
         // rotation axis vector
-        float rotAngle = (rand() % 360);
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. now add to list of matrices
-        rock_matrices[i] = model;
+        float           rotAngle = (rand() % 360);
+        const glm::quat q        = glm::angleAxis(rotAngle, axis);
+        rock_instance.rotation   = glm::vec4(q.x, q.y, q.z, q.w);
     }
 
-    // create OpenGL buffer and load with data
-    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(glm::mat4) * num_instances,
-                 &rock_matrices[0],
-                 GL_STATIC_DRAW);
+    // GPU buffer filled every frame with visible instances only
+    rocks.set_instances(std::move(rock_instances));
 
     std::cout << "num_instances = " << num_instances << std::endl;
 }
@@ -495,16 +495,14 @@ scene::scene()
     , instanced_shader("res/instanced.vsh", "res/instanced.fsh")
     , planet_shader("res/textured.vsh", "res/textured.fsh")
     , quad{ create_mesh(quadVertices.data(), quadVertices.size() / 8, {}) }
-    , instance_vbo{}
     , planet_mars("res/planet.obj")
     , rock("res/rock.obj")
+    , rocks(rock)
 {
-    glGenBuffers(1, &instance_vbo);
     create_camera(properties);
 
     // generate offset positions
     regenerate_rock_matrixes();
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void scene::render([[maybe_unused]] float delta_time)
@@ -538,52 +536,15 @@ void scene::render([[maybe_unused]] float delta_time)
         instanced_shader.set_uniform("projection", camera.projection_matrix());
         instanced_shader.set_uniform("view", camera.view_matrix());
 
-        rock.draw_instanced(
-            instanced_shader,
-            num_instances,
-            [&]
-            {
-                //        // explain data for OpenGL
-                glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
-
-                // vertex attributes
-                std::size_t vec4Size = sizeof(glm::vec4);
-                glEnableVertexAttribArray(3);
-                glVertexAttribPointer(
-                    3, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)0);
-                glEnableVertexAttribArray(4);
-                glVertexAttribPointer(4,
-                                      4,
-                                      GL_FLOAT,
-                                      GL_FALSE,
-                                      4 * vec4Size,
-                                      (void*)(1 * vec4Size));
-                glEnableVertexAttribArray(5);
-                glVertexAttribPointer(5,
-                                      4,
-                                      GL_FLOAT,
-                                      GL_FALSE,
-                                      4 * vec4Size,
-                                      (void*)(2 * vec4Size));
-                glEnableVertexAttribArray(6);
-                glVertexAttribPointer(6,
-                                      4,
-                                      GL_FLOAT,
-                                      GL_FALSE,
-                                      4 * vec4Size,
-                                      (void*)(3 * vec4Size));
-
-                glVertexAttribDivisor(3, 1);
-                glVertexAttribDivisor(4, 1);
-                glVertexAttribDivisor(5, 1);
-                glVertexAttribDivisor(6, 1);
-            });
+        rocks.draw(instanced_shader,
+                   camera.projection_matrix() * camera.view_matrix());
     }
     else
     {
         for (size_t i = 0; i < num_instances; ++i)
         {
-            planet_shader.set_uniform("model", rock_matrices[i]);
+            planet_shader.set_uniform(
+                "model", gles30::to_matrix(rocks.get_instances()[i]));
             rock.draw(planet_shader);
         }
     }
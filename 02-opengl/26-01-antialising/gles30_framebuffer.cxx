@@ -49,4 +49,26 @@ void framebuffer::unbind()
 {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
+
+void framebuffer::blit_to_framebuffer(framebuffer& destenasion,
+                                      const rect&  src,
+                                      const rect&  dst,
+                                      uint32_t     mask_canals,
+                                      filter       filtering)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destenasion.fbo);
+    // glBlitFramebuffer accepts only GL_NEAREST and GL_LINEAR
+    int filt = filtering == filter::liner ? GL_LINEAR : GL_NEAREST;
+    glBlitFramebuffer(src.x0,
+                      src.y0,
+                      src.x1,
+                      src.y1,
+                      dst.x0,
+                      dst.y0,
+                      dst.x1,
+                      dst.y1,
+                      mask_canals,
+                      filt);
+}
 } // namespace gles30
@@ -1,6 +1,9 @@
 #pragma once
 #include <cstdint>
 
+#include "gles30_texture.hxx"
+#include "opengles30.hxx"
+
 namespace gles30
 {
 class texture;
@@ -14,8 +17,17 @@ public:
     void bind();
     void unbind();
 
+    void blit_to_framebuffer(framebuffer& destenasion,
+                             const rect&  src,
+                             const rect&  dst,
+                             uint32_t     mask_canals,
+                             filter       filtering);
+
+    [[nodiscard]] uint32_t get_id() const { return fbo; }
+    [[nodiscard]] bool     has_depth_stencil() const { return rbo != 0; }
+
 private:
     uint32_t fbo;
-    uint32_t rbo; // for depth and stensil
+    uint32_t rbo = 0; // for depth and stensil
 };
 } // namespace gles30
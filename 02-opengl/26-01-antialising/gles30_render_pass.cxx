@@ -0,0 +1,90 @@
+#include "gles30_render_pass.hxx"
+
+#include <array>
+
+#include "gles30_framebuffer.hxx"
+
+namespace gles30
+{
+/// invalidate attachments of bound target, window framebuffer names them
+/// GL_COLOR, GL_DEPTH, GL_STENCIL
+static void invalidate(const render_pass& pass, bool color, bool depth_stencil)
+{
+    // desktop OpenGL 3.3 has no glInvalidateFramebuffer, it is only hint
+    if (glInvalidateFramebuffer == nullptr)
+    {
+        return;
+    }
+    const bool window = pass.target == nullptr;
+    const bool has_depth_stencil =
+        window || pass.target->has_depth_stencil();
+
+    std::array<uint32_t, 3> attachments{};
+    int32_t                 count = 0;
+    if (color)
+    {
+        attachments[count++] = window ? GL_COLOR : GL_COLOR_ATTACHMENT0;
+    }
+    if (depth_stencil && has_depth_stencil)
+    {
+        if (window)
+        {
+            attachments[count++] = GL_DEPTH;
+            attachments[count++] = GL_STENCIL;
+        }
+        else
+        {
+            attachments[count++] = GL_DEPTH_STENCIL_ATTACHMENT;
+        }
+    }
+    if (count > 0)
+    {
+        glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments.data());
+    }
+}
+
+void render_pass::begin() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, target ? target->get_id() : 0);
+    glViewport(area.x0, area.y0, area.x1 - area.x0, area.y1 - area.y0);
+
+    invalidate(*this,
+               color.load == load_op::dont_care,
+               depth_stencil.load == load_op::dont_care);
+
+    uint32_t mask = 0;
+    if (color.load == load_op::clear)
+    {
+        glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_alpha);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        mask |= GL_COLOR_BUFFER_BIT;
+    }
+    if (depth_stencil.load == load_op::clear)
+    {
+        // clear must not be masked, else driver has to load old values
+        glClearDepthf(clear_depth);
+        glClearStencil(clear_stencil);
+        glDepthMask(GL_TRUE);
+        glStencilMask(0xFF);
+        mask |= GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+    }
+    if (mask != 0)
+    {
+        glClear(mask);
+    }
+}
+
+void render_pass::end() const
+{
+    if (resolve != nullptr)
+    {
+        target->blit_to_framebuffer(
+            *resolve, area, area, GL_COLOR_BUFFER_BIT, filter::nearest);
+        glBindFramebuffer(GL_FRAMEBUFFER, target->get_id());
+    }
+
+    invalidate(*this,
+               color.store == store_op::dont_care,
+               depth_stencil.store == store_op::dont_care);
+}
+} // namespace gles30
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+#include "opengles30.hxx"
+
+namespace gles30
+{
+class framebuffer;
+
+/// what to do with old attachment content when pass begins
+enum class load_op
+{
+    load,     ///< keep, tiled GPU reads it from memory into tile
+    clear,    ///< glClear, no read
+    dont_care ///< glInvalidateFramebuffer, no read, content undefined
+};
+
+/// what to do with attachment content when pass ends
+enum class store_op
+{
+    store,    ///< keep, tiled GPU writes tile to memory
+    dont_care ///< glInvalidateFramebuffer, no write
+};
+
+struct attachment_ops
+{
+    load_op  load  = load_op::load;
+    store_op store = store_op::store;
+};
+
+/// Render target of one pass and load/store operation of every attachment.
+/// GLES has no render pass object, so driver guesses what to load and store
+/// for every tile from glClear and glInvalidateFramebuffer calls. begin() and
+/// end() make these calls in right places:
+///     begin: bind target, viewport, invalidate dont_care, clear clear;
+///     end:   blit color to resolve target (MSAA resolve), then invalidate
+///            attachments with store_op::dont_care.
+/// Typical MSAA pass: clear everything, resolve, store nothing - multisample
+/// data never leaves tile memory on tiled GPU.
+struct render_pass
+{
+    framebuffer*   target = nullptr; ///< nullptr - window framebuffer
+    attachment_ops color;
+    attachment_ops depth_stencil; ///< ignored if target has no depth/stencil
+    glm::vec3      clear_color{ 0.f };
+    float          clear_alpha   = 0.f;
+    float          clear_depth   = 1.f;
+    int32_t        clear_stencil = 0;
+    /// color blitted here in end(), target must be framebuffer then
+    framebuffer*   resolve       = nullptr;
+    rect           area{};                  ///< viewport and resolve region
+
+    void begin() const;
+    /// leave target bound to GL_FRAMEBUFFER
+    void end() const;
+};
+} // namespace gles30
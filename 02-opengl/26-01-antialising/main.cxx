@@ -12,6 +12,7 @@
 #include "fps_camera.hxx"
 #include "gles30_framebuffer.hxx"
 #include "gles30_model.hxx"
+#include "gles30_render_pass.hxx"
 #include "gles30_shader.hxx"
 #include "gles30_texture.hxx"
 #include "opengles30.hxx"
@@ -196,17 +197,6 @@ float update_delta_time(float& lastFrame)
     return deltaTime;
 }
 
-void clear_back_buffer(const glm::vec3 clear_color)
-{
-    float red   = clear_color.r;
-    float green = clear_color.g;
-    float blue  = clear_color.b;
-    float alpha = 0.f;
-
-    glClearColor(red, green, blue, alpha);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-}
-
 static void destroy_window(SDL_Window* ptr)
 {
     // for debug check
@@ -359,6 +349,8 @@ struct scene
 
     gles30::shader cube_shader;
     gles30::mesh   cube;
+
+    gles30::render_pass window_pass;
 };
 
 void scene::create_uniform_buffer(const void*            buffer_ptr,
@@ -469,6 +461,13 @@ scene::scene()
 {
     create_camera(properties);
 
+    // only resolved color is presented, multisample depth/stencil is
+    // not needed after frame
+    window_pass.color         = { gles30::load_op::clear,
+                                  gles30::store_op::store };
+    window_pass.depth_stencil = { gles30::load_op::clear,
+                                  gles30::store_op::dont_care };
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
@@ -479,7 +478,12 @@ void scene::render([[maybe_unused]] float delta_time)
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
 
-    clear_back_buffer(properties.get_vec3("clear_color"));
+    window_pass.clear_color = properties.get_vec3("clear_color");
+    window_pass.area        = { 0,
+                                0,
+                                static_cast<int32_t>(screen_width),
+                                static_cast<int32_t>(screen_height) };
+    window_pass.begin();
 
     cube_shader.use();
     cube_shader.set_uniform("model", glm::mat4(1.f));
@@ -487,6 +491,7 @@ void scene::render([[maybe_unused]] float delta_time)
     cube_shader.set_uniform("projection", camera.projection_matrix());
 
     cube.draw(cube_shader);
+    window_pass.end();
 }
 
 int main(int /*argc*/, char* /*argv*/[])
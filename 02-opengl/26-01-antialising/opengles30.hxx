@@ -6,6 +6,17 @@
 #include <iosfwd>
 #include <string_view>
 
+namespace gles30
+{
+struct rect
+{
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+};
+} // namespace gles30
+
 void windows_make_process_dpi_aware() noexcept(false);
 void initialize_opengles_3_2() noexcept(false);
 bool is_desktop();
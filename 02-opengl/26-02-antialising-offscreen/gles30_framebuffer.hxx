@@ -33,8 +33,11 @@ public:
                              uint32_t     mask_canals,
                              filter       filtering);
 
+    [[nodiscard]] uint32_t get_id() const { return fbo; }
+    [[nodiscard]] bool     has_depth_stencil() const { return rbo != 0; }
+
 private:
     uint32_t fbo;
-    uint32_t rbo; // for depth and stensil
+    uint32_t rbo = 0; // for depth and stensil
 };
 } // namespace gles30
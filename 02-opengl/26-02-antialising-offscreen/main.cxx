@@ -12,6 +12,7 @@
 #include "fps_camera.hxx"
 #include "gles30_framebuffer.hxx"
 #include "gles30_model.hxx"
+#include "gles30_render_pass.hxx"
 #include "gles30_shader.hxx"
 #include "gles30_texture.hxx"
 #include "opengles30.hxx"
@@ -199,17 +200,6 @@ float update_delta_time(float& lastFrame)
     return deltaTime;
 }
 
-void clear_back_buffer(const glm::vec3 clear_color)
-{
-    float red   = clear_color.r;
-    float green = clear_color.g;
-    float blue  = clear_color.b;
-    float alpha = 0.f;
-
-    glClearColor(red, green, blue, alpha);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-}
-
 static void destroy_window(SDL_Window* ptr)
 {
     // for debug check
@@ -363,6 +353,9 @@ struct scene
 
     gles30::texture     intermediate_screen_texture;
     gles30::framebuffer intermediate_framebuffer;
+
+    gles30::render_pass msaa_pass;
+    gles30::render_pass screen_pass;
 };
 
 void scene::create_uniform_buffer(const void*            buffer_ptr,
@@ -507,6 +500,27 @@ scene::scene()
     }
     intermediate_framebuffer.unbind();
 
+    // multisample color and depth live only during pass: clear instead of
+    // load, resolve color to intermediate texture, store nothing
+    msaa_pass.target        = &msaa_framebuffer;
+    msaa_pass.color         = { gles30::load_op::clear,
+                                gles30::store_op::dont_care };
+    msaa_pass.depth_stencil = { gles30::load_op::clear,
+                                gles30::store_op::dont_care };
+    msaa_pass.resolve       = &intermediate_framebuffer;
+    msaa_pass.area          = { 0,
+                                0,
+                                properties.get_int("screen_width"),
+                                properties.get_int("screen_height") };
+
+    // full screen quad without depth test, window depth never needed
+    screen_pass.color         = { gles30::load_op::clear,
+                                  gles30::store_op::store };
+    screen_pass.depth_stencil = { gles30::load_op::dont_care,
+                                  gles30::store_op::dont_care };
+    screen_pass.clear_color   = glm::vec3(0.1f);
+    screen_pass.clear_alpha   = 1.f;
+
     create_camera(properties);
 }
 
@@ -515,11 +529,10 @@ void scene::render([[maybe_unused]] float delta_time)
     camera.move_using_keyboard_wasd(delta_time);
 
     // 1. draw scene as normal in multisampled buffers
-    msaa_framebuffer.bind();
+    msaa_pass.clear_color = properties.get_vec3("clear_color");
+    msaa_pass.begin();
     glEnable(GL_DEPTH_TEST);
 
-    clear_back_buffer(properties.get_vec3("clear_color"));
-
     cube_shader.use();
     cube_shader.set_uniform("model", glm::mat4(1.f));
     cube_shader.set_uniform("view", camera.view_matrix());
@@ -529,25 +542,20 @@ void scene::render([[maybe_unused]] float delta_time)
 
     // 2. now blit multisampled buffer(s) to normal colorbuffer of intermediate
     // FBO. Image is stored in intermediate_screen_texture
-    gles30::rect full_screen{ 0,
-                              0,
-                              properties.get_int("screen_width"),
-                              properties.get_int("screen_height") };
-    msaa_framebuffer.blit_to_framebuffer(intermediate_framebuffer,
-                                         full_screen,
-                                         full_screen,
-                                         GL_COLOR_BUFFER_BIT,
-                                         gles30::filter::nearest);
+    msaa_pass.end();
 
     // 3. now render quad with scene's visuals as its texture image
-    msaa_framebuffer.unbind();
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    screen_pass.area = { 0,
+                         0,
+                         static_cast<int32_t>(screen_width),
+                         static_cast<int32_t>(screen_height) };
+    screen_pass.begin();
     glDisable(GL_DEPTH_TEST);
     quad_shader.use();
     quad_shader.set_uniform(
         "material.tex_diffuse0", intermediate_screen_texture, 0);
     quad.draw(quad_shader);
+    screen_pass.end();
 }
 
 int main(int /*argc*/, char* /*argv*/[])
@@ -1,8 +1,10 @@
 #include "gles30_mesh.hxx"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 
+#include "gles30_state.hxx"
 #include "opengles30.hxx"
 
 namespace gles30
@@ -21,6 +23,11 @@ mesh::mesh(mesh&& other) noexcept
     , indices{ std::move(other.indices) }
     , textures{ std::move(other.textures) }
     , primitive_type{ primitive::triangles }
+    , disable_textures{ other.disable_textures }
+    , center{ other.center }
+    , radius{ other.radius }
+    , half_extent{ other.half_extent }
+    , material_tables{ std::move(other.material_tables) }
 {
     std::swap(vbo, other.vbo);
     std::swap(ebo, other.ebo);
@@ -38,6 +45,11 @@ void swap(mesh& l, mesh& r) noexcept
     std::swap(l.vbo, r.vbo);
     std::swap(l.vao, r.vao);
     std::swap(l.primitive_type, r.primitive_type);
+    std::swap(l.disable_textures, r.disable_textures);
+    std::swap(l.center, r.center);
+    std::swap(l.radius, r.radius);
+    std::swap(l.half_extent, r.half_extent);
+    swap(l.material_tables, r.material_tables);
 }
 
 mesh& mesh::operator=(mesh&& other) noexcept
@@ -49,26 +61,41 @@ mesh& mesh::operator=(mesh&& other) noexcept
 
 mesh::~mesh() noexcept
 {
-    glDeleteBuffers(1, &vao);
+    if (vao != 0)
+    {
+        state_cache::get().on_delete_vertex_array(vao);
+    }
+    glDeleteVertexArrays(1, &vao);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ebo);
 }
 
-void mesh::draw(shader& shader) const
+const mesh::material_table& mesh::get_material_table(
+    const shader& shader) const
 {
-    shader.use();
+    const std::uint32_t program_id = shader.get_program_id();
+    const std::uint64_t generation =
+        state_cache::get().get_program_generation();
+
+    auto it = std::find_if(material_tables.begin(),
+                           material_tables.end(),
+                           [program_id](const material_table& table)
+                           { return table.program_id == program_id; });
+    if (it != material_tables.end() && it->program_generation == generation)
+    {
+        return *it;
+    }
+
+    material_table table{ program_id, generation, {} };
+
     uint32_t diffuse_index  = 0;
     uint32_t specular_index = 0;
     uint32_t cubemap_index  = 0;
-    for (uint32_t i = 0; i < textures.size() && !disable_textures; i++)
+    for (uint32_t i = 0; i < textures.size(); i++)
     {
-        // activate proper texture unit before binding
-        glActiveTexture(GL_TEXTURE0 + i);
-
         // retrieve texture number (the N in diffuse_textureN)
-        texture& texture = *textures.at(i);
-        texture.bind();
-        texture::type        type = texture.get_type();
+        texture&             texture = *textures.at(i);
+        texture::type        type    = texture.get_type();
         std::array<char, 32> str{};
 
         int32_t is_ok = 0;
@@ -106,18 +133,58 @@ void mesh::draw(shader& shader) const
             throw std::runtime_error("error: can't fit name in 64 chars");
         }
 
-        shader.set_uniform(tex_uniform_name.data(), static_cast<int32_t>(i));
+        table.bindings.push_back(
+            { &texture, i, shader.get_uniform(tex_uniform_name.data()) });
     }
 
-    // draw mesh
-    glBindVertexArray(vao);
+    // drop tables built before any program was deleted, id may be reused
+    std::erase_if(material_tables,
+                  [generation](const material_table& old)
+                  { return old.program_generation != generation; });
+    material_tables.push_back(std::move(table));
+    return material_tables.back();
+}
+
+void mesh::bind_material(shader& shader) const
+{
+    for (const material_binding& binding : get_material_table(shader).bindings)
+    {
+        shader.set_uniform(binding.sampler, *binding.tex, binding.unit);
+    }
+}
+
+std::uint64_t mesh::get_material_key() const
+{
+    // FNV-1a of texture addresses
+    std::uint64_t key = textures.empty() ? 0 : 14695981039346656037ull;
+    for (const texture* tex : textures)
+    {
+        key ^= reinterpret_cast<std::uintptr_t>(tex);
+        key *= 1099511628211ull;
+    }
+    return key;
+}
+
+void mesh::draw(shader& shader) const
+{
+    draw(shader, !disable_textures);
+}
+
+void mesh::draw(shader& shader, bool bind_textures) const
+{
+    shader.use();
+    if (bind_textures)
+    {
+        bind_material(shader);
+    }
+
+    // vertex array stays bound, next draw of same mesh skips binding
+    state_cache::get().bind_vertex_array(vao);
 
     glDrawElements(static_cast<GLenum>(primitive_type),
                    static_cast<signed>(indices.size()),
                    GL_UNSIGNED_INT,
                    nullptr);
-
-    glBindVertexArray(0);
 }
 
 void mesh::draw_instanced(shader&               shader,
@@ -125,56 +192,12 @@ void mesh::draw_instanced(shader&               shader,
                           std::function<void()> bind_custom_data) const
 {
     shader.use();
-    uint32_t diffuse_index  = 0;
-    uint32_t specular_index = 0;
-    uint32_t cubemap_index  = 0;
-    for (uint32_t i = 0; i < textures.size() && !disable_textures; i++)
+    if (!disable_textures)
     {
-        // activate proper texture unit before binding
-        glActiveTexture(GL_TEXTURE0 + i);
-
-        // retrieve texture number (the N in diffuse_textureN)
-        texture& texture = *textures.at(i);
-        texture.bind();
-        texture::type        type = texture.get_type();
-        std::array<char, 32> str{};
-
-        int32_t is_ok = 0;
-
-        if (type == texture::type::diffuse)
-        {
-            is_ok = snprintf(
-                str.data(), str.size(), "tex_diffuse%u", diffuse_index);
-            assert(is_ok > 0);
-            ++diffuse_index;
-        }
-        else if (type == texture::type::specular)
-        {
-            is_ok = snprintf(
-                str.data(), str.size(), "tex_specular%u", specular_index);
-            assert(is_ok > 0);
-            ++specular_index;
-        }
-        else if (type == texture::type::cubemap)
-        {
-            is_ok = snprintf(
-                str.data(), str.size(), "tex_cubemap%u", cubemap_index);
-            assert(is_ok > 0);
-            ++cubemap_index;
-        }
-
-        std::array<char, 64> tex_uniform_name{};
-        is_ok = snprintf(tex_uniform_name.data(),
-                         tex_uniform_name.size(),
-                         "material.%s",
-                         str.data());
-        assert(is_ok > 0);
-
-        shader.set_uniform(tex_uniform_name.data(), static_cast<int32_t>(i));
+        bind_material(shader);
     }
 
-    // draw mesh
-    glBindVertexArray(vao);
+    state_cache::get().bind_vertex_array(vao);
 
     if (bind_custom_data)
     {
@@ -186,8 +209,6 @@ void mesh::draw_instanced(shader&               shader,
                             GL_UNSIGNED_INT,
                             nullptr,
                             static_cast<GLsizei>(instance_count));
-
-    glBindVertexArray(0);
 }
 
 void mesh::setup()
@@ -196,13 +217,27 @@ void mesh::setup()
     assert(ebo == 0);
     assert(vao == 0);
 
+    if (!vertices.empty())
+    {
+        glm::vec3 min = vertices.front().position;
+        glm::vec3 max = min;
+        for (const vertex& v : vertices)
+        {
+            min = glm::min(min, v.position);
+            max = glm::max(max, v.position);
+        }
+        center      = (min + max) * 0.5f;
+        half_extent = max - center;
+        radius      = glm::length(half_extent);
+    }
+
     glGenVertexArrays(1, &vao);
 
     glGenBuffers(1, &vbo);
 
     glGenBuffers(1, &ebo);
 
-    glBindVertexArray(vao);
+    state_cache::get().bind_vertex_array(vao);
 
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
@@ -243,6 +278,7 @@ void mesh::setup()
                           sizeof(vertex),
                           reinterpret_cast<void*>(offsetof(vertex, uv)));
 
-    glBindVertexArray(0);
+    // so later GL_ELEMENT_ARRAY_BUFFER binding can't change this vertex array
+    state_cache::get().bind_vertex_array(0);
 }
 } // namespace gles30
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <vector>
 
@@ -44,6 +45,8 @@ public:
     mesh& operator=(const mesh&) = delete;
 
     void draw(shader& shader) const;
+    /// draw with or without textures, ignores textures_enable/disable
+    void draw(shader& shader, bool bind_textures) const;
     void draw_instanced(shader&               shader,
                         size_t                instance_count,
                         std::function<void()> bind_custom_data) const;
@@ -54,9 +57,35 @@ public:
     void textures_enable();
     void textures_disable();
 
+    /// center of bounding box in model space
+    [[nodiscard]] glm::vec3 get_center() const { return center; }
+    /// radius of sphere around bounding box, centered at get_center()
+    [[nodiscard]] float get_radius() const { return radius; }
+    /// half size of bounding box in model space, centered at get_center()
+    [[nodiscard]] glm::vec3 get_half_extent() const { return half_extent; }
+    /// same for meshes with same textures, 0 - no textures
+    [[nodiscard]] std::uint64_t get_material_key() const;
+
 private:
+    /// texture unit and sampler uniform of every mesh texture for one
+    /// shader, names like material.tex_diffuse0 resolved once
+    struct material_binding
+    {
+        texture*        tex;
+        std::uint32_t   unit;
+        shader::uniform sampler;
+    };
+    struct material_table
+    {
+        std::uint32_t                 program_id;
+        std::uint64_t                 program_generation;
+        std::vector<material_binding> bindings;
+    };
+
     friend void swap(mesh& l, mesh& r) noexcept;
     void        setup();
+    void        bind_material(shader& shader) const;
+    const material_table& get_material_table(const shader& shader) const;
 
     std::vector<vertex>   vertices;
     std::vector<uint32_t> indices;
@@ -69,6 +98,13 @@ private:
     primitive primitive_type{};
 
     bool disable_textures{ false };
+
+    glm::vec3 center{};
+    float     radius{};
+    glm::vec3 half_extent{};
+
+    /// one table per shader used to draw mesh (depth pass, color pass)
+    mutable std::vector<material_table> material_tables;
 };
 
 inline mesh::mesh(std::vector<vertex>   a_vertices,
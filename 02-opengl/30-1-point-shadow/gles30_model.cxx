@@ -1,15 +1,20 @@
 #include "gles30_model.hxx"
 
 #include <algorithm>
+#include <array>
+#include <fstream>
 #include <iostream>
 #include <ranges>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include "gles30_texture_cache.hxx"
+
 namespace gles30
 {
 
@@ -29,46 +34,325 @@ void model::draw_instanced(shader&               shader,
         { m.draw_instanced(shader, instance_count, bind_custom_buffer); });
 }
 
-static void                  process_node(const aiNode*      node,
-                                          const aiScene*     scene,
-                                          std::vector<mesh>& meshes,
-                                          const std::string& directory);
-static mesh                  process_mesh(const aiMesh*      mesh,
-                                          const aiScene*     scene,
-                                          const std::string& directory);
-static std::vector<texture*> load_material_textures(
-    const aiMaterial*  mat,
-    aiTextureType      type,
-    texture::type      type_name,
-    const std::string& directory);
+void model::submit(render_queue& queue, draw_item item) const
+{
+    for (const mesh& m : meshes)
+    {
+        item.geometry = &m;
+        queue.submit(item);
+    }
+}
+
+namespace
+{
+/// texture reference of cooked model, path relative to model directory
+struct texture_ref
+{
+    std::string   path;
+    texture::type type;
+};
+
+struct mesh_data
+{
+    std::vector<vertex>        vertices;
+    std::vector<uint32_t>      indices;
+    std::vector<std::uint32_t> textures; // indexes in model_data::textures
+};
+
+/// CPU side of model, same for assimp import and cooked file
+struct model_data
+{
+    std::vector<texture_ref> textures;
+    std::vector<mesh_data>   meshes;
+    std::vector<model::node> nodes;
+};
+
+constexpr std::array<char, 8> cooked_magic{ 'O', 'M', 'M', 'O',
+                                            'D', 'E', 'L', '1' };
+// change after any change of layout below or of gles30::vertex
+constexpr std::uint32_t cooked_version = 1;
+
+/// source file identity, cooked file ignored if source changed
+struct source_stamp
+{
+    std::uint64_t size       = 0;
+    std::int64_t  write_time = 0;
+
+    bool operator==(const source_stamp&) const = default;
+};
+
+source_stamp get_source_stamp(const std::filesystem::path& path)
+{
+    return { static_cast<std::uint64_t>(std::filesystem::file_size(path)),
+             static_cast<std::int64_t>(std::filesystem::last_write_time(path)
+                                           .time_since_epoch()
+                                           .count()) };
+}
+} // namespace
+
+static void process_node(const aiNode*  node,
+                         const aiScene* scene,
+                         std::int32_t   parent,
+                         model_data&    data);
+static mesh_data process_mesh(const aiMesh*  mesh,
+                              const aiScene* scene,
+                              model_data&    data);
+static std::vector<std::uint32_t> load_material_textures(
+    const aiMaterial* mat,
+    aiTextureType     type,
+    texture::type     type_name,
+    model_data&       data);
+
+template <typename T>
+static void write_pod(std::ostream& out, const T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static void write_array(std::ostream& out, const std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    write_pod(out, static_cast<std::uint32_t>(values.size()));
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+template <typename T>
+static bool read_pod(std::istream& in, T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename T>
+static bool read_array(std::istream& in, std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    // bigger arrays mean broken file, do not try to allocate them
+    constexpr std::uint32_t max_count = 1u << 28u;
+    std::uint32_t           count     = 0;
+    if (!read_pod(in, count) || count > max_count)
+    {
+        return false;
+    }
+    values.resize(count);
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char*>(values.data()),
+                static_cast<std::streamsize>(values.size() * sizeof(T))));
+}
+
+static void write_cooked(const std::filesystem::path& cooked_path,
+                         const source_stamp&          stamp,
+                         const model_data&            data)
+{
+    std::ofstream out(cooked_path, std::ios::binary | std::ios::trunc);
+    write_pod(out, cooked_magic);
+    write_pod(out, cooked_version);
+    write_pod(out, stamp);
+
+    write_pod(out, static_cast<std::uint32_t>(data.textures.size()));
+    for (const texture_ref& ref : data.textures)
+    {
+        write_pod(out, static_cast<std::int32_t>(ref.type));
+        write_array(out, std::vector<char>(ref.path.begin(), ref.path.end()));
+    }
+
+    write_pod(out, static_cast<std::uint32_t>(data.meshes.size()));
+    for (const mesh_data& m : data.meshes)
+    {
+        write_array(out, m.vertices);
+        write_array(out, m.indices);
+        write_array(out, m.textures);
+    }
+
+    write_array(out, data.nodes);
+
+    if (!out)
+    {
+        // not fatal, next launch imports source again
+        std::clog << "warning: can't write cooked model: " << cooked_path
+                  << std::endl;
+        out.close();
+        std::error_code ignore;
+        std::filesystem::remove(cooked_path, ignore);
+    }
+}
+
+static bool read_cooked(const std::filesystem::path& cooked_path,
+                        const source_stamp&          stamp,
+                        model_data&                  data)
+{
+    std::ifstream in(cooked_path, std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+
+    std::array<char, 8> magic{};
+    std::uint32_t       version = 0;
+    source_stamp        cooked_stamp;
+    if (!read_pod(in, magic) || magic != cooked_magic ||
+        !read_pod(in, version) || version != cooked_version ||
+        !read_pod(in, cooked_stamp) || cooked_stamp != stamp)
+    {
+        return false;
+    }
+
+    std::uint32_t texture_count = 0;
+    if (!read_pod(in, texture_count))
+    {
+        return false;
+    }
+    data.textures.resize(texture_count);
+    for (texture_ref& ref : data.textures)
+    {
+        std::int32_t      type = 0;
+        std::vector<char> path;
+        // model textures are diffuse or specular only, other value would
+        // throw from texture constructor instead of import from source
+        if (!read_pod(in, type) || !read_array(in, path) ||
+            (type != static_cast<std::int32_t>(texture::type::diffuse) &&
+             type != static_cast<std::int32_t>(texture::type::specular)))
+        {
+            return false;
+        }
+        ref.type = static_cast<texture::type>(type);
+        ref.path.assign(path.begin(), path.end());
+    }
+
+    std::uint32_t mesh_count = 0;
+    if (!read_pod(in, mesh_count))
+    {
+        return false;
+    }
+    data.meshes.resize(mesh_count);
+    for (mesh_data& m : data.meshes)
+    {
+        if (!read_array(in, m.vertices) || !read_array(in, m.indices) ||
+            !read_array(in, m.textures))
+        {
+            return false;
+        }
+        if (std::ranges::any_of(m.textures,
+                                [&](std::uint32_t index)
+                                { return index >= data.textures.size(); }))
+        {
+            return false;
+        }
+        // GPU would read vertex buffer out of bounds
+        if (std::ranges::any_of(m.indices,
+                                [&](std::uint32_t index)
+                                { return index >= m.vertices.size(); }))
+        {
+            return false;
+        }
+    }
+
+    if (!read_array(in, data.nodes))
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < data.nodes.size(); ++i)
+    {
+        // parent written before child, meshes of node inside meshes
+        const model::node& n = data.nodes[i];
+        if (n.parent >= static_cast<std::int64_t>(i) || n.parent < -1 ||
+            std::uint64_t{ n.first_mesh } + n.mesh_count > data.meshes.size())
+        {
+            return false;
+        }
+    }
+    // trailing data - file written by other code, not trusted
+    return in.peek() == std::ifstream::traits_type::eof();
+}
 
 void model::load_model(std::string_view path)
 {
     std::string path_to_file{ path };
 
-    Assimp::Importer importer;
-    const aiScene*   scene = importer.ReadFile(
-        path_to_file, aiProcess_Triangulate | aiProcess_FlipUVs);
+    directory = path.substr(0, path.find_last_of('/'));
+
+    const source_stamp          stamp = get_source_stamp(path_to_file);
+    const std::filesystem::path cooked_path{ path_to_file + ".cooked" };
 
-    if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
-        scene->mRootNode == nullptr)
+    model_data data;
+    if (!read_cooked(cooked_path, stamp, data))
     {
-        std::stringstream ss;
-        ss << "error: assimp loading model[" << path
-           << "] failed: " << importer.GetErrorString() << std::endl;
-        throw std::runtime_error(ss.str());
+        data = {};
+
+        Assimp::Importer importer;
+        const aiScene*   scene = importer.ReadFile(
+            path_to_file, aiProcess_Triangulate | aiProcess_FlipUVs);
+
+        if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
+            scene->mRootNode == nullptr)
+        {
+            std::stringstream ss;
+            ss << "error: assimp loading model[" << path
+               << "] failed: " << importer.GetErrorString() << std::endl;
+            throw std::runtime_error(ss.str());
+        }
+
+        process_node(scene->mRootNode, scene, -1, data);
+
+        write_cooked(cooked_path, stamp, data);
     }
 
-    directory = path.substr(0, path.find_last_of('/'));
+    // every unique image decoded once, even if used by other models,
+    // model drawn with placeholders while images stream in
+    textures.reserve(data.textures.size());
+    for (const texture_ref& ref : data.textures)
+    {
+        std::filesystem::path texture_file_path{ directory };
+        texture_file_path /= ref.path;
+        textures.push_back(texture_cache::get().acquire(
+            texture_file_path, ref.type, texture::loading::streamed));
+    }
 
-    process_node(scene->mRootNode, scene, meshes, directory);
+    meshes.reserve(data.meshes.size());
+    for (mesh_data& m : data.meshes)
+    {
+        std::vector<texture*> mesh_textures;
+        mesh_textures.reserve(m.textures.size());
+        for (std::uint32_t index : m.textures)
+        {
+            mesh_textures.push_back(textures[index].get());
+        }
+        meshes.emplace_back(std::move(m.vertices),
+                            std::move(m.indices),
+                            std::move(mesh_textures));
+    }
+
+    nodes = std::move(data.nodes);
 }
 
-static void process_node(const aiNode*      node,
-                         const aiScene*     scene,
-                         std::vector<mesh>& meshes,
-                         const std::string& directory)
+static void process_node(const aiNode*  node,
+                         const aiScene* scene,
+                         std::int32_t   parent,
+                         model_data&    data)
 {
+    // assimp matrices are row major, glm column major
+    const aiMatrix4x4& m = node->mTransformation;
+    glm::mat4          transform{};
+    for (unsigned row = 0; row < 4; ++row)
+    {
+        for (unsigned col = 0; col < 4; ++col)
+        {
+            transform[col][row] = m[row][col];
+        }
+    }
+    model::node cooked_node{
+        .transform  = transform,
+        .parent     = parent,
+        .first_mesh = static_cast<std::uint32_t>(data.meshes.size()),
+        .mesh_count = node->mNumMeshes,
+    };
+    const auto node_index = static_cast<std::int32_t>(data.nodes.size());
+    data.nodes.push_back(cooked_node);
+
     // process all the node's meshes (if any)
     auto begin_mesh = &node->mMeshes[0];
     auto end_mesh   = begin_mesh + node->mNumMeshes;
@@ -78,9 +362,8 @@ static void process_node(const aiNode*      node,
                   [&](auto mesh_index)
                   {
                       const aiMesh* assimp_mesh = scene->mMeshes[mesh_index];
-                      gles30::mesh  mesh =
-                          process_mesh(assimp_mesh, scene, directory);
-                      meshes.push_back(std::move(mesh));
+                      data.meshes.push_back(
+                          process_mesh(assimp_mesh, scene, data));
                   });
 
     auto beg_child = &node->mChildren[0];
@@ -89,17 +372,19 @@ static void process_node(const aiNode*      node,
     std::for_each(beg_child,
                   end_child,
                   [&](aiNode* sub_node)
-                  { process_node(sub_node, scene, meshes, directory); });
+                  { process_node(sub_node, scene, node_index, data); });
 }
 
-static mesh process_mesh(const aiMesh*      mesh,
-                         const aiScene*     scene,
-                         const std::string& directory)
+static mesh_data process_mesh(const aiMesh*  mesh,
+                              const aiScene* scene,
+                              model_data&    data)
 {
     assert(mesh != nullptr);
     assert(scene != nullptr);
 
-    std::vector<vertex> vertices;
+    mesh_data result;
+
+    std::vector<vertex>& vertices = result.vertices;
     vertices.reserve(mesh->mNumVertices);
 
     for (size_t i = 0; i < mesh->mNumVertices; ++i)
@@ -131,7 +416,7 @@ static mesh process_mesh(const aiMesh*      mesh,
     }
 
     // process indices
-    std::vector<uint32_t> indices;
+    std::vector<uint32_t>& indices = result.indices;
 
     indices.reserve(static_cast<std::vector<uint32_t>::size_type>(3) *
                     mesh->mNumFaces);
@@ -145,38 +430,35 @@ static mesh process_mesh(const aiMesh*      mesh,
         }
     }
 
-    std::vector<texture*> textures;
     // process material
     if (mesh->mMaterialIndex > 0)
     {
         const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
         assert(material != nullptr);
 
-        std::vector<texture*> diffuse_maps = load_material_textures(
-            material, aiTextureType_DIFFUSE, texture::type::diffuse, directory);
+        std::vector<std::uint32_t> diffuse_maps = load_material_textures(
+            material, aiTextureType_DIFFUSE, texture::type::diffuse, data);
 
-        std::vector<texture*> specular_maps =
-            load_material_textures(material,
-                                   aiTextureType_SPECULAR,
-                                   texture::type::specular,
-                                   directory);
+        std::vector<std::uint32_t> specular_maps = load_material_textures(
+            material, aiTextureType_SPECULAR, texture::type::specular, data);
 
-        textures.reserve(diffuse_maps.size() + specular_maps.size());
-        textures.insert(end(textures), begin(diffuse_maps), end(diffuse_maps));
-        textures.insert(
-            end(textures), begin(specular_maps), end(specular_maps));
+        result.textures.reserve(diffuse_maps.size() + specular_maps.size());
+        result.textures.insert(
+            end(result.textures), begin(diffuse_maps), end(diffuse_maps));
+        result.textures.insert(
+            end(result.textures), begin(specular_maps), end(specular_maps));
     }
 
-    return { std::move(vertices), std::move(indices), std::move(textures) };
+    return result;
 }
 
-std::vector<texture*> load_material_textures(const aiMaterial*  mat,
-                                             aiTextureType      type,
-                                             texture::type      type_name,
-                                             const std::string& directory)
+std::vector<std::uint32_t> load_material_textures(const aiMaterial* mat,
+                                                  aiTextureType     type,
+                                                  texture::type     type_name,
+                                                  model_data&       data)
 {
-    std::vector<texture*> textures;
-    size_t                count = mat->GetTextureCount(type);
+    std::vector<std::uint32_t> textures;
+    size_t                     count = mat->GetTextureCount(type);
     textures.reserve(count);
     for (unsigned int i = 0; i < count; i++)
     {
@@ -184,11 +466,20 @@ std::vector<texture*> load_material_textures(const aiMaterial*  mat,
         aiReturn isOk = mat->GetTexture(type, i, &str);
         assert(isOk == aiReturn_SUCCESS);
 
-        std::filesystem::path texture_file_path{ directory };
-        texture_file_path /= str.C_Str();
-
-        auto* tex = new gles30::texture(texture_file_path, type_name);
-        textures.push_back(tex);
+        // materials often share same image, keep one reference for it
+        const std::string_view path = str.C_Str();
+        auto it = std::find_if(
+            data.textures.begin(),
+            data.textures.end(),
+            [&](const texture_ref& ref)
+            { return ref.path == path && ref.type == type_name; });
+        if (it == data.textures.end())
+        {
+            it = data.textures.insert(data.textures.end(),
+                                      { std::string(path), type_name });
+        }
+        textures.push_back(
+            static_cast<std::uint32_t>(it - data.textures.begin()));
     }
     return textures;
 }
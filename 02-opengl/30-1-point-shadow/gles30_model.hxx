@@ -1,24 +1,52 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+
 #include "gles30_mesh.hxx"
+#include "gles30_render_queue.hxx"
 
 namespace gles30
 {
 
+/// Model imported with assimp on first load and saved next to source as
+/// cooked binary file (path + ".cooked"): meshes, material references and
+/// node transforms. Next loads read cooked file if source not changed and
+/// skip assimp. Textures shared through texture_cache.
 class model
 {
 public:
+    /// node of source scene, meshes of node are
+    /// meshes[first_mesh, first_mesh + mesh_count)
+    struct node
+    {
+        glm::mat4     transform; ///< relative to parent
+        std::int32_t  parent;    ///< -1 for root
+        std::uint32_t first_mesh;
+        std::uint32_t mesh_count;
+    };
+
     explicit model(std::string_view path) { load_model(path); }
     void draw(shader& shader) const;
     void draw_instanced(shader&               shader,
                         size_t                instance_count,
                         std::function<void()> bind_custom_buffer) const;
+    /// submit every mesh as item, so meshes sorted with rest of frame
+    void submit(render_queue& queue, draw_item item) const;
+
+    [[nodiscard]] const std::vector<node>& get_nodes() const { return nodes; }
+    [[nodiscard]] const std::vector<mesh>& get_meshes() const
+    {
+        return meshes;
+    }
 
 private:
     void load_model(std::string_view path);
 
-    std::vector<mesh> meshes;
-    std::string       directory;
+    std::vector<mesh>                     meshes;
+    std::vector<node>                     nodes;
+    std::vector<std::shared_ptr<texture>> textures; // used by meshes
+    std::string                           directory;
 };
 
 } // namespace gles30
@@ -0,0 +1,259 @@
+#include "gles30_occlusion.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gles30_state.hxx"
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+/// boxes a bit bigger than geometry, so box of visible object never
+/// fails depth test against object itself (same depth, other rounding)
+static constexpr float box_margin = 0.02f;
+
+occlusion_culler::occlusion_culler(std::uint32_t visible_interval_) noexcept(
+    false)
+    : visible_interval{ std::max(visible_interval_, 1u) }
+    , program{ "res/occlusion_box.vert", "res/occlusion_box.frag" }
+{
+    box_matrix = program.get_uniform("box_matrix");
+
+    // corner i: x, y, z from bits 0, 1, 2
+    std::array<glm::vec3, 8> corners;
+    for (std::size_t i = 0; i < corners.size(); ++i)
+    {
+        corners[i] = glm::vec3(i & 1 ? 1.f : -1.f,
+                               i & 2 ? 1.f : -1.f,
+                               i & 4 ? 1.f : -1.f);
+    }
+    // no face culling, winding does not matter
+    static constexpr std::array<std::uint8_t, 36> indices{
+        0, 2, 6, 0, 6, 4, // -x
+        1, 5, 7, 1, 7, 3, // +x
+        0, 4, 5, 0, 5, 1, // -y
+        2, 3, 7, 2, 7, 6, // +y
+        0, 1, 3, 0, 3, 2, // -z
+        4, 6, 7, 4, 7, 5  // +z
+    };
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+
+    state_cache& state = state_cache::get();
+    state.bind_vertex_array(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 sizeof(corners),
+                 corners.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 sizeof(indices),
+                 indices.data(),
+                 GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+
+    state.bind_vertex_array(0);
+}
+
+occlusion_culler::~occlusion_culler()
+{
+    for (object& o : objects)
+    {
+        glDeleteQueries(1, &o.query);
+    }
+    state_cache::get().on_delete_vertex_array(vao);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+}
+
+occlusion_culler::object_id occlusion_culler::add_object(
+    const mesh& geometry, const glm::mat4& transform)
+{
+    const glm::vec3 center = geometry.get_center();
+    const glm::vec3 half   = geometry.get_half_extent();
+    return add_box(center - half, center + half, transform);
+}
+
+occlusion_culler::object_id occlusion_culler::add_object(
+    const model& geometry, const glm::mat4& transform)
+{
+    const std::vector<mesh>& meshes = geometry.get_meshes();
+    if (meshes.empty())
+    {
+        return add_box(glm::vec3(0.f), glm::vec3(0.f), transform);
+    }
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    for (const mesh& m : meshes)
+    {
+        min = glm::min(min, m.get_center() - m.get_half_extent());
+        max = glm::max(max, m.get_center() + m.get_half_extent());
+    }
+    return add_box(min, max, transform);
+}
+
+occlusion_culler::object_id occlusion_culler::add_box(
+    const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform)
+{
+    object o{};
+    o.local_center = (min + max) * 0.5f;
+    o.local_half   = max - o.local_center;
+    glGenQueries(1, &o.query);
+    objects.push_back(o);
+
+    const auto id = static_cast<object_id>(objects.size() - 1);
+    move_object(id, transform);
+    return id;
+}
+
+void occlusion_culler::move_object(object_id id, const glm::mat4& transform)
+{
+    object& o = objects.at(id);
+    o.center  = glm::vec3(transform * glm::vec4(o.local_center, 1.f));
+    // box around transformed box: every axis of result gets projections
+    // of all local axes
+    for (int row = 0; row < 3; ++row)
+    {
+        o.half[row] = std::abs(transform[0][row]) * o.local_half.x +
+                      std::abs(transform[1][row]) * o.local_half.y +
+                      std::abs(transform[2][row]) * o.local_half.z;
+    }
+}
+
+void occlusion_culler::begin_frame()
+{
+    ++frame;
+    stats.occluded = 0;
+    stats.pending  = 0;
+    if (!enabled)
+    {
+        return;
+    }
+
+    for (object& o : objects)
+    {
+        if (o.pending)
+        {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(o.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_TRUE)
+            {
+                GLuint passed = GL_FALSE;
+                glGetQueryObjectuiv(o.query, GL_QUERY_RESULT, &passed);
+                o.visible = passed != GL_FALSE;
+                o.pending = false;
+            }
+            else
+            {
+                ++stats.pending;
+            }
+        }
+        if (!o.visible)
+        {
+            ++stats.occluded;
+        }
+    }
+}
+
+bool occlusion_culler::is_due(const object& o, object_id id) const
+{
+    if (o.pending)
+    {
+        return false;
+    }
+    // occluded every frame: only way to become visible again
+    return !o.visible || (frame + id) % visible_interval == 0;
+}
+
+void occlusion_culler::issue_queries(const glm::mat4& projection_view,
+                                     const glm::vec3& eye,
+                                     float            near_plane)
+{
+    stats.queries = 0;
+    if (!enabled)
+    {
+        return;
+    }
+
+    state_cache& state = state_cache::get();
+    bool         begun = false;
+    // depth and color writes of caller, set back after boxes
+    bool          color_mask = true;
+    bool          depth_mask = true;
+    std::uint32_t depth_func = GL_LESS;
+    for (object_id id = 0; id < objects.size(); ++id)
+    {
+        object& o = objects[id];
+        if (!is_due(o, id))
+        {
+            continue;
+        }
+        // near plane corners are at most 2 * near_plane from eye for fovy
+        // and aspect samples use, box there may be cut by near plane
+        const glm::vec3 distance = glm::abs(eye - o.center);
+        if (glm::all(glm::lessThanEqual(distance, o.half + 2.f * near_plane)))
+        {
+            o.visible = true;
+            continue;
+        }
+
+        if (!begun)
+        {
+            begun      = true;
+            color_mask = state.get_color_mask();
+            depth_mask = state.get_depth_mask();
+            depth_func = state.get_depth_func();
+            program.use();
+            state.bind_vertex_array(vao);
+            state.disable(GL_CULL_FACE);
+            state.enable(GL_DEPTH_TEST);
+            state.color_mask(false);
+            state.depth_mask(false);
+            state.depth_func(GL_LEQUAL);
+        }
+
+        glm::mat4 box = glm::translate(projection_view, o.center);
+        box           = glm::scale(box, o.half * (1.f + box_margin));
+        program.set_uniform(box_matrix, box);
+
+        glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, o.query);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, nullptr);
+        glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+
+        o.pending = true;
+        ++stats.queries;
+    }
+
+    if (begun)
+    {
+        state.color_mask(color_mask);
+        state.depth_mask(depth_mask);
+        state.depth_func(depth_func);
+    }
+}
+
+void occlusion_culler::set_enabled(bool value)
+{
+    if (value && !enabled)
+    {
+        // results of old queries may be frames old, start from visible
+        for (object& o : objects)
+        {
+            o.visible = true;
+        }
+    }
+    enabled = value;
+}
+
+} // namespace gles30
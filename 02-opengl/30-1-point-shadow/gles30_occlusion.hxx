@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gles30_mesh.hxx"
+#include "gles30_model.hxx"
+#include "gles30_shader.hxx"
+
+namespace gles30
+{
+
+/// Skips objects hidden behind already drawn geometry. After frame drawn
+/// issue_queries() draws bounding boxes of objects (no color, no depth
+/// write) inside GL_ANY_SAMPLES_PASSED_CONSERVATIVE queries. Results read
+/// in later frames only if GPU has them, CPU never waits for GPU, so
+/// object appears one or two frames after it becomes visible.
+/// Temporal coherence: occluded object not drawn and tested every frame
+/// until query passes; visible object drawn and tested again only every
+/// visible_interval frames (tests of objects spread over frames).
+class occlusion_culler
+{
+public:
+    using object_id = std::uint32_t;
+
+    struct counters
+    {
+        std::uint32_t queries  = 0; ///< boxes drawn by last issue_queries()
+        std::uint32_t occluded = 0; ///< objects skipped in last frame
+        std::uint32_t pending  = 0; ///< queries without result yet
+    };
+
+    explicit occlusion_culler(std::uint32_t visible_interval = 8) noexcept(
+        false);
+    ~occlusion_culler();
+    occlusion_culler(const occlusion_culler&)            = delete;
+    occlusion_culler& operator=(const occlusion_culler&) = delete;
+
+    /// bounding box of geometry moved by transform, new object visible
+    object_id add_object(const mesh& geometry, const glm::mat4& transform);
+    /// one box around all meshes of geometry
+    object_id add_object(const model& geometry, const glm::mat4& transform);
+    void      move_object(object_id object, const glm::mat4& transform);
+
+    /// read available query results, call once per frame before
+    /// is_visible()
+    void begin_frame();
+    /// false - object was occluded, do not draw it this frame
+    [[nodiscard]] bool is_visible(object_id object) const
+    {
+        return !enabled || objects.at(object).visible;
+    }
+    /// call after opaque geometry drawn with depth test and depth write,
+    /// same framebuffer and viewport. near_plane - of projection, boxes
+    /// cut by it never pass, objects around eye always visible. Color and
+    /// depth writes and depth function set back to values of caller
+    void issue_queries(const glm::mat4& projection_view,
+                       const glm::vec3& eye,
+                       float            near_plane);
+
+    /// disabled - every object visible, no queries
+    void               set_enabled(bool value);
+    [[nodiscard]] bool is_enabled() const { return enabled; }
+    [[nodiscard]] const counters& get_counters() const { return stats; }
+
+private:
+    struct object
+    {
+        glm::vec3     local_center; ///< bounding box in model space
+        glm::vec3     local_half;
+        glm::vec3     center; ///< bounding box in world space
+        glm::vec3     half;
+        std::uint32_t query   = 0;
+        bool          pending = false; ///< query without result
+        bool          visible = true;
+    };
+
+    object_id add_box(const glm::vec3& min,
+                      const glm::vec3& max,
+                      const glm::mat4& transform);
+    /// object needs new query this frame
+    [[nodiscard]] bool is_due(const object& o, object_id id) const;
+
+    std::uint32_t visible_interval;
+    std::uint32_t frame   = 0;
+    bool          enabled = true;
+
+    std::vector<object> objects;
+
+    /// unit cube [-1, 1], 36 indices
+    std::uint32_t vao = 0;
+    std::uint32_t vbo = 0;
+    std::uint32_t ebo = 0;
+
+    shader          program;
+    shader::uniform box_matrix;
+
+    counters stats;
+};
+
+} // namespace gles30
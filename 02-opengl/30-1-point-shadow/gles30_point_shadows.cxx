@@ -0,0 +1,467 @@
+#include "gles30_point_shadows.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <numbers>
+
+#include "gles30_state.hxx"
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+point_shadows::point_shadows(std::uint32_t resolution_,
+                             float         near_plane_,
+                             float         far_plane_) noexcept(false)
+    : resolution{ resolution_ }
+    , near_plane{ near_plane_ }
+    , far_plane{ far_plane_ }
+    , face_program{ "res/point_shadow.vert", "res/point_shadow.frag" }
+{
+    face_uniforms.model       = face_program.get_uniform("model");
+    face_uniforms.face_matrix = face_program.get_uniform("face_matrix");
+    face_uniforms.light_pos   = face_program.get_uniform("light_pos");
+    face_uniforms.far_plane   = face_program.get_uniform("far_plane");
+
+    // glFramebufferTexture is GLES 3.2, loader leaves it null if missing
+    if (glFramebufferTexture != nullptr)
+    {
+        try
+        {
+            layered_program.emplace("res/point_shadow_layered.vert",
+                                    "res/point_shadow.geom",
+                                    "res/point_shadow.frag");
+            shader& program            = *layered_program;
+            layered_uniforms.model     = program.get_uniform("model");
+            layered_uniforms.face_mask = program.get_uniform("face_mask");
+            for (std::size_t face = 0; face < 6; ++face)
+            {
+                layered_uniforms.face_matrices[face] = program.get_uniform(
+                    "face_matrices[" + std::to_string(face) + "]");
+            }
+            layered_uniforms.light_pos = program.get_uniform("light_pos");
+            layered_uniforms.far_plane = program.get_uniform("far_plane");
+            use_layered                = true;
+        }
+        catch (const std::exception& ex)
+        {
+            layered_program.reset();
+            std::clog << "point shadows: no geometry shader, pass per face\n"
+                      << ex.what() << std::endl;
+        }
+    }
+
+    // depth only framebuffers
+    const GLenum none = GL_NONE;
+    for (std::uint32_t* framebuffer : { &fbo, &copy_fbo })
+    {
+        glGenFramebuffers(1, framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, *framebuffer);
+        glDrawBuffers(1, &none);
+        glReadBuffer(GL_NONE);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+point_shadows::~point_shadows()
+{
+    state_cache& state = state_cache::get();
+    for (light& l : lights)
+    {
+        for (std::uint32_t* cubemap : { &l.static_map, &l.map })
+        {
+            if (*cubemap != 0)
+            {
+                state.on_delete_texture(*cubemap);
+                glDeleteTextures(1, cubemap);
+            }
+        }
+    }
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteFramebuffers(1, &copy_fbo);
+}
+
+std::uint32_t point_shadows::create_cubemap() const
+{
+    std::uint32_t cubemap = 0;
+    glGenTextures(1, &cubemap);
+    state_cache::get().bind_texture(GL_TEXTURE_CUBE_MAP, cubemap);
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP,
+                   1,
+                   GL_DEPTH_COMPONENT24,
+                   static_cast<GLsizei>(resolution),
+                   static_cast<GLsizei>(resolution));
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return cubemap;
+}
+
+std::array<glm::mat4, 6> cube_face_matrices(const glm::vec3& position,
+                                            float            near_plane,
+                                            float            far_plane)
+{
+    static const std::array<std::pair<glm::vec3, glm::vec3>, 6> directions{
+        { { { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } },
+          { { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } },
+          { { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+          { { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+          { { 0.0f, 0.0f, 1.0f }, { 0.0f, -1.0f, 0.0f } },
+          { { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f } } }
+    };
+
+    const glm::mat4 projection =
+        glm::perspective(glm::radians(90.0f), 1.0f, near_plane, far_plane);
+    std::array<glm::mat4, 6> matrices;
+    for (std::size_t face = 0; face < 6; ++face)
+    {
+        const auto& [direction, up] = directions[face];
+        matrices[face] =
+            projection * glm::lookAt(position, position + direction, up);
+    }
+    return matrices;
+}
+
+std::uint8_t cube_face_mask(const glm::vec3& position,
+                            float            far_plane,
+                            const glm::vec3& center,
+                            float            radius)
+{
+    const glm::vec3 p = center - position;
+    const float     r = radius;
+
+    if (glm::length(p) - r > far_plane)
+    {
+        return 0;
+    }
+    if (glm::dot(p, p) <= r * r)
+    {
+        return 0b11'1111; // position inside sphere
+    }
+
+    // face +X is pyramid x >= |y|, x >= |z|: sphere touches it if it is
+    // not fully outside of any plane x = |y|, x = |z| (normal length sqrt2)
+    const float  r_plane = r * std::numbers::sqrt2_v<float>;
+    std::uint8_t mask    = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float b = std::abs(p[(axis + 1) % 3]);
+        const float c = std::abs(p[(axis + 2) % 3]);
+        for (int negative = 0; negative < 2; ++negative)
+        {
+            const float a = negative != 0 ? -p[axis] : p[axis];
+            if (a - b >= -r_plane && a - c >= -r_plane)
+            {
+                mask |= static_cast<std::uint8_t>(1u << (axis * 2 + negative));
+            }
+        }
+    }
+    return mask;
+}
+
+void bounding_sphere(const mesh&      geometry,
+                     const glm::mat4& model,
+                     glm::vec3&       center,
+                     float&           radius)
+{
+    center = glm::vec3(model * glm::vec4(geometry.get_center(), 1.0f));
+    const float scale = std::max({ glm::length(glm::vec3(model[0])),
+                                   glm::length(glm::vec3(model[1])),
+                                   glm::length(glm::vec3(model[2])) });
+    radius            = geometry.get_radius() * scale;
+}
+
+void point_shadows::update_face_matrices(light& l) const
+{
+    l.face_matrices = cube_face_matrices(l.position, near_plane, far_plane);
+}
+
+std::uint8_t point_shadows::face_mask(const light&  l,
+                                      const caster& object) const
+{
+    return cube_face_mask(l.position, far_plane, object.center, object.radius);
+}
+
+void point_shadows::mark_dirty(const caster& c)
+{
+    for (light& l : lights)
+    {
+        const std::uint8_t mask = face_mask(l, c);
+        if (c.type == mobility::static_caster)
+        {
+            l.static_dirty |= mask;
+        }
+        else
+        {
+            l.dirty |= mask;
+        }
+    }
+}
+
+point_shadows::light_id point_shadows::add_light(const glm::vec3& position)
+{
+    light l{};
+    l.position = position;
+    update_face_matrices(l);
+    l.static_map = create_cubemap();
+    if (has_dynamic)
+    {
+        l.map = create_cubemap();
+    }
+    lights.push_back(l);
+    return static_cast<light_id>(lights.size() - 1);
+}
+
+void point_shadows::move_light(light_id id, const glm::vec3& position)
+{
+    light& l = lights.at(id);
+    if (l.position == position)
+    {
+        return;
+    }
+    l.position = position;
+    update_face_matrices(l);
+    l.static_dirty = all_faces;
+}
+
+point_shadows::caster_id point_shadows::add_caster(const mesh&      geometry,
+                                                   const glm::mat4& model,
+                                                   mobility         type)
+{
+    caster c{ &geometry, model, {}, 0.0f, type };
+    bounding_sphere(geometry, model, c.center, c.radius);
+
+    if (type == mobility::dynamic_caster && !has_dynamic)
+    {
+        // from now lights sample map, not static_map
+        has_dynamic = true;
+        for (light& l : lights)
+        {
+            l.map   = create_cubemap();
+            l.dirty = all_faces;
+        }
+    }
+
+    casters.push_back(c);
+    mark_dirty(c);
+    return static_cast<caster_id>(casters.size() - 1);
+}
+
+void point_shadows::move_caster(caster_id id, const glm::mat4& model)
+{
+    caster& c = casters.at(id);
+    if (c.model == model)
+    {
+        return;
+    }
+    mark_dirty(c); // faces it leaves
+    c.model = model;
+    bounding_sphere(*c.geometry, model, c.center, c.radius);
+    mark_dirty(c); // faces it enters
+}
+
+void point_shadows::set_layered(bool value)
+{
+    use_layered = value && layered_program.has_value();
+}
+
+void point_shadows::bind_cubemap(light_id id, std::uint32_t unit) const
+{
+    const light& l = lights.at(id);
+    state_cache::get().bind_texture(
+        unit, GL_TEXTURE_CUBE_MAP, l.map != 0 ? l.map : l.static_map);
+}
+
+void point_shadows::restore_static(const light& l, std::uint8_t faces)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, copy_fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    const auto size = static_cast<GLint>(resolution);
+    for (std::uint32_t face = 0; face < 6; ++face)
+    {
+        if ((faces & (1u << face)) == 0)
+        {
+            continue;
+        }
+        const GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER,
+                               GL_DEPTH_ATTACHMENT,
+                               target,
+                               l.static_map,
+                               0);
+        glFramebufferTexture2D(
+            GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target, l.map, 0);
+        glBlitFramebuffer(0,
+                          0,
+                          size,
+                          size,
+                          0,
+                          0,
+                          size,
+                          size,
+                          GL_DEPTH_BUFFER_BIT,
+                          GL_NEAREST);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void point_shadows::render(const light&  l,
+                           std::uint32_t cubemap,
+                           std::uint8_t  faces,
+                           mobility      type,
+                           bool          clear)
+{
+    caster_faces.resize(casters.size());
+    std::transform(casters.begin(),
+                   casters.end(),
+                   caster_faces.begin(),
+                   [&](const caster& c)
+                   {
+                       return c.type == type ? face_mask(l, c) & faces : 0;
+                   });
+
+    // glClear clears every layer, so partial clear needs pass per face
+    if (use_layered && (!clear || faces == all_faces))
+    {
+        render_layered(l, cubemap, clear);
+    }
+    else
+    {
+        render_per_face(l, cubemap, faces, clear);
+    }
+}
+
+void point_shadows::render_per_face(const light&  l,
+                                    std::uint32_t cubemap,
+                                    std::uint8_t  faces,
+                                    bool          clear)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    face_program.use();
+    face_program.set_uniform(face_uniforms.light_pos, l.position);
+    face_program.set_uniform(face_uniforms.far_plane, far_plane);
+
+    for (std::uint32_t face = 0; face < 6; ++face)
+    {
+        const std::uint32_t bit = 1u << face;
+        if ((faces & bit) == 0)
+        {
+            continue;
+        }
+        glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               cubemap,
+                               0);
+        ++stats.passes;
+        if (clear)
+        {
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+        face_program.set_uniform(face_uniforms.face_matrix,
+                                 l.face_matrices[face]);
+
+        for (std::size_t i = 0; i < casters.size(); ++i)
+        {
+            if ((caster_faces[i] & bit) == 0)
+            {
+                continue; // culled for face or other type
+            }
+            face_program.set_uniform(face_uniforms.model, casters[i].model);
+            casters[i].geometry->draw(face_program, false);
+            ++stats.draws;
+        }
+    }
+}
+
+void point_shadows::render_layered(const light&  l,
+                                   std::uint32_t cubemap,
+                                   bool          clear)
+{
+    shader& program = *layered_program;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cubemap, 0);
+    ++stats.passes;
+    if (clear)
+    {
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    program.use();
+    program.set_uniform(layered_uniforms.light_pos, l.position);
+    program.set_uniform(layered_uniforms.far_plane, far_plane);
+    for (std::size_t face = 0; face < 6; ++face)
+    {
+        program.set_uniform(layered_uniforms.face_matrices[face],
+                            l.face_matrices[face]);
+    }
+
+    for (std::size_t i = 0; i < casters.size(); ++i)
+    {
+        if (caster_faces[i] == 0)
+        {
+            continue;
+        }
+        // geometry shader emits triangle only to faces of mask
+        program.set_uniform(layered_uniforms.face_mask,
+                            static_cast<std::int32_t>(caster_faces[i]));
+        program.set_uniform(layered_uniforms.model, casters[i].model);
+        casters[i].geometry->draw(program, false);
+        ++stats.draws;
+    }
+}
+
+void point_shadows::update()
+{
+    stats = {};
+
+    const bool nothing_changed =
+        std::none_of(lights.begin(),
+                     lights.end(),
+                     [](const light& l)
+                     { return l.static_dirty != 0 || l.dirty != 0; });
+    if (nothing_changed)
+    {
+        return;
+    }
+
+    state_cache& state = state_cache::get();
+    state.enable(GL_DEPTH_TEST);
+    // floor is one quad, front face culling would lose its shadow
+    state.disable(GL_CULL_FACE);
+    glViewport(0,
+               0,
+               static_cast<GLsizei>(resolution),
+               static_cast<GLsizei>(resolution));
+
+    for (light& l : lights)
+    {
+        if (l.static_dirty != 0)
+        {
+            render(l,
+                   l.static_map,
+                   l.static_dirty,
+                   mobility::static_caster,
+                   true);
+            stats.static_faces += std::popcount(l.static_dirty);
+            l.dirty |= l.static_dirty;
+            l.static_dirty = 0;
+        }
+        if (l.map != 0 && l.dirty != 0)
+        {
+            restore_static(l, l.dirty);
+            render(l, l.map, l.dirty, mobility::dynamic_caster, false);
+            stats.dynamic_faces += std::popcount(l.dirty);
+        }
+        l.dirty = 0;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+} // namespace gles30
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gles30_mesh.hxx"
+#include "gles30_shader.hxx"
+
+namespace gles30
+{
+
+/// projection * view of cubemap faces around position, same order and up
+/// vectors as GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+[[nodiscard]] std::array<glm::mat4, 6> cube_face_matrices(
+    const glm::vec3& position, float near_plane, float far_plane);
+
+/// faces of cubemap around position sphere is visible in, bit per face
+[[nodiscard]] std::uint8_t cube_face_mask(const glm::vec3& position,
+                                          float            far_plane,
+                                          const glm::vec3& center,
+                                          float            radius);
+
+/// world space bounding sphere of mesh moved by model
+void bounding_sphere(const mesh&      geometry,
+                     const glm::mat4& model,
+                     glm::vec3&       center,
+                     float&           radius);
+
+/// Depth cubemaps of point lights, value is distance to light / far plane.
+/// Casters registered once and moved with move_caster(). Static casters
+/// rendered to cached cubemap of light, only again if light moves (or
+/// static caster moves). Faces touched by moved dynamic caster restored
+/// from cache and dynamic casters drawn over it. Nothing moved - update()
+/// renders nothing. Every caster culled per face by bounding sphere. If GL
+/// has geometry shaders and layered framebuffers (ES 3.2, GL 3.2) all
+/// faces rendered in one pass, gl_Layer selects face, else pass per face.
+class point_shadows
+{
+public:
+    using light_id  = std::uint32_t;
+    using caster_id = std::uint32_t;
+
+    enum class mobility
+    {
+        static_caster, ///< should not move, moving rebuilds cache
+        dynamic_caster
+    };
+
+    struct counters
+    {
+        std::uint32_t static_faces  = 0; ///< faces of cache rendered
+        std::uint32_t dynamic_faces = 0; ///< faces restored and redrawn
+        std::uint32_t passes        = 0; ///< framebuffer attachments
+        std::uint32_t draws         = 0;
+    };
+
+    point_shadows(std::uint32_t resolution,
+                  float         near_plane,
+                  float         far_plane) noexcept(false);
+    ~point_shadows();
+    point_shadows(const point_shadows&)            = delete;
+    point_shadows& operator=(const point_shadows&) = delete;
+
+    light_id add_light(const glm::vec3& position);
+    /// no work if position same as before
+    void move_light(light_id light, const glm::vec3& position);
+
+    /// mesh must live longer than this object
+    caster_id add_caster(const mesh&      geometry,
+                         const glm::mat4& model,
+                         mobility         type);
+    /// no work if model same as before
+    void move_caster(caster_id caster, const glm::mat4& model);
+
+    /// render changed faces. If something rendered framebuffer 0 is bound
+    /// and viewport changed, set it before next pass
+    void update();
+
+    /// bind depth cubemap of light to texture unit for lighting shader
+    void bind_cubemap(light_id light, std::uint32_t unit) const;
+
+    [[nodiscard]] float get_far_plane() const { return far_plane; }
+    [[nodiscard]] bool  is_layered_supported() const
+    {
+        return layered_program.has_value();
+    }
+    /// use pass per face even if layered supported, to compare
+    void set_layered(bool value);
+    [[nodiscard]] bool is_layered() const { return use_layered; }
+    [[nodiscard]] const counters& get_counters() const { return stats; }
+
+private:
+    static constexpr std::uint8_t all_faces = 0b11'1111;
+
+    struct light
+    {
+        glm::vec3                position;
+        std::array<glm::mat4, 6> face_matrices; ///< projection * view
+        std::uint32_t            static_map   = 0; ///< static casters
+        std::uint32_t            map          = 0; ///< static + dynamic
+        std::uint8_t             static_dirty = all_faces;
+        std::uint8_t             dirty        = all_faces;
+    };
+
+    struct caster
+    {
+        const mesh* geometry;
+        glm::mat4   model;
+        glm::vec3   center; ///< bounding sphere in world space
+        float       radius;
+        mobility    type;
+    };
+
+    /// faces of light frustums sphere is visible in, bit per face
+    [[nodiscard]] std::uint8_t face_mask(const light&  l,
+                                         const caster& c) const;
+    /// faces with caster need render, call before and after move
+    void          mark_dirty(const caster& c);
+    void          update_face_matrices(light& l) const;
+    std::uint32_t create_cubemap() const;
+    /// draw casters of type to faces of cubemap, clear faces before
+    void render(const light&  l,
+                std::uint32_t cubemap,
+                std::uint8_t  faces,
+                mobility      type,
+                bool          clear);
+    void render_per_face(const light&  l,
+                         std::uint32_t cubemap,
+                         std::uint8_t  faces,
+                         bool          clear);
+    void render_layered(const light& l, std::uint32_t cubemap, bool clear);
+    /// copy faces of static_map to map
+    void restore_static(const light& l, std::uint8_t faces);
+
+    std::uint32_t resolution;
+    float         near_plane;
+    float         far_plane;
+
+    std::vector<light>        lights;
+    std::vector<caster>       casters;
+    std::vector<std::uint8_t> caster_faces; ///< face_mask() of render()
+    bool                      has_dynamic = false;
+
+    std::uint32_t fbo      = 0;
+    std::uint32_t copy_fbo = 0; ///< read framebuffer of restore_static()
+
+    /// pass per face, face_matrix uniform
+    shader face_program;
+    struct
+    {
+        shader::uniform model;
+        shader::uniform face_matrix;
+        shader::uniform light_pos;
+        shader::uniform far_plane;
+    } face_uniforms;
+
+    /// one pass, geometry shader emits triangle to faces of face_mask
+    std::optional<shader> layered_program;
+    struct
+    {
+        shader::uniform                model;
+        shader::uniform                face_mask;
+        std::array<shader::uniform, 6> face_matrices;
+        shader::uniform                light_pos;
+        shader::uniform                far_plane;
+    } layered_uniforms;
+    bool use_layered = false;
+
+    counters stats;
+};
+
+} // namespace gles30
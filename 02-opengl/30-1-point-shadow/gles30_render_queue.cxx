@@ -0,0 +1,209 @@
+#include "gles30_render_queue.hxx"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include "gles30_state.hxx"
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+// key bits from most significant
+static constexpr std::uint32_t pass_bits        = 4;
+static constexpr std::uint32_t transparent_bits = 1;
+static constexpr std::uint32_t shader_bits      = 11;
+static constexpr std::uint32_t material_bits    = 16;
+static constexpr std::uint32_t depth_bits       = 32;
+
+static_assert(pass_bits + transparent_bits + shader_bits + material_bits +
+                  depth_bits ==
+              64);
+
+void render_queue::begin()
+{
+    eyes.fill(glm::vec3(0.0f));
+    items.clear();
+    keys.clear();
+    order.clear();
+    programs.clear();
+    materials.clear();
+    blocks_ring = nullptr;
+}
+
+void render_queue::set_eye(std::uint8_t pass, const glm::vec3& eye)
+{
+    eyes.at(pass) = eye;
+}
+
+std::uint64_t render_queue::shader_id(std::uint32_t program_id)
+{
+    auto it = std::find(programs.begin(), programs.end(), program_id);
+    if (it == programs.end())
+    {
+        it = programs.insert(programs.end(), program_id);
+    }
+    // more shaders than fit in key only mixes their order, not results
+    return static_cast<std::uint64_t>(it - programs.begin()) &
+           ((1u << shader_bits) - 1u);
+}
+
+std::uint64_t render_queue::material_id(std::uint64_t material_key)
+{
+    auto it = std::find(materials.begin(), materials.end(), material_key);
+    if (it == materials.end())
+    {
+        it = materials.insert(materials.end(), material_key);
+    }
+    return static_cast<std::uint64_t>(it - materials.begin()) &
+           ((1u << material_bits) - 1u);
+}
+
+std::uint64_t render_queue::make_key(const draw_item& item)
+{
+    const glm::vec3 center =
+        glm::vec3(item.model * glm::vec4(item.geometry->get_center(), 1.0f));
+    const std::uint64_t pass = item.pass & ((1u << pass_bits) - 1u);
+    // bits of non negative float grow with value
+    const std::uint64_t depth =
+        std::bit_cast<std::uint32_t>(glm::length(center - eyes[pass]));
+
+    const std::uint64_t shader   = shader_id(item.program->get_program_id());
+    const std::uint64_t material = material_id(
+        item.bind_textures ? item.geometry->get_material_key() : 0);
+
+    std::uint64_t key = pass << (64 - pass_bits);
+    if (!item.transparent)
+    {
+        key |= shader << (material_bits + depth_bits);
+        key |= material << depth_bits;
+        key |= depth;
+    }
+    else
+    {
+        // back to front, state grouping only for equal depth
+        key |= std::uint64_t{ 1 } << (64 - pass_bits - transparent_bits);
+        key |= (~depth & 0xFFFF'FFFFull) << (shader_bits + material_bits);
+        key |= shader << material_bits;
+        key |= material;
+    }
+    return key;
+}
+
+void render_queue::submit(const draw_item& item)
+{
+    keys.push_back(make_key(item));
+    items.push_back(item);
+}
+
+void render_queue::sort()
+{
+    const std::size_t count = items.size();
+    sort_buffer.resize(count);
+    sort_scratch.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        sort_buffer[i] = { keys[i], i };
+    }
+
+    // LSD radix sort, 8 bits per pass, stable so equal keys keep submit
+    // order, digits same for every item (often high bits) are skipped
+    for (std::uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::array<std::size_t, 256> offsets{};
+        for (const auto& [key, index] : sort_buffer)
+        {
+            ++offsets[(key >> shift) & 0xFF];
+        }
+        if (count == 0 ||
+            offsets[(sort_buffer.front().first >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+        std::size_t sum = 0;
+        for (std::size_t& offset : offsets)
+        {
+            sum += std::exchange(offset, sum);
+        }
+        for (const auto& entry : sort_buffer)
+        {
+            sort_scratch[offsets[(entry.first >> shift) & 0xFF]++] = entry;
+        }
+        sort_buffer.swap(sort_scratch);
+    }
+
+    order.resize(count);
+    std::transform(sort_buffer.begin(),
+                   sort_buffer.end(),
+                   order.begin(),
+                   [](const auto& entry) { return entry.second; });
+}
+
+void render_queue::write_draw_blocks(uniform_ring& ring,
+                                     std::uint32_t binding)
+{
+    if (order.size() != items.size())
+    {
+        sort();
+    }
+    blocks_ring    = &ring;
+    blocks_binding = binding;
+    blocks.resize(items.size());
+    for (std::uint32_t index : order)
+    {
+        const draw_item& item = items[index];
+        if (!item.model_uniform)
+        {
+            const glm::mat3 normal = glm::transpose(glm::inverse(
+                glm::mat3(item.model)));
+            blocks[index] = ring.push(draw_block{ item.model,
+                                                  glm::mat4(normal) });
+        }
+    }
+}
+
+void render_queue::execute(
+    const std::function<void(std::uint8_t pass)>& begin_pass)
+{
+    state_cache& state = state_cache::get();
+
+    if (order.size() != items.size())
+    {
+        sort();
+    }
+
+    int current_pass = -1;
+    for (std::uint32_t index : order)
+    {
+        const draw_item& item = items[index];
+        if (item.pass != current_pass)
+        {
+            current_pass = item.pass;
+            begin_pass(item.pass);
+        }
+
+        if (item.culling == cull::none)
+        {
+            state.disable(GL_CULL_FACE);
+        }
+        else
+        {
+            state.enable(GL_CULL_FACE);
+            state.cull_face(item.culling == cull::front ? GL_FRONT : GL_BACK);
+        }
+
+        item.program->use();
+        if (item.model_uniform || blocks_ring == nullptr)
+        {
+            item.program->set_uniform(item.model_uniform, item.model);
+        }
+        else
+        {
+            blocks_ring->bind(blocks_binding, blocks[index]);
+        }
+        item.geometry->draw(*item.program, item.bind_textures);
+    }
+}
+
+} // namespace gles30
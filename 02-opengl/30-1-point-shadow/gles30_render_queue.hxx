@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gles30_mesh.hxx"
+#include "gles30_shader.hxx"
+#include "gles30_uniform_ring.hxx"
+
+namespace gles30
+{
+
+enum class cull
+{
+    none,
+    front,
+    back
+};
+
+/// std140 layout of draw_data uniform block, written by
+/// render_queue::write_draw_blocks()
+struct draw_block
+{
+    glm::mat4 model;
+    glm::mat4 normal_matrix; ///< transpose(inverse(mat3(model)))
+};
+
+/// one draw call, everything but per pass uniforms (view, projection...)
+/// which are set in begin_pass callback of render_queue::execute()
+struct draw_item
+{
+    const mesh* geometry = nullptr;
+    shader*     program  = nullptr;
+    /// set to model matrix before draw, not set - program reads model from
+    /// draw_data block, see write_draw_blocks()
+    shader::uniform model_uniform{};
+    glm::mat4       model{ 1.0f };
+    std::uint8_t    pass          = 0; ///< 0..15, passes executed in order
+    bool            transparent   = false;
+    bool            bind_textures = true;
+    cull            culling       = cull::back;
+};
+
+/// Draw calls of one frame sorted by 64 bit key:
+///     opaque:      pass | 0 | shader | material | depth
+///     transparent: pass | 1 | inverted depth | shader | material
+/// so opaque geometry grouped by shader and textures and drawn front to
+/// back (early depth test), transparent drawn back to front after it.
+class render_queue
+{
+public:
+    /// forget previous frame
+    void begin();
+    /// depth of items in pass measured from eye (camera, light), set it
+    /// before submit
+    void set_eye(std::uint8_t pass, const glm::vec3& eye);
+    void submit(const draw_item& item);
+    /// radix sort of keys, call once after all submits
+    void sort();
+    /// push draw_block of every item without model_uniform to ring in
+    /// execution order, execute() binds it to binding before draw. Call
+    /// after sort() and before ring.upload()
+    void write_draw_blocks(uniform_ring& ring, std::uint32_t binding);
+    /// begin_pass called before first draw of every pass
+    void execute(const std::function<void(std::uint8_t pass)>& begin_pass);
+
+    [[nodiscard]] std::size_t size() const { return items.size(); }
+
+private:
+    std::uint64_t make_key(const draw_item& item);
+    std::uint64_t shader_id(std::uint32_t program_id);
+    std::uint64_t material_id(std::uint64_t material_key);
+
+    std::array<glm::vec3, 16> eyes{}; // one per pass
+
+    std::vector<draw_item>     items;
+    std::vector<std::uint64_t> keys;
+    /// indexes of items in execution order after sort()
+    std::vector<std::uint32_t> order;
+
+    /// draw blocks of items by item index, valid if blocks_ring set
+    uniform_ring*                    blocks_ring    = nullptr;
+    std::uint32_t                    blocks_binding = 0;
+    std::vector<uniform_ring::range> blocks;
+
+    // compact ids of this frame, so they fit in key bits
+    std::vector<std::uint32_t> programs;
+    std::vector<std::uint64_t> materials;
+
+    // radix sort temporaries, kept to not allocate every frame
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> sort_buffer;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> sort_scratch;
+};
+
+} // namespace gles30
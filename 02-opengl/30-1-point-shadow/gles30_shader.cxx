@@ -2,6 +2,7 @@
 #include <array>
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <charconv>
 #include <cstdint>
@@ -11,6 +12,7 @@
 #include <string>
 #include <utility>
 
+#include "gles30_state.hxx"
 #include "gles30_texture.hxx"
 #include "opengles30.hxx"
 
@@ -146,6 +148,8 @@ void shader::create(std::string_view vertex_shader_src,
         throw std::runtime_error(ss.str());
     }
 
+    enumerate_uniforms();
+
     // after linking shader program we don't need object parts of it
     // so we can free OpenGL memory and delete vertex and fragment parts
     glDeleteShader(vertex_shader);
@@ -198,6 +202,8 @@ shader::shader(
 
 shader::shader(shader&& other) noexcept
     : program_id(other.program_id)
+    , uniforms(std::move(other.uniforms))
+    , uniform_slots(std::move(other.uniform_slots))
 {
     other.program_id = 0;
 }
@@ -207,78 +213,211 @@ shader& shader::operator=(shader&& other) noexcept
     shader tmp(std::move(other));
 
     std::swap(tmp.program_id, program_id);
+    std::swap(tmp.uniforms, uniforms);
+    std::swap(tmp.uniform_slots, uniform_slots);
     return *this;
 }
 shader::~shader() noexcept
 {
+    if (program_id != 0)
+    {
+        state_cache::get().on_delete_program(program_id);
+    }
     glDeleteProgram(program_id); // 0 will be silently ignored
 }
 
 void shader::use()
 {
     assert(GL_TRUE == glIsProgram(program_id));
-    glUseProgram(program_id);
+    state_cache::get().use_program(program_id);
+}
+
+// FNV-1a
+static std::size_t hash_uniform_name(std::string_view name) noexcept
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : name)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
 }
 
-GLint get_uniform_index(std::string_view name, uint32_t program_id)
+void shader::enumerate_uniforms()
 {
-    const std::string uniform_name(name);
-    GLint             uniform_index =
-        glGetUniformLocation(program_id, uniform_name.c_str());
+    uniforms.clear();
 
-    if (uniform_index == -1)
+    GLint count      = 0;
+    GLint max_length = 0;
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::string buffer(static_cast<std::size_t>(std::max(max_length, 1)),
+                       '\0');
+    auto add_uniform = [this](std::string name)
+    {
+        GLint location = glGetUniformLocation(program_id, name.c_str());
+        // -1 for members of uniform blocks, they are set with buffers
+        if (location != -1)
+        {
+            uniforms.push_back({ std::move(name), location });
+        }
+    };
+
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(program_id,
+                           static_cast<GLuint>(i),
+                           static_cast<GLsizei>(buffer.size()),
+                           &length,
+                           &size,
+                           &type,
+                           buffer.data());
+        std::string_view name(buffer.data(), static_cast<std::size_t>(length));
+
+        // array reported once as "name[0]", add every element and "name"
+        constexpr std::string_view first_element = "[0]";
+        if (name.size() > first_element.size() &&
+            name.substr(name.size() - first_element.size()) == first_element)
+        {
+            name.remove_suffix(first_element.size());
+            for (GLint element = 0; element < size; ++element)
+            {
+                add_uniform(std::string(name) + '[' +
+                            std::to_string(element) + ']');
+            }
+        }
+        add_uniform(std::string(name));
+    }
+
+    uniform_slots.assign(
+        std::bit_ceil(std::max<std::size_t>(uniforms.size() * 2, 8)), 0);
+    const std::size_t mask = uniform_slots.size() - 1;
+    for (std::uint32_t i = 0; i < uniforms.size(); ++i)
+    {
+        std::size_t slot = hash_uniform_name(uniforms[i].name) & mask;
+        while (uniform_slots[slot] != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+        uniform_slots[slot] = i + 1;
+    }
+}
+
+shader::uniform shader::find_uniform(std::string_view name) const noexcept
+{
+    if (uniform_slots.empty())
+    {
+        return {};
+    }
+    const std::size_t mask = uniform_slots.size() - 1;
+    for (std::size_t slot = hash_uniform_name(name) & mask;
+         uniform_slots[slot] != 0;
+         slot = (slot + 1) & mask)
+    {
+        const uniform_info& info = uniforms[uniform_slots[slot] - 1];
+        if (info.name == name)
+        {
+            return { info.location };
+        }
+    }
+    return {};
+}
+
+shader::uniform shader::get_uniform(std::string_view name) const
+    noexcept(false)
+{
+    uniform result = find_uniform(name);
+    if (!result)
     {
         throw std::runtime_error("can't find uniform: " + std::string(name));
     }
-    return uniform_index;
+    return result;
+}
+
+void shader::set_uniform(uniform u, bool value)
+{
+    state_cache::get().uniform_1i(u.location, value);
+}
+void shader::set_uniform(uniform u, std::int32_t value)
+{
+    state_cache::get().uniform_1i(u.location, value);
+}
+void shader::set_uniform(uniform u, float value)
+{
+    glUniform1f(u.location, value);
+}
+void shader::set_uniform(uniform u, texture& tex, std::uint32_t index)
+{
+    tex.bind(index);
+    state_cache::get().uniform_1i(u.location, static_cast<int32_t>(index));
+}
+void shader::set_uniform(uniform u, const glm::mat4& m)
+{
+    glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(m));
+}
+void shader::set_uniform(uniform u, const glm::mat3& m)
+{
+    glUniformMatrix3fv(u.location, 1, GL_FALSE, glm::value_ptr(m));
+}
+void shader::set_uniform(uniform u, const glm::vec3& v)
+{
+    glUniform3fv(u.location, 1, glm::value_ptr(v));
+}
+void shader::set_uniform(uniform u, const glm::vec2& v)
+{
+    glUniform2fv(u.location, 1, glm::value_ptr(v));
+}
+void shader::set_uniform(uniform u, std::span<const glm::vec4> values)
+{
+    if (values.empty())
+    {
+        return; // front() of empty span is undefined behavior
+    }
+    glUniform4fv(u.location,
+                 static_cast<GLsizei>(values.size()),
+                 glm::value_ptr(values.front()));
 }
 
 void shader::set_uniform(std::string_view name, bool value)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glUniform1i(uniform_index, value);
+    set_uniform(get_uniform(name), value);
 }
 void shader::set_uniform(std::string_view name, std::int32_t value)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glUniform1i(uniform_index, value);
+    set_uniform(get_uniform(name), value);
 }
 void shader::set_uniform(std::string_view name, float value)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glUniform1f(uniform_index, value);
+    set_uniform(get_uniform(name), value);
 }
 void shader::set_uniform(std::string_view name,
                          texture&         tex,
                          std::uint32_t    index)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glActiveTexture(GL_TEXTURE0 + index);
-
-    tex.bind();
-    glUniform1i(uniform_index, static_cast<int32_t>(index));
+    set_uniform(get_uniform(name), tex, index);
 }
 void shader::set_uniform(std::string_view name, const glm::mat4& m)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glUniformMatrix4fv(uniform_index, 1, GL_FALSE, glm::value_ptr(m));
+    set_uniform(get_uniform(name), m);
 }
 void shader::set_uniform(std::string_view name, const glm::mat3& m)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glUniformMatrix3fv(uniform_index, 1, GL_FALSE, glm::value_ptr(m));
+    set_uniform(get_uniform(name), m);
 }
 
 void shader::set_uniform(std::string_view name, const glm::vec3& v)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glUniform3fv(uniform_index, 1, glm::value_ptr(v));
+    set_uniform(get_uniform(name), v);
 }
 
 void shader::set_uniform(std::string_view name, const glm::vec2& v)
 {
-    GLint uniform_index = get_uniform_index(name, program_id);
-    glUniform2fv(uniform_index, 1, glm::value_ptr(v));
+    set_uniform(get_uniform(name), v);
 }
 
 void shader::bind_uniform_block(std::string_view uniform_block_name,
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -24,6 +27,39 @@ public:
 
     void use();
 
+    [[nodiscard]] std::uint32_t get_program_id() const noexcept
+    {
+        return program_id;
+    }
+
+    /// location of active uniform, resolved once at link time. Get it once
+    /// and pass to set_uniform() every frame: no name lookup and no
+    /// glGetUniformLocation call on hot path
+    struct uniform
+    {
+        std::int32_t location = -1;
+
+        explicit operator bool() const noexcept { return location != -1; }
+    };
+
+    /// throw if program has no active uniform with name
+    [[nodiscard]] uniform get_uniform(std::string_view name) const
+        noexcept(false);
+    /// uniform with location -1 (ignored by set_uniform) if not active
+    [[nodiscard]] uniform find_uniform(std::string_view name) const noexcept;
+
+    void set_uniform(uniform u, bool value);
+    void set_uniform(uniform u, std::int32_t value);
+    void set_uniform(uniform u, float value);
+    void set_uniform(uniform u, texture& tex, std::uint32_t index);
+    void set_uniform(uniform u, const glm::mat4&);
+    void set_uniform(uniform u, const glm::mat3&);
+    void set_uniform(uniform u, const glm::vec3&);
+    void set_uniform(uniform u, const glm::vec2&);
+    /// array uniform, u - location of its first element, empty values -
+    /// nothing set
+    void set_uniform(uniform u, std::span<const glm::vec4> values);
+
     void set_uniform(std::string_view name, bool value);
     void set_uniform(std::string_view name, std::int32_t value);
     void set_uniform(std::string_view name, float value);
@@ -51,6 +87,19 @@ private:
     void          create(std::string_view vertex_shader_src,
                          std::string_view geometry_shader_src,
                          std::string_view fragment_shader_src) noexcept(false);
+    void          enumerate_uniforms();
+
+    struct uniform_info
+    {
+        std::string  name;
+        std::int32_t location;
+    };
+
     std::uint32_t program_id;
+    /// active uniforms (and every element of arrays) of linked program
+    std::vector<uniform_info> uniforms;
+    /// open addressing hash table of names, index + 1 into uniforms,
+    /// 0 - empty slot, size is power of two
+    std::vector<std::uint32_t> uniform_slots;
 };
 } // end namespace gles30
@@ -0,0 +1,422 @@
+#include "gles30_shadow_atlas.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+#include "gles30_point_shadows.hxx"
+#include "gles30_state.hxx"
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+shadow_atlas::shadow_atlas(std::uint32_t size_,
+                           std::uint32_t min_tile_,
+                           std::uint32_t max_tile_,
+                           float         near_plane_) noexcept(false)
+    : size{ size_ }
+    , min_tile{ min_tile_ }
+    , max_tile{ max_tile_ }
+    , near_plane{ near_plane_ }
+    , program{ "res/point_shadow.vert", "res/point_shadow.frag" }
+{
+    if (!std::has_single_bit(min_tile) || !std::has_single_bit(max_tile) ||
+        min_tile > max_tile || size % max_tile != 0 || size > 0xFFFF)
+    {
+        throw std::runtime_error(
+            "error: shadow_atlas tiles must be powers of 2 and divide size");
+    }
+
+    uniforms.model       = program.get_uniform("model");
+    uniforms.face_matrix = program.get_uniform("face_matrix");
+    uniforms.light_pos   = program.get_uniform("light_pos");
+    uniforms.far_plane   = program.get_uniform("far_plane");
+
+    free_tiles.resize(std::countr_zero(max_tile / min_tile) + 1);
+    for (std::uint32_t y = 0; y < size; y += max_tile)
+    {
+        for (std::uint32_t x = 0; x < size; x += max_tile)
+        {
+            free_tiles[0].push_back({ static_cast<std::uint16_t>(x),
+                                      static_cast<std::uint16_t>(y) });
+        }
+    }
+    free_area = std::uint64_t{ size } * size;
+
+    glGenTextures(1, &texture);
+    state_cache::get().bind_texture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D,
+                   1,
+                   GL_DEPTH_COMPONENT24,
+                   static_cast<GLsizei>(size),
+                   static_cast<GLsizei>(size));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    const GLenum none = GL_NONE;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    glDrawBuffers(1, &none);
+    glReadBuffer(GL_NONE);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw std::runtime_error("error: shadow_atlas framebuffer incomplete");
+    }
+}
+
+shadow_atlas::~shadow_atlas()
+{
+    state_cache::get().on_delete_texture(texture);
+    glDeleteTextures(1, &texture);
+    glDeleteFramebuffers(1, &fbo);
+}
+
+shadow_atlas::light_id shadow_atlas::add_light(const glm::vec3& position,
+                                               float            range)
+{
+    light l{};
+    l.position = position;
+    l.range    = range;
+    l.changed  = true;
+    lights.push_back(l);
+    return static_cast<light_id>(lights.size() - 1);
+}
+
+void shadow_atlas::move_light(light_id id, const glm::vec3& position)
+{
+    light& l = lights.at(id);
+    if (l.position == position)
+    {
+        return;
+    }
+    l.position = position;
+    l.changed  = true;
+}
+
+shadow_atlas::caster_id shadow_atlas::add_caster(const mesh&      geometry,
+                                                 const glm::mat4& model)
+{
+    caster c{ &geometry, model, {}, 0.0f };
+    bounding_sphere(geometry, model, c.center, c.radius);
+    casters.push_back(c);
+    mark_changed(c);
+    return static_cast<caster_id>(casters.size() - 1);
+}
+
+void shadow_atlas::move_caster(caster_id id, const glm::mat4& model)
+{
+    caster& c = casters.at(id);
+    if (c.model == model)
+    {
+        return;
+    }
+    mark_changed(c); // lights it leaves
+    c.model = model;
+    bounding_sphere(*c.geometry, model, c.center, c.radius);
+    mark_changed(c); // lights it enters
+}
+
+void shadow_atlas::mark_changed(const caster& c)
+{
+    for (light& l : lights)
+    {
+        if (cube_face_mask(l.position, l.range, c.center, c.radius) != 0)
+        {
+            l.changed = true;
+        }
+    }
+}
+
+void shadow_atlas::bind_atlas(std::uint32_t unit) const
+{
+    state_cache::get().bind_texture(unit, GL_TEXTURE_2D, texture);
+}
+
+bool shadow_atlas::allocate(std::uint32_t level, tile& result)
+{
+    std::vector<tile>& level_tiles = free_tiles[level];
+    if (!level_tiles.empty())
+    {
+        result = level_tiles.back();
+        level_tiles.pop_back();
+        return true;
+    }
+    tile parent;
+    if (level == 0 || !allocate(level - 1, parent))
+    {
+        return false;
+    }
+    // take one quarter of bigger tile, other 3 are free
+    const auto side = static_cast<std::uint16_t>(tile_side(level));
+    level_tiles.push_back({ static_cast<std::uint16_t>(parent.x + side),
+                            parent.y });
+    level_tiles.push_back({ parent.x,
+                            static_cast<std::uint16_t>(parent.y + side) });
+    level_tiles.push_back({ static_cast<std::uint16_t>(parent.x + side),
+                            static_cast<std::uint16_t>(parent.y + side) });
+    result = parent;
+    return true;
+}
+
+void shadow_atlas::release(std::uint32_t level, tile freed)
+{
+    std::vector<tile>& level_tiles = free_tiles[level];
+    if (level == 0)
+    {
+        level_tiles.push_back(freed);
+        return;
+    }
+
+    // merge back to bigger tile if other 3 quarters of it are free
+    const std::uint32_t parent_side = tile_side(level - 1);
+    const auto align = [parent_side](std::uint16_t v)
+    { return static_cast<std::uint16_t>(v - v % parent_side); };
+    const tile parent{ align(freed.x), align(freed.y) };
+    std::array<std::size_t, 3> quarters{};
+    std::size_t                found = 0;
+    for (std::size_t i = 0; i < level_tiles.size() && found < 3; ++i)
+    {
+        const tile& t = level_tiles[i];
+        if (t.x >= parent.x && t.x < parent.x + parent_side &&
+            t.y >= parent.y && t.y < parent.y + parent_side)
+        {
+            quarters[found++] = i;
+        }
+    }
+    if (found < 3)
+    {
+        level_tiles.push_back(freed);
+        return;
+    }
+    // indexes ascending, remove from last so others stay valid
+    for (auto it = quarters.rbegin(); it != quarters.rend(); ++it)
+    {
+        level_tiles[*it] = level_tiles.back();
+        level_tiles.pop_back();
+    }
+    release(level - 1, parent);
+}
+
+void shadow_atlas::release_light(light& l)
+{
+    if (!l.has_tile)
+    {
+        return;
+    }
+    for (const tile& t : l.tiles)
+    {
+        release(l.level, t);
+    }
+    const std::uint64_t side = tile_side(l.level);
+    free_area += side * side * l.tiles.size();
+    l.has_tile = false;
+    l.rects    = {};
+}
+
+bool shadow_atlas::allocate_light(light& l, std::uint32_t level)
+{
+    release_light(l);
+    // atlas full for level - try smaller tiles, remember it, so light does
+    // not release and take same tiles again every frame
+    const std::uint32_t wanted = level;
+    for (; level < free_tiles.size(); ++level)
+    {
+        std::size_t count = 0;
+        while (count < l.tiles.size() && allocate(level, l.tiles[count]))
+        {
+            ++count;
+        }
+        if (count == l.tiles.size())
+        {
+            const float side = static_cast<float>(tile_side(level));
+            const float s    = static_cast<float>(size);
+            for (std::size_t face = 0; face < l.tiles.size(); ++face)
+            {
+                l.rects[face] = { l.tiles[face].x / s,
+                                  l.tiles[face].y / s,
+                                  side / s,
+                                  0.0f };
+            }
+            const std::uint64_t taken = tile_side(level);
+            free_area -= taken * taken * l.tiles.size();
+            l.level     = level;
+            l.has_tile  = true;
+            l.fallback  = level != wanted;
+            l.free_then = free_area;
+            return true;
+        }
+        while (count > 0)
+        {
+            release(level, l.tiles[--count]);
+        }
+    }
+    l.fallback  = true;
+    l.free_then = free_area;
+    return false;
+}
+
+bool shadow_atlas::needs_resize(const light& l) const
+{
+    if (l.has_tile && l.wanted >= l.level)
+    {
+        // shrink after 2 levels, so light near border of two sizes is not
+        // resized every frame
+        return l.wanted > l.level + 1;
+    }
+    // grow at once, but after atlas was full only if other lights released
+    // tiles since then
+    return !l.fallback || free_area > l.free_then;
+}
+
+std::uint32_t shadow_atlas::wanted_level(const light&     l,
+                                         const glm::vec3& eye,
+                                         float            fovy,
+                                         float            height) const
+{
+    const float distance = glm::length(l.position - eye);
+    if (distance <= l.range)
+    {
+        return 0; // eye inside light range
+    }
+    // diameter of range sphere on screen in pixels, one face sees quarter
+    // of sphere around light, so half of diameter is enough for tile
+    const float diameter =
+        height * l.range / (distance * std::tan(fovy * 0.5f));
+    const float side = std::max(diameter * 0.5f, 1.0f);
+    if (side >= static_cast<float>(max_tile))
+    {
+        return 0;
+    }
+    const auto level = static_cast<std::uint32_t>(
+        std::floor(std::log2(static_cast<float>(max_tile) / side)));
+    return std::min(level, static_cast<std::uint32_t>(free_tiles.size() - 1));
+}
+
+bool shadow_atlas::render(light& l)
+{
+    if (needs_resize(l))
+    {
+        allocate_light(l, l.wanted);
+    }
+    if (!l.has_tile)
+    {
+        return false; // atlas full, wait for released tiles
+    }
+
+    caster_faces.resize(casters.size());
+    std::transform(casters.begin(),
+                   casters.end(),
+                   caster_faces.begin(),
+                   [&](const caster& c)
+                   {
+                       return cube_face_mask(
+                           l.position, l.range, c.center, c.radius);
+                   });
+
+    const std::array<glm::mat4, 6> face_matrices =
+        cube_face_matrices(l.position, near_plane, l.range);
+    program.set_uniform(uniforms.light_pos, l.position);
+    program.set_uniform(uniforms.far_plane, l.range);
+
+    const auto side = static_cast<GLsizei>(tile_side(l.level));
+    for (std::uint32_t face = 0; face < 6; ++face)
+    {
+        const tile& t = l.tiles[face];
+        glViewport(t.x, t.y, side, side);
+        glScissor(t.x, t.y, side, side); // glClear only this tile
+        glClear(GL_DEPTH_BUFFER_BIT);
+        program.set_uniform(uniforms.face_matrix, face_matrices[face]);
+
+        for (std::size_t i = 0; i < casters.size(); ++i)
+        {
+            if ((caster_faces[i] & (1u << face)) == 0)
+            {
+                continue;
+            }
+            program.set_uniform(uniforms.model, casters[i].model);
+            casters[i].geometry->draw(program, false);
+            ++stats.draws;
+        }
+    }
+    return true;
+}
+
+void shadow_atlas::update(const glm::vec3& eye,
+                          float            fovy,
+                          float            screen_height,
+                          std::uint32_t    budget)
+{
+    stats = {};
+    queue.clear();
+    for (light_id id = 0; id < lights.size(); ++id)
+    {
+        light& l = lights[id];
+        l.wanted          = wanted_level(l, eye, fovy, screen_height);
+        const bool resize = needs_resize(l);
+        if (l.has_tile && resize)
+        {
+            l.changed = true;
+        }
+        // light without tiles takes budget only if atlas has more free space
+        if (l.changed && (l.has_tile || resize))
+        {
+            // waited longer and nearer to eye - first
+            const float distance = glm::length(l.position - eye);
+            queue.emplace_back(static_cast<float>(l.stale + 1) /
+                                   std::max(distance, 1.0f),
+                               id);
+        }
+    }
+
+    const std::size_t count = std::min<std::size_t>(budget, queue.size());
+    std::partial_sort(queue.begin(),
+                      queue.begin() + static_cast<std::ptrdiff_t>(count),
+                      queue.end(),
+                      [](const auto& a, const auto& b)
+                      { return a.first > b.first; });
+
+    if (count > 0)
+    {
+        state_cache& state = state_cache::get();
+        state.enable(GL_DEPTH_TEST);
+        // floor is one quad, front face culling would lose its shadow
+        state.disable(GL_CULL_FACE);
+        state.enable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        program.use();
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            light& l = lights[queue[i].second];
+            l.stale  = 0;
+            if (render(l))
+            {
+                l.changed = false;
+                ++stats.rendered;
+            }
+        }
+
+        state.disable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    for (std::size_t i = count; i < queue.size(); ++i)
+    {
+        ++lights[queue[i].second].stale;
+    }
+
+    stats.waiting    = static_cast<std::uint32_t>(queue.size() - count);
+    stats.unshadowed = static_cast<std::uint32_t>(
+        std::count_if(lights.begin(),
+                      lights.end(),
+                      [](const light& l) { return !l.has_tile; }));
+}
+
+} // namespace gles30
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gles30_mesh.hxx"
+#include "gles30_shader.hxx"
+
+namespace gles30
+{
+
+/// Shadows of many point lights in one depth texture. Every light gets 6
+/// square tiles (cubemap faces) of one size, size follows how big light
+/// range looks on screen. Tiles allocated like buddy allocator: free tile
+/// split in 4, 4 free neighbours merged back.
+/// update() renders at most budget lights per frame: lights changed (moved,
+/// caster in range moved, resized) wait in queue, most stale and nearest
+/// to eye first, so frame time grows with budget, not with light count.
+class shadow_atlas
+{
+public:
+    using light_id  = std::uint32_t;
+    using caster_id = std::uint32_t;
+
+    struct counters
+    {
+        std::uint32_t rendered   = 0; ///< lights rendered by last update()
+        std::uint32_t waiting    = 0; ///< out of date lights left for later
+        std::uint32_t unshadowed = 0; ///< lights without tiles, atlas full
+        std::uint32_t draws      = 0;
+    };
+
+    /// size - side of atlas texture, min_tile and max_tile - powers of 2,
+    /// max_tile divides size
+    shadow_atlas(std::uint32_t size,
+                 std::uint32_t min_tile,
+                 std::uint32_t max_tile,
+                 float         near_plane) noexcept(false);
+    ~shadow_atlas();
+    shadow_atlas(const shadow_atlas&)            = delete;
+    shadow_atlas& operator=(const shadow_atlas&) = delete;
+
+    /// range - distance light reaches, far plane of its faces
+    light_id add_light(const glm::vec3& position, float range);
+    void     move_light(light_id light, const glm::vec3& position);
+
+    /// mesh must live longer than this object
+    caster_id add_caster(const mesh& geometry, const glm::mat4& model);
+    /// no work if model same as before
+    void move_caster(caster_id caster, const glm::mat4& model);
+
+    /// choose tile sizes for eye, render up to budget changed lights.
+    /// fovy in radians. If something rendered framebuffer 0 is bound and
+    /// viewport changed, set it before next pass
+    void update(const glm::vec3& eye,
+                float            fovy,
+                float            screen_height,
+                std::uint32_t    budget);
+
+    void bind_atlas(std::uint32_t unit) const;
+
+    /// per face: xy - corner, z - side of tile in atlas texture
+    /// coordinates, z == 0 - light not rendered yet, no shadow
+    [[nodiscard]] const std::array<glm::vec4, 6>& get_tiles(
+        light_id light) const
+    {
+        return lights.at(light).rects;
+    }
+    [[nodiscard]] float get_range(light_id light) const
+    {
+        return lights.at(light).range;
+    }
+    [[nodiscard]] std::uint32_t get_size() const { return size; }
+    [[nodiscard]] std::size_t   get_light_count() const
+    {
+        return lights.size();
+    }
+    [[nodiscard]] const counters& get_counters() const { return stats; }
+
+private:
+    struct tile
+    {
+        std::uint16_t x;
+        std::uint16_t y;
+    };
+
+    struct light
+    {
+        glm::vec3                position;
+        float                    range;
+        std::array<tile, 6>      tiles{};
+        std::array<glm::vec4, 6> rects{}; ///< tiles for shader
+        std::uint32_t            level    = 0; ///< of tiles, valid if rects
+        std::uint32_t            wanted   = 0; ///< level chosen for eye
+        std::uint32_t            stale    = 0; ///< frames waiting render
+        /// free_area after atlas was full for wanted level, grow again
+        /// only when more is free
+        std::uint64_t free_then = 0;
+        bool          changed   = true;
+        bool          has_tile  = false;
+        bool          fallback  = false; ///< atlas was full
+    };
+
+    struct caster
+    {
+        const mesh* geometry;
+        glm::mat4   model;
+        glm::vec3   center; ///< bounding sphere in world space
+        float       radius;
+    };
+
+    [[nodiscard]] std::uint32_t tile_side(std::uint32_t level) const
+    {
+        return max_tile >> level;
+    }
+    /// tile level for light seen from eye, 0 - max_tile
+    [[nodiscard]] std::uint32_t wanted_level(
+        const light& l, const glm::vec3& eye, float fovy, float height) const;
+    /// false if no free tile of level or bigger
+    bool allocate(std::uint32_t level, tile& result);
+    void release(std::uint32_t level, tile freed);
+    /// old tiles of light released, 6 new of level or smaller taken
+    bool allocate_light(light& l, std::uint32_t level);
+    void release_light(light& l);
+    /// tiles of light must be taken again before render
+    [[nodiscard]] bool needs_resize(const light& l) const;
+    void mark_changed(const caster& c);
+    /// false if no tiles left for light
+    bool render(light& l);
+
+    std::uint32_t size;
+    std::uint32_t min_tile;
+    std::uint32_t max_tile;
+    float         near_plane;
+
+    /// free tiles of every level, level 0 - max_tile
+    std::vector<std::vector<tile>> free_tiles;
+    /// texels not taken by lights
+    std::uint64_t free_area = 0;
+
+    std::vector<light>        lights;
+    std::vector<caster>       casters;
+    std::vector<std::uint8_t> caster_faces; ///< face masks of render()
+    /// scratch of update(): priority and light out of date
+    std::vector<std::pair<float, light_id>> queue;
+
+    std::uint32_t texture = 0;
+    std::uint32_t fbo     = 0;
+
+    /// same shaders as point_shadows pass per face
+    shader program;
+    struct
+    {
+        shader::uniform model;
+        shader::uniform face_matrix;
+        shader::uniform light_pos;
+        shader::uniform far_plane;
+    } uniforms;
+
+    counters stats;
+};
+
+} // namespace gles30
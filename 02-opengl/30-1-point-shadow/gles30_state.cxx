@@ -0,0 +1,297 @@
+#include "gles30_state.hxx"
+
+#include <algorithm>
+
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+state_cache& state_cache::get()
+{
+    static state_cache instance;
+    return instance;
+}
+
+state_cache::state_cache()
+{
+    invalidate();
+}
+
+std::size_t state_cache::target_index(std::uint32_t target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_CUBE_MAP:
+            return 1;
+        case GL_TEXTURE_2D_MULTISAMPLE:
+            return 2;
+        case GL_TEXTURE_2D_ARRAY:
+            return 3;
+        case GL_TEXTURE_3D:
+            return 4;
+        default:
+            return max_targets;
+    }
+}
+
+bool state_cache::skip(bool redundant)
+{
+    if (redundant)
+    {
+        ++frame.skipped;
+    }
+    else
+    {
+        ++frame.issued;
+    }
+    return redundant;
+}
+
+void state_cache::use_program(std::uint32_t value)
+{
+    if (!skip(program == value))
+    {
+        glUseProgram(value);
+        program = value;
+    }
+}
+
+void state_cache::bind_vertex_array(std::uint32_t vao)
+{
+    if (!skip(vertex_array == vao))
+    {
+        glBindVertexArray(vao);
+        vertex_array = vao;
+    }
+}
+
+void state_cache::active_texture(std::uint32_t unit)
+{
+    if (!skip(active_unit == unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_unit = unit;
+    }
+}
+
+void state_cache::bind_texture(std::uint32_t target, std::uint32_t texture)
+{
+    const std::size_t index = target_index(target);
+    if (active_unit >= max_units || index == max_targets)
+    {
+        // not tracked, state of unit stays unknown
+        skip(false);
+        glBindTexture(target, texture);
+        if (active_unit < max_units)
+        {
+            textures[active_unit].fill(unknown);
+        }
+        return;
+    }
+    std::uint32_t& bound = textures[active_unit][index];
+    if (!skip(bound == texture))
+    {
+        glBindTexture(target, texture);
+        bound = texture;
+    }
+}
+
+void state_cache::bind_texture(std::uint32_t unit,
+                               std::uint32_t target,
+                               std::uint32_t texture)
+{
+    const std::size_t index = target_index(target);
+    if (unit < max_units && index != max_targets &&
+        textures[unit][index] == texture)
+    {
+        skip(true);
+        return;
+    }
+    active_texture(unit);
+    bind_texture(target, texture);
+}
+
+void state_cache::set_enabled(std::uint32_t capability, bool value)
+{
+    auto it = std::find_if(enabled.begin(),
+                           enabled.end(),
+                           [capability](const auto& known)
+                           { return known.first == capability; });
+    if (it != enabled.end() && skip(it->second == value))
+    {
+        return;
+    }
+    if (it == enabled.end())
+    {
+        skip(false);
+        it = enabled.insert(enabled.end(), { capability, value });
+    }
+    if (value)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+    it->second = value;
+}
+
+void state_cache::enable(std::uint32_t capability)
+{
+    set_enabled(capability, true);
+}
+
+void state_cache::disable(std::uint32_t capability)
+{
+    set_enabled(capability, false);
+}
+
+void state_cache::cull_face(std::uint32_t mode)
+{
+    if (!skip(cull_mode == mode))
+    {
+        glCullFace(mode);
+        cull_mode = mode;
+    }
+}
+
+void state_cache::color_mask(bool value)
+{
+    if (!skip(color_write == value))
+    {
+        glColorMask(value, value, value, value);
+        color_write = value;
+    }
+}
+
+void state_cache::depth_mask(bool value)
+{
+    if (!skip(depth_write == value))
+    {
+        glDepthMask(value);
+        depth_write = value;
+    }
+}
+
+void state_cache::depth_func(std::uint32_t func)
+{
+    if (!skip(depth_test == func))
+    {
+        glDepthFunc(func);
+        depth_test = func;
+    }
+}
+
+bool state_cache::get_color_mask()
+{
+    if (color_write == unknown)
+    {
+        std::array<GLboolean, 4> mask{};
+        glGetBooleanv(GL_COLOR_WRITEMASK, mask.data());
+        color_write = mask[0] == GL_TRUE;
+    }
+    return color_write != 0;
+}
+
+bool state_cache::get_depth_mask()
+{
+    if (depth_write == unknown)
+    {
+        GLboolean mask = GL_TRUE;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &mask);
+        depth_write = mask == GL_TRUE;
+    }
+    return depth_write != 0;
+}
+
+std::uint32_t state_cache::get_depth_func()
+{
+    if (depth_test == unknown)
+    {
+        GLint func = GL_LESS;
+        glGetIntegerv(GL_DEPTH_FUNC, &func);
+        depth_test = static_cast<std::uint32_t>(func);
+    }
+    return depth_test;
+}
+
+void state_cache::uniform_1i(std::int32_t location, std::int32_t value)
+{
+    if (location == -1)
+    {
+        return; // ignored by GL too
+    }
+    if (program == unknown)
+    {
+        skip(false);
+        glUniform1i(location, value);
+        return;
+    }
+    const std::uint64_t key = std::uint64_t{ program } << 32u |
+                              static_cast<std::uint32_t>(location);
+    auto [it, inserted]     = int_uniforms.try_emplace(key, value);
+    if (!skip(!inserted && it->second == value))
+    {
+        glUniform1i(location, value);
+        it->second = value;
+    }
+}
+
+void state_cache::on_delete_program(std::uint32_t value)
+{
+    // program stays current until other one used, but may not match
+    // cached id after it
+    if (program == value)
+    {
+        program = unknown;
+    }
+    std::erase_if(int_uniforms,
+                  [value](const auto& entry)
+                  { return (entry.first >> 32u) == value; });
+    ++program_generation;
+}
+
+void state_cache::on_delete_vertex_array(std::uint32_t vao)
+{
+    if (vertex_array == vao)
+    {
+        vertex_array = 0;
+    }
+}
+
+void state_cache::on_delete_texture(std::uint32_t texture)
+{
+    for (auto& unit : textures)
+    {
+        std::replace(unit.begin(), unit.end(), texture, 0u);
+    }
+}
+
+void state_cache::invalidate()
+{
+    program      = unknown;
+    vertex_array = unknown;
+    active_unit  = unknown;
+    cull_mode    = unknown;
+    color_write  = unknown;
+    depth_write  = unknown;
+    depth_test   = unknown;
+    for (auto& unit : textures)
+    {
+        unit.fill(unknown);
+    }
+    enabled.clear();
+    int_uniforms.clear();
+    ++program_generation;
+}
+
+state_cache::counters state_cache::end_frame()
+{
+    return std::exchange(frame, counters{});
+}
+
+} // namespace gles30
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gles30
+{
+
+/// Shadow copy of GL state changed by gles30 classes: current program,
+/// vertex array, textures bound to every unit, enabled capabilities, depth
+/// and color writes, depth function and int (sampler) uniforms of
+/// programs. Every setter compares with last known value and calls GL only
+/// if value differs. Samples use single GL context on main thread, so there
+/// is one instance per process. Code changing same state with direct GL
+/// calls must call invalidate().
+class state_cache
+{
+public:
+    struct counters
+    {
+        std::uint64_t issued  = 0; ///< GL calls done
+        std::uint64_t skipped = 0; ///< redundant GL calls not done
+    };
+
+    static state_cache& get();
+
+    void use_program(std::uint32_t program);
+    void bind_vertex_array(std::uint32_t vao);
+    void active_texture(std::uint32_t unit);
+    /// bind texture to current active unit
+    void bind_texture(std::uint32_t target, std::uint32_t texture);
+    /// bind texture to unit, glActiveTexture only if binding changes
+    void bind_texture(std::uint32_t unit,
+                      std::uint32_t target,
+                      std::uint32_t texture);
+    void enable(std::uint32_t capability);
+    void disable(std::uint32_t capability);
+    void set_enabled(std::uint32_t capability, bool value);
+    void cull_face(std::uint32_t mode);
+    /// all 4 channels written or none
+    void color_mask(bool value);
+    void depth_mask(bool value);
+    void depth_func(std::uint32_t func);
+    /// current value, asked from GL once if unknown, so caller changing it
+    /// can set it back
+    [[nodiscard]] bool          get_color_mask();
+    [[nodiscard]] bool          get_depth_mask();
+    [[nodiscard]] std::uint32_t get_depth_func();
+    /// glUniform1i for current program, values live in program object
+    void uniform_1i(std::int32_t location, std::int32_t value);
+
+    /// GL unbinds deleted object and may reuse its id, forget it too
+    void on_delete_program(std::uint32_t program);
+    void on_delete_vertex_array(std::uint32_t vao);
+    void on_delete_texture(std::uint32_t texture);
+
+    /// changes every time any program deleted, so objects caching data
+    /// by program id can detect id reuse
+    [[nodiscard]] std::uint64_t get_program_generation() const
+    {
+        return program_generation;
+    }
+
+    /// forget everything, next calls go to GL
+    void invalidate();
+
+    [[nodiscard]] const counters& get_counters() const { return frame; }
+    /// return counters of finished frame and start new one
+    counters end_frame();
+
+private:
+    state_cache();
+
+    static constexpr std::uint32_t unknown   = ~0u;
+    static constexpr std::size_t   max_units = 32; // GLES 3.0 minimum
+    // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_MULTISAMPLE,
+    // GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D
+    static constexpr std::size_t max_targets = 5;
+
+    static std::size_t target_index(std::uint32_t target);
+    bool               skip(bool redundant);
+
+    std::uint32_t program      = unknown;
+    std::uint32_t vertex_array = unknown;
+    std::uint32_t active_unit  = unknown;
+    std::uint32_t cull_mode    = unknown;
+    std::uint32_t color_write  = unknown; ///< 0, 1 or unknown
+    std::uint32_t depth_write  = unknown; ///< 0, 1 or unknown
+    std::uint32_t depth_test   = unknown; ///< glDepthFunc
+    std::array<std::array<std::uint32_t, max_targets>, max_units> textures{};
+    std::vector<std::pair<std::uint32_t, bool>>                   enabled;
+    /// (program << 32 | location) -> value
+    std::unordered_map<std::uint64_t, std::int32_t> int_uniforms;
+    std::uint64_t                                   program_generation = 0;
+
+    counters frame;
+};
+
+} // namespace gles30
@@ -10,6 +10,8 @@
 #include <stb/stb_image.h>
 #pragma GCC diagnostic pop
 
+#include "gles30_state.hxx"
+#include "gles30_texture_streamer.hxx"
 #include "opengles30.hxx"
 
 namespace gles30
@@ -63,7 +65,7 @@ texture::texture(const extent size, size_t num_of_samples)
 {
     glGenTextures(1, &texture_id);
 
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture_id);
+    state_cache::get().bind_texture(GL_TEXTURE_2D_MULTISAMPLE, texture_id);
     const auto gl_width  = static_cast<GLsizei>(size.width);
     const auto gl_height = static_cast<GLsizei>(size.height);
     // glTexStorage2DMultisample // OpenGL ES 3.2 OpenGL 4.0
@@ -99,7 +101,7 @@ void texture::set_default_wrap_and_filters()
 void gles30::texture::gen_texture_and_bind_it()
 {
     glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    state_cache::get().bind_texture(GL_TEXTURE_2D, texture_id);
 }
 
 void texture::gen_texture_set_filters_and_wrap()
@@ -117,10 +119,8 @@ texture::texture(const std::filesystem::path& path,
 {
     throw_exception_if_not_diffuse_or_specular();
 
-    if (options == opt::flip_y)
-    {
-        stbi_set_flip_vertically_on_load(1);
-    }
+    // thread local flag, global one stays unset for texture_streamer workers
+    stbi_set_flip_vertically_on_load_thread(options == opt::flip_y);
 
     int width;
     int height;
@@ -183,6 +183,27 @@ texture::texture(const std::filesystem::path& path,
     generate_mipmap();
 }
 
+texture::texture(const std::filesystem::path& path,
+                 const type                   tex_type,
+                 const loading                mode,
+                 const opt                    options)
+    : file_name{ path.string() }
+    , texture_id{ 0 }
+    , texture_type{ tex_type }
+{
+    throw_exception_if_not_diffuse_or_specular();
+
+    if (mode == loading::blocking)
+    {
+        *this = texture(path, tex_type, options);
+        return;
+    }
+
+    texture_streamer& streamer = texture_streamer::get();
+    texture_id = streamer.get_placeholder(texture_type);
+    stream_job = streamer.start(*this, path, options);
+}
+
 static std::string join_strings_with_spaces(
     const std::array<std::filesystem::path, 6>& faces)
 {
@@ -208,7 +229,7 @@ texture::texture(const std::array<std::filesystem::path, 6>& faces,
     , texture_type{ type::cubemap }
 {
     glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
+    state_cache::get().bind_texture(GL_TEXTURE_CUBE_MAP, texture_id);
 
     const std::array<int, 6> face_type{
         GL_TEXTURE_CUBE_MAP_POSITIVE_X, GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
@@ -216,10 +237,8 @@ texture::texture(const std::array<std::filesystem::path, 6>& faces,
         GL_TEXTURE_CUBE_MAP_POSITIVE_Z, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
     };
 
-    if (opt::flip_y == options)
-    {
-        stbi_set_flip_vertically_on_load(1);
-    }
+    // thread local flag, global one stays unset for texture_streamer workers
+    stbi_set_flip_vertically_on_load_thread(opt::flip_y == options);
 
     for (size_t i = 0; i < faces.size(); ++i)
     {
@@ -311,20 +330,27 @@ texture::texture(const type   tex_type,
                  nullptr);
 }
 
-void texture::bind()
+std::uint32_t texture::get_target() const
 {
     if (type::cubemap == texture_type)
     {
-        glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
+        return GL_TEXTURE_CUBE_MAP;
     }
-    else if (type::multisample2d == texture_type)
+    if (type::multisample2d == texture_type)
     {
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture_id);
-    }
-    else
-    {
-        glBindTexture(GL_TEXTURE_2D, texture_id);
+        return GL_TEXTURE_2D_MULTISAMPLE;
     }
+    return GL_TEXTURE_2D;
+}
+
+void texture::bind()
+{
+    state_cache::get().bind_texture(get_target(), texture_id);
+}
+
+void texture::bind(std::uint32_t unit)
+{
+    state_cache::get().bind_texture(unit, get_target(), texture_id);
 }
 
 void texture::generate_mipmap()
@@ -382,17 +408,40 @@ void texture::set_border_color(float r, float g, float b, float a)
 
 texture::~texture()
 {
+    if (stream_job != 0)
+    {
+        // texture_id is shared placeholder
+        texture_streamer::get().cancel(stream_job);
+        return;
+    }
+    if (texture_id != 0)
+    {
+        state_cache::get().on_delete_texture(texture_id);
+    }
     glDeleteTextures(1, &texture_id);
 }
 texture::texture(texture&& other)
     : texture_id{ other.texture_id }
+    , stream_job{ other.stream_job }
 {
     other.texture_id = 0;
+    other.stream_job = 0;
+    retarget_stream_job();
 }
 texture& texture::operator=(texture&& other)
 {
     texture tmp(std::move(other));
     std::swap(tmp.texture_id, texture_id);
+    std::swap(tmp.stream_job, stream_job);
+    retarget_stream_job();
+    tmp.retarget_stream_job();
     return *this;
 }
+void texture::retarget_stream_job()
+{
+    if (stream_job != 0)
+    {
+        texture_streamer::get().retarget(stream_job, *this);
+    }
+}
 } // namespace gles30
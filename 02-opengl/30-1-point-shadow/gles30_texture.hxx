@@ -50,6 +50,12 @@ public:
         gl_unsigned_byte
     };
 
+    enum class loading
+    {
+        blocking, ///< decode and upload in constructor
+        streamed  ///< see texture_streamer, placeholder until ready
+    };
+
     /// type in {diffuse, specular}
     texture(const type, const extent size);
     /// type in {multisample2d}
@@ -58,13 +64,21 @@ public:
     texture(const std::filesystem::path& path,
             const type,
             const opt = opt::no_flip);
+    /// type in {diffuse, specular}
+    texture(const std::filesystem::path& path,
+            const type,
+            const loading,
+            const opt = opt::no_flip);
     /// type in {cubemap}
     texture(const std::array<std::filesystem::path, 6>& faces,
             const opt = opt::no_flip);
     /// type in {depth_component}
     texture(const type, const extent size, pixel_type pixel_data_type);
 
+    /// bind to current active texture unit
     void bind();
+    /// bind to unit, no GL calls if texture already bound there
+    void bind(std::uint32_t unit);
 
     void bind_to_framebuffer();
 
@@ -80,6 +94,8 @@ public:
 
     void set_type(const type);
     type get_type() const;
+    /// false while streamed texture shows placeholder
+    bool is_ready() const;
 
     ~texture();
     texture(texture&&);
@@ -94,11 +110,15 @@ private:
     void set_default_wrap_and_filters();
     void throw_exception_if_not_diffuse_or_specular();
     void throw_exception_if_not_depth_component();
+    std::uint32_t get_target() const;
+    void retarget_stream_job();
     friend class framebuffer;
+    friend class texture_streamer;
 
     std::string   file_name;
     std::uint32_t texture_id;
     type          texture_type = type::diffuse;
+    std::uint64_t stream_job   = 0; ///< texture_id is placeholder if not 0
 };
 
 inline void texture::set_type(const type t)
@@ -111,4 +131,9 @@ inline texture::type texture::get_type() const
     return texture_type;
 }
 
+inline bool texture::is_ready() const
+{
+    return stream_job == 0;
+}
+
 } // namespace gles30
@@ -0,0 +1,50 @@
+#include "gles30_texture_cache.hxx"
+
+#include <algorithm>
+
+namespace gles30
+{
+
+texture_cache& texture_cache::get()
+{
+    static texture_cache instance;
+    return instance;
+}
+
+std::shared_ptr<texture> texture_cache::acquire(
+    const std::filesystem::path& path,
+    texture::type                type,
+    texture::loading             mode) noexcept(false)
+{
+    std::string key = path.lexically_normal().generic_string();
+    key += '#';
+    key += std::to_string(static_cast<int>(type));
+
+    if (auto it = textures.find(key); it != textures.end())
+    {
+        if (std::shared_ptr<texture> alive = it->second.lock())
+        {
+            ++stats.hits;
+            return alive;
+        }
+    }
+
+    auto loaded = std::make_shared<texture>(path, type, mode);
+    ++stats.loads;
+
+    // forget textures deleted since last load
+    std::erase_if(textures,
+                  [](const auto& entry) { return entry.second.expired(); });
+    textures[key] = loaded;
+    return loaded;
+}
+
+std::size_t texture_cache::size() const
+{
+    return static_cast<std::size_t>(std::count_if(
+        textures.begin(),
+        textures.end(),
+        [](const auto& entry) { return !entry.second.expired(); }));
+}
+
+} // namespace gles30
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "gles30_texture.hxx"
+
+namespace gles30
+{
+
+/// Textures loaded from files, keyed by normalized path and type. Owners
+/// (models) hold std::shared_ptr, texture deleted with last owner, so
+/// image used by many materials or models decoded and uploaded once.
+class texture_cache
+{
+public:
+    struct counters
+    {
+        std::uint64_t loads = 0; ///< images decoded and uploaded
+        std::uint64_t hits  = 0; ///< requests served by live texture
+    };
+
+    static texture_cache& get();
+
+    /// mode used only if texture not loaded yet
+    [[nodiscard]] std::shared_ptr<texture> acquire(
+        const std::filesystem::path& path,
+        texture::type                type,
+        texture::loading mode = texture::loading::blocking) noexcept(false);
+
+    /// textures still used by someone
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] const counters& get_counters() const { return stats; }
+
+private:
+    texture_cache() = default;
+
+    std::unordered_map<std::string, std::weak_ptr<texture>> textures;
+    counters                                                stats;
+};
+
+} // namespace gles30
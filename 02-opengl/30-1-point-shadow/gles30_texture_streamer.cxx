@@ -0,0 +1,386 @@
+#include "gles30_texture_streamer.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iostream>
+
+#include <stb/stb_image.h>
+
+#include "gles30_state.hxx"
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+texture_streamer& texture_streamer::get()
+{
+    static texture_streamer instance;
+    return instance;
+}
+
+texture_streamer::texture_streamer()
+{
+    // leave cores for render thread and rest of application
+    const unsigned hardware = std::thread::hardware_concurrency();
+    const unsigned count    = std::clamp(hardware / 2u, 1u, 4u);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        workers.emplace_back([this](std::stop_token stop) { worker(stop); });
+    }
+}
+
+// process exit, GL context already destroyed, so GL objects not deleted
+texture_streamer::~texture_streamer() = default;
+
+bool texture_streamer::idle() const
+{
+    return uploads.empty();
+}
+
+std::uint64_t texture_streamer::start(texture&                     owner,
+                                      const std::filesystem::path& path,
+                                      texture::opt                 options)
+{
+    const std::uint64_t id = next_job++;
+    uploads[id].owner = &owner;
+    {
+        std::lock_guard lock(mutex);
+        decode_queue.push_back({ id, path, options });
+    }
+    wake_worker.notify_one();
+    return id;
+}
+
+void texture_streamer::retarget(std::uint64_t job, texture& owner)
+{
+    if (auto it = uploads.find(job); it != uploads.end())
+    {
+        it->second.owner = &owner;
+    }
+}
+
+void texture_streamer::cancel(std::uint64_t job)
+{
+    if (auto it = uploads.find(job); it != uploads.end())
+    {
+        if (it->second.texture_id != 0)
+        {
+            state_cache::get().on_delete_texture(it->second.texture_id);
+            glDeleteTextures(1, &it->second.texture_id);
+        }
+        uploads.erase(it);
+        std::erase(upload_order, job);
+    }
+    // decoding in worker now: result dropped in take_decoded()
+    std::lock_guard lock(mutex);
+    std::erase_if(decode_queue,
+                  [job](const decode_job& queued) { return queued.id == job; });
+}
+
+std::uint32_t texture_streamer::get_placeholder(texture::type type)
+{
+    std::uint32_t& placeholder = type == texture::type::specular
+                                     ? placeholder_specular
+                                     : placeholder_diffuse;
+    if (placeholder == 0)
+    {
+        // no highlights from specular map, neutral grey diffuse
+        const std::array<std::uint8_t, 4> pixel =
+            type == texture::type::specular
+                ? std::array<std::uint8_t, 4>{ 0, 0, 0, 255 }
+                : std::array<std::uint8_t, 4>{ 128, 128, 128, 255 };
+
+        glGenTextures(1, &placeholder);
+        state_cache::get().bind_texture(GL_TEXTURE_2D, placeholder);
+        glTexImage2D(GL_TEXTURE_2D,
+                     0,
+                     GL_RGBA,
+                     1,
+                     1,
+                     0,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     pixel.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    return placeholder;
+}
+
+// stbi_load is safe to call from many threads, but reads global flip flag
+// unless thread sets own one, texture sets only thread local flag, so here
+// global one is always unset and workers flip rows themselves
+texture_streamer::image texture_streamer::decode(
+    const std::filesystem::path& path, texture::opt options)
+{
+    int width;
+    int height;
+    int channels;
+
+    const int prefered_channels_count = 0; // same as in texture
+
+    std::unique_ptr<std::uint8_t, void (*)(void*)> data(
+        stbi_load(path.string().c_str(),
+                  &width,
+                  &height,
+                  &channels,
+                  prefered_channels_count),
+        &stbi_image_free);
+
+    if (data.get() == nullptr)
+    {
+        throw std::runtime_error("can't create texture from file: " +
+                                 path.string());
+    }
+    if (channels != 3 && channels != 4)
+    {
+        throw std::runtime_error("3 or 4 channel textures only now supported");
+    }
+
+    image result;
+    result.width    = static_cast<std::uint32_t>(width);
+    result.height   = static_cast<std::uint32_t>(height);
+    result.channels = static_cast<std::uint32_t>(channels);
+
+    const std::size_t row_size = std::size_t{ result.width } * result.channels;
+    result.pixels.resize(row_size * result.height);
+
+    for (std::size_t row = 0; row < result.height; ++row)
+    {
+        const std::size_t source_row = options == texture::opt::flip_y
+                                           ? result.height - 1 - row
+                                           : row;
+        std::memcpy(result.pixels.data() + row * row_size,
+                    data.get() + source_row * row_size,
+                    row_size);
+    }
+    return result;
+}
+
+void texture_streamer::worker(std::stop_token stop)
+{
+    while (true)
+    {
+        decode_job job;
+        {
+            std::unique_lock lock(mutex);
+            if (!wake_worker.wait(
+                    lock, stop, [this] { return !decode_queue.empty(); }))
+            {
+                return; // stop requested
+            }
+            job = std::move(decode_queue.front());
+            decode_queue.pop_front();
+        }
+
+        decoded result{ job.id, {}, {} };
+        try
+        {
+            result.result = decode(job.path, job.options);
+        }
+        catch (const std::exception& ex)
+        {
+            result.error = ex.what();
+        }
+
+        std::lock_guard lock(mutex);
+        decoded_queue.push_back(std::move(result));
+    }
+}
+
+void texture_streamer::take_decoded()
+{
+    std::vector<decoded> ready;
+    {
+        std::lock_guard lock(mutex);
+        ready.swap(decoded_queue);
+    }
+
+    for (decoded& item : ready)
+    {
+        auto it = uploads.find(item.id);
+        if (it == uploads.end())
+        {
+            continue; // texture deleted while decoding
+        }
+        if (!item.error.empty())
+        {
+            // texture keeps placeholder, same as missing file in game
+            std::clog << "warning: " << item.error << std::endl;
+            uploads.erase(it);
+            continue;
+        }
+        it->second.source = std::move(item.result);
+        upload_order.push_back(item.id);
+    }
+}
+
+std::size_t texture_streamer::copy_rows(std::uint8_t* pbo_memory,
+                                        std::size_t   capacity)
+{
+    std::size_t written = 0;
+    for (std::uint64_t id : upload_order)
+    {
+        upload&             job      = uploads.at(id);
+        const image&        source   = job.source;
+        const std::size_t   row_size = std::size_t{ source.width } *
+                                     source.channels;
+        const std::uint32_t rows     = static_cast<std::uint32_t>(
+            std::min<std::size_t>(source.height - job.next_row,
+                                  (capacity - written) / row_size));
+        if (rows == 0)
+        {
+            break; // budget used, keep upload order
+        }
+
+        std::memcpy(pbo_memory + written,
+                    source.pixels.data() + job.next_row * row_size,
+                    rows * row_size);
+        bands.push_back({ id, job.next_row, rows, written });
+        job.next_row += rows;
+        written += rows * row_size;
+    }
+    return written;
+}
+
+void texture_streamer::upload_bands()
+{
+    state_cache& state = state_cache::get();
+
+    for (const band& current : bands)
+    {
+        upload&      job    = uploads.at(current.job);
+        const image& source = job.source;
+        const GLenum format = source.channels == 4 ? GL_RGBA : GL_RGB;
+
+        if (job.texture_id == 0)
+        {
+            // immutable storage with all mipmap levels, no pixel transfer,
+            // so safe while pbo bound
+            const auto levels = static_cast<GLsizei>(
+                std::bit_width(std::max(source.width, source.height)));
+            glGenTextures(1, &job.texture_id);
+            state.bind_texture(GL_TEXTURE_2D, job.texture_id);
+            glTexStorage2D(GL_TEXTURE_2D,
+                           levels,
+                           source.channels == 4 ? GL_RGBA8 : GL_RGB8,
+                           static_cast<GLsizei>(source.width),
+                           static_cast<GLsizei>(source.height));
+        }
+
+        state.bind_texture(GL_TEXTURE_2D, job.texture_id);
+        // data argument is offset in bound GL_PIXEL_UNPACK_BUFFER
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        0,
+                        static_cast<GLint>(current.first_row),
+                        static_cast<GLsizei>(source.width),
+                        static_cast<GLsizei>(current.rows),
+                        format,
+                        GL_UNSIGNED_BYTE,
+                        reinterpret_cast<const void*>(current.offset));
+    }
+}
+
+void texture_streamer::finish(upload& job)
+{
+    state_cache::get().bind_texture(GL_TEXTURE_2D, job.texture_id);
+    // same as texture::set_default_wrap_and_filters()
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(
+        GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // placeholder shared, not deleted
+    job.owner->texture_id = job.texture_id;
+    job.owner->stream_job = 0;
+}
+
+void texture_streamer::update()
+{
+    stats.uploaded_bytes = 0;
+    stats.completed      = 0;
+
+    take_decoded();
+
+    if (!upload_order.empty())
+    {
+        // at least one row, so image with row bigger than budget finishes
+        const upload&     first = uploads.at(upload_order.front());
+        const std::size_t capacity =
+            std::max(frame_budget,
+                     std::size_t{ first.source.width } * first.source.channels);
+
+        if (pbo[0] == 0)
+        {
+            glGenBuffers(static_cast<GLsizei>(pbo.size()), pbo.data());
+        }
+        pbo_index = (pbo_index + 1) % pbo.size();
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo[pbo_index]);
+        if (pbo_size[pbo_index] < capacity)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER,
+                         static_cast<GLsizeiptr>(capacity),
+                         nullptr,
+                         GL_STREAM_DRAW);
+            pbo_size[pbo_index] = capacity;
+        }
+
+        void* memory = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                        0,
+                                        static_cast<GLsizeiptr>(capacity),
+                                        GL_MAP_WRITE_BIT |
+                                            GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (memory == nullptr)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            throw std::runtime_error("error: can't map pixel buffer object");
+        }
+
+        bands.clear();
+        stats.uploaded_bytes =
+            copy_rows(static_cast<std::uint8_t*>(memory), capacity);
+
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+        {
+            // buffer content lost (rare), send same rows next frame
+            for (const band& lost : bands)
+            {
+                uploads.at(lost.job).next_row = lost.first_row;
+            }
+            bands.clear();
+            stats.uploaded_bytes = 0;
+        }
+
+        // rows in pbo tightly packed, GL default alignment is 4
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        upload_bands();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        // glTexImage2D with nullptr elsewhere must not read from pbo
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        std::erase_if(upload_order,
+                      [this](std::uint64_t id)
+                      {
+                          auto it = uploads.find(id);
+                          if (it->second.next_row < it->second.source.height)
+                          {
+                              return false;
+                          }
+                          finish(it->second);
+                          uploads.erase(it);
+                          ++stats.completed;
+                          return true;
+                      });
+    }
+
+    stats.uploading = static_cast<std::uint32_t>(upload_order.size());
+    stats.decoding =
+        static_cast<std::uint32_t>(uploads.size() - upload_order.size());
+}
+
+} // namespace gles30
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gles30_texture.hxx"
+
+namespace gles30
+{
+
+/// Loads textures without stalling render thread. Images decoded by worker
+/// threads, decoded pixels copied to pixel buffer object and uploaded with
+/// glTexSubImage2D in row bands, not more than frame budget bytes per
+/// update(), so big image uploaded during several frames. Until all rows
+/// uploaded and mipmaps generated texture shows 1x1 placeholder (grey for
+/// diffuse, black for specular), then texture switches to real object.
+/// GL calls made only from update(), call it once per frame on thread
+/// with GL context.
+class texture_streamer
+{
+public:
+    struct counters
+    {
+        std::uint64_t uploaded_bytes = 0; ///< in last update()
+        std::uint32_t decoding       = 0; ///< waiting for or in worker
+        std::uint32_t uploading      = 0; ///< decoded, rows left
+        std::uint32_t completed      = 0; ///< in last update()
+    };
+
+    static texture_streamer& get();
+
+    /// upload decoded images, at most budget bytes
+    void update();
+
+    void set_frame_budget(std::size_t bytes) { frame_budget = bytes; }
+    [[nodiscard]] std::size_t get_frame_budget() const
+    {
+        return frame_budget;
+    }
+    [[nodiscard]] const counters& get_counters() const { return stats; }
+    /// no texture waiting for decode or upload
+    [[nodiscard]] bool idle() const;
+
+    ~texture_streamer();
+    texture_streamer(const texture_streamer&)            = delete;
+    texture_streamer& operator=(const texture_streamer&) = delete;
+
+private:
+    friend class texture;
+
+    struct image
+    {
+        std::vector<std::uint8_t> pixels; ///< rows tightly packed
+        std::uint32_t             width    = 0;
+        std::uint32_t             height   = 0;
+        std::uint32_t             channels = 0;
+    };
+
+    struct decode_job
+    {
+        std::uint64_t         id = 0;
+        std::filesystem::path path;
+        texture::opt          options = texture::opt::no_flip;
+    };
+
+    struct decoded
+    {
+        std::uint64_t id;
+        image         result;
+        std::string   error; ///< empty if decoded
+    };
+
+    struct upload
+    {
+        texture*      owner = nullptr;
+        image         source;
+        std::uint32_t texture_id = 0; ///< real texture, 0 until allocated
+        std::uint32_t next_row   = 0;
+    };
+
+    /// rows of one upload written to pbo this frame
+    struct band
+    {
+        std::uint64_t job;
+        std::uint32_t first_row;
+        std::uint32_t rows;
+        std::size_t   offset; ///< in pbo
+    };
+
+    texture_streamer();
+
+    // used by texture, render thread only
+    std::uint64_t start(texture&                     owner,
+                        const std::filesystem::path& path,
+                        texture::opt                 options);
+    void          retarget(std::uint64_t job, texture& owner);
+    void          cancel(std::uint64_t job);
+    std::uint32_t get_placeholder(texture::type type);
+
+    void worker(std::stop_token stop);
+    void take_decoded();
+    /// copy rows of decoded uploads to pbo memory, fill bands
+    std::size_t copy_rows(std::uint8_t* pbo_memory, std::size_t capacity);
+    void        upload_bands();
+    void        finish(upload& job);
+
+    static image decode(const std::filesystem::path& path, texture::opt);
+
+    // shared with workers
+    mutable std::mutex          mutex;
+    std::condition_variable_any wake_worker;
+    std::deque<decode_job>      decode_queue;
+    std::vector<decoded>        decoded_queue;
+
+    // render thread only
+    std::unordered_map<std::uint64_t, upload> uploads; ///< by job id
+    std::vector<std::uint64_t>                upload_order; ///< decoded
+    std::vector<band>                         bands;
+    std::uint64_t                             next_job = 1;
+    std::size_t                               frame_budget = 4u << 20;
+    /// ring of pbo, one per frame, so cpu writes to buffer gpu
+    /// does not read now
+    std::array<std::uint32_t, 3> pbo{};
+    std::array<std::size_t, 3>   pbo_size{};
+    std::size_t                  pbo_index = 0;
+    std::uint32_t                placeholder_diffuse  = 0;
+    std::uint32_t                placeholder_specular = 0;
+    counters                     stats;
+
+    std::vector<std::jthread> workers; // last, stopped first
+};
+
+} // namespace gles30
@@ -0,0 +1,152 @@
+#include "gles30_uniform_ring.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gles30
+{
+
+uniform_ring::uniform_ring(std::size_t capacity_) noexcept(false)
+{
+    glGenBuffers(1, &buffer);
+    GLint offset_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+    if (offset_alignment > 0)
+    {
+        alignment = static_cast<std::size_t>(offset_alignment);
+    }
+    reallocate(align(std::max<std::size_t>(capacity_, alignment)));
+}
+
+uniform_ring::~uniform_ring()
+{
+    for (region& r : in_flight)
+    {
+        glDeleteSync(r.fence);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void uniform_ring::reallocate(std::size_t size)
+{
+    // orphan: driver frees old storage after GPU is done with it, so
+    // fences of old regions are not needed
+    for (region& r : in_flight)
+    {
+        glDeleteSync(r.fence);
+    }
+    in_flight.clear();
+    capacity = size;
+    head     = 0;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER,
+                 static_cast<GLsizeiptr>(capacity),
+                 nullptr,
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void uniform_ring::begin_frame()
+{
+    staging.clear();
+    frame = {};
+}
+
+uniform_ring::range uniform_ring::push(const void* data, std::size_t size)
+{
+    const std::size_t offset = align(staging.size());
+    staging.resize(offset + size);
+    std::memcpy(staging.data() + offset, data, size);
+    return { static_cast<std::uint32_t>(offset),
+             static_cast<std::uint32_t>(size) };
+}
+
+void uniform_ring::wait_oldest()
+{
+    region& oldest = in_flight.front();
+    GLenum  status = GL_TIMEOUT_EXPIRED;
+    while (status == GL_TIMEOUT_EXPIRED)
+    {
+        status = glClientWaitSync(
+            oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+    }
+    glDeleteSync(oldest.fence);
+    in_flight.pop_front();
+    ++frame.waits;
+}
+
+void uniform_ring::upload() noexcept(false)
+{
+    frame.bytes            = staging.size();
+    const std::size_t size = align(staging.size());
+    if (size == 0)
+    {
+        base = head;
+        return;
+    }
+    if (size > capacity)
+    {
+        reallocate(std::max(size, capacity * 2));
+    }
+
+    // regions lie in ring in frame order, so the ones ahead of head are
+    // oldest: wait only for those new data overlaps
+    std::size_t begin = head;
+    if (begin + size > capacity)
+    {
+        // rest of buffer skipped, GPU has to be done with it too
+        while (!in_flight.empty() && in_flight.front().begin >= begin)
+        {
+            wait_oldest();
+        }
+        begin = 0;
+    }
+    while (!in_flight.empty() && in_flight.front().begin < begin + size &&
+           in_flight.front().end > begin)
+    {
+        wait_oldest();
+    }
+
+    // unsynchronized - driver does not wait for GPU, fences above did it
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    void* mapped = glMapBufferRange(GL_UNIFORM_BUFFER,
+                                    static_cast<GLintptr>(begin),
+                                    static_cast<GLsizeiptr>(size),
+                                    GL_MAP_WRITE_BIT |
+                                        GL_MAP_INVALIDATE_RANGE_BIT |
+                                        GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped == nullptr)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        throw std::runtime_error("error: can't map uniform ring buffer");
+    }
+    std::memcpy(mapped, staging.data(), staging.size());
+    // GL_FALSE - content lost (display mode change), next frame rewrites
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    base = begin;
+    head = begin + size;
+}
+
+void uniform_ring::bind(std::uint32_t binding, range block) const
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER,
+                      binding,
+                      buffer,
+                      static_cast<GLintptr>(base + block.offset),
+                      static_cast<GLsizeiptr>(block.size));
+}
+
+void uniform_ring::end_frame()
+{
+    if (!staging.empty())
+    {
+        in_flight.push_back(
+            { base, head, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    }
+}
+
+} // namespace gles30
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "opengles30.hxx"
+
+namespace gles30
+{
+
+/// Streams uniform blocks of a frame through one big GL_UNIFORM_BUFFER
+/// instead of glUniform* calls. Blocks pushed during frame are packed
+/// one after another (offsets aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+/// in CPU memory, upload() copies all of them with one unsynchronized map
+/// at ring head, and every draw binds its block with glBindBufferRange.
+/// Ring regions of previous frames are protected by fences: head waits
+/// only if it catches up with region GPU still reads, with few frames of
+/// data in buffer that normally never happens.
+///     begin_frame(); r = push(block) ...; upload(); bind(r) + draws ...;
+///     end_frame();
+class uniform_ring
+{
+public:
+    /// place of block in frame, valid until end_frame()
+    struct range
+    {
+        std::uint32_t offset = 0; ///< from frame start
+        std::uint32_t size   = 0;
+    };
+
+    struct counters
+    {
+        std::size_t   bytes = 0; ///< uploaded by last frame
+        std::uint32_t waits = 0; ///< fences waited for in last frame
+    };
+
+    /// capacity grows (buffer reallocated) if frame does not fit
+    explicit uniform_ring(std::size_t capacity = 1024 * 1024) noexcept(false);
+    ~uniform_ring();
+    uniform_ring(const uniform_ring&)            = delete;
+    uniform_ring& operator=(const uniform_ring&) = delete;
+
+    void begin_frame();
+    /// copy block to frame data, T is std140 layout of GLSL block
+    template <typename T>
+    range push(const T& block)
+    {
+        return push(&block, sizeof(T));
+    }
+    range push(const void* data, std::size_t size);
+    /// write all pushed blocks to buffer, call once before first bind()
+    void upload() noexcept(false);
+    /// glBindBufferRange of block to binding point of uniform blocks
+    void bind(std::uint32_t binding, range block) const;
+    /// fence for draws of this frame, protects its region from next frames
+    void end_frame();
+
+    [[nodiscard]] const counters& get_counters() const { return frame; }
+
+private:
+    struct region
+    {
+        std::size_t begin;
+        std::size_t end;
+        GLsync      fence;
+    };
+
+    std::size_t align(std::size_t value) const
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+    void wait_oldest();
+    void reallocate(std::size_t size);
+
+    std::uint32_t          buffer    = 0;
+    std::size_t            capacity  = 0;
+    std::size_t            alignment = 256;
+    std::size_t            head      = 0; ///< next write offset
+    std::size_t            base      = 0; ///< offset of this frame
+    std::vector<std::byte> staging;
+    std::deque<region>     in_flight; ///< oldest first
+    counters               frame;
+};
+
+} // namespace gles30
@@ -1,12 +1,17 @@
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 #include <SDL3/SDL.h>
@@ -15,13 +20,24 @@
 #include "fps_camera.hxx"
 #include "gles30_framebuffer.hxx"
 #include "gles30_model.hxx"
+#include "gles30_occlusion.hxx"
+#include "gles30_point_shadows.hxx"
+#include "gles30_render_queue.hxx"
 #include "gles30_shader.hxx"
+#include "gles30_shadow_atlas.hxx"
+#include "gles30_state.hxx"
 #include "gles30_texture.hxx"
+#include "gles30_texture_streamer.hxx"
+#include "gles30_uniform_ring.hxx"
 #include "opengles30.hxx"
 #include "properties_reader.hxx"
 
 #include "res/runtime.properties.hxx"
 
+#ifdef OM_GL_BENCHMARK
+#include "benchmark.hxx"
+#endif
+
 static fps_camera camera;
 
 extern const std::array<float, std::size_t{ 6 } * std::size_t{ 8 }>
@@ -86,6 +102,50 @@ void render_mesh(gles30::shader&          shader,
     }
 }
 
+/// where frames go: window or offscreen framebuffer of headless context
+enum class output
+{
+    window,
+    headless_desktop, ///< OpenGL core context, same as window on desktop
+    headless_es
+};
+
+/// same start state for window and headless contexts
+static void initialize_gl_state(bool desktop_gl)
+{
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_STENCIL_TEST);
+
+    if (desktop_gl)
+    {
+
+#define GL_MULTISAMPLE 32925      // or 0x809D
+        glEnable(GL_MULTISAMPLE); // not working in GLES3.0
+#undef GL_MULTISAMPLE
+    }
+    else
+    {
+        // TODO
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    // on MacOS no such functional
+    if (glDebugMessageCallback != nullptr)
+    {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(gles30::callback_opengl_debug, nullptr);
+        glDebugMessageControl(
+            GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    }
+    if (desktop_gl)
+    {
+// we have to emulate OpenGL ES 3.2 so enable gl_PointSize
+#define GL_PROGRAM_POINT_SIZE 0x8642
+        glEnable(GL_PROGRAM_POINT_SIZE);
+#undef GL_PROGRAM_POINT_SIZE
+    }
+}
+
 static bool destroy_opengl_context(SDL_GLContext ptr)
 {
     return SDL_GL_DestroyContext(ptr);
@@ -159,41 +219,30 @@ create_opengl_context(SDL_Window* window)
     clog << "Receive " << got_context << endl;
 
     initialize_opengles_3_2();
+    initialize_gl_state(is_desktop());
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_STENCIL_TEST);
-
-    if (is_desktop())
-    {
-
-#define GL_MULTISAMPLE 32925      // or 0x809D
-        glEnable(GL_MULTISAMPLE); // not working in GLES3.0
-#undef GL_MULTISAMPLE
-    }
-    else
-    {
-        // TODO
-    }
+    return gl_context;
+};
 
-    glEnable(GL_DEBUG_OUTPUT);
-    // on MacOS no such functional
-    if (glDebugMessageCallback != nullptr)
-    {
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-        glDebugMessageCallback(callback_opengl_debug, nullptr);
-        glDebugMessageControl(
-            GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
-    }
-    if (is_desktop())
+/// headless: no window and no SDL context, GL loaded from EGL context
+/// current on this thread
+[[nodiscard]] std::unique_ptr<std::remove_pointer_t<SDL_GLContext>,
+                              decltype(&SDL_GL_DestroyContext)>
+load_headless_opengl(output type)
+{
+#ifdef OM_GL_BENCHMARK
+    if (0 == gladLoadGLES2Loader(reinterpret_cast<GLADloadproc>(
+                 benchmark::headless_context::get_proc_address)))
     {
-// we have to emulate OpenGL ES 3.2 so enable gl_PointSize
-#define GL_PROGRAM_POINT_SIZE 0x8642
-        glEnable(GL_PROGRAM_POINT_SIZE);
-#undef GL_PROGRAM_POINT_SIZE
+        throw std::runtime_error("error: failed initialize headless GLES");
     }
-
-    return gl_context;
-};
+    initialize_gl_state(type == output::headless_desktop);
+    return { nullptr, destroy_opengl_context };
+#else
+    static_cast<void>(type);
+    throw std::runtime_error("error: built without headless benchmark");
+#endif
+}
 
 float update_delta_time(float& lastFrame)
 {
@@ -340,34 +389,139 @@ void create_camera(const properties_reader& properties)
 
 struct scene
 {
-    scene();
+    explicit scene(output target = output::window);
     void render(float delta_time);
     void pull_system_events(bool& continue_loop);
+    gles30::uniform_ring::range push_atlas_block();
 
-    static constexpr size_t fbo_width  = 1024;
-    static constexpr size_t fbo_height = 1024;
+    static constexpr std::uint32_t shadow_resolution = 1024;
 
     properties_reader properties;
 
+    // bound once in constructor, render() reads values without name lookup,
+    // values follow file changes
+    struct
+    {
+        properties_reader::property<glm::vec3> light_pos;
+        properties_reader::property<glm::vec3> light_look_at;
+        properties_reader::property<glm::vec3> clear_color;
+        properties_reader::property<glm::vec3> cube_pos;
+        properties_reader::property<glm::vec3> rotate_axis;
+        properties_reader::property<float>     angle; ///< degrees per second
+        properties_reader::property<float>     lights_orbit_speed;
+        properties_reader::property<float>     shadow_updates_per_frame;
+    } runtime;
+
     std::unique_ptr<SDL_Window, void (*)(SDL_Window*)> window;
     std::unique_ptr<std::remove_pointer_t<SDL_GLContext>,
                     decltype(&SDL_GL_DestroyContext)>
         context;
 
-    gles30::shader depth_shader;
     gles30::shader shader_shadow;
 
-    gles30::mesh mesh_floor;
-    gles30::mesh mesh_cube;
+    // resolved once in constructor, render() never looks up uniform names
 
-    gles30::texture depth_texture;
-    gles30::mesh    mesh_quad;
+    struct
+    {
+        gles30::shader::uniform tex_shadow_map;
+    } shadow_uniforms;
+
+    /// per frame and per draw data of color pass streamed through
+    /// uniform_ring, few buffer writes instead of glUniform per value
+    static constexpr std::uint32_t frame_binding = 0;
+    static constexpr std::uint32_t draw_binding  = 1; ///< gles30::draw_block
+    static constexpr std::uint32_t atlas_binding = 2;
+
+    /// std140 layout of frame_data block, res/shadow.vert and .frag,
+    /// res/shadow_atlas.frag
+    struct frame_block
+    {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::vec3 light_pos;
+        float     far_plane;
+        glm::vec3 view_pos;
+        float     unused;
+    };
 
-    gles30::framebuffer depth_fbo;
+    gles30::mesh mesh_floor;
+    gles30::mesh mesh_cube;
 
     gles30::texture wood_texture;
 
-    bool use_perspective_matrix = false;
+    /// floor is static caster, cube dynamic (it spins if angle != 0), so
+    /// only faces around cube rendered again while it moves
+    gles30::point_shadows            shadows;
+    gles30::point_shadows::light_id  light;
+    gles30::point_shadows::caster_id floor_caster;
+    gles30::point_shadows::caster_id cube_caster;
+    float                            cube_angle = 0.f;
+
+    /// key 3: many lights, shadows of all in one atlas, only
+    /// shadow_updates_per_frame of them rendered per frame. Light 0 is
+    /// light_pos, others orbit around cube
+    static constexpr std::size_t atlas_max_lights  = 16; ///< MAX_LIGHTS
+    static constexpr std::size_t atlas_light_count = 12; ///< <= MAX_LIGHTS
+    static constexpr float       atlas_light_range = 8.f;
+    gles30::shader               shader_atlas;
+    struct
+    {
+        gles30::shader::uniform tex_shadow_atlas;
+    } atlas_uniforms;
+
+    /// std140 layout of atlas_data block, res/shadow_atlas.frag
+    struct atlas_block
+    {
+        struct light
+        {
+            glm::vec3 position;
+            float     unused;
+            glm::vec3 color;
+            float     range;
+        };
+        std::array<light, atlas_max_lights>         lights;
+        std::array<glm::vec4, atlas_max_lights * 6> light_tiles;
+        std::int32_t                                light_count;
+        float                                       atlas_texel;
+        float                                       unused[2];
+    };
+
+    gles30::shadow_atlas                                          atlas;
+    std::array<gles30::shadow_atlas::light_id, atlas_light_count> atlas_lights;
+    std::array<glm::vec3, atlas_light_count> atlas_positions;
+    std::array<glm::vec3, atlas_light_count> atlas_colors;
+    gles30::shadow_atlas::caster_id              atlas_cube_caster;
+    float                                        lights_orbit = 0.f;
+    bool                                         use_atlas    = false;
+
+    /// key 4: skip cube and crowd of small cubes behind wall when hidden
+    /// (hardware occlusion queries). Crowd does not cast shadows, so
+    /// shadow passes cost same as without it
+    static constexpr std::size_t crowd_columns = 8;
+    static constexpr std::size_t crowd_rows    = 6;
+    glm::mat4                    wall_model;
+    std::vector<glm::mat4>       crowd_models;
+    gles30::occlusion_culler     occlusion;
+    gles30::occlusion_culler::object_id              cube_object;
+    std::vector<gles30::occlusion_culler::object_id> crowd_objects;
+
+    /// draws sorted to minimize state changes
+    static constexpr std::uint8_t color_pass = 0;
+    gles30::render_queue          queue;
+    gles30::uniform_ring          uniforms;
+
+    /// GL calls of last frame issued and skipped by gles30::state_cache
+    gles30::state_cache::counters gl_calls;
+
+    /// color pass draws here, 0 - window, headless - offscreen framebuffer
+    std::uint32_t output_framebuffer = 0;
+
+#ifdef OM_GL_BENCHMARK
+    /// key 7: record camera to benchmark.path for --benchmark runs
+    benchmark::camera_path recorded_path;
+    float                  recording_time = 0.f;
+    bool                   recording      = false;
+#endif
 };
 
 void scene::pull_system_events(bool& continue_loop)
@@ -403,7 +557,10 @@ void scene::pull_system_events(bool& continue_loop)
             }
             else if (event.key.key == SDLK_0)
             {
-                use_perspective_matrix = !use_perspective_matrix;
+                shadows.set_layered(!shadows.is_layered());
+                std::cout << "point shadows layered (one pass): "
+                          << std::boolalpha << shadows.is_layered()
+                          << std::endl;
             }
             else if (event.key.key == SDLK_1)
             {
@@ -431,12 +588,47 @@ void scene::pull_system_events(bool& continue_loop)
             }
             else if (event.key.key == SDLK_2)
             {
+                std::cout << "gl calls per frame issued: " << gl_calls.issued
+                          << " skipped: " << gl_calls.skipped << std::endl;
+                const gles30::texture_streamer::counters& streamed =
+                    gles30::texture_streamer::get().get_counters();
+                std::cout << "textures decoding: " << streamed.decoding
+                          << " uploading: " << streamed.uploading
+                          << " last frame bytes: " << streamed.uploaded_bytes
+                          << std::endl;
+                const gles30::point_shadows::counters& shadow =
+                    shadows.get_counters();
+                std::cout << "shadow faces static: " << shadow.static_faces
+                          << " dynamic: " << shadow.dynamic_faces
+                          << " passes: " << shadow.passes
+                          << " draws: " << shadow.draws << std::endl;
+                const gles30::shadow_atlas::counters& packed =
+                    atlas.get_counters();
+                std::cout << "atlas lights rendered: " << packed.rendered
+                          << " waiting: " << packed.waiting
+                          << " unshadowed: " << packed.unshadowed
+                          << " draws: " << packed.draws << std::endl;
+                const gles30::occlusion_culler::counters& hidden =
+                    occlusion.get_counters();
+                std::cout << "occlusion queries: " << hidden.queries
+                          << " occluded: " << hidden.occluded
+                          << " pending: " << hidden.pending << std::endl;
+                const gles30::uniform_ring::counters& blocks =
+                    uniforms.get_counters();
+                std::cout << "uniform ring bytes: " << blocks.bytes
+                          << " fence waits: " << blocks.waits << std::endl;
             }
             else if (event.key.key == SDLK_3)
             {
+                use_atlas = !use_atlas;
+                std::cout << "point lights with shadow atlas: "
+                          << std::boolalpha << use_atlas << std::endl;
             }
             else if (event.key.key == SDLK_4)
             {
+                occlusion.set_enabled(!occlusion.is_enabled());
+                std::cout << "occlusion culling: " << std::boolalpha
+                          << occlusion.is_enabled() << std::endl;
             }
             else if (event.key.key == SDLK_5)
             {
@@ -454,6 +646,23 @@ void scene::pull_system_events(bool& continue_loop)
                     throw std::runtime_error(SDL_GetError());
                 }
             }
+#ifdef OM_GL_BENCHMARK
+            else if (event.key.key == SDLK_7)
+            {
+                recording = !recording;
+                if (recording)
+                {
+                    recorded_path.clear();
+                    recording_time = 0.f;
+                }
+                else
+                {
+                    recorded_path.save("benchmark.path");
+                }
+                std::cout << "record camera path to benchmark.path: "
+                          << std::boolalpha << recording << std::endl;
+            }
+#endif
         }
         else if (SDL_EVENT_WINDOW_RESIZED == event.type)
         {
@@ -471,136 +680,411 @@ void scene::pull_system_events(bool& continue_loop)
     }
 }
 
-scene::scene()
+scene::scene(output target)
     : properties("res/runtime.properties.hxx")
-    , window{ create_window(properties, gles30::multisampling::disable) }
-    , context{ create_opengl_context(window.get()) }
-    , depth_shader{ "res/depth.vert", "res/depth.frag" }
+    , window{ target == output::window
+                  ? create_window(properties, gles30::multisampling::disable)
+                  : decltype(window){ nullptr, destroy_window } }
+    , context{ target == output::window ? create_opengl_context(window.get())
+                                        : load_headless_opengl(target) }
     , shader_shadow{ "res/shadow.vert", "res/shadow.frag" }
     , mesh_floor{ create_mesh(
           plane_vertices.data(), plane_vertices.size() / 8, { &wood_texture }) }
     , mesh_cube{ create_mesh(
           cube_vertices.data(), cube_vertices.size() / 8, { &wood_texture }) }
-    , depth_texture{ gles30::texture::type::depth_component,
-                     gles30::texture::extent{ fbo_width, fbo_height },
-                     gles30::texture::pixel_type::gl_float }
-    , mesh_quad{ create_mesh(
-          quad_virtices, sizeof(quad_virtices) / 4 / 8, { &depth_texture }) }
-    , depth_fbo{ fbo_width, fbo_height, gles30::generate_render_object::no }
-    , wood_texture("res/wood.png", gles30::texture::type::diffuse)
+    , wood_texture("res/wood.png",
+                   gles30::texture::type::diffuse,
+                   gles30::texture::loading::streamed)
+    , shadows{ shadow_resolution, /*near*/ 0.1f, /*far*/ 25.f }
+    , shader_atlas{ "res/shadow.vert", "res/shadow_atlas.frag" }
+    , atlas{ /*size*/ 2048, /*min_tile*/ 32, /*max_tile*/ 256, /*near*/ 0.1f }
 {
-    depth_fbo.depth_attachment(depth_texture);
-    if (!depth_fbo.is_complete())
+    runtime.light_pos     = properties.bind<glm::vec3>("light_pos");
+    runtime.light_look_at = properties.bind<glm::vec3>("light_look_at");
+    runtime.clear_color   = properties.bind<glm::vec3>("clear_color");
+    runtime.cube_pos      = properties.bind<glm::vec3>("cube_pos");
+    runtime.rotate_axis   = properties.bind<glm::vec3>("rotate_axis");
+    runtime.angle         = properties.bind<float>("angle");
+    runtime.lights_orbit_speed =
+        properties.bind<float>("lights_orbit_speed");
+    runtime.shadow_updates_per_frame =
+        properties.bind<float>("shadow_updates_per_frame");
+
+    // wall from floor up, crowd behind it, hidden from start camera
+    wall_model = glm::translate(glm::mat4(1.0f), glm::vec3(0.f, 1.f, -3.f));
+    wall_model = glm::scale(wall_model, glm::vec3(4.f, 1.5f, 0.1f));
+    for (std::size_t row = 0; row < crowd_rows; ++row)
+    {
+        for (std::size_t column = 0; column < crowd_columns; ++column)
+        {
+            const glm::vec3 position(-3.5f + static_cast<float>(column),
+                                     -0.3f,
+                                     -4.5f - static_cast<float>(row));
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+            model           = glm::scale(model, glm::vec3(0.2f));
+            crowd_models.push_back(model);
+            crowd_objects.push_back(occlusion.add_object(mesh_cube, model));
+        }
+    }
+    cube_object = occlusion.add_object(mesh_cube, glm::mat4(1.0f));
+
+    using mobility = gles30::point_shadows::mobility;
+    light          = shadows.add_light(*runtime.light_pos);
+    floor_caster   = shadows.add_caster(
+        mesh_floor, glm::mat4(1.0f), mobility::static_caster);
+    shadows.add_caster(mesh_cube, wall_model, mobility::static_caster);
+    cube_caster = shadows.add_caster(
+        mesh_cube, glm::mat4(1.0f), mobility::dynamic_caster);
+
+    shader_shadow.bind_uniform_block("frame_data", frame_binding);
+    shader_shadow.bind_uniform_block("draw_data", draw_binding);
+    shadow_uniforms.tex_shadow_map =
+        shader_shadow.get_uniform("tex_shadow_map");
+
+    atlas.add_caster(mesh_floor, glm::mat4(1.0f));
+    atlas.add_caster(mesh_cube, wall_model);
+    atlas_cube_caster = atlas.add_caster(mesh_cube, glm::mat4(1.0f));
+    for (std::size_t i = 0; i < atlas_light_count; ++i)
     {
-        throw std::runtime_error("depth_fbo not complete");
+        atlas_lights[i] =
+            atlas.add_light(*runtime.light_pos, atlas_light_range);
+
+        // light 0 white, others around color wheel
+        const float h = 6.f * static_cast<float>(i) / atlas_light_count;
+        const glm::vec3 rgb(std::abs(h - 3.f) - 1.f,
+                            2.f - std::abs(h - 2.f),
+                            2.f - std::abs(h - 4.f));
+        atlas_colors[i] = i == 0 ? glm::vec3(1.f) : glm::clamp(rgb, 0.f, 1.f);
     }
-    depth_fbo.unbind();
+    shader_atlas.bind_uniform_block("frame_data", frame_binding);
+    shader_atlas.bind_uniform_block("draw_data", draw_binding);
+    shader_atlas.bind_uniform_block("atlas_data", atlas_binding);
+    atlas_uniforms.tex_shadow_atlas =
+        shader_atlas.get_uniform("tex_shadow_atlas");
 
     create_camera(properties);
 }
 
-void scene::render([[maybe_unused]] float delta_time)
+gles30::uniform_ring::range scene::push_atlas_block()
 {
-    camera.move_using_keyboard_wasd(delta_time);
-
-    glEnable(GL_DEPTH_TEST);
+    static_assert(atlas_light_count <= atlas_max_lights);
+    atlas_block block{};
+    block.light_count = static_cast<std::int32_t>(atlas_light_count);
+    block.atlas_texel = 1.f / static_cast<float>(atlas.get_size());
+    for (std::size_t i = 0; i < atlas_light_count; ++i)
+    {
+        block.lights[i].position = atlas_positions[i];
+        block.lights[i].color    = atlas_colors[i];
+        block.lights[i].range    = atlas.get_range(atlas_lights[i]);
+
+        const std::array<glm::vec4, 6>& tiles =
+            atlas.get_tiles(atlas_lights[i]);
+        std::copy(
+            tiles.begin(), tiles.end(), block.light_tiles.begin() + i * 6);
+    }
+    return uniforms.push(block);
+}
 
-    /// 1. render depth to texture
-    depth_texture.bind();
-    depth_texture.wrap_s(gles30::wrap::clamp_to_border);
-    depth_texture.wrap_t(gles30::wrap::clamp_to_border);
-    depth_texture.set_border_color(1.0f, 1.0f, 1.0f, 1.0f);
-    depth_fbo.bind();
+void scene::render([[maybe_unused]] float delta_time)
+{
+    if (window != nullptr)
+    {
+        camera.move_using_keyboard_wasd(delta_time);
+    }
+#ifdef OM_GL_BENCHMARK
+    if (recording)
+    {
+        recording_time += delta_time;
+        recorded_path.add(recording_time,
+                          { camera.position(), camera.direction() });
+    }
+#endif
 
-    clear_back_buffer(properties.get_vec3("clear_color"));
+    gles30::state_cache& state = gles30::state_cache::get();
+    state.enable(GL_DEPTH_TEST);
 
-    float     near_plane = 1.0f, far_plane = 7.5f;
-    glm::mat4 light_orto_projection =
-        glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
-    glm::mat4 light_perspective_projection = camera.projection_matrix();
+    light_pos     = *runtime.light_pos;
+    light_look_at = *runtime.light_look_at;
 
-    light_pos     = properties.get_vec3("light_pos");
-    light_look_at = properties.get_vec3("light_look_at");
+    cube_angle += *runtime.angle * delta_time;
+    glm::mat4 cube_model = glm::translate(glm::mat4(1.0f), *runtime.cube_pos);
+    cube_model           = glm::rotate(
+        cube_model, glm::radians(cube_angle), *runtime.rotate_axis);
+    cube_model = glm::scale(cube_model, glm::vec3(0.5f));
 
-    glm::mat4 light_view =
-        glm::lookAt(light_pos, light_look_at, glm::vec3(0.0f, 1.0f, 0.0f));
+    lights_orbit += *runtime.lights_orbit_speed * delta_time;
+    atlas_positions[0] = light_pos;
+    for (std::size_t i = 1; i < atlas_light_count; ++i)
+    {
+        const float angle = glm::radians(lights_orbit) +
+                            6.2831853f * static_cast<float>(i) /
+                                static_cast<float>(atlas_light_count - 1);
+        const float height = i % 2 == 0 ? 1.f : 2.5f;
+        atlas_positions[i] =
+            glm::vec3(4.f * std::cos(angle), height, 4.f * std::sin(angle));
+    }
 
-    depth_shader.use();
-    depth_shader.set_uniform("model", glm::mat4(1.f));
-    if (use_perspective_matrix)
+    /// 1. render changed faces of shadow cubemap, nothing if nothing moved,
+    /// or changed atlas lights up to budget
+    shadows.move_light(light, light_pos);
+    shadows.move_caster(cube_caster, cube_model);
+    for (std::size_t i = 0; i < atlas_light_count; ++i)
+    {
+        atlas.move_light(atlas_lights[i], atlas_positions[i]);
+    }
+    atlas.move_caster(atlas_cube_caster, cube_model);
+    if (use_atlas)
     {
-        depth_shader.set_uniform("view", light_view);
-        depth_shader.set_uniform("projection", light_perspective_projection);
+        atlas.update(camera.position(),
+                     glm::radians(camera.fovy()),
+                     screen_height,
+                     static_cast<std::uint32_t>(
+                         std::max(*runtime.shadow_updates_per_frame, 1.f)));
     }
     else
     {
-        depth_shader.set_uniform("view", light_view);
-        depth_shader.set_uniform("projection", light_orto_projection);
+        shadows.update();
     }
 
-    glViewport(0, 0, fbo_width, fbo_height);
-
-    mesh_floor.textures_disable();
-    mesh_cube.textures_disable();
-
-    // we render @floor without culling couse it is only one quad
-    // and only solid objects like @cube benifit from glCullFace(GL_FRONT)
-    // but even @cube shadow incorrect if shadow reciver are too close
-    // so we still need to play with bias in .frag shader
-    glDisable(GL_CULL_FACE);
-    mesh_floor.draw(depth_shader);
-
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_FRONT);
-
-    mesh_cube.draw(depth_shader);
-
-    depth_fbo.unbind();
-
-    /// 2. render floor and cube with shadow
-
-    glViewport(0, 0, screen_width, screen_height);
-    clear_back_buffer(properties.get_vec3("clear_color"));
-
-    shader_shadow.use();
-
-    shader_shadow.set_uniform("view", camera.view_matrix());
-    shader_shadow.set_uniform("projection", camera.projection_matrix());
-    shader_shadow.set_uniform("model", glm::mat4(1.f));
-    if (use_perspective_matrix)
+    gles30::shader& program = use_atlas ? shader_atlas : shader_shadow;
+
+    /// 2. render floor, wall and not occluded cubes with shadow
+    occlusion.begin_frame();
+    occlusion.move_object(cube_object, cube_model);
+
+    queue.begin();
+    queue.set_eye(color_pass, camera.position());
+    queue.submit({ .geometry = &mesh_floor,
+                   .program  = &program,
+                   .pass     = color_pass,
+                   .culling  = gles30::cull::none });
+    queue.submit({ .geometry = &mesh_cube,
+                   .program  = &program,
+                   .model    = wall_model,
+                   .pass     = color_pass,
+                   .culling  = gles30::cull::back });
+    if (occlusion.is_visible(cube_object))
     {
-        shader_shadow.set_uniform("light_space_matrix",
-                                  light_perspective_projection * light_view);
+        queue.submit({ .geometry = &mesh_cube,
+                       .program  = &program,
+                       .model    = cube_model,
+                       .pass     = color_pass,
+                       .culling  = gles30::cull::back });
     }
-    else
+    for (std::size_t i = 0; i < crowd_models.size(); ++i)
     {
-        shader_shadow.set_uniform("light_space_matrix",
-                                  light_orto_projection * light_view);
+        if (occlusion.is_visible(crowd_objects[i]))
+        {
+            queue.submit({ .geometry = &mesh_cube,
+                           .program  = &program,
+                           .model    = crowd_models[i],
+                           .pass     = color_pass,
+                           .culling  = gles30::cull::back });
+        }
     }
+    queue.sort();
+
+    // all uniform blocks of frame go to ring with one upload, draws only
+    // rebind ranges of it
+    uniforms.begin_frame();
+    const gles30::uniform_ring::range frame_range =
+        uniforms.push(frame_block{ .projection = camera.projection_matrix(),
+                                   .view       = camera.view_matrix(),
+                                   .light_pos  = light_pos,
+                                   .far_plane  = shadows.get_far_plane(),
+                                   .view_pos   = camera.position(),
+                                   .unused     = 0.f });
+    const gles30::uniform_ring::range atlas_range =
+        use_atlas ? push_atlas_block() : gles30::uniform_ring::range{};
+    queue.write_draw_blocks(uniforms, draw_binding);
+    uniforms.upload();
+
+    queue.execute(
+        [&](std::uint8_t)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, output_framebuffer);
+            glViewport(0, 0, screen_width, screen_height);
+            clear_back_buffer(*runtime.clear_color);
+
+            uniforms.bind(frame_binding, frame_range);
+            if (use_atlas)
+            {
+                shader_atlas.use();
+                uniforms.bind(atlas_binding, atlas_range);
+                atlas.bind_atlas(2);
+                shader_atlas.set_uniform(atlas_uniforms.tex_shadow_atlas,
+                                         std::int32_t{ 2 });
+                return;
+            }
+
+            shader_shadow.use();
+
+            // we need set by hand third texture - shadow cubemap - see
+            // res/shadow.frag
+            shadows.bind_cubemap(light, 2);
+            shader_shadow.set_uniform(shadow_uniforms.tex_shadow_map,
+                                      std::int32_t{ 2 });
+        });
+    uniforms.end_frame();
+
+    /// 3. test boxes of cubes against depth of this frame, results used in
+    /// next frames
+    occlusion.issue_queries(camera.projection_matrix() * camera.view_matrix(),
+                            camera.position(),
+                            camera.z_near());
+}
 
-    shader_shadow.set_uniform("light_pos", light_pos);
-    shader_shadow.set_uniform("view_pos", camera.position());
+#ifdef OM_GL_BENCHMARK
+/// lesson --benchmark [key=value ...], see benchmark.hxx
+static int run_benchmark(const benchmark::options& settings)
+{
+    benchmark::headless_context headless(
+        settings.width, settings.height, settings.context);
+    scene scene(settings.context == benchmark::headless_context::api::gles
+                    ? output::headless_es
+                    : output::headless_desktop);
+    scene.output_framebuffer = headless.get_framebuffer();
+
+    screen_width  = static_cast<float>(settings.width);
+    screen_height = static_cast<float>(settings.height);
+    screen_aspect = screen_width / screen_height;
+    camera.aspect(screen_aspect);
 
-    // we need set by hand third texture - shadow_map - see res/shadow.fsh
-    shader_shadow.set_uniform("tex_shadow_map", depth_texture, 2);
+    // streamed textures must be ready, or first frames and png differ
+    while (!gles30::texture_streamer::get().idle())
+    {
+        gles30::texture_streamer::get().update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
 
-    mesh_floor.textures_enable();
-    mesh_cube.textures_enable();
+    benchmark::run(settings,
+                   headless,
+                   [&](const benchmark::frame_info& frame)
+                   {
+                       if (frame.has_camera)
+                       {
+                           fps_camera next(frame.camera.position,
+                                           frame.camera.direction,
+                                           /*up*/ { 0, 1, 0 });
+                           next.fovy(camera.fovy());
+                           next.aspect(camera.aspect());
+                           next.z_near(camera.z_near());
+                           next.z_far(camera.z_far());
+                           camera = next;
+                       }
+                       gles30::texture_streamer::get().update();
+                       scene.render(frame.dt);
+                       scene.gl_calls =
+                           gles30::state_cache::get().end_frame();
+                   });
+    return 0;
+}
 
-    glDisable(GL_CULL_FACE);
+/// lesson --check-occlusion: box behind wall must become occluded, box in
+/// front of it stay visible, and issue_queries() must leave depth and
+/// color state of caller as it was. Exit code 0 - passed, used by ctest
+static int run_occlusion_check(benchmark::headless_context::api type)
+{
+    benchmark::headless_context headless(64, 64, type);
+    const auto gl = load_headless_opengl(
+        type == benchmark::headless_context::api::gles
+            ? output::headless_es
+            : output::headless_desktop);
+
+    gles30::mesh wall_mesh =
+        create_mesh(cube_vertices.data(), cube_vertices.size() / 8, {});
+    // same shader as occlusion boxes, only depth of wall needed
+    gles30::shader depth_only("res/occlusion_box.vert",
+                              "res/occlusion_box.frag");
+    const gles30::shader::uniform wall_matrix =
+        depth_only.get_uniform("box_matrix");
+
+    const glm::vec3 eye(0.f, 0.f, 5.f);
+    const float     near_plane = 0.1f;
+    const glm::mat4 projection_view =
+        glm::perspective(glm::radians(45.f), 1.f, near_plane, 100.f) *
+        glm::lookAt(eye, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+    const glm::mat4 wall_model =
+        glm::scale(glm::mat4(1.f), glm::vec3(8.f, 8.f, 0.2f));
+
+    gles30::occlusion_culler occlusion;
+    const auto               hidden = occlusion.add_object(
+        wall_mesh, glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, -3.f)));
+    const auto front = occlusion.add_object(
+        wall_mesh, glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, 2.f)));
+
+    // not default, so forced GL_LESS after queries is caught
+    gles30::state_cache& state = gles30::state_cache::get();
+    state.depth_func(GL_LEQUAL);
+
+    // visible objects tested every 8 frames, result read next frame
+    constexpr int frames = 10;
+    for (int i = 0; i <= frames; ++i)
+    {
+        occlusion.begin_frame();
+        if (i == frames)
+        {
+            break;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, headless.get_framebuffer());
+        glViewport(0, 0, 64, 64);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+                GL_STENCIL_BUFFER_BIT);
+        state.enable(GL_DEPTH_TEST);
+        depth_only.use();
+        depth_only.set_uniform(wall_matrix, projection_view * wall_model);
+        wall_mesh.draw(depth_only, false);
+
+        occlusion.issue_queries(projection_view, eye, near_plane);
+        glFinish(); // results available in next begin_frame()
+    }
 
-    // glCullFace(GL_BACK); // floor is only one quad
-    mesh_floor.draw(shader_shadow);
+    GLboolean                depth_mask = GL_FALSE;
+    GLint                    depth_func = 0;
+    std::array<GLboolean, 4> color_mask{};
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask);
+    glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+    glGetBooleanv(GL_COLOR_WRITEMASK, color_mask.data());
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    mesh_cube.draw(shader_shadow);
+    bool       passed = true;
+    const auto expect = [&passed](bool value, std::string_view what)
+    {
+        std::cout << (value ? "ok: " : "failed: ") << what << '\n';
+        passed = passed && value;
+    };
+    expect(!occlusion.is_visible(hidden), "box behind wall occluded");
+    expect(occlusion.is_visible(front), "box in front of wall visible");
+    expect(depth_mask == GL_TRUE, "depth writes restored");
+    expect(depth_func == GL_LEQUAL, "depth function restored");
+    expect(std::ranges::all_of(color_mask,
+                               [](GLboolean c) { return c == GL_TRUE; }),
+           "color writes restored");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
 }
+#endif
 
-int main(int /*argc*/, char* /*argv*/[])
+int main(int argc, char* argv[])
 {
     try
     {
+#ifdef OM_GL_BENCHMARK
+        benchmark::options defaults;
+        defaults.context = gles30::is_desktop()
+                               ? benchmark::headless_context::api::desktop_core
+                               : benchmark::headless_context::api::gles;
+        if (argc > 1 && std::string_view(argv[1]) == "--check-occlusion")
+        {
+            return run_occlusion_check(defaults.context);
+        }
+        if (const std::optional<benchmark::options> settings =
+                benchmark::parse_options(argc, argv, defaults))
+        {
+            return run_benchmark(*settings);
+        }
+#else
+        static_cast<void>(argc);
+        static_cast<void>(argv);
+#endif
         gles30::windows_make_process_dpi_aware();
 
         {
@@ -617,7 +1101,11 @@ int main(int /*argc*/, char* /*argv*/[])
 
                 scene.pull_system_events(continue_loop);
 
+                gles30::texture_streamer::get().update();
+
                 scene.render(delta_time);
+
+                scene.gl_calls = gles30::state_cache::get().end_frame();
             }
         }
 
@@ -14,23 +14,30 @@
 //              *_literal operation expression,
 //              identifier operation expression,
 //              '{' expression ',' expression ',' expression '}'>
+//
+// file lexed in one pass and evaluated while parsed, no syntax tree
 
 #include "properties_reader.hxx"
 
 #include <algorithm>
 #include <array>
-// #include <charconv>
-#include <forward_list>
+#include <charconv>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <numeric>
-#include <regex>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <variant>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 #ifdef __GNUG__
 #include <cstdlib>
@@ -89,21 +96,29 @@ using value_t = std::variant<std::string, glm::vec3, float, bool>;
 std::ostream& operator<<(std::ostream& stream, const enum token::type t);
 std::ostream& operator<<(std::ostream& stream, const value_t& t);
 
-struct lexer_t
+/// line with token and ^ under its first character
+static std::string print_position(std::string_view content,
+                                  std::string_view token_value)
 {
-    struct token_regex
-    {
-        token_regex(enum token::type t_, const char* r_)
-            : type{ t_ }
-            , regex{ r_ }
-        {
-        }
-        enum token::type type;
-        std::regex       regex;
-    };
+    const auto offset =
+        static_cast<size_t>(token_value.data() - content.data());
+    const size_t line_begin = content.rfind('\n', offset) + 1; // npos + 1 = 0
+    const size_t line_end =
+        std::min(content.find('\n', offset), content.size());
+    const auto   line_number =
+        std::count(content.begin(), content.begin() + offset, '\n') + 1;
+
+    std::stringstream ss;
+    ss << "\nline " << line_number << ":\n"
+       << content.substr(line_begin, line_end - line_begin) << '\n'
+       << std::string(offset - line_begin, ' ') << '^';
+    return ss.str();
+}
 
-    explicit lexer_t(std::string content_)
-        : content{ std::move(content_) }
+struct lexer_t
+{
+    explicit lexer_t(std::string_view content_)
+        : content{ content_ }
     {
         try
         {
@@ -116,383 +131,363 @@ struct lexer_t
         }
     }
 
-    std::vector<token> tokens;
-    const std::string  content;
+    std::vector<token>     tokens;
+    const std::string_view content;
 
 private:
-    void generate_token_stream()
+    static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    static bool is_identifier_start(char c)
     {
-        std::vector<token_regex> token_bind;
-
-        token_bind.reserve(10);
-        token_bind.emplace_back(token::type::type_id,
-                                R"(float|std::string|glm::vec3|bool)");
-        token_bind.emplace_back(token::type::operation, R"(=|\+|-|\*|\/)");
-        token_bind.emplace_back(token::type::float_literal,
-                                R"([+-]?([0-9]+([.][0-9]*)?|[.][0-9]+)f)");
-        // original from internet: /"([^"\\]|\\.)*"/
-        token_bind.emplace_back(token::type::string_literal,
-                                R"("([^"\\]|\\.)*")");
-        token_bind.emplace_back(token::type::bool_literal, R"(true|false)");
-        token_bind.emplace_back(token::type::identifier,
-                                R"([a-zA-Z_][a-zA-Z0-9_]*)");
-        token_bind.emplace_back(token::type::semicolon, R"(;)");
-        token_bind.emplace_back(token::type::open_curly_bracket, R"(\{)");
-        token_bind.emplace_back(token::type::close_curle_bracket, R"(\})");
-        token_bind.emplace_back(token::type::comma, R"(\,)");
-        token_bind.emplace_back(token::type::none, R"(#.*\n|//.*\n| |\n|\t)");
-
-        std::string_view rest_content{ content };
-        bool             cant_find_match = false;
-
-        while (!rest_content.empty() && !cant_find_match)
-        {
-            std::cmatch      token_best_match;
-            enum token::type token_best_type{ token::type::none };
-
-            for (token_regex& tok_regex : token_bind)
-            {
-                std::cmatch token_match;
-                if (std::regex_search(rest_content.data(),
-                                      rest_content.data() +
-                                          rest_content.length(),
-                                      token_match,
-                                      tok_regex.regex,
-                                      std::regex_constants::match_continuous))
-                {
-                    auto first = token_match.cbegin();
-                    if (token_best_match.empty() ||
-                        first->length() > token_best_match.cbegin()->length())
-                    {
-                        token_best_match = token_match;
-                        token_best_type  = tok_regex.type;
-                    }
-                }
-            }
-
-            if (!token_best_match.empty())
-            {
-                token tok;
-                tok.type                   = token_best_type;
-                auto&       first_match    = token_best_match[0];
-                const char* first_char_ptr = first_match.first;
-                auto        length = static_cast<size_t>(first_match.length());
-                tok.value          = std::string_view(first_char_ptr, length);
-
-                rest_content = rest_content.substr(tok.value.size());
-
-                if (tok.type == token::type::string_literal)
-                {
-                    // skip "" - charecters in string literal
-                    tok.value = tok.value.substr(1, tok.value.size() - 2);
-                }
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+    static bool is_identifier_char(char c)
+    {
+        return is_identifier_start(c) || is_digit(c);
+    }
 
-                if (token_best_type == token::type::none)
-                {
-                    continue;
-                }
-                else
-                {
-                    tokens.push_back(tok);
-                }
-            }
-            else
+    /// length of [+-]?([0-9]+([.][0-9]*)?|[.][0-9]+)f at pos, 0 if no
+    /// match, so sign without number is operation
+    [[nodiscard]] size_t float_length(size_t pos) const
+    {
+        const size_t start = pos;
+        if (content[pos] == '+' || content[pos] == '-')
+        {
+            ++pos;
+        }
+        const auto skip_digits = [&]
+        {
+            const size_t first = pos;
+            while (pos < content.size() && is_digit(content[pos]))
             {
-                cant_find_match = true;
+                ++pos;
             }
-        } // while
+            return pos - first;
+        };
 
-        if (!rest_content.empty())
+        const size_t integer_digits = skip_digits();
+        size_t       fraction_digits = 0;
+        if (pos < content.size() && content[pos] == '.')
+        {
+            ++pos;
+            fraction_digits = skip_digits();
+        }
+        if (integer_digits == 0 && fraction_digits == 0)
+        {
+            return 0;
+        }
+        if (pos >= content.size() || content[pos] != 'f')
         {
-            throw std::runtime_error("can't find regex startfing from: " +
-                                     std::string(rest_content));
+            return 0;
         }
+        return pos + 1 - start;
+    }
 
-        if constexpr (print_debug_info)
+    /// identifier with optional :: parts, like std::string
+    [[nodiscard]] size_t word_length(size_t pos) const
+    {
+        const size_t start = pos;
+        while (pos < content.size())
         {
-            for (auto tok : tokens)
+            if (is_identifier_char(content[pos]))
             {
-                std::clog << tok.type << " = [" << tok.value << "]\n";
+                ++pos;
+            }
+            else if (content.substr(pos, 2) == "::" &&
+                     pos + 2 < content.size() &&
+                     is_identifier_start(content[pos + 2]))
+            {
+                pos += 2;
+            }
+            else
+            {
+                break;
             }
         }
+        return pos - start;
     }
-};
 
-struct parser_t
-{
-    struct expression_t
+    void add(enum token::type type, size_t pos, size_t length)
     {
-        virtual ~expression_t() = default;
-        virtual value_t evaluate(
-            std::unordered_map<std::string, value_t>& key_values) const = 0;
-    };
+        tokens.push_back({ type, content.substr(pos, length) });
+    }
 
-    struct definition_ast
+    [[noreturn]] void fail(std::string_view what, size_t pos) const
     {
-        token*                        type_id    = nullptr;
-        token*                        identifier = nullptr;
-        token*                        operation  = nullptr;
-        std::shared_ptr<expression_t> expression;
-        token*                        semicolon = nullptr;
-    };
+        throw std::runtime_error(
+            "error: " + std::string(what) +
+            print_position(content, content.substr(pos, 1)));
+    }
 
-    struct literal_expr : expression_t
+    void generate_token_stream()
     {
-        token* literal = nullptr;
-
-        value_t evaluate(
-            std::unordered_map<std::string, value_t>&) const override
+        size_t pos = 0;
+        while (pos < content.size())
         {
-            if (literal->type == token::type::string_literal)
+            const char c = content[pos];
+
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
             {
-                return std::string{ literal->value };
+                ++pos;
             }
-            else if (literal->type == token::type::float_literal)
+            else if (c == '#' || content.substr(pos, 2) == "//")
             {
-                const std::string value{ literal->value };
-                return std::stof(value);
+                // comment or #include till end of line
+                pos = std::min(content.find('\n', pos), content.size());
             }
-            else if (literal->type == token::type::bool_literal)
+            else if (c == '"')
             {
-                return literal->value == "true";
+                size_t end = pos + 1;
+                while (end < content.size() && content[end] != '"')
+                {
+                    end += content[end] == '\\' ? 2 : 1;
+                }
+                if (end >= content.size())
+                {
+                    fail("string literal without closing \"", pos);
+                }
+                // skip "" - charecters in string literal
+                add(token::type::string_literal, pos + 1, end - pos - 1);
+                pos = end + 1;
+            }
+            else if (const size_t length = float_length(pos); length != 0)
+            {
+                add(token::type::float_literal, pos, length);
+                pos += length;
+            }
+            else if (c == '=' || c == '+' || c == '-' || c == '*' || c == '/')
+            {
+                add(token::type::operation, pos++, 1);
+            }
+            else if (c == ';')
+            {
+                add(token::type::semicolon, pos++, 1);
+            }
+            else if (c == '{')
+            {
+                add(token::type::open_curly_bracket, pos++, 1);
+            }
+            else if (c == '}')
+            {
+                add(token::type::close_curle_bracket, pos++, 1);
+            }
+            else if (c == ',')
+            {
+                add(token::type::comma, pos++, 1);
+            }
+            else if (is_identifier_start(c))
+            {
+                const size_t           length = word_length(pos);
+                const std::string_view word   = content.substr(pos, length);
+                if (word == "float" || word == "bool" ||
+                    word == "std::string" || word == "glm::vec3")
+                {
+                    add(token::type::type_id, pos, length);
+                }
+                else if (word == "true" || word == "false")
+                {
+                    add(token::type::bool_literal, pos, length);
+                }
+                else if (word.find("::") == std::string_view::npos)
+                {
+                    add(token::type::identifier, pos, length);
+                }
+                else
+                {
+                    fail("unknown type: " + std::string(word), pos);
+                }
+                pos += length;
             }
             else
             {
-                throw std::runtime_error("error: unsuported literal: " +
-                                         std::string(literal->value));
+                fail("unexpected character", pos);
             }
         }
-    };
-
-    struct identifier_expr : expression_t
-    {
-        token* identifier = nullptr;
-
-        value_t evaluate(
-            std::unordered_map<std::string, value_t>& key_values) const override
-        {
-            const std::string value{ identifier->value };
-            return key_values.at(value);
-        }
-    };
-
-    struct gml_vec3_expr : expression_t
-    {
-        token*                        open_curl = nullptr;
-        std::shared_ptr<expression_t> x_component;
-        token*                        first_comma = nullptr;
-        std::shared_ptr<expression_t> y_component;
-        token*                        second_comma = nullptr;
-        std::shared_ptr<expression_t> z_component;
-        token*                        close_curl = nullptr;
-
-        value_t evaluate(
-            std::unordered_map<std::string, value_t>& key_values) const override
-        {
-            float x = std::get<float>(x_component->evaluate(key_values));
-            float y = std::get<float>(y_component->evaluate(key_values));
-            float z = std::get<float>(z_component->evaluate(key_values));
-            return { glm::vec3(x, y, z) };
-        }
-    };
-
-    struct sub_expr : expression_t
-    {
-        std::shared_ptr<expression_t> identifier_or_literal;
-        token*                        operation = nullptr;
-        std::shared_ptr<expression_t> other_expr;
 
-        value_t evaluate(
-            std::unordered_map<std::string, value_t>& key_values) const override
+        if constexpr (print_debug_info)
         {
-            value_t left  = identifier_or_literal->evaluate(key_values);
-            value_t right = other_expr->evaluate(key_values);
-            return parser_t::apply(operation->value, left, right);
+            for (auto tok : tokens)
+            {
+                std::clog << tok.type << " = [" << tok.value << "]\n";
+            }
         }
-    };
-
-    std::vector<definition_ast> commands;
+    }
+};
 
-    lexer_t& lexer;
+/// evaluates definitions while parsing them, fills key_values
+struct interpretator_t
+{
+    const lexer_t&                            lexer;
+    std::unordered_map<std::string, value_t>& key_values;
+    size_t                                    current = 0;
 
-    void generate_ast()
+    interpretator_t(const lexer_t&                            lexer_,
+                    std::unordered_map<std::string, value_t>& key_values_)
+        : lexer{ lexer_ }
+        , key_values{ key_values_ }
     {
-        for (auto token_iter = begin(lexer.tokens);
-             token_iter != end(lexer.tokens);)
-        {
-            definition_ast key_val;
-            key_val.type_id = expected(token_iter, token::type::type_id);
-            ++token_iter;
-            key_val.identifier = expected(token_iter, token::type::identifier);
-            ++token_iter;
-            key_val.operation = expected(token_iter, token::type::operation);
-            ++token_iter;
-            key_val.expression = parse_expression(token_iter);
-            key_val.semicolon  = expected(token_iter, token::type::semicolon);
-            ++token_iter;
-            commands.push_back(key_val);
-        }
     }
 
-    explicit parser_t(lexer_t& lexer_)
-        : lexer{ lexer_ }
+    void run()
     {
         try
         {
-            generate_ast();
+            while (current < lexer.tokens.size())
+            {
+                execute_definition();
+            }
         }
         catch (...)
         {
             std::cerr << "error: parser failed:" << std::endl;
             throw;
         }
-    }
 
-    std::string print_position_of_token(const token& token)
-    {
-        std::string_view from_start_to_token(
-            lexer.content.data(),
-            static_cast<size_t>(token.value.data() - lexer.content.data()) +
-                token.value.length());
-        std::stringstream ss;
-        ss << '\n' << from_start_to_token << '\n';
-        size_t last_line_length = 0;
-        for (auto back_char = &from_start_to_token.back();
-             *back_char != '\0' && *back_char != '\n';
-             --back_char)
+        if constexpr (print_debug_info)
         {
-            ++last_line_length;
+            // dump values
+            for (const auto& [key, value] : key_values)
+            {
+                std::cout << key << "=[" << value << "]" << std::endl;
+            }
         }
-        last_line_length -= token.value.length();
-        ss << std::string(last_line_length, ' ') << '^';
-        return ss.str();
     }
 
-    token* expected(const std::vector<token>::iterator& it,
-                    const enum token::type              type)
+private:
+    [[nodiscard]] const token* peek() const
     {
-        if (it == end(lexer.tokens))
+        return current < lexer.tokens.size() ? &lexer.tokens[current]
+                                             : nullptr;
+    }
+
+    [[nodiscard]] bool next_is(enum token::type type) const
+    {
+        const token* tok = peek();
+        return tok != nullptr && tok->type == type;
+    }
+
+    const token& expected(const enum token::type type)
+    {
+        const token* tok = peek();
+        if (tok == nullptr)
         {
             std::stringstream ss;
             ss << "error: expected " << type << " but got: EOF";
             throw std::runtime_error(ss.str());
         }
-        if (it->type != type)
+        if (tok->type != type)
         {
             std::stringstream ss;
-            ss << "error: expected " << type << " but got: " << it->value;
-            ss << print_position_of_token(*it);
+            ss << "error: expected " << type << " but got: " << tok->value;
+            ss << print_position(lexer.content, tok->value);
             throw std::runtime_error(ss.str());
         }
-        return &(*it);
+        ++current;
+        return *tok;
     }
 
-    token* expected_one_of(
-        const std::vector<token>::iterator&                 it,
-        const std::initializer_list<decltype(token::type)>& types)
+    [[noreturn]] void fail(std::string_view what, const token& tok) const
     {
-        if (it == end(lexer.tokens))
-        {
-            std::stringstream ss;
-            ss << "error: expected one of: ";
-            for (auto type : types)
-            {
-                ss << type << ", ";
-            }
-            ss << " but got: EOF";
-            throw std::runtime_error(ss.str());
-        }
-        auto type_it = std::ranges::find(types, it->type);
-        if (type_it == std::end(types))
+        throw std::runtime_error("error: " + std::string(what) +
+                                 print_position(lexer.content, tok.value));
+    }
+
+    static bool has_type(const value_t& value, std::string_view type_id)
+    {
+        return (type_id == "float" && std::holds_alternative<float>(value)) ||
+               (type_id == "bool" && std::holds_alternative<bool>(value)) ||
+               (type_id == "std::string" &&
+                std::holds_alternative<std::string>(value)) ||
+               (type_id == "glm::vec3" &&
+                std::holds_alternative<glm::vec3>(value));
+    }
+
+    void execute_definition()
+    {
+        const token& type_id    = expected(token::type::type_id);
+        const token& identifier = expected(token::type::identifier);
+        expected(token::type::operation);
+        value_t value = parse_expression();
+        expected(token::type::semicolon);
+
+        // handles are typed, so value must be of declared type
+        if (!has_type(value, type_id.value))
         {
-            std::stringstream ss;
-            ss << "error: expected ";
-            for (auto type : types)
-            {
-                ss << type << ", ";
-            }
-            ss << "but got: " << it->type;
-            ss << print_position_of_token(*it);
-            throw std::runtime_error(ss.str());
+            fail("value does not match type " + std::string(type_id.value),
+                 identifier);
         }
-        return &(*it);
+        key_values[std::string(identifier.value)] = std::move(value);
     }
-    std::shared_ptr<expression_t> parse_expression(
-        std::vector<token>::iterator& token_it)
+
+    value_t parse_literal_or_identifier()
     {
-        if (token_it->type == token::type::open_curly_bracket)
+        const token* tok = peek();
+        if (tok == nullptr)
         {
-            // parse {expression, expression, expression};
-            auto expr = std::make_shared<parser_t::gml_vec3_expr>();
-            expr->open_curl =
-                expected(token_it, token::type::open_curly_bracket);
-            ++token_it;
-            expr->x_component = parse_expression(token_it);
-            expr->first_comma = expected(token_it, token::type::comma);
-            ++token_it;
-            expr->y_component  = parse_expression(token_it);
-            expr->second_comma = expected(token_it, token::type::comma);
-            ++token_it;
-            expr->z_component = parse_expression(token_it);
-            expr->close_curl =
-                expected(token_it, token::type::close_curle_bracket);
-            ++token_it;
-            return expr;
-        }
-        else if (token_it->type == token::type::float_literal ||
-                 token_it->type == token::type::string_literal ||
-                 token_it->type == token::type::bool_literal)
-        {
-            token* literal = &*token_it;
-            ++token_it;
-            if (token_it->type == token::type::semicolon ||
-                token_it->type == token::type::close_curle_bracket ||
-                token_it->type == token::type::comma)
-            {
-                auto expr     = std::make_shared<parser_t::literal_expr>();
-                expr->literal = literal;
-                return expr;
-            }
-            else
-            {
-                token* operation  = expected(token_it, token::type::operation);
-                auto   first_expr = std::make_shared<literal_expr>();
-                first_expr->literal         = literal;
-                auto expr                   = std::make_shared<sub_expr>();
-                expr->identifier_or_literal = first_expr;
-                expr->operation             = operation;
-                ++token_it;
-                expr->other_expr = parse_expression(token_it);
-                return expr;
-            }
+            throw std::runtime_error("error: expected expression but got: EOF");
         }
-        else if (token_it->type == token::type::identifier)
+        ++current;
+        switch (tok->type)
         {
-            token* identifier = &*token_it;
-            ++token_it;
-            if (token_it->type == token::type::semicolon ||
-                token_it->type == token::type::close_curle_bracket ||
-                token_it->type == token::type::comma)
+            case token::type::string_literal:
+                return std::string{ tok->value };
+            case token::type::bool_literal:
+                return tok->value == "true";
+            case token::type::float_literal:
             {
-                auto expr = std::make_shared<parser_t::identifier_expr>();
-                expr->identifier = identifier;
-                return expr;
+                // from_chars does not accept '+', f suffix not number
+                std::string_view number = tok->value;
+                number.remove_prefix(number.front() == '+' ? 1 : 0);
+                number.remove_suffix(1);
+                float result{};
+                auto [end, error] = std::from_chars(
+                    number.data(), number.data() + number.size(), result);
+                if (error != std::errc{} ||
+                    end != number.data() + number.size())
+                {
+                    fail("bad float literal", *tok);
+                }
+                return result;
             }
-            else
+            case token::type::identifier:
             {
-                token* operation  = expected(token_it, token::type::operation);
-                auto   first_expr = std::make_shared<identifier_expr>();
-                first_expr->identifier      = identifier;
-                auto expr                   = std::make_shared<sub_expr>();
-                expr->identifier_or_literal = first_expr;
-                expr->operation             = operation;
-                ++token_it;
-                expr->other_expr = parse_expression(token_it);
-                return expr;
+                auto it = key_values.find(std::string(tok->value));
+                if (it == key_values.end())
+                {
+                    fail("unknown identifier", *tok);
+                }
+                return it->second;
             }
+            default:
+                fail("expected expression", *tok);
+        }
+    }
+
+    value_t parse_expression()
+    {
+        if (next_is(token::type::open_curly_bracket))
+        {
+            // parse {expression, expression, expression};
+            ++current;
+            const float x = std::get<float>(parse_expression());
+            expected(token::type::comma);
+            const float y = std::get<float>(parse_expression());
+            expected(token::type::comma);
+            const float z = std::get<float>(parse_expression());
+            expected(token::type::close_curle_bracket);
+            return glm::vec3(x, y, z);
         }
 
-        throw std::runtime_error("error: parse failed:");
+        value_t left = parse_literal_or_identifier();
+        if (next_is(token::type::semicolon) ||
+            next_is(token::type::close_curle_bracket) ||
+            next_is(token::type::comma))
+        {
+            return left;
+        }
+        // right to left, no priorities: a - b - c == a - (b - c)
+        const token& operation = expected(token::type::operation);
+        value_t      right     = parse_expression();
+        return apply(operation.value, left, right);
     }
 
     static value_t apply(std::string_view operator_literal,
@@ -552,42 +547,6 @@ struct parser_t
     }
 };
 
-struct interpretator_t
-{
-    parser_t& parser;
-    explicit interpretator_t(parser_t& parser_)
-        : parser{ parser_ }
-    {
-    }
-
-    void run(std::unordered_map<std::string, value_t>& key_values)
-    {
-        // interpret program and fill key_values map
-        for (/*[[maybe_unused]]*/ const auto& command : parser.commands)
-        {
-            execute(command, key_values);
-        }
-
-        if constexpr (print_debug_info)
-        {
-            // dump values
-            for (const auto& [key, value] : key_values)
-            {
-                std::cout << key << "=[" << value << "]" << std::endl;
-            }
-        }
-    }
-
-private:
-    void execute(const parser_t::definition_ast&           command,
-                 std::unordered_map<std::string, value_t>& key_values)
-    {
-        value_t     value = command.expression->evaluate(key_values);
-        std::string identifier{ command.identifier->value };
-        key_values[identifier] = value;
-    }
-};
-
 class properties_reader::impl
 {
 public:
@@ -595,7 +554,22 @@ public:
         : path{ std::move(path_) }
         , last_update_time{ std::filesystem::last_write_time(path) }
     {
-        build_properties_map();
+        watch_file();
+        content = load_file();
+        build_properties_map(content);
+    }
+
+    impl(const impl&)            = delete;
+    impl& operator=(const impl&) = delete;
+
+    ~impl()
+    {
+#ifdef __linux__
+        if (watch_fd != -1)
+        {
+            close(watch_fd);
+        }
+#endif
     }
 
     [[nodiscard]] const std::filesystem::path& get_filepath() const
@@ -670,16 +644,103 @@ public:
 
     void update_changes()
     {
-        std::filesystem::file_time_type new_time =
-            std::filesystem::last_write_time(path);
-        if (new_time != last_update_time)
+        if (!file_changed())
+        {
+            return;
+        }
+        std::string new_content;
+        try
+        {
+            new_content = load_file();
+        }
+        catch (const std::exception&)
+        {
+            return; // editor replaces file, next event brings new one
+        }
+        // touched but same bytes - nothing to parse
+        if (new_content == content)
         {
-            last_update_time = new_time;
-            build_properties_map();
+            return;
+        }
+        content = std::move(new_content);
+        try
+        {
+            build_properties_map(content);
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl
+                      << "    properties file [" << path << "]" << std::endl
+                      << "    keep previous values" << std::endl;
         }
     }
 
 private:
+    /// on linux inotify watches directory, not file, so file replaced by
+    /// editor (write new, rename over old) still reported
+    void watch_file()
+    {
+#ifdef __linux__
+        watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watch_fd == -1)
+        {
+            return; // fallback to last_write_time
+        }
+        const std::filesystem::path directory =
+            path.has_parent_path() ? path.parent_path()
+                                   : std::filesystem::path(".");
+        if (inotify_add_watch(watch_fd,
+                              directory.c_str(),
+                              IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+        {
+            close(watch_fd);
+            watch_fd = -1;
+        }
+#endif
+    }
+
+    bool file_changed()
+    {
+#ifdef __linux__
+        if (watch_fd != -1)
+        {
+            const std::string file_name = path.filename().string();
+            bool              changed   = false;
+            alignas(inotify_event) std::array<char, 4096> buffer;
+            for (;;)
+            {
+                const ssize_t length =
+                    read(watch_fd, buffer.data(), buffer.size());
+                if (length <= 0)
+                {
+                    break; // EAGAIN - no more events
+                }
+                for (ssize_t offset = 0; offset < length;)
+                {
+                    const auto* event = reinterpret_cast<const inotify_event*>(
+                        buffer.data() + offset);
+                    if (event->len != 0 && file_name == event->name)
+                    {
+                        changed = true;
+                    }
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) +
+                                                   event->len);
+                }
+            }
+            return changed;
+        }
+#endif
+        std::error_code                 error;
+        std::filesystem::file_time_type new_time =
+            std::filesystem::last_write_time(path, error);
+        if (error || new_time == last_update_time)
+        {
+            return false;
+        }
+        last_update_time = new_time;
+        return true;
+    }
+
     std::string load_file()
     {
         std::ifstream file;
@@ -691,23 +752,49 @@ private:
                  std::istreambuf_iterator<char>() };
     }
 
-    void build_properties_map()
+    void build_properties_map(std::string_view text)
     {
-        std::string content{ load_file() };
-
-        lexer_t         lexer(content);
-        parser_t        parser(lexer);
-        interpretator_t interpretator(parser);
+        lexer_t lexer(text);
 
         std::unordered_map<std::string, value_t> generated_key_values;
-        interpretator.run(generated_key_values);
+        interpretator_t interpretator(lexer, generated_key_values);
+        interpretator.run();
+
+        if (key_values.empty())
+        {
+            std::swap(generated_key_values, key_values);
+            return;
+        }
 
-        std::swap(generated_key_values, key_values);
+        // assign in place: nodes of unordered_map never move, so bound
+        // property handles see new values
+        for (auto& [key, value] : generated_key_values)
+        {
+            auto it = key_values.find(key);
+            if (it == key_values.end())
+            {
+                key_values.emplace(key, std::move(value));
+            }
+            else if (it->second.index() != value.index())
+            {
+                std::cerr << "error: property_reader can't change type of ["
+                          << key << "] at runtime, keep previous value"
+                          << std::endl;
+            }
+            else
+            {
+                it->second = std::move(value);
+            }
+        }
     }
 
     std::unordered_map<std::string, value_t> key_values;
     std::filesystem::path                    path;
     std::filesystem::file_time_type          last_update_time;
+    std::string                              content;
+#ifdef __linux__
+    int watch_fd = -1;
+#endif
 };
 
 properties_reader::properties_reader(const std::filesystem::path& path)
@@ -751,6 +838,23 @@ const Result& get_value_checked_type(const value_t*               ptr_value,
     }
 };
 
+template <typename T>
+properties_reader::property<T> properties_reader::bind(
+    std::string_view name) const
+{
+    return property<T>(&get_value_checked_type<T>(
+        ptr->get_value_t(name), name, ptr->get_filepath()));
+}
+
+template properties_reader::property<std::string>
+properties_reader::bind<std::string>(std::string_view) const;
+template properties_reader::property<float>
+properties_reader::bind<float>(std::string_view) const;
+template properties_reader::property<glm::vec3>
+properties_reader::bind<glm::vec3>(std::string_view) const;
+template properties_reader::property<bool>
+properties_reader::bind<bool>(std::string_view) const;
+
 const std::string& properties_reader::get_string(std::string_view key) const
 {
     return get_value_checked_type<std::string>(
@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <string>
 #include <string_view>
 
 #include <glm/vec3.hpp>
@@ -12,13 +13,45 @@
 class properties_reader
 {
 public:
+    /// Value of one property, bound once by name and type. Reading it is
+    /// pointer dereference. Stays valid while reader alive, after reload
+    /// points to new value (reload can't change property type).
+    template <typename T>
+    class property
+    {
+    public:
+        property() = default;
+
+        [[nodiscard]] const T& get() const { return *value; }
+        [[nodiscard]] const T& operator*() const { return *value; }
+        [[nodiscard]] const T* operator->() const { return value; }
+        explicit operator bool() const { return value != nullptr; }
+
+    private:
+        friend class properties_reader;
+        explicit property(const T* value_)
+            : value{ value_ }
+        {
+        }
+
+        const T* value = nullptr;
+    };
+
     explicit properties_reader(const std::filesystem::path& path);
     properties_reader(const properties_reader&)            = delete;
     properties_reader& operator=(const properties_reader&) = delete;
     ~properties_reader();
 
+    /// reparse file if it was written since last call, on linux changes
+    /// come from inotify so call is cheap. Errors in changed file printed,
+    /// previous values kept.
     void update_changes();
 
+    /// T in {std::string, float, glm::vec3, bool}
+    template <typename T>
+    [[nodiscard]] property<T> bind(std::string_view name) const
+        noexcept(false);
+
     [[nodiscard]] const std::string& get_string(std::string_view name) const
         noexcept(false);
     [[nodiscard]] float get_float(std::string_view name) const noexcept(false);
@@ -33,3 +66,12 @@ private:
     class impl;
     std::unique_ptr<impl> ptr;
 };
+
+extern template properties_reader::property<std::string>
+properties_reader::bind<std::string>(std::string_view) const;
+extern template properties_reader::property<float>
+properties_reader::bind<float>(std::string_view) const;
+extern template properties_reader::property<glm::vec3>
+properties_reader::bind<glm::vec3>(std::string_view) const;
+extern template properties_reader::property<bool>
+properties_reader::bind<bool>(std::string_view) const;
@@ -0,0 +1,6 @@
+#version 320 es
+
+// only depth test result counted by occlusion query, color writes off
+void main()
+{
+}
@@ -0,0 +1,10 @@
+#version 320 es
+layout (location = 0) in vec3 a_position;
+
+// projection * view * box transform, box is cube [-1, 1]
+uniform mat4 box_matrix;
+
+void main()
+{
+    gl_Position = box_matrix * vec4(a_position, 1.0);
+}
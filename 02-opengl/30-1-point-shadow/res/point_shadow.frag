@@ -0,0 +1,13 @@
+#version 320 es
+precision highp float;
+
+in vec3 frag_pos;
+
+uniform vec3 light_pos;
+uniform float far_plane;
+
+void main()
+{
+    // linear distance to light in [0, 1], same for every cubemap face
+    gl_FragDepth = length(frag_pos - light_pos) / far_plane;
+}
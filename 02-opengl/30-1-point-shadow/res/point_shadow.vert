@@ -0,0 +1,15 @@
+#version 320 es
+layout (location = 0) in vec3 a_position;
+
+uniform mat4 model;
+// projection * view of one cubemap face
+uniform mat4 face_matrix;
+
+out vec3 frag_pos;
+
+void main()
+{
+    vec4 world_pos = model * vec4(a_position, 1.0);
+    frag_pos = world_pos.xyz;
+    gl_Position = face_matrix * world_pos;
+}
@@ -0,0 +1,10 @@
+#version 320 es
+layout (location = 0) in vec3 a_position;
+
+uniform mat4 model;
+
+void main()
+{
+    // world position, point_shadow.geom projects it to every face
+    gl_Position = model * vec4(a_position, 1.0);
+}
@@ -23,6 +23,10 @@ glm::vec3 light_pos     = { -2.0f, 2.0f, -2.0f };
 glm::vec3 light_look_at = { 0.f, 0.f, 0.f };
 glm::vec3 cube_pos      = { 0.f, 0.f, 0.f };
 
+// key 3 - many point lights with shadow atlas
+float lights_orbit_speed       = 10.f; // degrees per second
+float shadow_updates_per_frame = 4.f;  // lights rendered to atlas per frame
+
 glm::vec3 clear_color = { 0.2f, 0.1f, 0.1f };
 
 bool show_z_buffer   = false;
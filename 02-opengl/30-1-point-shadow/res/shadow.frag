@@ -5,7 +5,6 @@ in VS_OUT {
     vec3 frag_pos;
     vec3 normal;
     vec2 uv;
-    vec4 frag_pos_light_space;
 } fs_in;
 
 struct mesh_material
@@ -16,43 +15,53 @@ struct mesh_material
 
 uniform mesh_material material;
 
-uniform sampler2D tex_shadow_map;
+// distance to light / far_plane, see point_shadow.frag
+uniform samplerCube tex_shadow_map;
 
-uniform vec3 light_pos;
-uniform vec3 view_pos;
-
-float ShadowCalculation(vec4 frag_pos_light_space, vec3 normal, vec3 light_dir)
+// per frame, see frame_block in main.cxx
+layout (std140) uniform frame_data
 {
-    // perform perspective divide
-    vec3 proj_coords = frag_pos_light_space.xyz / frag_pos_light_space.w;
+    mat4 projection;
+    mat4 view;
+    vec3 light_pos;
+    float far_plane;
+    vec3 view_pos;
+};
 
-    // Because the depth from the depth map is in the range [0,1]
-    // and we also want to use projCoords to sample from the depth map,
-    // we transform the NDC coordinates to the range [0,1]:
-    proj_coords = proj_coords * 0.5 + 0.5;
+// few directions around sample direction for PCF, cube map needs no
+// texel size, offsets scaled by distance to viewer
+const vec3 sample_offsets[20] = vec3[]
+(
+   vec3( 1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1,  1,  1),
+   vec3( 1,  1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1,  1, -1),
+   vec3( 1,  1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1,  1,  0),
+   vec3( 1,  0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1,  0, -1),
+   vec3( 0,  1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0,  1, -1)
+);
+
+float ShadowCalculation(vec3 frag_pos, vec3 normal, vec3 light_dir)
+{
+    vec3 light_to_frag = frag_pos - light_pos;
+    float current_depth = length(light_to_frag);
 
     // All object far from far_plane - have no shadow
-    if (proj_coords.z > 1.0)
+    if (current_depth > far_plane)
     {
         return 0.0;
     }
 
-    float current_depth = proj_coords.z;
-    float bias = max(0.005 * (1.0 - dot(normal, light_dir)), 0.001);
+    float bias = max(0.05 * (1.0 - dot(normal, light_dir)), 0.005);
+    float disk_radius = (1.0 + length(view_pos - frag_pos) / far_plane) / 25.0;
     float shadow = 0.0;
-    vec2 texel_size = 1.0 / textureSize(tex_shadow_map, 0);
-    for(int x = -1; x <= 1; ++x)
+    for (int i = 0; i < 20; ++i)
     {
-        for(int y= -1; y<=1; ++y)
-        {
-            // closest depth from light point of view
-            vec2 coord = proj_coords.xy + vec2(x, y) * texel_size;
-            // PCF depth
-            float closest_depth = texture(tex_shadow_map, coord).r;
-            shadow += (current_depth - bias) >= closest_depth  ? 1.0 : 0.0;
-        }
+        // closest depth from light point of view
+        float closest_depth = texture(tex_shadow_map,
+            light_to_frag + sample_offsets[i] * disk_radius).r;
+        closest_depth *= far_plane;
+        shadow += (current_depth - bias) > closest_depth ? 1.0 : 0.0;
     }
-    shadow /= 9.0;
+    shadow /= 20.0;
 
     return shadow;
 }
@@ -75,7 +84,7 @@ void main()
     spec = pow(max(dot(normal, halfway_dir), 0.0), 64.0);
     vec3 specular = spec * light_color;
     // calculate shadow
-    float shadow = ShadowCalculation(fs_in.frag_pos_light_space, normal, light_dir);
+    float shadow = ShadowCalculation(fs_in.frag_pos, normal, light_dir);
     vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;
 
     frag_color = vec4(lighting, 1.0);
@@ -7,19 +7,29 @@ out VS_OUT {
     vec3 frag_pos;
     vec3 normal;
     vec2 uv;
-    vec4 frag_pos_light_space;
 } vs_out;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
-uniform mat4 light_space_matrix;
+// per frame, see frame_block in main.cxx
+layout (std140) uniform frame_data
+{
+    mat4 projection;
+    mat4 view;
+    vec3 light_pos;
+    float far_plane;
+    vec3 view_pos;
+};
+
+// per draw, see gles30::draw_block
+layout (std140) uniform draw_data
+{
+    mat4 model;
+    mat4 normal_matrix; // transpose(inverse(mat3(model))) in mat4
+};
 
 void main()
 {
     vs_out.frag_pos = vec3(model * vec4(a_position, 1.0));
-    vs_out.normal = transpose(inverse(mat3(model))) * a_normal;
+    vs_out.normal = mat3(normal_matrix) * a_normal;
     vs_out.uv = a_uv;
-    vs_out.frag_pos_light_space = light_space_matrix * vec4(vs_out.frag_pos, 1.0);
     gl_Position = projection * view * vec4(vs_out.frag_pos, 1.0);
 }
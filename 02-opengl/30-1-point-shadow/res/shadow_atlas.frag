@@ -0,0 +1,137 @@
+#version 330 core
+out vec4 frag_color;
+
+in VS_OUT {
+    vec3 frag_pos;
+    vec3 normal;
+    vec2 uv;
+} fs_in;
+
+struct mesh_material
+{
+    sampler2D tex_diffuse0;
+    sampler2D tex_specular0;
+};
+
+uniform mesh_material material;
+
+#define MAX_LIGHTS 16
+
+struct point_light
+{
+    vec3 position;
+    vec3 color;
+    float range; // far plane of its shadow faces
+};
+
+// distance to light / range, 6 tiles per light, see gles30_shadow_atlas.hxx
+uniform sampler2D tex_shadow_atlas;
+
+// per frame, see frame_block in main.cxx
+layout (std140) uniform frame_data
+{
+    mat4 projection;
+    mat4 view;
+    vec3 light_pos;
+    float far_plane;
+    vec3 view_pos;
+};
+
+// see atlas_block in main.cxx
+layout (std140) uniform atlas_data
+{
+    point_light lights[MAX_LIGHTS];
+    // xy - corner, z - side of tile, z == 0 - no shadow yet
+    vec4 light_tiles[MAX_LIGHTS * 6];
+    int light_count;
+    float atlas_texel; // 1.0 / atlas size
+};
+
+// same face and orientation as cube map lookup of direction d,
+// returns uv in face and face index
+vec3 cube_face_uv(vec3 d)
+{
+    vec3 a = abs(d);
+    if (a.x >= a.y && a.x >= a.z)
+    {
+        vec2 st = vec2(d.x > 0.0 ? -d.z : d.z, -d.y) / a.x;
+        return vec3(st * 0.5 + 0.5, d.x > 0.0 ? 0.0 : 1.0);
+    }
+    if (a.y >= a.z)
+    {
+        vec2 st = vec2(d.x, d.y > 0.0 ? d.z : -d.z) / a.y;
+        return vec3(st * 0.5 + 0.5, d.y > 0.0 ? 2.0 : 3.0);
+    }
+    vec2 st = vec2(d.z > 0.0 ? d.x : -d.x, -d.y) / a.z;
+    return vec3(st * 0.5 + 0.5, d.z > 0.0 ? 4.0 : 5.0);
+}
+
+float ShadowCalculation(int light, vec3 normal, vec3 light_dir)
+{
+    vec3 light_to_frag = fs_in.frag_pos - lights[light].position;
+    float current_depth = length(light_to_frag) / lights[light].range;
+
+    if (current_depth >= 1.0)
+    {
+        return 0.0;
+    }
+
+    vec3 face_uv = cube_face_uv(light_to_frag);
+    vec4 tile = light_tiles[light * 6 + int(face_uv.z)];
+    if (tile.z == 0.0)
+    {
+        return 0.0;
+    }
+
+    float bias = max(0.05 * (1.0 - dot(normal, light_dir)), 0.005) /
+                 lights[light].range;
+    // PCF 3x3, clamped inside tile so neighbour tiles do not leak in
+    vec2 uv = tile.xy + face_uv.xy * tile.z;
+    vec2 lo = tile.xy + vec2(0.5 * atlas_texel);
+    vec2 hi = tile.xy + vec2(tile.z - 0.5 * atlas_texel);
+    float shadow = 0.0;
+    for (int x = -1; x <= 1; ++x)
+    {
+        for (int y = -1; y <= 1; ++y)
+        {
+            vec2 offset = vec2(x, y) * atlas_texel;
+            float closest_depth =
+                texture(tex_shadow_atlas, clamp(uv + offset, lo, hi)).r;
+            shadow += (current_depth - bias) > closest_depth ? 1.0 : 0.0;
+        }
+    }
+    return shadow / 9.0;
+}
+
+void main()
+{
+    vec3 color = texture(material.tex_diffuse0, fs_in.uv).rgb;
+    vec3 normal = normalize(fs_in.normal);
+    vec3 view_dir = normalize(view_pos - fs_in.frag_pos);
+
+    vec3 lighting = 0.15 * color; // ambient
+    for (int i = 0; i < light_count; ++i)
+    {
+        vec3 to_light = lights[i].position - fs_in.frag_pos;
+        float distance = length(to_light);
+        if (distance >= lights[i].range)
+        {
+            continue;
+        }
+        vec3 light_dir = to_light / distance;
+        // fade to zero at range, where shadow ends too
+        float attenuation = 1.0 - smoothstep(0.5 * lights[i].range,
+                                             lights[i].range, distance);
+        // diffuse
+        float diff = max(dot(light_dir, normal), 0.0);
+        // specular
+        vec3 halfway_dir = normalize(light_dir + view_dir);
+        float spec = pow(max(dot(normal, halfway_dir), 0.0), 64.0);
+
+        float shadow = ShadowCalculation(i, normal, light_dir);
+        lighting += (1.0 - shadow) * attenuation * (diff + spec) *
+                    lights[i].color * color;
+    }
+
+    frag_color = vec4(lighting, 1.0);
+}
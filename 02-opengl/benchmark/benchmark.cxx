@@ -0,0 +1,246 @@
+#include "benchmark.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+#include "frame_timer.hxx"
+
+namespace benchmark
+{
+
+template <typename number>
+static number parse_number(std::string_view key, std::string_view value)
+{
+    number result{};
+    auto [end, error] =
+        std::from_chars(value.data(), value.data() + value.size(), result);
+    if (error != std::errc() || end != value.data() + value.size())
+    {
+        throw std::runtime_error("error: bad benchmark option " +
+                                 std::string(key) + "=" + std::string(value));
+    }
+    return result;
+}
+
+std::optional<options> parse_options(int     argc,
+                                     char*   argv[],
+                                     options defaults) noexcept(false)
+{
+    int first = 1;
+    while (first < argc && std::string_view(argv[first]) != "--benchmark")
+    {
+        ++first;
+    }
+    if (first == argc)
+    {
+        return std::nullopt;
+    }
+
+    options result = defaults;
+    for (int i = first + 1; i < argc; ++i)
+    {
+        const std::string_view argument(argv[i]);
+        const std::size_t      equal = argument.find('=');
+        const std::string_view key   = argument.substr(0, equal);
+        const std::string_view value = equal == std::string_view::npos
+                                           ? std::string_view{}
+                                           : argument.substr(equal + 1);
+        if (key == "frames")
+        {
+            result.frames = parse_number<std::uint32_t>(key, value);
+        }
+        else if (key == "warmup")
+        {
+            result.warmup = parse_number<std::uint32_t>(key, value);
+        }
+        else if (key == "width")
+        {
+            result.width = parse_number<std::uint32_t>(key, value);
+        }
+        else if (key == "height")
+        {
+            result.height = parse_number<std::uint32_t>(key, value);
+        }
+        else if (key == "dt")
+        {
+            result.dt = parse_number<float>(key, value);
+        }
+        else if (key == "path")
+        {
+            result.path = value;
+        }
+        else if (key == "csv")
+        {
+            result.csv = value;
+        }
+        else if (key == "png")
+        {
+            result.png = value;
+        }
+        else if (key == "api" && (value == "gl" || value == "gles"))
+        {
+            result.context = value == "gl"
+                                 ? headless_context::api::desktop_core
+                                 : headless_context::api::gles;
+        }
+        else
+        {
+            throw std::runtime_error("error: unknown benchmark option: " +
+                                     std::string(argument));
+        }
+    }
+    if (result.frames == 0 || result.width == 0 || result.height == 0 ||
+        !(result.dt > 0.f))
+    {
+        throw std::runtime_error("error: benchmark needs frames, width, "
+                                 "height and dt > 0");
+    }
+    return result;
+}
+
+/// value at fraction of sorted values
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+    const auto index = static_cast<std::size_t>(
+        std::round(fraction * static_cast<double>(sorted.size() - 1)));
+    return sorted[index];
+}
+
+static void print_summary(std::string_view name, std::vector<double> values)
+{
+    if (values.empty())
+    {
+        std::cout << name << ": no data\n";
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values)
+    {
+        sum += value;
+    }
+    std::cout << std::fixed << std::setprecision(3) << name
+              << " ms mean: " << sum / static_cast<double>(values.size())
+              << " p50: " << percentile(values, 0.5)
+              << " p95: " << percentile(values, 0.95)
+              << " max: " << values.back() << '\n';
+}
+
+static void write_csv(const std::filesystem::path&           path,
+                      const std::vector<frame_timer::sample>& samples)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("error: can't write " + path.string());
+    }
+    file << "frame,cpu_ms,gpu_ms\n" << std::fixed << std::setprecision(4);
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+        file << i << ',' << samples[i].cpu_ms << ',';
+        if (samples[i].gpu_ms >= 0.0)
+        {
+            file << samples[i].gpu_ms;
+        }
+        file << '\n';
+    }
+}
+
+static void write_png(const std::filesystem::path& path,
+                      const headless_context&      context)
+{
+    std::vector<std::uint8_t> pixels = context.read_pixels();
+    // lessons clear with alpha 0, golden images compare color only
+    for (std::size_t i = 3; i < pixels.size(); i += 4)
+    {
+        pixels[i] = 255;
+    }
+    const auto width  = static_cast<int>(context.get_width());
+    const auto height = static_cast<int>(context.get_height());
+    if (stbi_write_png(path.string().c_str(),
+                       width,
+                       height,
+                       4,
+                       pixels.data(),
+                       width * 4) == 0)
+    {
+        throw std::runtime_error("error: can't write " + path.string());
+    }
+}
+
+void run(const options&          settings,
+         const headless_context& context,
+         const render_function&  render) noexcept(false)
+{
+    camera_path path;
+    if (!settings.path.empty())
+    {
+        path = camera_path::load(settings.path);
+    }
+
+    frame_timer       timer;
+    const std::uint32_t total = settings.warmup + settings.frames;
+    for (std::uint32_t index = 0; index < total; ++index)
+    {
+        frame_info frame{};
+        frame.index      = index;
+        frame.recorded   = index >= settings.warmup;
+        frame.time       = static_cast<float>(index) * settings.dt;
+        frame.dt         = settings.dt;
+        frame.has_camera = !path.empty();
+        if (frame.has_camera)
+        {
+            const float duration = path.get_duration();
+            frame.camera         = path.sample(
+                duration > 0.f ? std::fmod(frame.time, duration) : 0.f);
+        }
+
+        if (frame.recorded)
+        {
+            timer.begin_frame();
+            render(frame);
+            timer.end_frame();
+        }
+        else
+        {
+            render(frame);
+        }
+    }
+    timer.finish();
+
+    const std::vector<frame_timer::sample>& samples = timer.get_samples();
+    write_csv(settings.csv, samples);
+    write_png(settings.png, context);
+
+    std::vector<double> cpu;
+    std::vector<double> gpu;
+    for (const frame_timer::sample& s : samples)
+    {
+        cpu.push_back(s.cpu_ms);
+        if (s.gpu_ms >= 0.0)
+        {
+            gpu.push_back(s.gpu_ms);
+        }
+    }
+    std::cout << "benchmark: " << context.get_description() << ", "
+              << settings.frames << " frames " << context.get_width() << 'x'
+              << context.get_height() << '\n';
+    print_summary("cpu", std::move(cpu));
+    print_summary(timer.has_gpu_timer() ? "gpu" : "gpu (no timer queries)",
+                  std::move(gpu));
+    std::cout << "results: " << settings.csv.string() << ' '
+              << settings.png.string() << std::endl;
+}
+
+} // namespace benchmark
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+#include "camera_path.hxx"
+#include "headless_context.hxx"
+
+namespace benchmark
+{
+
+/// lesson command line: lesson --benchmark [key=value ...]
+///     frames=300          recorded frames
+///     warmup=10           frames rendered before recording
+///     width=1024 height=768
+///     dt=0.016667         seconds per frame, same every run
+///     path=res/benchmark.path   camera path, empty - lesson camera
+///     csv=benchmark.csv png=benchmark.png   results, png of last frame
+///     api=gl|gles         headless context, default lesson default
+struct options
+{
+    std::uint32_t         frames  = 300;
+    std::uint32_t         warmup  = 10;
+    std::uint32_t         width   = 1024;
+    std::uint32_t         height  = 768;
+    float                 dt      = 1.f / 60.f;
+    std::filesystem::path path    = "res/benchmark.path";
+    std::filesystem::path csv     = "benchmark.csv";
+    std::filesystem::path png     = "benchmark.png";
+    headless_context::api context = headless_context::api::desktop_core;
+};
+
+/// nullopt if no --benchmark in argv, throw on unknown key or bad value.
+/// defaults - values of options before parsing
+std::optional<options> parse_options(int     argc,
+                                     char*   argv[],
+                                     options defaults = {}) noexcept(false);
+
+struct frame_info
+{
+    std::uint32_t     index; ///< warmup frames first
+    bool              recorded;
+    float             time; ///< seconds, index * dt
+    float             dt;
+    camera_path::pose camera; ///< from path, path time loops
+    bool              has_camera; ///< false - no path file
+};
+
+/// render one frame to context.get_framebuffer() with camera of frame
+using render_function = std::function<void(const frame_info& frame)>;
+
+/// render warmup and recorded frames with fixed dt, then write csv with
+/// frame, cpu_ms, gpu_ms (empty if unknown) and png of last frame, print
+/// summary to std::cout. Same options - same images on same driver.
+void run(const options&          settings,
+         const headless_context& context,
+         const render_function&  render) noexcept(false);
+
+} // namespace benchmark
@@ -0,0 +1,108 @@
+#include "camera_path.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <glm/geometric.hpp>
+
+namespace benchmark
+{
+
+camera_path camera_path::load(const std::filesystem::path& path) noexcept(
+    false)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("error: can't open camera path: " +
+                                 path.string());
+    }
+
+    camera_path result;
+    std::string line;
+    for (std::size_t number = 1; std::getline(file, line); ++number)
+    {
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        std::istringstream fields(line);
+        float              time = 0.f;
+        pose               camera{};
+        fields >> time >> camera.position.x >> camera.position.y >>
+            camera.position.z >> camera.direction.x >> camera.direction.y >>
+            camera.direction.z;
+        if (!fields || glm::length(camera.direction) == 0.f ||
+            (!result.keys.empty() && time < result.keys.back().time))
+        {
+            throw std::runtime_error("error: bad camera path line " +
+                                     std::to_string(number) + " in " +
+                                     path.string());
+        }
+        result.add(time, camera);
+    }
+    return result;
+}
+
+void camera_path::save(const std::filesystem::path& path) const noexcept(
+    false)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("error: can't write camera path: " +
+                                 path.string());
+    }
+    file << "# time px py pz dx dy dz\n";
+    for (const key& k : keys)
+    {
+        const pose& c = k.camera;
+        file << k.time << ' ' << c.position.x << ' ' << c.position.y << ' '
+             << c.position.z << ' ' << c.direction.x << ' ' << c.direction.y
+             << ' ' << c.direction.z << '\n';
+    }
+}
+
+void camera_path::add(float time, const pose& camera)
+{
+    keys.push_back({ time,
+                     { camera.position, glm::normalize(camera.direction) } });
+}
+
+camera_path::pose camera_path::sample(float time) const
+{
+    if (keys.empty())
+    {
+        return { glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f) };
+    }
+    // first key later than time
+    auto next = std::upper_bound(keys.begin(),
+                                 keys.end(),
+                                 time,
+                                 [](float t, const key& k)
+                                 { return t < k.time; });
+    if (next == keys.begin())
+    {
+        return keys.front().camera;
+    }
+    if (next == keys.end())
+    {
+        return keys.back().camera;
+    }
+    const key&  prev = *(next - 1);
+    const float t    = (time - prev.time) / (next->time - prev.time);
+
+    const glm::vec3 direction =
+        prev.camera.direction + t * (next->camera.direction -
+                                     prev.camera.direction);
+    return { prev.camera.position +
+                 t * (next->camera.position - prev.camera.position),
+             glm::length(direction) > 0.f ? glm::normalize(direction)
+                                          : next->camera.direction };
+}
+
+} // namespace benchmark
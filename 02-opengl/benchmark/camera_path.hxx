@@ -0,0 +1,52 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace benchmark
+{
+
+/// Camera positions and directions over time, recorded while flying in
+/// lesson window or written by hand. Text file, one key per line:
+///     time px py pz dx dy dz
+/// time in seconds, increasing, '#' starts comment line.
+class camera_path
+{
+public:
+    struct pose
+    {
+        glm::vec3 position;
+        glm::vec3 direction; ///< normalized
+    };
+
+    struct key
+    {
+        float time;
+        pose  camera;
+    };
+
+    camera_path() = default;
+    /// throw if file can't be read or has bad line
+    static camera_path load(const std::filesystem::path& path) noexcept(
+        false);
+    void save(const std::filesystem::path& path) const noexcept(false);
+
+    /// time must not be less than time of last key
+    void add(float time, const pose& camera);
+    void clear() { keys.clear(); }
+
+    /// linear between keys, first/last key outside of path time range
+    [[nodiscard]] pose sample(float time) const;
+    [[nodiscard]] float get_duration() const
+    {
+        return keys.empty() ? 0.f : keys.back().time;
+    }
+    [[nodiscard]] bool empty() const { return keys.empty(); }
+
+private:
+    std::vector<key> keys;
+};
+
+} // namespace benchmark
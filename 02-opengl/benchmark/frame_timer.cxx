@@ -0,0 +1,118 @@
+#include "frame_timer.hxx"
+
+#include "gl_api.hxx"
+
+namespace benchmark
+{
+
+frame_timer::frame_timer()
+    : gpu_timer{ gl::functions().GetQueryObjectui64v != nullptr }
+{
+    if (gpu_timer)
+    {
+        for (in_flight& slot : queries)
+        {
+            gl::functions().GenQueries(1, &slot.query);
+        }
+    }
+}
+
+frame_timer::~frame_timer()
+{
+    if (gpu_timer)
+    {
+        for (in_flight& slot : queries)
+        {
+            gl::functions().DeleteQueries(1, &slot.query);
+        }
+    }
+}
+
+void frame_timer::begin_frame()
+{
+    if (gpu_timer)
+    {
+        in_flight& slot = queries[next];
+        // ring full: result of frame queries.size() ago needed now
+        if (slot.used)
+        {
+            collect(slot, true);
+        }
+        gl::functions().BeginQuery(gl::time_elapsed, slot.query);
+    }
+    started = clock::now();
+}
+
+void frame_timer::end_frame()
+{
+    const std::chrono::duration<double, std::milli> cpu =
+        clock::now() - started;
+    samples.push_back({ cpu.count(), -1.0 });
+
+    if (gpu_timer)
+    {
+        const gl::api& f = gl::functions();
+        f.EndQuery(gl::time_elapsed);
+        in_flight& slot = queries[next];
+        slot.frame      = samples.size() - 1;
+        slot.used       = true;
+        next            = (next + 1) % queries.size();
+
+        // read every result ready by now, keeps ring mostly free
+        for (in_flight& other : queries)
+        {
+            if (other.used)
+            {
+                collect(other, false);
+            }
+        }
+    }
+    // no swap in headless mode, flush so GPU works while CPU records
+    gl::functions().Flush();
+}
+
+void frame_timer::finish()
+{
+    if (!gpu_timer)
+    {
+        return;
+    }
+    for (in_flight& slot : queries)
+    {
+        if (slot.used)
+        {
+            collect(slot, true);
+        }
+    }
+}
+
+bool frame_timer::collect(in_flight& slot, bool wait)
+{
+    const gl::api& f = gl::functions();
+    if (!wait)
+    {
+        gl::uint_t available = 0;
+        f.GetQueryObjectuiv(slot.query, gl::query_result_avail, &available);
+        if (available == 0)
+        {
+            return false;
+        }
+    }
+    std::uint64_t nanoseconds = 0;
+    f.GetQueryObjectui64v(slot.query, gl::query_result, &nanoseconds);
+    slot.used = false;
+
+    // GLES: GPU clock changed (power state) while measuring, drop value
+    gl::int_t disjoint = 0;
+    if (f.has_gpu_disjoint)
+    {
+        f.GetIntegerv(gl::gpu_disjoint, &disjoint);
+    }
+    if (disjoint == 0)
+    {
+        samples[slot.frame].gpu_ms = static_cast<double>(nanoseconds) * 1e-6;
+    }
+    return true;
+}
+
+} // namespace benchmark
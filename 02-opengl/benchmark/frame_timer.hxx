@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace benchmark
+{
+
+/// CPU and GPU time of every frame. CPU - wall time between
+/// begin_frame() and end_frame() on calling thread. GPU - GL_TIME_ELAPSED
+/// query around same commands (GL 3.3 core or GLES with
+/// GL_EXT_disjoint_timer_query), results read frames later so measuring
+/// does not stall pipeline. Waits only if all queries still in flight.
+class frame_timer
+{
+public:
+    struct sample
+    {
+        double cpu_ms = 0.0;
+        double gpu_ms = -1.0; ///< < 0 - no timer queries or disjoint
+    };
+
+    /// GL context must be current
+    frame_timer();
+    ~frame_timer();
+    frame_timer(const frame_timer&)            = delete;
+    frame_timer& operator=(const frame_timer&) = delete;
+
+    void begin_frame();
+    void end_frame();
+    /// wait GPU results of all ended frames
+    void finish();
+
+    [[nodiscard]] bool has_gpu_timer() const { return gpu_timer; }
+    /// one per ended frame, gpu_ms of last frames valid after finish()
+    [[nodiscard]] const std::vector<sample>& get_samples() const
+    {
+        return samples;
+    }
+
+private:
+    struct in_flight
+    {
+        std::uint32_t query = 0;
+        std::size_t   frame = 0; ///< index in samples
+        bool          used  = false;
+    };
+
+    /// store result of query, wait for it if wait
+    bool collect(in_flight& slot, bool wait);
+
+    using clock = std::chrono::steady_clock;
+
+    bool                      gpu_timer = false;
+    std::array<in_flight, 8>  queries;
+    std::size_t               next = 0; ///< slot of next frame
+    clock::time_point         started;
+    std::vector<sample>       samples;
+};
+
+} // namespace benchmark
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+#include <KHR/khrplatform.h>
+
+/// GL functions used by harness itself. Lesson loads its own glad with
+/// headless_context::get_proc_address(), harness does not link glad, so
+/// one program never has two glad copies with same symbol names.
+/// Signatures same in GLES 3.0 and GL 3.3 core.
+namespace benchmark::gl
+{
+
+using enum_t     = std::uint32_t;
+using uint_t     = std::uint32_t;
+using int_t      = std::int32_t;
+using sizei_t    = std::int32_t;
+using bitfield_t = std::uint32_t;
+
+inline constexpr enum_t framebuffer          = 0x8D40;
+inline constexpr enum_t renderbuffer         = 0x8D41;
+inline constexpr enum_t color_attachment0    = 0x8CE0;
+inline constexpr enum_t depth_stencil_attach = 0x821A;
+inline constexpr enum_t framebuffer_complete = 0x8CD5;
+inline constexpr enum_t rgba8                = 0x8058;
+inline constexpr enum_t depth24_stencil8     = 0x88F0;
+inline constexpr enum_t rgba                 = 0x1908;
+inline constexpr enum_t unsigned_byte        = 0x1401;
+inline constexpr enum_t pack_alignment       = 0x0D05;
+inline constexpr enum_t renderer             = 0x1F01;
+inline constexpr enum_t version              = 0x1F02;
+inline constexpr enum_t extensions           = 0x1F03;
+inline constexpr enum_t num_extensions       = 0x821D;
+inline constexpr enum_t time_elapsed         = 0x88BF; ///< same in EXT
+inline constexpr enum_t query_result         = 0x8866;
+inline constexpr enum_t query_result_avail   = 0x8867;
+inline constexpr enum_t gpu_disjoint         = 0x8FBB; ///< EXT only
+
+struct api
+{
+    // clang-format off
+    void (KHRONOS_APIENTRY* GenFramebuffers)(sizei_t, uint_t*);
+    void (KHRONOS_APIENTRY* DeleteFramebuffers)(sizei_t, const uint_t*);
+    void (KHRONOS_APIENTRY* BindFramebuffer)(enum_t, uint_t);
+    enum_t (KHRONOS_APIENTRY* CheckFramebufferStatus)(enum_t);
+    void (KHRONOS_APIENTRY* FramebufferRenderbuffer)(enum_t, enum_t, enum_t,
+                                                     uint_t);
+    void (KHRONOS_APIENTRY* GenRenderbuffers)(sizei_t, uint_t*);
+    void (KHRONOS_APIENTRY* DeleteRenderbuffers)(sizei_t, const uint_t*);
+    void (KHRONOS_APIENTRY* BindRenderbuffer)(enum_t, uint_t);
+    void (KHRONOS_APIENTRY* RenderbufferStorage)(enum_t, enum_t, sizei_t,
+                                                 sizei_t);
+    void (KHRONOS_APIENTRY* ReadPixels)(int_t, int_t, sizei_t, sizei_t,
+                                        enum_t, enum_t, void*);
+    void (KHRONOS_APIENTRY* PixelStorei)(enum_t, int_t);
+    void (KHRONOS_APIENTRY* Finish)();
+    void (KHRONOS_APIENTRY* Flush)();
+    const unsigned char* (KHRONOS_APIENTRY* GetString)(enum_t);
+    const unsigned char* (KHRONOS_APIENTRY* GetStringi)(enum_t, uint_t);
+    void (KHRONOS_APIENTRY* GetIntegerv)(enum_t, int_t*);
+    void (KHRONOS_APIENTRY* GenQueries)(sizei_t, uint_t*);
+    void (KHRONOS_APIENTRY* DeleteQueries)(sizei_t, const uint_t*);
+    void (KHRONOS_APIENTRY* BeginQuery)(enum_t, uint_t);
+    void (KHRONOS_APIENTRY* EndQuery)(enum_t);
+    void (KHRONOS_APIENTRY* GetQueryObjectuiv)(uint_t, enum_t, uint_t*);
+    /// null if no timer queries
+    void (KHRONOS_APIENTRY* GetQueryObjectui64v)(uint_t, enum_t,
+                                                 std::uint64_t*);
+    // clang-format on
+    /// GL_GPU_DISJOINT_EXT can be read (GLES extension)
+    bool has_gpu_disjoint = false;
+};
+
+/// filled by headless_context when its GL context made current
+const api& functions();
+
+/// true if GL extension name in extension list of current context
+bool has_extension(const char* name);
+
+} // namespace benchmark::gl
@@ -0,0 +1,316 @@
+#include "headless_context.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "gl_api.hxx"
+
+namespace benchmark
+{
+
+namespace gl
+{
+
+static api loaded{};
+
+const api& functions()
+{
+    return loaded;
+}
+
+bool has_extension(const char* name)
+{
+    int_t count = 0;
+    loaded.GetIntegerv(num_extensions, &count);
+    for (int_t i = 0; i < count; ++i)
+    {
+        const auto* extension = reinterpret_cast<const char*>(
+            loaded.GetStringi(extensions, static_cast<uint_t>(i)));
+        if (extension != nullptr && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace gl
+
+static bool has_word(const char* list, std::string_view word)
+{
+    for (std::string_view rest = list != nullptr ? list : ""; !rest.empty();)
+    {
+        const std::size_t end = rest.find(' ');
+        if (rest.substr(0, end) == word)
+        {
+            return true;
+        }
+        rest.remove_prefix(end == std::string_view::npos ? rest.size()
+                                                         : end + 1);
+    }
+    return false;
+}
+
+template <typename function>
+static void load(function& result, const char* name, bool required = true)
+{
+    result = reinterpret_cast<function>(eglGetProcAddress(name));
+    if (result == nullptr && required)
+    {
+        throw std::runtime_error(std::string("error: no GL function ") +
+                                 name);
+    }
+}
+
+static void load_functions(headless_context::api type)
+{
+    gl::api& f = gl::loaded;
+    load(f.GenFramebuffers, "glGenFramebuffers");
+    load(f.DeleteFramebuffers, "glDeleteFramebuffers");
+    load(f.BindFramebuffer, "glBindFramebuffer");
+    load(f.CheckFramebufferStatus, "glCheckFramebufferStatus");
+    load(f.FramebufferRenderbuffer, "glFramebufferRenderbuffer");
+    load(f.GenRenderbuffers, "glGenRenderbuffers");
+    load(f.DeleteRenderbuffers, "glDeleteRenderbuffers");
+    load(f.BindRenderbuffer, "glBindRenderbuffer");
+    load(f.RenderbufferStorage, "glRenderbufferStorage");
+    load(f.ReadPixels, "glReadPixels");
+    load(f.PixelStorei, "glPixelStorei");
+    load(f.Finish, "glFinish");
+    load(f.Flush, "glFlush");
+    load(f.GetString, "glGetString");
+    load(f.GetStringi, "glGetStringi");
+    load(f.GetIntegerv, "glGetIntegerv");
+    load(f.GenQueries, "glGenQueries");
+    load(f.DeleteQueries, "glDeleteQueries");
+    load(f.BeginQuery, "glBeginQuery");
+    load(f.EndQuery, "glEndQuery");
+    load(f.GetQueryObjectuiv, "glGetQueryObjectuiv");
+
+    // timer queries: core in GL 3.3, extension in GLES
+    f.GetQueryObjectui64v = nullptr;
+    f.has_gpu_disjoint    = false;
+    if (type == headless_context::api::desktop_core)
+    {
+        load(f.GetQueryObjectui64v, "glGetQueryObjectui64v", false);
+    }
+    else if (gl::has_extension("GL_EXT_disjoint_timer_query"))
+    {
+        load(f.GetQueryObjectui64v, "glGetQueryObjectui64vEXT", false);
+        f.has_gpu_disjoint = true;
+    }
+}
+
+static EGLDisplay open_display()
+{
+    const char* client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (has_word(client, "EGL_MESA_platform_surfaceless"))
+    {
+        auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display != nullptr)
+        {
+            EGLDisplay display = get_platform_display(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY)
+            {
+                return display;
+            }
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static EGLContext create_context(EGLDisplay            display,
+                                 headless_context::api type)
+{
+    const bool desktop = type == headless_context::api::desktop_core;
+    if (eglBindAPI(desktop ? EGL_OPENGL_API : EGL_OPENGL_ES_API) != EGL_TRUE)
+    {
+        throw std::runtime_error("error: eglBindAPI failed");
+    }
+
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE,
+        EGL_DONT_CARE, // no surface ever created
+        EGL_RENDERABLE_TYPE,
+        desktop ? EGL_OPENGL_BIT : EGL_OPENGL_ES3_BIT_KHR,
+        EGL_NONE
+    };
+    EGLConfig config  = nullptr;
+    EGLint    configs = 0;
+    if (eglChooseConfig(display, config_attributes, &config, 1, &configs) !=
+            EGL_TRUE ||
+        configs == 0)
+    {
+        throw std::runtime_error("error: no EGL config for GL context");
+    }
+
+    // ES 3.2 has geometry shaders lessons use if present, else ES 3.0
+    using version = std::pair<EGLint, EGLint>;
+    const std::vector<version> versions =
+        desktop ? std::vector<version>{ { 3, 3 } }
+                : std::vector<version>{ { 3, 2 }, { 3, 0 } };
+    for (const auto& [major, minor] : versions)
+    {
+        std::vector<EGLint> attributes{ EGL_CONTEXT_MAJOR_VERSION,
+                                        major,
+                                        EGL_CONTEXT_MINOR_VERSION,
+                                        minor };
+        if (desktop)
+        {
+            attributes.push_back(EGL_CONTEXT_OPENGL_PROFILE_MASK);
+            attributes.push_back(EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT);
+        }
+        attributes.push_back(EGL_NONE);
+
+        EGLContext context = eglCreateContext(
+            display, config, EGL_NO_CONTEXT, attributes.data());
+        if (context != EGL_NO_CONTEXT)
+        {
+            return context;
+        }
+    }
+    throw std::runtime_error("error: can't create headless GL context");
+}
+
+headless_context::headless_context(std::uint32_t width_,
+                                   std::uint32_t height_,
+                                   api           type) noexcept(false)
+    : width{ width_ }
+    , height{ height_ }
+{
+    EGLDisplay egl_display = open_display();
+    if (egl_display == EGL_NO_DISPLAY ||
+        eglInitialize(egl_display, nullptr, nullptr) != EGL_TRUE)
+    {
+        throw std::runtime_error("error: can't initialize EGL display");
+    }
+    display = egl_display;
+
+    try
+    {
+        if (!has_word(eglQueryString(egl_display, EGL_EXTENSIONS),
+                      "EGL_KHR_surfaceless_context"))
+        {
+            throw std::runtime_error("error: EGL_KHR_surfaceless_context "
+                                     "not supported");
+        }
+        context = create_context(egl_display, type);
+        if (eglMakeCurrent(
+                egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) !=
+            EGL_TRUE)
+        {
+            throw std::runtime_error("error: eglMakeCurrent failed");
+        }
+        load_functions(type);
+        create_framebuffer();
+    }
+    catch (...)
+    {
+        // framebuffer objects die with context
+        if (context != nullptr)
+        {
+            eglMakeCurrent(
+                egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(egl_display, context);
+        }
+        eglTerminate(egl_display);
+        throw;
+    }
+
+    std::clog << "headless context: " << get_description() << std::endl;
+}
+
+void headless_context::create_framebuffer()
+{
+    const gl::api& f = gl::functions();
+
+    f.GenRenderbuffers(1, &color);
+    f.BindRenderbuffer(gl::renderbuffer, color);
+    f.RenderbufferStorage(gl::renderbuffer,
+                          gl::rgba8,
+                          static_cast<gl::sizei_t>(width),
+                          static_cast<gl::sizei_t>(height));
+    f.GenRenderbuffers(1, &depth);
+    f.BindRenderbuffer(gl::renderbuffer, depth);
+    f.RenderbufferStorage(gl::renderbuffer,
+                          gl::depth24_stencil8,
+                          static_cast<gl::sizei_t>(width),
+                          static_cast<gl::sizei_t>(height));
+    f.BindRenderbuffer(gl::renderbuffer, 0);
+
+    f.GenFramebuffers(1, &fbo);
+    f.BindFramebuffer(gl::framebuffer, fbo);
+    f.FramebufferRenderbuffer(
+        gl::framebuffer, gl::color_attachment0, gl::renderbuffer, color);
+    f.FramebufferRenderbuffer(
+        gl::framebuffer, gl::depth_stencil_attach, gl::renderbuffer, depth);
+    if (f.CheckFramebufferStatus(gl::framebuffer) != gl::framebuffer_complete)
+    {
+        throw std::runtime_error("error: headless framebuffer incomplete");
+    }
+}
+
+headless_context::~headless_context()
+{
+    const gl::api& f = gl::functions();
+    f.DeleteFramebuffers(1, &fbo);
+    f.DeleteRenderbuffers(1, &color);
+    f.DeleteRenderbuffers(1, &depth);
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
+
+void* headless_context::get_proc_address(const char* name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+std::string headless_context::get_description() const
+{
+    const gl::api& f = gl::functions();
+    return std::string(reinterpret_cast<const char*>(
+               f.GetString(gl::renderer))) +
+           ", " +
+           reinterpret_cast<const char*>(f.GetString(gl::version));
+}
+
+std::vector<std::uint8_t> headless_context::read_pixels() const
+{
+    const gl::api&            f = gl::functions();
+    const std::size_t         row = std::size_t{ width } * 4;
+    std::vector<std::uint8_t> pixels(row * height);
+
+    f.BindFramebuffer(gl::framebuffer, fbo);
+    f.PixelStorei(gl::pack_alignment, 1);
+    f.ReadPixels(0,
+                 0,
+                 static_cast<gl::sizei_t>(width),
+                 static_cast<gl::sizei_t>(height),
+                 gl::rgba,
+                 gl::unsigned_byte,
+                 pixels.data());
+
+    // GL rows go bottom up
+    for (std::size_t y = 0; y < height / 2; ++y)
+    {
+        std::swap_ranges(pixels.begin() + y * row,
+                         pixels.begin() + (y + 1) * row,
+                         pixels.begin() + (height - 1 - y) * row);
+    }
+    return pixels;
+}
+
+} // namespace benchmark
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace benchmark
+{
+
+/// GL context without window: EGL surfaceless display (Mesa llvmpipe,
+/// drivers with EGL_MESA_platform_surfaceless) or default display, no
+/// surface at all. Frames drawn to offscreen framebuffer get_framebuffer()
+/// of RGBA8 color and depth24 stencil8 renderbuffers, bind it where lesson
+/// binds framebuffer 0. Context current on constructing thread.
+class headless_context
+{
+public:
+    enum class api
+    {
+        gles,        ///< OpenGL ES 3.2, 3.0 if no 3.2
+        desktop_core ///< OpenGL 3.3 core, as lessons ask on desktop
+    };
+
+    headless_context(std::uint32_t width,
+                     std::uint32_t height,
+                     api           type) noexcept(false);
+    ~headless_context();
+    headless_context(const headless_context&)            = delete;
+    headless_context& operator=(const headless_context&) = delete;
+
+    /// GL function address for loaders: gladLoadGLES2Loader(...)
+    static void* get_proc_address(const char* name);
+
+    [[nodiscard]] std::uint32_t get_framebuffer() const { return fbo; }
+    [[nodiscard]] std::uint32_t get_width() const { return width; }
+    [[nodiscard]] std::uint32_t get_height() const { return height; }
+    /// GL_RENDERER and GL_VERSION, to keep next to results
+    [[nodiscard]] std::string get_description() const;
+
+    /// RGBA8 pixels of framebuffer, first row is top of image
+    [[nodiscard]] std::vector<std::uint8_t> read_pixels() const;
+
+private:
+    void create_framebuffer();
+
+    std::uint32_t width;
+    std::uint32_t height;
+
+    void* display = nullptr; // EGLDisplay
+    void* context = nullptr; // EGLContext
+
+    std::uint32_t fbo   = 0;
+    std::uint32_t color = 0;
+    std::uint32_t depth = 0;
+};
+
+} // namespace benchmark
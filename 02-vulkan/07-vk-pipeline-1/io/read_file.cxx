@@ -1,9 +1,23 @@
 #include "read_file.hxx"
 
+#include <cerrno>
+#include <cstring>
 #include <exception>
 #include <fstream>
 #include <stdexcept>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace om::io
 {
 
@@ -42,4 +56,129 @@ content read_file(const std::filesystem::path& path)
     return out;
 }
 
+static std::runtime_error map_error(const std::filesystem::path& path,
+                                    std::string_view             cause)
+{
+    std::string msg;
+    msg.reserve(512);
+    msg += "error: can't map file [";
+    msg += path.generic_string();
+    msg += "] cause: ";
+    msg += cause;
+    return std::runtime_error(msg);
+}
+
+#ifdef _WIN32
+mapped_content map_file(const std::filesystem::path& path)
+{
+    mapped_content out;
+
+    HANDLE file = CreateFileW(path.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw map_error(path, "CreateFileW failed");
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        throw map_error(path, "GetFileSizeEx failed");
+    }
+
+    if (file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return out;
+    }
+
+    HANDLE mapping =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // view keeps mapping alive, so handles can be closed right away
+    CloseHandle(file);
+    if (mapping == nullptr)
+    {
+        throw map_error(path, "CreateFileMappingW failed");
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr)
+    {
+        throw map_error(path, "MapViewOfFile failed");
+    }
+
+    const auto size = static_cast<std::size_t>(file_size.QuadPart);
+    out.memory      = std::unique_ptr<std::byte[], unmap_deleter>(
+        static_cast<std::byte*>(view), unmap_deleter{ size });
+    out.size = size;
+    return out;
+}
+
+void unmap_file(std::byte* memory, std::size_t /*size*/) noexcept
+{
+    if (memory != nullptr)
+    {
+        UnmapViewOfFile(memory);
+    }
+}
+#else
+mapped_content map_file(const std::filesystem::path& path)
+{
+    mapped_content out;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw map_error(path, std::strerror(errno));
+    }
+
+    struct stat file_stat{};
+    if (::fstat(fd, &file_stat) == -1)
+    {
+        const int err = errno;
+        ::close(fd);
+        throw map_error(path, std::strerror(err));
+    }
+
+    if (file_stat.st_size == 0)
+    {
+        ::close(fd);
+        return out;
+    }
+
+    const auto size = static_cast<std::size_t>(file_stat.st_size);
+    void*      view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int  err  = errno;
+    // mapping holds own reference to file
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        throw map_error(path, std::strerror(err));
+    }
+
+    // assets are read once from begin to end
+    ::madvise(view, size, MADV_SEQUENTIAL);
+
+    out.memory = std::unique_ptr<std::byte[], unmap_deleter>(
+        static_cast<std::byte*>(view), unmap_deleter{ size });
+    out.size = size;
+    return out;
+}
+
+void unmap_file(std::byte* memory, std::size_t size) noexcept
+{
+    if (memory != nullptr)
+    {
+        ::munmap(memory, size);
+    }
+}
+#endif
+
 } // namespace om::io
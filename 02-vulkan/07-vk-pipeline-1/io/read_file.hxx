@@ -41,5 +41,59 @@ struct content
     }
 };
 
+/// unmap memory returned by map_file, size must be same as mapped
+void unmap_file(std::byte* memory, std::size_t size) noexcept;
+
+struct unmap_deleter
+{
+    std::size_t size{};
+    void        operator()(std::byte* memory) const noexcept
+    {
+        unmap_file(memory, size);
+    }
+};
+
+/// same interface as content, but memory is read only view of file mapped
+/// into process address space, pages are loaded by OS on first access and
+/// never copied into heap
+struct mapped_content
+{
+    std::unique_ptr<std::byte[], unmap_deleter> memory;
+    std::size_t                                 size{};
+
+    mapped_content(const mapped_content& other)            = delete;
+    mapped_content& operator=(const mapped_content& other) = delete;
+
+    mapped_content() noexcept
+        : memory{}
+    {
+    }
+    mapped_content(mapped_content&& other) noexcept
+        : memory{ std::move(other.memory) }
+        , size{ std::exchange(other.size, 0) }
+    {
+    }
+
+    mapped_content& operator=(mapped_content&& other) noexcept
+    {
+        memory = std::move(other.memory);
+        size   = std::exchange(other.size, 0);
+        return *this;
+    }
+
+    [[nodiscard]] std::string_view as_string_view() const noexcept
+    {
+        return { reinterpret_cast<char*>(memory.get()), size };
+    }
+    [[nodiscard]] std::span<std::byte> as_span() const noexcept
+    {
+        return std::span{ memory.get(), size };
+    }
+};
+
 content read_file(const std::filesystem::path& path);
+
+/// map whole file, empty file gives empty content
+/// do not write to mapped memory, it is mapped read only
+mapped_content map_file(const std::filesystem::path& path);
 } // namespace om::io
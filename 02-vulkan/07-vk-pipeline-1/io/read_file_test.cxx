@@ -11,7 +11,7 @@ TEST_CASE("check file reading", "io::read_file")
     std::filesystem::path path =
         "./02-vulkan/07-vk-pipeline-1/io/read_file_test.cxx";
 
-    constexpr size_t this_file_num_of_lines = 40;
+    constexpr size_t this_file_num_of_lines = 74;
 
     om::io::content content = om::io::read_file(path);
     auto            str     = content.as_string_view();
@@ -38,4 +38,37 @@ TEST_CASE("check file reading", "io::read_file")
                 std::ranges::count(bytes, std::byte{ '\n' }));
     }
 }
+
+TEST_CASE("check file mapping", "io::map_file")
+{
+    std::filesystem::path path =
+        "./02-vulkan/07-vk-pipeline-1/io/read_file_test.cxx";
+
+    om::io::content        content = om::io::read_file(path);
+    om::io::mapped_content mapped  = om::io::map_file(path);
+
+    BENCHMARK("how fast is map same file")
+    {
+        return om::io::map_file(path);
+    };
+
+    SECTION("mapped content same as read content")
+    {
+        REQUIRE(mapped.size == content.size);
+        REQUIRE(mapped.as_string_view() == content.as_string_view());
+    }
+
+    SECTION("moved mapped content still valid")
+    {
+        om::io::mapped_content moved = std::move(mapped);
+        REQUIRE(mapped.size == 0);
+        REQUIRE(moved.as_string_view() == content.as_string_view());
+    }
+
+    SECTION("missing file throws")
+    {
+        REQUIRE_THROWS_AS(om::io::map_file("./no_such_file.bin"),
+                          std::runtime_error);
+    }
+}
 // NOLINTEND(*)
@@ -147,7 +147,10 @@ int main_cant_throw(int argc, char** argv)
                                 .minor = args_parser.vulkan_version_minor },
             .verbose        = verbose,
             .enable_validation_layers  = vk_validation_layer,
-            .enable_debug_callback_ext = vk_debug_callback_ext
+            .enable_debug_callback_ext = vk_debug_callback_ext,
+            .recording_threads         = 2u, // main + mesh recording thread
+            .hot_reload_shaders        = args_parser.hot_reload_shaders,
+            .compare_mipmap_generation = verbose
         };
         render render(platform, hints);
 
@@ -180,7 +183,9 @@ int main_cant_throw(int argc, char** argv)
             false);
         uniform_buffer_object ubo{};
 
-        om::vulkan::mesh mesh = om::tinyobj::load_model(
+        // model split in parts, culled on GPU against camera frustum, parts
+        // draw from same vertex and index buffers as whole mesh
+        auto [mesh, room_parts] = om::tinyobj::load_culled_model(
             "02-vulkan/16-vk-compute/model/viking_room.obj", render);
 
         // User creates initial particles (same layout as compute SSBO).
@@ -209,6 +214,7 @@ int main_cant_throw(int argc, char** argv)
 
         bool running         = true;
         bool mip_level_state = true;
+        bool gpu_culling     = true;
         while (running)
         {
             sdl::Event event;
@@ -232,6 +238,13 @@ int main_cant_throw(int argc, char** argv)
                             om::cout << "change state: " << mip_level_state
                                      << std::endl;
                         }
+                        if (static_cast<sdl::Keycode>(event.key.key) ==
+                            sdl::Keycode::C)
+                        {
+                            gpu_culling = !gpu_culling;
+                            om::cout << "gpu culling: " << gpu_culling
+                                     << std::endl;
+                        }
                         break;
                     case sdl::EventType::WINDOW_RESIZED:
                         render.recreate_swapchain();
@@ -283,8 +296,21 @@ int main_cant_throw(int argc, char** argv)
 
             render.begin_frame();
 
-            render.draw(mesh, image_mip_on, ubo_span);
-            render.draw(parts, compute_ubo_span);
+            if (gpu_culling)
+            {
+                render.draw(mesh, image_mip_on, room_parts, ubo_span);
+                render.draw(parts, compute_ubo_span);
+            }
+            else
+            {
+                // record mesh on worker thread while main thread dispatch
+                // particles, every thread uses own thread_index
+                auto mesh_recorded = std::async(
+                    std::launch::async,
+                    [&] { render.draw(1u, mesh, image_mip_on, ubo_span); });
+                render.draw(parts, compute_ubo_span);
+                mesh_recorded.get();
+            }
 
             render.end_frame();
 
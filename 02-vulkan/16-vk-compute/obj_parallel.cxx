@@ -0,0 +1,401 @@
+module;
+
+#include "read_file.hxx"
+
+export module obj_parallel;
+
+import std;
+import glm;
+import vulkan_render;
+
+namespace om::obj
+{
+namespace
+{
+// one face corner, indexes zero based, relative (negative in file) ones
+// are relative to chunk start until chunk base is known
+struct corner
+{
+    std::int64_t position          = 0;
+    std::int64_t texcoord          = 0;
+    bool         position_relative = false;
+    bool         texcoord_relative = false;
+};
+
+struct chunk_result
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords; // already flipped for Vulkan
+    std::vector<corner>    corners;
+    bool                   supported = true;
+};
+
+void skip_spaces(const char*& cursor, const char* end)
+{
+    while (cursor != end && (*cursor == ' ' || *cursor == '\t'))
+    {
+        ++cursor;
+    }
+}
+
+// parsed as double and narrowed like tinyobjloader does, so float values
+// are same as in tinyobj::load_geometry
+bool parse_real(const char*& cursor, const char* end, float& value)
+{
+    skip_spaces(cursor, end);
+    if (cursor != end && *cursor == '+')
+    {
+        ++cursor;
+    }
+    double number = 0.0;
+    auto [ptr, ec] = std::from_chars(cursor, end, number);
+    if (ec != std::errc{})
+    {
+        return false;
+    }
+    cursor = ptr;
+    value  = static_cast<float>(number);
+    return true;
+}
+
+bool parse_index(const char*&  cursor,
+                 const char*   end,
+                 std::size_t   local_count,
+                 std::int64_t& index,
+                 bool&         relative)
+{
+    std::int64_t number = 0;
+    auto [ptr, ec]      = std::from_chars(cursor, end, number);
+    if (ec != std::errc{} || number == 0)
+    {
+        return false;
+    }
+    cursor   = ptr;
+    relative = number < 0;
+    index    = relative ? static_cast<std::int64_t>(local_count) + number
+                        : number - 1;
+    return true;
+}
+
+// "f v/vt v/vt/vn v/vt" - only triangles with texture coordinates are
+// supported, everything else goes to tinyobjloader
+bool parse_face(const char* cursor, const char* end, chunk_result& chunk)
+{
+    std::size_t corners = 0;
+    for (;;)
+    {
+        skip_spaces(cursor, end);
+        if (cursor == end)
+        {
+            break;
+        }
+        corner c;
+        if (!parse_index(cursor,
+                         end,
+                         chunk.positions.size(),
+                         c.position,
+                         c.position_relative))
+        {
+            return false;
+        }
+        if (cursor == end || *cursor != '/')
+        {
+            return false; // no texcoord
+        }
+        ++cursor;
+        if (!parse_index(cursor,
+                         end,
+                         chunk.texcoords.size(),
+                         c.texcoord,
+                         c.texcoord_relative))
+        {
+            return false;
+        }
+        // skip normal index, not used by vertex
+        while (cursor != end && *cursor != ' ' && *cursor != '\t')
+        {
+            ++cursor;
+        }
+        chunk.corners.push_back(c);
+        ++corners;
+    }
+    return corners == 3;
+}
+
+bool parse_line(const char* cursor, const char* end, chunk_result& chunk)
+{
+    skip_spaces(cursor, end);
+    const char* keyword_end = cursor;
+    while (keyword_end != end && *keyword_end != ' ' && *keyword_end != '\t')
+    {
+        ++keyword_end;
+    }
+    const std::string_view keyword(cursor, keyword_end);
+
+    if (keyword == "v")
+    {
+        glm::vec3 pos{};
+        if (!parse_real(keyword_end, end, pos.x) ||
+            !parse_real(keyword_end, end, pos.y) ||
+            !parse_real(keyword_end, end, pos.z))
+        {
+            return false;
+        }
+        chunk.positions.push_back(pos);
+    }
+    else if (keyword == "vt")
+    {
+        // tinyobjloader: missing v component is 0
+        glm::vec2 tex{ 0.0f, 0.0f };
+        if (!parse_real(keyword_end, end, tex.x))
+        {
+            return false;
+        }
+        parse_real(keyword_end, end, tex.y);
+        // Y direction in Vulkan from up to down
+        chunk.texcoords.emplace_back(tex.x, 1.0f - tex.y);
+    }
+    else if (keyword == "f")
+    {
+        return parse_face(keyword_end, end, chunk);
+    }
+    // comments, normals, groups, materials do not change geometry
+    return true;
+}
+
+void parse_chunk(std::string_view text, chunk_result& chunk)
+{
+    const char* cursor = text.data();
+    const char* end    = text.data() + text.size();
+    while (cursor != end && chunk.supported)
+    {
+        const char* line_end = std::find(cursor, end, '\n');
+        const char* content  = line_end;
+        if (content != cursor && content[-1] == '\r')
+        {
+            --content;
+        }
+        chunk.supported = parse_line(cursor, content, chunk);
+        cursor          = line_end == end ? end : line_end + 1;
+    }
+}
+
+/// Open addressing hash table (linear probing) of uint32 ids. Keys live
+/// outside of table and are compared by caller, so slot is 4 bytes and
+/// table never grows, capacity is known before first insert.
+class flat_id_table
+{
+public:
+    explicit flat_id_table(std::size_t max_size)
+        : slots_(std::bit_ceil(std::max<std::size_t>(max_size * 2u, 16u)),
+                 empty)
+        , mask_{ slots_.size() - 1u }
+    {
+    }
+
+    /// id of equal key already in table or insert id
+    template <typename Equal>
+    std::uint32_t find_or_insert(std::uint64_t hash,
+                                 std::uint32_t id,
+                                 Equal&&       equal)
+    {
+        for (std::size_t slot = mix(hash) & mask_;;
+             slot             = (slot + 1u) & mask_)
+        {
+            if (slots_[slot] == empty)
+            {
+                slots_[slot] = id;
+                return id;
+            }
+            if (equal(slots_[slot]))
+            {
+                return slots_[slot];
+            }
+        }
+    }
+
+private:
+    static constexpr std::uint32_t empty = ~0u;
+
+    // splitmix64 finalizer, spreads bits of index pairs over table
+    static std::uint64_t mix(std::uint64_t x)
+    {
+        x ^= x >> 30u;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27u;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31u;
+        return x;
+    }
+
+    std::vector<std::uint32_t> slots_;
+    std::size_t                mask_;
+};
+
+// +0.0 and -0.0 are equal as in vertex::operator==
+std::uint64_t float_bits(float value)
+{
+    return std::bit_cast<std::uint32_t>(value == 0.0f ? 0.0f : value);
+}
+
+/// for every element id of first element with same value, so index pairs
+/// compare equal exactly when vertex values compare equal
+template <typename T>
+std::vector<std::uint32_t> canonical_ids(const std::vector<T>& values)
+{
+    flat_id_table              table(values.size());
+    std::vector<std::uint32_t> ids(values.size());
+    for (std::uint32_t i = 0; i < values.size(); ++i)
+    {
+        std::uint64_t hash = 0;
+        for (glm::length_t c = 0; c < T::length(); ++c)
+        {
+            hash = hash * 0x100000001b3ull ^ float_bits(values[i][c]);
+        }
+        ids[i] = table.find_or_insert(hash,
+                                      i,
+                                      [&](std::uint32_t other)
+                                      { return values[other] == values[i]; });
+    }
+    return ids;
+}
+} // namespace
+
+/// Parse OBJ text on threads and build same vertexes and indexes as
+/// om::tinyobj::load_geometry. Text split in line aligned chunks, numbers
+/// parsed with std::from_chars, vertexes deduplicated by (position,
+/// texcoord) index pairs in flat hash table instead of hashing whole vertex.
+/// Returns false if file has something beyond triangles with texcoords
+/// (polygons, faces without vt, bad indexes), caller should use tinyobj.
+export bool parse_geometry(std::string_view                 text,
+                           std::vector<om::vulkan::vertex>& vertices,
+                           std::vector<std::uint32_t>&      indices,
+                           std::uint32_t                    threads = std::max(
+                               1u, std::thread::hardware_concurrency()))
+{
+    // small files are not worth of thread start
+    constexpr std::size_t min_chunk_size = 256u * 1024u;
+    const std::size_t     chunk_count    = std::clamp<std::size_t>(
+        text.size() / min_chunk_size, 1u, std::max(threads, 1u));
+
+    std::vector<std::string_view> chunks;
+    std::size_t                   begin = 0;
+    for (std::size_t i = 1; i <= chunk_count && begin < text.size(); ++i)
+    {
+        std::size_t end = text.size();
+        if (i != chunk_count)
+        {
+            // end after '\n' of line crossing even split point
+            end = std::max(text.size() * i / chunk_count, begin);
+            end = std::min(text.find('\n', end), text.size() - 1u) + 1u;
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    if (chunks.empty())
+    {
+        chunks.emplace_back();
+    }
+
+    std::vector<chunk_result> results(chunks.size());
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i = 1; i < chunks.size(); ++i)
+        {
+            workers.emplace_back(
+                [&, i] { parse_chunk(chunks[i], results[i]); });
+        }
+        parse_chunk(chunks[0], results[0]);
+    } // join
+
+    // merge chunks, relative indexes get global base of their chunk
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::size_t            corner_count = 0;
+    for (const chunk_result& chunk : results)
+    {
+        if (!chunk.supported)
+        {
+            return false;
+        }
+        corner_count += chunk.corners.size();
+    }
+
+    std::vector<std::uint64_t> corner_keys;
+    corner_keys.reserve(corner_count);
+    for (chunk_result& chunk : results)
+    {
+        const auto position_base = static_cast<std::int64_t>(positions.size());
+        const auto texcoord_base = static_cast<std::int64_t>(texcoords.size());
+        positions.insert(
+            positions.end(), chunk.positions.begin(), chunk.positions.end());
+        texcoords.insert(
+            texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+
+        for (corner c : chunk.corners)
+        {
+            c.position += c.position_relative ? position_base : 0;
+            c.texcoord += c.texcoord_relative ? texcoord_base : 0;
+            if (c.position < 0 ||
+                c.position >= static_cast<std::int64_t>(positions.size()) ||
+                c.texcoord < 0 ||
+                c.texcoord >= static_cast<std::int64_t>(texcoords.size()))
+            {
+                return false;
+            }
+            corner_keys.push_back(
+                static_cast<std::uint64_t>(c.position) << 32u |
+                static_cast<std::uint64_t>(c.texcoord));
+        }
+        chunk = {}; // free memory early
+    }
+    if (positions.size() >= ~0u || texcoords.size() >= ~0u)
+    {
+        return false;
+    }
+
+    const std::vector<std::uint32_t> position_ids = canonical_ids(positions);
+    const std::vector<std::uint32_t> texcoord_ids = canonical_ids(texcoords);
+
+    // same order as tinyobj path: vertex appended on first use
+    flat_id_table              table(corner_count);
+    std::vector<std::uint64_t> vertex_keys;
+    vertices.clear();
+    indices.clear();
+    indices.reserve(corner_count);
+    for (const std::uint64_t corner_key : corner_keys)
+    {
+        const std::uint32_t position = position_ids[corner_key >> 32u];
+        const std::uint32_t texcoord = texcoord_ids[corner_key & ~0u];
+        const std::uint64_t key =
+            static_cast<std::uint64_t>(position) << 32u | texcoord;
+
+        const auto next_id = static_cast<std::uint32_t>(vertices.size());
+        const std::uint32_t id =
+            table.find_or_insert(key,
+                                 next_id,
+                                 [&](std::uint32_t other)
+                                 { return vertex_keys[other] == key; });
+        if (id == next_id)
+        {
+            vertex_keys.push_back(key);
+            vertices.push_back(om::vulkan::vertex{
+                .pos = positions[position],
+                .col = { 1.0f, 1.0f, 1.0f },
+                .tex = texcoords[texcoord],
+            });
+        }
+        indices.push_back(id);
+    }
+    return true;
+}
+
+/// map file and parse_geometry() it
+export bool load_geometry(const std::filesystem::path&     path,
+                          std::vector<om::vulkan::vertex>& vertices,
+                          std::vector<std::uint32_t>&      indices)
+{
+    const io::mapped_content file = io::map_file(path);
+    return parse_geometry(file.as_string_view(), vertices, indices);
+}
+} // namespace om::obj
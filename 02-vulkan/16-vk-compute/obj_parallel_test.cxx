@@ -0,0 +1,136 @@
+#include <catch2/catch_all.hpp>
+
+import std;
+import vulkan_render;
+import obj_parallel;
+import tinyobj;
+
+// NOLINTBEGIN(*)
+namespace
+{
+struct geometry
+{
+    std::vector<om::vulkan::vertex> vertices;
+    std::vector<std::uint32_t>      indices;
+};
+
+geometry load_reference(const std::filesystem::path& path)
+{
+    geometry result;
+    om::tinyobj::load_geometry(path, result.vertices, result.indices);
+    return result;
+}
+
+std::filesystem::path write_temp_obj(std::string_view name,
+                                     std::string_view text)
+{
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path, std::ios::binary) << text;
+    return path;
+}
+
+// big enough to be split in many chunks, uses negative indexes, normals,
+// CRLF line ends, groups and -0.0 to check deduplication by value
+std::string make_obj(std::uint32_t seed)
+{
+    constexpr std::array<float, 6> values{ 0.0f,   -0.0f,  0.5f,
+                                           -1.25f, 0.125f, 3.0f };
+
+    std::mt19937 rnd(seed);
+    std::string  text      = "# generated\r\nmtllib none.mtl\n";
+    std::int64_t positions = 0;
+    std::int64_t texcoords = 0;
+    auto         value = [&] { return values[rnd() % values.size()]; };
+    for (std::uint32_t i = 0; i < 300'000u; ++i)
+    {
+        switch (rnd() % 5u)
+        {
+            case 0:
+                text += std::format("v {} {} {}\n", value(), value(), value());
+                ++positions;
+                break;
+            case 1:
+                text += std::format("vt {} {}\r\n", value(), value());
+                ++texcoords;
+                break;
+            case 2:
+                text += "vn 0 1 0\n";
+                break;
+            default:
+                if (positions == 0 || texcoords == 0)
+                {
+                    text += "o part\n";
+                    break;
+                }
+                text += "f";
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    const std::int64_t p        = rnd() % positions;
+                    const std::int64_t t        = rnd() % texcoords;
+                    const bool         relative = rnd() % 2u;
+                    text += std::format(" {}/{}{}",
+                                        relative ? p - positions : p + 1,
+                                        relative ? t - texcoords : t + 1,
+                                        rnd() % 2u ? "/1" : "");
+                }
+                text += '\n';
+                break;
+        }
+    }
+    return text;
+}
+} // namespace
+
+TEST_CASE("parallel obj importer matches tinyobjloader", "obj_parallel")
+{
+    SECTION("viking room model")
+    {
+        const std::filesystem::path path =
+            "./02-vulkan/16-vk-compute/model/viking_room.obj";
+        if (!std::filesystem::exists(path))
+        {
+            SKIP("viking_room.obj not found, run from repository root");
+        }
+        const geometry expected = load_reference(path);
+
+        geometry result;
+        REQUIRE(om::obj::load_geometry(path, result.vertices, result.indices));
+        REQUIRE(result.vertices == expected.vertices);
+        REQUIRE(result.indices == expected.indices);
+    }
+
+    SECTION("generated model on any thread count")
+    {
+        const std::string text = make_obj(42u);
+        const auto path = write_temp_obj("om_obj_parallel_test.obj", text);
+        const geometry expected = load_reference(path);
+        std::filesystem::remove(path);
+        REQUIRE(!expected.indices.empty());
+
+        for (std::uint32_t threads : { 1u, 3u, 8u, 64u })
+        {
+            geometry result;
+            REQUIRE(om::obj::parse_geometry(
+                text, result.vertices, result.indices, threads));
+            REQUIRE(result.vertices == expected.vertices);
+            REQUIRE(result.indices == expected.indices);
+        }
+    }
+}
+
+TEST_CASE("parallel obj importer rejects unsupported files", "obj_parallel")
+{
+    std::vector<om::vulkan::vertex> vertices;
+    std::vector<std::uint32_t>      indices;
+
+    const char* quad = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\n"
+                       "f 1/1 2/1 3/1 4/1\n";
+    REQUIRE_FALSE(om::obj::parse_geometry(quad, vertices, indices));
+
+    const char* no_texcoords = "v 0 0 0\nvn 0 0 1\nf 1//1 1//1 1//1\n";
+    REQUIRE_FALSE(om::obj::parse_geometry(no_texcoords, vertices, indices));
+
+    const char* out_of_range = "v 0 0 0\nvt 0 0\nf 1/1 2/1 -2/1\n";
+    REQUIRE_FALSE(om::obj::parse_geometry(out_of_range, vertices, indices));
+}
+// NOLINTEND(*)
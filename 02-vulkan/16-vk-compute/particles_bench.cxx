@@ -0,0 +1,115 @@
+// Particles update throughput of CPU backends (every SIMD level and thread
+// count) and compute shader on headless Vulkan device, in particles per
+// second. Run from repository root:
+//     ./build/.../16-vk-compute-particles-bench [particle_count] [steps]
+import std;
+import glm;
+import vulkan_render;
+import vulkan_headless_device;
+import vulkan_headless_particles;
+import particles_cpu;
+
+namespace
+{
+std::vector<om::vulkan::particle> make_particles(std::size_t count)
+{
+    std::mt19937                          rnd_engine(7u);
+    std::uniform_real_distribution<float> rnd_dist(-1.0f, 1.0f);
+    std::vector<om::vulkan::particle>     result(count);
+    for (auto& p : result)
+    {
+        p.position = glm::vec2(rnd_dist(rnd_engine), rnd_dist(rnd_engine));
+        p.velocity = glm::vec2(rnd_dist(rnd_engine), rnd_dist(rnd_engine));
+        p.color    = glm::vec4(1.0f);
+    }
+    return result;
+}
+
+void report(std::string_view         name,
+            std::size_t              count,
+            std::uint32_t            steps,
+            std::chrono::nanoseconds duration)
+{
+    const double seconds = std::chrono::duration<double>(duration).count();
+    const double rate    = static_cast<double>(count) * steps / seconds;
+    std::cout << std::format("{:<24} {:>10.3f} ms {:>10.1f} M particles/s\n",
+                             name,
+                             seconds * 1000.0,
+                             rate / 1e6);
+}
+
+constexpr float delta_time = 1.0f / 60.0f;
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::size_t count =
+        argc > 1 ? std::stoul(argv[1]) : std::size_t{ 1u } << 20u;
+    const std::uint32_t steps =
+        argc > 2 ? static_cast<std::uint32_t>(std::stoul(argv[2])) : 100u;
+
+    const auto initial = make_particles(count);
+    std::cout << "particles: " << count << " steps: " << steps << '\n';
+
+    using om::particles::cpu_backend;
+    const std::uint32_t max_threads =
+        std::max(1u, std::thread::hardware_concurrency());
+
+    for (cpu_backend backend :
+         { cpu_backend::scalar, cpu_backend::sse2, cpu_backend::avx2 })
+    {
+        if (!om::particles::is_supported(backend))
+        {
+            std::cout << om::particles::to_string(backend)
+                      << ": not supported\n";
+            continue;
+        }
+        for (std::uint32_t threads = 1u;; threads = std::min(threads * 2u,
+                                                             max_threads))
+        {
+            om::particles::thread_pool   pool(threads);
+            om::particles::cpu_particles particles(initial, backend);
+
+            particles.update(delta_time, &pool); // warm up caches and pool
+            const auto start = std::chrono::steady_clock::now();
+            for (std::uint32_t i = 0; i < steps; ++i)
+            {
+                particles.update(delta_time, &pool);
+            }
+            report(std::format("cpu {} x{}",
+                               om::particles::to_string(backend),
+                               threads),
+                   count,
+                   steps,
+                   std::chrono::steady_clock::now() - start);
+
+            if (threads == max_threads)
+            {
+                break;
+            }
+        }
+    }
+
+    const auto spir_v = om::vulkan::read_spir_v(
+        "./02-vulkan/16-vk-compute/shaders/compute.slang.spv");
+    if (spir_v.empty())
+    {
+        std::cout << "gpu: compute.slang.spv not found, run from repo root\n";
+        return 0;
+    }
+    try
+    {
+        om::vulkan::headless_particles gpu(spir_v, initial);
+        gpu.update(delta_time, 1u); // warm up
+        // one submit for all steps, includes submit and fence wait
+        report("gpu " + gpu.get_device_name(),
+               count,
+               steps,
+               gpu.update(delta_time, steps));
+    }
+    catch (const std::runtime_error& ex)
+    {
+        std::cout << "gpu: " << ex.what() << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,412 @@
+module;
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define OM_PARTICLES_X86 1
+#include <immintrin.h>
+#endif
+
+// AVX2 kernel compiled even if whole target is not, used after cpu check
+#if defined(OM_PARTICLES_X86) && defined(__GNUC__)
+#define OM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define OM_TARGET_AVX2
+#endif
+
+export module particles_cpu;
+
+import std;
+import glm;
+import vulkan_render;
+
+namespace om::particles
+{
+export enum class cpu_backend
+{
+    scalar,
+    sse2,
+    avx2,
+};
+
+export std::string_view to_string(cpu_backend backend)
+{
+    switch (backend)
+    {
+        case cpu_backend::scalar:
+            return "scalar";
+        case cpu_backend::sse2:
+            return "sse2";
+        case cpu_backend::avx2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+/// backend compiled in and supported by current cpu
+export bool is_supported(cpu_backend backend)
+{
+    switch (backend)
+    {
+        case cpu_backend::scalar:
+            return true;
+        case cpu_backend::sse2:
+#if defined(OM_PARTICLES_X86)
+            return true; // x86_64 baseline
+#else
+            return false;
+#endif
+        case cpu_backend::avx2:
+#if defined(OM_PARTICLES_X86) && defined(__GNUC__)
+            return __builtin_cpu_supports("avx2");
+#elif defined(OM_PARTICLES_X86) && defined(__AVX2__)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+export cpu_backend best_cpu_backend()
+{
+    for (cpu_backend backend : { cpu_backend::avx2, cpu_backend::sse2 })
+    {
+        if (is_supported(backend))
+        {
+            return backend;
+        }
+    }
+    return cpu_backend::scalar;
+}
+
+/// Fixed set of workers for data parallel loops. parallel_for() splits
+/// range in chunks of grain elements, workers and calling thread take
+/// chunks from shared atomic counter until range ends.
+export class thread_pool final
+{
+public:
+    using task = std::function<void(std::size_t begin, std::size_t end)>;
+
+    /// threads - total threads including caller of parallel_for()
+    explicit thread_pool(std::uint32_t threads = std::max(
+                             1u, std::thread::hardware_concurrency()));
+    thread_pool(const thread_pool&)            = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    ~thread_pool();
+
+    [[nodiscard]] std::uint32_t get_thread_count() const
+    {
+        return static_cast<std::uint32_t>(workers_.size()) + 1u;
+    }
+
+    /// blocks until body called for every chunk of [0, count), body must
+    /// not throw
+    void parallel_for(std::size_t count, std::size_t grain, const task& body);
+
+private:
+    void worker(std::stop_token stop);
+    void run_chunks();
+
+    std::mutex                  mutex_;
+    std::condition_variable_any wake_;
+    std::condition_variable     done_;
+    // current loop, written under mutex_ before generation_ changes
+    const task*              body_  = nullptr;
+    std::size_t              count_ = 0u;
+    std::size_t              grain_ = 1u;
+    std::atomic<std::size_t> next_{ 0u };
+    std::uint64_t            generation_ = 0u;
+    std::uint32_t            active_     = 0u; // workers in current loop
+    std::vector<std::jthread> workers_; // last, joined first
+};
+
+thread_pool::thread_pool(std::uint32_t threads)
+{
+    workers_.reserve(threads > 0u ? threads - 1u : 0u);
+    for (std::uint32_t i = 1; i < threads; ++i)
+    {
+        workers_.emplace_back([this](std::stop_token stop) { worker(stop); });
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    for (auto& thread : workers_)
+    {
+        thread.request_stop();
+    }
+    wake_.notify_all();
+    workers_.clear(); // join
+}
+
+void thread_pool::parallel_for(std::size_t count,
+                               std::size_t grain,
+                               const task& body)
+{
+    grain = std::max<std::size_t>(grain, 1u);
+    if (workers_.empty() || count <= grain)
+    {
+        body(0u, count);
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mutex_);
+        body_   = &body;
+        count_  = count;
+        grain_  = grain;
+        active_ = static_cast<std::uint32_t>(workers_.size());
+        next_.store(0u, std::memory_order_relaxed);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    run_chunks();
+
+    std::unique_lock lock(mutex_);
+    done_.wait(lock, [this] { return active_ == 0u; });
+    body_ = nullptr;
+}
+
+void thread_pool::worker(std::stop_token stop)
+{
+    std::uint64_t seen_generation = 0u;
+    for (;;)
+    {
+        {
+            std::unique_lock lock(mutex_);
+            if (!wake_.wait(lock,
+                            stop,
+                            [&] { return generation_ != seen_generation; }))
+            {
+                return; // stop requested
+            }
+            seen_generation = generation_;
+        }
+
+        run_chunks();
+
+        std::scoped_lock lock(mutex_);
+        if (--active_ == 0u)
+        {
+            done_.notify_one();
+        }
+    }
+}
+
+void thread_pool::run_chunks()
+{
+    for (;;)
+    {
+        const std::size_t begin =
+            next_.fetch_add(grain_, std::memory_order_relaxed);
+        if (begin >= count_)
+        {
+            return;
+        }
+        (*body_)(begin, std::min(begin + grain_, count_));
+    }
+}
+
+// One axis of comp_main from shaders/compute.slang:
+//     position += velocity * delta_time;
+//     if (position <= -1 || position >= 1) velocity = -velocity;
+// Multiply and add are separate statements and instructions (no fused
+// multiply add), so every backend gives same bits.
+static void integrate_axis_scalar(float*      position,
+                                  float*      velocity,
+                                  std::size_t count,
+                                  float       delta_time)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float step = velocity[i] * delta_time;
+        const float p    = position[i] + step;
+        position[i]      = p;
+        if (p <= -1.0f || p >= 1.0f)
+        {
+            velocity[i] = -velocity[i];
+        }
+    }
+}
+
+#if defined(OM_PARTICLES_X86)
+static void integrate_axis_sse2(float*      position,
+                                float*      velocity,
+                                std::size_t count,
+                                float       delta_time)
+{
+    const __m128 dt        = _mm_set1_ps(delta_time);
+    const __m128 lower     = _mm_set1_ps(-1.0f);
+    const __m128 upper     = _mm_set1_ps(1.0f);
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+    std::size_t i = 0;
+    for (; i + 4u <= count; i += 4u)
+    {
+        const __m128 v = _mm_loadu_ps(velocity + i);
+        const __m128 p = _mm_add_ps(_mm_loadu_ps(position + i),
+                                    _mm_mul_ps(v, dt));
+        // flip sign bit where particle reached border
+        const __m128 hit =
+            _mm_or_ps(_mm_cmple_ps(p, lower), _mm_cmpge_ps(p, upper));
+        _mm_storeu_ps(position + i, p);
+        _mm_storeu_ps(velocity + i,
+                      _mm_xor_ps(v, _mm_and_ps(hit, sign_mask)));
+    }
+    integrate_axis_scalar(position + i, velocity + i, count - i, delta_time);
+}
+
+OM_TARGET_AVX2 static void integrate_axis_avx2(float*      position,
+                                               float*      velocity,
+                                               std::size_t count,
+                                               float       delta_time)
+{
+    const __m256 dt        = _mm256_set1_ps(delta_time);
+    const __m256 lower     = _mm256_set1_ps(-1.0f);
+    const __m256 upper     = _mm256_set1_ps(1.0f);
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+    std::size_t i = 0;
+    for (; i + 8u <= count; i += 8u)
+    {
+        const __m256 v = _mm256_loadu_ps(velocity + i);
+        const __m256 p = _mm256_add_ps(_mm256_loadu_ps(position + i),
+                                       _mm256_mul_ps(v, dt));
+        const __m256 hit =
+            _mm256_or_ps(_mm256_cmp_ps(p, lower, _CMP_LE_OQ),
+                         _mm256_cmp_ps(p, upper, _CMP_GE_OQ));
+        _mm256_storeu_ps(position + i, p);
+        _mm256_storeu_ps(velocity + i,
+                         _mm256_xor_ps(v, _mm256_and_ps(hit, sign_mask)));
+    }
+    integrate_axis_sse2(position + i, velocity + i, count - i, delta_time);
+}
+#endif
+
+/// CPU version of particles update (shaders/compute.slang). Structure of
+/// arrays layout, every axis is contiguous float array, so one SIMD
+/// register holds same component of 4 (sse2) or 8 (avx2) particles.
+/// Results of all backends are bit identical.
+export class cpu_particles final
+{
+public:
+    explicit cpu_particles(std::span<const om::vulkan::particle> initial_data,
+                           cpu_backend backend = best_cpu_backend());
+
+    /// one compute dispatch, pool == nullptr - run on calling thread
+    void update(float delta_time, thread_pool* pool = nullptr);
+
+    /// array of structures, same layout as GPU storage buffer
+    void read(std::span<om::vulkan::particle> output) const;
+    [[nodiscard]] std::vector<om::vulkan::particle> get_particles() const;
+
+    [[nodiscard]] std::uint32_t get_count() const
+    {
+        return static_cast<std::uint32_t>(position_x_.size());
+    }
+    [[nodiscard]] cpu_backend get_backend() const { return backend_; }
+
+private:
+    void integrate(std::size_t begin, std::size_t end, float delta_time);
+
+    // 64 KiB of every array per chunk, multiple of avx2 width
+    static constexpr std::size_t chunk_size = 16u * 1024u;
+
+    cpu_backend            backend_;
+    std::vector<float>     position_x_;
+    std::vector<float>     position_y_;
+    std::vector<float>     velocity_x_;
+    std::vector<float>     velocity_y_;
+    std::vector<glm::vec4> color_; // not changed by update
+};
+
+cpu_particles::cpu_particles(std::span<const om::vulkan::particle> initial_data,
+                             cpu_backend backend)
+    : backend_{ backend }
+{
+    if (!is_supported(backend))
+    {
+        throw std::runtime_error(
+            "error: cpu particles backend not supported: " +
+            std::string(to_string(backend)));
+    }
+
+    const std::size_t count = initial_data.size();
+    position_x_.reserve(count);
+    position_y_.reserve(count);
+    velocity_x_.reserve(count);
+    velocity_y_.reserve(count);
+    color_.reserve(count);
+    for (const om::vulkan::particle& p : initial_data)
+    {
+        position_x_.push_back(p.position.x);
+        position_y_.push_back(p.position.y);
+        velocity_x_.push_back(p.velocity.x);
+        velocity_y_.push_back(p.velocity.y);
+        color_.push_back(p.color);
+    }
+}
+
+void cpu_particles::update(float delta_time, thread_pool* pool)
+{
+    if (pool == nullptr)
+    {
+        integrate(0u, get_count(), delta_time);
+        return;
+    }
+    pool->parallel_for(get_count(),
+                       chunk_size,
+                       [this, delta_time](std::size_t begin, std::size_t end)
+                       { integrate(begin, end, delta_time); });
+}
+
+void cpu_particles::integrate(std::size_t begin,
+                              std::size_t end,
+                              float       delta_time)
+{
+    const std::size_t count = end - begin;
+    float*            px    = position_x_.data() + begin;
+    float*            py    = position_y_.data() + begin;
+    float*            vx    = velocity_x_.data() + begin;
+    float*            vy    = velocity_y_.data() + begin;
+
+    switch (backend_)
+    {
+#if defined(OM_PARTICLES_X86)
+        case cpu_backend::avx2:
+            integrate_axis_avx2(px, vx, count, delta_time);
+            integrate_axis_avx2(py, vy, count, delta_time);
+            return;
+        case cpu_backend::sse2:
+            integrate_axis_sse2(px, vx, count, delta_time);
+            integrate_axis_sse2(py, vy, count, delta_time);
+            return;
+#endif
+        default:
+            integrate_axis_scalar(px, vx, count, delta_time);
+            integrate_axis_scalar(py, vy, count, delta_time);
+            return;
+    }
+}
+
+void cpu_particles::read(std::span<om::vulkan::particle> output) const
+{
+    if (output.size() != get_count())
+    {
+        throw std::runtime_error("error: cpu particles read size mismatch");
+    }
+    for (std::size_t i = 0; i < output.size(); ++i)
+    {
+        output[i].position = { position_x_[i], position_y_[i] };
+        output[i].velocity = { velocity_x_[i], velocity_y_[i] };
+        output[i].color    = color_[i];
+    }
+}
+
+std::vector<om::vulkan::particle> cpu_particles::get_particles() const
+{
+    std::vector<om::vulkan::particle> output(get_count());
+    read(output);
+    return output;
+}
+} // namespace om::particles
@@ -0,0 +1,143 @@
+#include <catch2/catch_all.hpp>
+
+import std;
+import glm;
+import vulkan_render;
+import vulkan_headless_device;
+import vulkan_headless_particles;
+import particles_cpu;
+
+// NOLINTBEGIN(*)
+namespace
+{
+// same distribution as main.cxx, but fixed seed and faster particles so
+// many of them bounce from borders during test
+std::vector<om::vulkan::particle> make_particles(std::size_t count)
+{
+    std::mt19937                          rnd_engine(42u);
+    std::uniform_real_distribution<float> rnd_dist(0.0f, 1.0f);
+    std::vector<om::vulkan::particle>     result(count);
+    for (auto& p : result)
+    {
+        const float r     = 0.25f * std::sqrt(rnd_dist(rnd_engine));
+        const float theta = rnd_dist(rnd_engine) * 2.0f * glm::pi<float>();
+        const float x     = r * std::cos(theta);
+        const float y     = r * std::sin(theta);
+        p.position        = glm::vec2(x, y);
+        p.velocity        = glm::normalize(glm::vec2(x, y)) * 1.5f;
+        p.color           = glm::vec4(rnd_dist(rnd_engine), 0.5f, 0.5f, 1.0f);
+    }
+    return result;
+}
+
+bool same_bits(const om::vulkan::particle& a, const om::vulkan::particle& b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+constexpr float         delta_time = 1.0f / 60.0f;
+constexpr std::uint32_t steps      = 240;
+// not multiple of 8, so SIMD tails are tested too
+constexpr std::size_t particle_count = 100'003;
+} // namespace
+
+TEST_CASE("cpu particle backends are bit identical", "particles_cpu")
+{
+    using om::particles::cpu_backend;
+    const auto initial = make_particles(particle_count);
+
+    om::particles::cpu_particles reference(initial, cpu_backend::scalar);
+    for (std::uint32_t i = 0; i < steps; ++i)
+    {
+        reference.update(delta_time);
+    }
+    const auto expected = reference.get_particles();
+
+    om::particles::thread_pool pool(4u);
+
+    for (cpu_backend backend :
+         { cpu_backend::scalar, cpu_backend::sse2, cpu_backend::avx2 })
+    {
+        if (!om::particles::is_supported(backend))
+        {
+            continue;
+        }
+        DYNAMIC_SECTION("backend " << om::particles::to_string(backend))
+        {
+            om::particles::cpu_particles simulated(initial, backend);
+            for (std::uint32_t i = 0; i < steps; ++i)
+            {
+                simulated.update(delta_time, &pool);
+            }
+            const auto result = simulated.get_particles();
+            REQUIRE(result.size() == expected.size());
+            for (std::size_t i = 0; i < result.size(); ++i)
+            {
+                REQUIRE(same_bits(result[i], expected[i]));
+            }
+        }
+    }
+
+    SECTION("particles bounce from borders")
+    {
+        const auto moved = std::ranges::count_if(
+            std::views::iota(std::size_t{ 0 }, expected.size()),
+            [&](std::size_t i)
+            { return expected[i].velocity != initial[i].velocity; });
+        REQUIRE(moved > 0);
+    }
+}
+
+TEST_CASE("cpu particles match compute shader", "particles_cpu")
+{
+    const auto spir_v = om::vulkan::read_spir_v(
+        "./02-vulkan/16-vk-compute/shaders/compute.slang.spv");
+    if (spir_v.empty())
+    {
+        SKIP("compute.slang.spv not found, run from repository root");
+    }
+
+    const auto initial = make_particles(particle_count);
+
+    std::optional<om::vulkan::headless_particles> gpu;
+    try
+    {
+        gpu.emplace(spir_v, initial);
+    }
+    catch (const std::runtime_error& ex)
+    {
+        SKIP(ex.what());
+    }
+
+    om::particles::cpu_particles cpu(initial);
+    om::particles::thread_pool   pool;
+    for (std::uint32_t i = 0; i < steps; ++i)
+    {
+        cpu.update(delta_time, &pool);
+    }
+    gpu->update(delta_time, steps);
+
+    const auto expected = cpu.get_particles();
+    const auto result   = gpu->get_particles();
+    REQUIRE(result.size() == expected.size());
+
+    // GPU driver may fuse multiply and add, then particle very close to
+    // border may bounce one step earlier or later, allow few such cases
+    constexpr float tolerance        = 1e-4f;
+    std::size_t     out_of_tolerance = 0;
+    for (std::size_t i = 0; i < result.size(); ++i)
+    {
+        const float error = std::max(
+            glm::length(result[i].position - expected[i].position),
+            glm::length(result[i].velocity - expected[i].velocity));
+        if (error > tolerance)
+        {
+            ++out_of_tolerance;
+        }
+        REQUIRE(result[i].color == expected[i].color);
+    }
+    INFO("device: " << gpu->get_device_name()
+                    << " out of tolerance: " << out_of_tolerance);
+    REQUIRE(out_of_tolerance <= result.size() / 1000u);
+}
+// NOLINTEND(*)
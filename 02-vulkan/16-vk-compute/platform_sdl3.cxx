@@ -32,7 +32,8 @@ export struct platform_sdl3 final : platform_interface
 
     std::ostream& get_logger() noexcept override;
 
-    content get_file_content(std::string_view path) override;
+    content get_file_content(std::string_view path,
+                             file_access      access) override;
 
 private:
     sdl::SDL_Window* window;
@@ -113,13 +114,28 @@ std::ostream& platform_sdl3::get_logger() noexcept
 }
 
 platform_interface::content platform_sdl3::get_file_content(
-    std::string_view path)
+    std::string_view path, file_access access)
 {
-    content     result{};
-    io::content content = io::read_file(path);
+    content result{};
 
-    result.memory = std::move(content.memory);
-    result.size   = std::exchange(content.size, 0);
+    if (access == file_access::reloadable)
+    {
+        // copy, file may be rewritten under mapping while content alive
+        io::content copy = io::read_file(path);
+        result.memory    = decltype(result.memory)(copy.memory.release());
+        result.size      = std::exchange(copy.size, 0);
+        return result;
+    }
+
+    io::mapped_content mapped = io::map_file(path);
+
+    // images are read only, so map file instead of copy it into heap,
+    // mapping released with io::unmap_file
+    const std::size_t size = std::exchange(mapped.size, 0);
+    result.memory          = decltype(result.memory)(
+        mapped.memory.release(),
+        content::deleter{ .release = &io::unmap_file, .size = size });
+    result.size = size;
 
     return result;
 }
@@ -8,11 +8,14 @@ export module tinyobj;
 import std;
 
 import vulkan_render;
+import obj_parallel;
 
 namespace om::tinyobj
 {
-export om::vulkan::mesh load_model(std::filesystem::path path,
-                                   om::vulkan::render&   render)
+/// reference loader, any OBJ supported by tinyobjloader
+export void load_geometry(const std::filesystem::path&    path,
+                          std::vector<om::vulkan::vertex>& vertices,
+                          std::vector<std::uint32_t>&      indices)
 {
     using namespace ::tinyobj;
     attrib_t                attrib;
@@ -27,9 +30,6 @@ export om::vulkan::mesh load_model(std::filesystem::path path,
 
     std::unordered_map<om::vulkan::vertex, std::uint32_t> unique_vertexes;
 
-    std::vector<om::vulkan::vertex> vertices;
-    std::vector<std::uint32_t>      indices;
-
     for (const auto& shape : shapes)
     {
         for (const auto& index : shape.mesh.indices)
@@ -56,8 +56,52 @@ export om::vulkan::mesh load_model(std::filesystem::path path,
             indices.push_back(it->second);
         }
     }
+}
+
+/// parallel om::obj loader, tinyobjloader if file has polygons or faces
+/// without texture coordinates
+static void import_geometry(const std::filesystem::path&    path,
+                            std::vector<om::vulkan::vertex>& vertices,
+                            std::vector<std::uint32_t>&      indices)
+{
+    if (!om::obj::load_geometry(path, vertices, indices))
+    {
+        vertices.clear();
+        indices.clear();
+        load_geometry(path, vertices, indices);
+    }
+}
+
+export om::vulkan::mesh load_model(std::filesystem::path path,
+                                   om::vulkan::render&   render)
+{
+    std::vector<om::vulkan::vertex> vertices;
+    std::vector<std::uint32_t>      indices;
+    import_geometry(path, vertices, indices);
 
     return om::vulkan::mesh(
         std::span{ vertices }, std::span{ indices }, render, "viking_home");
 }
+
+/// load model and split it into parts of triangles_per_object triangles
+/// for GPU frustum culling, parts index into returned mesh buffers, so same
+/// mesh draws whole model and culled parts from single GPU copy
+export std::pair<om::vulkan::mesh, om::vulkan::culled_mesh> load_culled_model(
+    std::filesystem::path path,
+    om::vulkan::render&   render,
+    std::uint32_t         triangles_per_object = 256u)
+{
+    std::vector<om::vulkan::vertex> vertices;
+    std::vector<std::uint32_t>      indices;
+    import_geometry(path, vertices, indices);
+
+    auto objects =
+        om::vulkan::make_cull_objects(vertices, indices, triangles_per_object);
+
+    return { om::vulkan::mesh(std::span{ vertices },
+                              std::span{ indices },
+                              render,
+                              "viking_home"),
+             om::vulkan::culled_mesh(objects, render) };
+}
 } // namespace om::tinyobj
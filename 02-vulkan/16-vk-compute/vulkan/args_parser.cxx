@@ -17,6 +17,7 @@ export struct args_parser
     bool          validation_layer     = false;
     bool          debug_callback       = false;
     bool          high_pixel_density   = false;
+    bool          hot_reload_shaders   = false;
 };
 
 export std::ostream& operator<<(std::ostream& out, const args_parser& arg)
@@ -41,6 +42,8 @@ export std::ostream& operator<<(std::ostream& out, const args_parser& arg)
         << (arg.debug_callback ? "enabled" : "disabled") << "│\n";
     out << "│ High pixel density    │ " << std::setw(28) << std::left
         << (arg.high_pixel_density ? "enabled" : "disabled") << "│\n";
+    out << "│ Hot reload shaders    │ " << std::setw(28) << std::left
+        << (arg.hot_reload_shaders ? "enabled" : "disabled") << "│\n";
     out << "└───────────────────────┴─────────────────────────────┘";
 
     return out;
@@ -64,6 +67,8 @@ args_parser::args_parser(int argc, char** argv)
         options.add_options()("vk_debug_callback,d",
                               "enable VK_EXT_debug_utils");
         options.add_options()("hdpi", "enable high_pixel_density");
+        options.add_options()("hot_reload",
+                              "watch compiled shaders and rebuild pipelines");
 
         variables_map vm;
         store(parse_command_line(argc, argv, options), vm);
@@ -81,6 +86,7 @@ args_parser::args_parser(int argc, char** argv)
         validation_layer   = vm.count("vk_validation_layer");
         debug_callback     = vm.count("vk_debug_callback");
         high_pixel_density = vm.count("hdpi");
+        hot_reload_shaders = vm.count("hot_reload");
 
         // expected format is "1.0" or "1.1" or "1.2" or "1.3" or "1.4"
         auto index_of_point = vulkan_version.find('.');
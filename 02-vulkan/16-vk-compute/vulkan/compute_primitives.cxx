@@ -0,0 +1,750 @@
+export module vulkan_compute_primitives;
+
+import std;
+import vulkan;
+
+namespace om::vulkan
+{
+/// CPU reference of compute_primitives::record_exclusive_scan
+export std::vector<std::uint32_t> exclusive_scan_reference(
+    std::span<const std::uint32_t> input)
+{
+    std::vector<std::uint32_t> output(input.size());
+    std::exclusive_scan(input.begin(), input.end(), output.begin(), 0u);
+    return output;
+}
+
+/// CPU reference of compute_primitives::record_compact, keeps order
+export std::vector<std::uint32_t> compact_reference(
+    std::span<const std::uint32_t> values, std::span<const std::uint32_t> flags)
+{
+    std::vector<std::uint32_t> output;
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        if (flags[i] != 0u)
+        {
+            output.push_back(values[i]);
+        }
+    }
+    return output;
+}
+
+/// CPU reference of compute_primitives::record_radix_sort, stable LSD radix
+/// sort with same digit size as shader, so equal keys keep values order
+export void radix_sort_reference(std::span<std::uint32_t> keys,
+                                 std::span<std::uint32_t> values)
+{
+    constexpr std::uint32_t radix_bits = 4u;
+    constexpr std::uint32_t radix_size = 1u << radix_bits;
+
+    std::vector<std::uint32_t> keys_tmp(keys.size());
+    std::vector<std::uint32_t> values_tmp(values.size());
+
+    for (std::uint32_t shift = 0; shift < 32u; shift += radix_bits)
+    {
+        std::array<std::uint32_t, radix_size> offsets{};
+        for (const std::uint32_t key : keys)
+        {
+            ++offsets[(key >> shift) & (radix_size - 1u)];
+        }
+        std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), 0u);
+
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            const std::uint32_t slot =
+                offsets[(keys[i] >> shift) & (radix_size - 1u)]++;
+            keys_tmp[slot]   = keys[i];
+            values_tmp[slot] = values[i];
+        }
+        std::ranges::copy(keys_tmp, keys.begin());
+        std::ranges::copy(values_tmp, values.begin());
+    }
+}
+
+/// GPU exclusive scan, stream compaction and key/value radix sort of uint32
+/// arrays, shaders/primitives.slang. Works on own buffers: fill keys and
+/// values buffers (copy or write from other shader), record primitive and
+/// read result from same buffers. Blocking helpers upload, run and download
+/// for tests and tools.
+export class compute_primitives final
+{
+public:
+    static constexpr std::uint32_t group_size = 256u;
+    static constexpr std::uint32_t radix_bits = 4u;
+    static constexpr std::uint32_t radix_size = 1u << radix_bits;
+
+    compute_primitives(const vk::raii::Device&         device,
+                       const vk::raii::PhysicalDevice& physical,
+                       std::uint32_t                   queue_family_index,
+                       std::span<const std::byte>      spir_v,
+                       std::uint32_t                   capacity);
+
+    [[nodiscard]] std::uint32_t get_capacity() const { return capacity_; }
+
+    /// keys: input of scan and sort, values to compact; scan result
+    [[nodiscard]] vk::Buffer get_keys_buffer() const { return keys_.buffer; }
+    /// values: sort payload, compaction flags (0 or 1)
+    [[nodiscard]] vk::Buffer get_values_buffer() const
+    {
+        return values_.buffer;
+    }
+    /// compacted keys
+    [[nodiscard]] vk::Buffer get_compacted_buffer() const
+    {
+        return keys_tmp_.buffer;
+    }
+    /// one uint32 - number of compacted keys
+    [[nodiscard]] vk::Buffer get_count_buffer() const
+    {
+        return count_.buffer;
+    }
+
+    /// keys = exclusive scan of keys
+    void record_exclusive_scan(vk::raii::CommandBuffer& cmd_buf,
+                               std::uint32_t            count);
+    /// compacted = keys where values != 0, count = compacted size
+    void record_compact(vk::raii::CommandBuffer& cmd_buf, std::uint32_t count);
+    /// sort keys and values by keys, stable
+    void record_radix_sort(vk::raii::CommandBuffer& cmd_buf,
+                           std::uint32_t            count);
+
+    std::vector<std::uint32_t> exclusive_scan(
+        vk::raii::Queue& queue, std::span<const std::uint32_t> input);
+    std::vector<std::uint32_t> compact(vk::raii::Queue&               queue,
+                                       std::span<const std::uint32_t> values,
+                                       std::span<const std::uint32_t> flags);
+    void radix_sort(vk::raii::Queue&         queue,
+                    std::span<std::uint32_t> keys,
+                    std::span<std::uint32_t> values);
+
+private:
+    struct buffer
+    {
+        vk::raii::Buffer       handle = nullptr;
+        vk::raii::DeviceMemory memory = nullptr;
+        vk::Buffer             buffer;
+        vk::DeviceSize         size = 0u;
+    };
+
+    struct push_constants
+    {
+        std::uint32_t count       = 0u;
+        std::uint32_t shift       = 0u;
+        std::uint32_t group_count = 0u;
+    };
+
+    enum class scan_target
+    {
+        keys,
+        flags,
+        histogram,
+    };
+
+    static constexpr std::uint32_t bindings_count = 5u;
+
+    buffer create_buffer(vk::DeviceSize          size,
+                         vk::BufferUsageFlags    usage,
+                         vk::MemoryPropertyFlags properties);
+    vk::raii::Pipeline create_pipeline(const vk::raii::ShaderModule& module,
+                                       const char*                   entry);
+    vk::raii::DescriptorSet create_set(
+        std::array<vk::Buffer, bindings_count> buffers);
+
+    void record_scan(vk::raii::CommandBuffer& cmd_buf,
+                     scan_target              target,
+                     std::uint32_t            count);
+    void record_scan_level(vk::raii::CommandBuffer& cmd_buf,
+                           vk::DescriptorSet        set,
+                           std::uint32_t            level,
+                           std::uint32_t            count);
+    void record_dispatch(vk::raii::CommandBuffer& cmd_buf,
+                         vk::Pipeline             pipeline,
+                         vk::DescriptorSet        set,
+                         push_constants           constants,
+                         std::uint32_t            groups);
+    static void record_barrier(vk::raii::CommandBuffer& cmd_buf);
+
+    void upload(vk::raii::CommandBuffer&       cmd_buf,
+                std::span<const std::uint32_t> keys,
+                std::span<const std::uint32_t> values);
+    void submit(vk::raii::Queue&                              queue,
+                const std::function<void(vk::raii::CommandBuffer&)>& record);
+    void check_count(std::uint32_t count) const;
+
+    static std::uint32_t group_count(std::uint32_t count)
+    {
+        return (count + group_size - 1u) / group_size;
+    }
+
+    const vk::raii::Device*            device_ = nullptr;
+    vk::PhysicalDeviceMemoryProperties memory_properties_{};
+    std::uint32_t                      capacity_ = 0u;
+
+    vk::raii::DescriptorSetLayout set_layout_      = nullptr;
+    vk::raii::PipelineLayout      pipeline_layout_ = nullptr;
+    vk::raii::Pipeline            scan_local_      = nullptr;
+    vk::raii::Pipeline            scan_add_        = nullptr;
+    vk::raii::Pipeline            compact_scatter_ = nullptr;
+    vk::raii::Pipeline            radix_histogram_ = nullptr;
+    vk::raii::Pipeline            radix_scatter_   = nullptr;
+    vk::raii::DescriptorPool      descriptor_pool_ = nullptr;
+    vk::raii::CommandPool         command_pool_    = nullptr;
+
+    buffer              keys_;
+    buffer              values_;
+    buffer              keys_tmp_;
+    buffer              values_tmp_;
+    buffer              flags_scan_;
+    buffer              histogram_;
+    buffer              count_;
+    buffer              staging_;
+    std::vector<buffer> group_sums_; // one per scan level
+
+    // descriptor sets are fixed, every dispatch binds own combination
+    std::array<vk::raii::DescriptorSet, 3> scan_sets_{
+        nullptr, nullptr, nullptr
+    }; // [scan_target] level 0
+    std::vector<vk::raii::DescriptorSet> scan_level_sets_; // level 1+
+    vk::raii::DescriptorSet              compact_set_ = nullptr;
+    std::array<vk::raii::DescriptorSet, 2> histogram_sets_{ nullptr,
+                                                            nullptr };
+    std::array<vk::raii::DescriptorSet, 2> scatter_sets_{ nullptr, nullptr };
+};
+
+compute_primitives::compute_primitives(const vk::raii::Device&         device,
+                                       const vk::raii::PhysicalDevice& physical,
+                                       std::uint32_t queue_family_index,
+                                       std::span<const std::byte> spir_v,
+                                       std::uint32_t              capacity)
+    : device_{ &device }
+    , memory_properties_{ physical.getMemoryProperties() }
+    , capacity_{ capacity }
+{
+    if (capacity == 0u)
+    {
+        throw std::runtime_error("error: compute_primitives capacity is 0");
+    }
+
+    // histogram is scanned too, it has radix_size counters per group
+    const std::uint32_t scan_capacity =
+        std::max(capacity, radix_size * group_count(capacity));
+
+    std::array<vk::DescriptorSetLayoutBinding, bindings_count> bindings{};
+    for (std::uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i] = vk::DescriptorSetLayoutBinding{
+            .binding         = i,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        };
+    }
+    set_layout_ = vk::raii::DescriptorSetLayout(
+        device,
+        vk::DescriptorSetLayoutCreateInfo{
+            .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+            .pBindings    = bindings.data(),
+        });
+
+    const vk::PushConstantRange push_range{
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset     = 0u,
+        .size       = sizeof(push_constants),
+    };
+    pipeline_layout_ = vk::raii::PipelineLayout(
+        device,
+        vk::PipelineLayoutCreateInfo{
+            .setLayoutCount         = 1,
+            .pSetLayouts            = &*set_layout_,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges    = &push_range,
+        });
+
+    const vk::raii::ShaderModule module(
+        device,
+        vk::ShaderModuleCreateInfo{
+            .codeSize = spir_v.size(),
+            .pCode    = reinterpret_cast<const std::uint32_t*>(spir_v.data()),
+        });
+    scan_local_      = create_pipeline(module, "scan_local");
+    scan_add_        = create_pipeline(module, "scan_add");
+    compact_scatter_ = create_pipeline(module, "compact_scatter");
+    radix_histogram_ = create_pipeline(module, "radix_histogram");
+    radix_scatter_   = create_pipeline(module, "radix_scatter");
+
+    const auto storage = vk::BufferUsageFlagBits::eStorageBuffer |
+                         vk::BufferUsageFlagBits::eTransferSrc |
+                         vk::BufferUsageFlagBits::eTransferDst;
+    const auto device_local = vk::MemoryPropertyFlagBits::eDeviceLocal;
+    const vk::DeviceSize bytes = sizeof(std::uint32_t) * capacity;
+
+    keys_       = create_buffer(bytes, storage, device_local);
+    values_     = create_buffer(bytes, storage, device_local);
+    keys_tmp_   = create_buffer(bytes, storage, device_local);
+    values_tmp_ = create_buffer(bytes, storage, device_local);
+    flags_scan_ = create_buffer(bytes, storage, device_local);
+    histogram_  = create_buffer(
+        sizeof(std::uint32_t) * radix_size * group_count(capacity),
+        storage,
+        device_local);
+    count_   = create_buffer(sizeof(std::uint32_t), storage, device_local);
+    staging_ = create_buffer(2u * bytes,
+                             vk::BufferUsageFlagBits::eTransferSrc |
+                                 vk::BufferUsageFlagBits::eTransferDst,
+                             vk::MemoryPropertyFlagBits::eHostVisible |
+                                 vk::MemoryPropertyFlagBits::eHostCoherent);
+
+    // every scan level reduces 256 times, last level is one group
+    for (std::uint32_t level_count = group_count(scan_capacity);;
+         level_count               = group_count(level_count))
+    {
+        group_sums_.push_back(create_buffer(
+            sizeof(std::uint32_t) * level_count, storage, device_local));
+        if (level_count == 1u)
+        {
+            break;
+        }
+    }
+
+    const auto sets_count = static_cast<std::uint32_t>(
+        scan_sets_.size() + group_sums_.size() + 1u + 4u);
+    const vk::DescriptorPoolSize pool_size{
+        .type            = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount = sets_count * bindings_count,
+    };
+    descriptor_pool_ = vk::raii::DescriptorPool(
+        device,
+        vk::DescriptorPoolCreateInfo{
+            .flags   = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+            .maxSets = sets_count,
+            .poolSizeCount = 1u,
+            .pPoolSizes    = &pool_size,
+        });
+
+    const vk::Buffer sums0 = group_sums_.front().buffer;
+    // unused bindings point to any valid buffer
+    scan_sets_[0] = create_set({ keys_.buffer, sums0, sums0, sums0, sums0 });
+    scan_sets_[1] =
+        create_set({ flags_scan_.buffer, sums0, sums0, sums0, sums0 });
+    scan_sets_[2] =
+        create_set({ histogram_.buffer, sums0, sums0, sums0, sums0 });
+    for (std::size_t level = 1; level < group_sums_.size(); ++level)
+    {
+        const vk::Buffer data = group_sums_[level - 1].buffer;
+        const vk::Buffer sums = group_sums_[level].buffer;
+        scan_level_sets_.push_back(
+            create_set({ data, sums, sums, sums, sums }));
+    }
+
+    compact_set_ = create_set({ keys_.buffer,
+                                values_.buffer,
+                                flags_scan_.buffer,
+                                keys_tmp_.buffer,
+                                count_.buffer });
+
+    // ping pong: even passes keys -> tmp, odd passes tmp -> keys
+    histogram_sets_[0] = create_set({ keys_.buffer,
+                                      histogram_.buffer,
+                                      histogram_.buffer,
+                                      histogram_.buffer,
+                                      histogram_.buffer });
+    histogram_sets_[1] = create_set({ keys_tmp_.buffer,
+                                      histogram_.buffer,
+                                      histogram_.buffer,
+                                      histogram_.buffer,
+                                      histogram_.buffer });
+    scatter_sets_[0]   = create_set({ keys_.buffer,
+                                      histogram_.buffer,
+                                      values_.buffer,
+                                      keys_tmp_.buffer,
+                                      values_tmp_.buffer });
+    scatter_sets_[1]   = create_set({ keys_tmp_.buffer,
+                                      histogram_.buffer,
+                                      values_tmp_.buffer,
+                                      keys_.buffer,
+                                      values_.buffer });
+
+    command_pool_ = vk::raii::CommandPool(
+        device,
+        vk::CommandPoolCreateInfo{
+            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+            .queueFamilyIndex = queue_family_index,
+        });
+}
+
+compute_primitives::buffer compute_primitives::create_buffer(
+    vk::DeviceSize          size,
+    vk::BufferUsageFlags    usage,
+    vk::MemoryPropertyFlags properties)
+{
+    buffer result;
+    result.size   = size;
+    result.handle = vk::raii::Buffer(
+        *device_,
+        vk::BufferCreateInfo{ .size        = size,
+                              .usage       = usage,
+                              .sharingMode = vk::SharingMode::eExclusive });
+    result.buffer = *result.handle;
+
+    const vk::MemoryRequirements requirements =
+        result.handle.getMemoryRequirements();
+
+    std::optional<std::uint32_t> type_index;
+    for (std::uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i)
+    {
+        if ((requirements.memoryTypeBits & (1u << i)) != 0u &&
+            (memory_properties_.memoryTypes[i].propertyFlags & properties) ==
+                properties)
+        {
+            type_index = i;
+            break;
+        }
+    }
+    if (!type_index)
+    {
+        throw std::runtime_error(
+            "error: compute_primitives no suitable memory type");
+    }
+
+    result.memory = vk::raii::DeviceMemory(
+        *device_,
+        vk::MemoryAllocateInfo{ .allocationSize  = requirements.size,
+                                .memoryTypeIndex = *type_index });
+    result.handle.bindMemory(*result.memory, 0u);
+    return result;
+}
+
+vk::raii::Pipeline compute_primitives::create_pipeline(
+    const vk::raii::ShaderModule& module, const char* entry)
+{
+    const vk::ComputePipelineCreateInfo pipeline_info{
+        .stage  = { .stage  = vk::ShaderStageFlagBits::eCompute,
+                    .module = *module,
+                    .pName  = entry },
+        .layout = *pipeline_layout_,
+    };
+    return vk::raii::Pipeline(*device_, nullptr, pipeline_info);
+}
+
+vk::raii::DescriptorSet compute_primitives::create_set(
+    std::array<vk::Buffer, bindings_count> buffers)
+{
+    const vk::DescriptorSetAllocateInfo alloc_info{
+        .descriptorPool     = *descriptor_pool_,
+        .descriptorSetCount = 1u,
+        .pSetLayouts        = &*set_layout_,
+    };
+    vk::raii::DescriptorSet set =
+        std::move(device_->allocateDescriptorSets(alloc_info).front());
+
+    std::array<vk::DescriptorBufferInfo, bindings_count> infos{};
+    std::array<vk::WriteDescriptorSet, bindings_count>   writes{};
+    for (std::uint32_t i = 0; i < bindings_count; ++i)
+    {
+        infos[i]  = vk::DescriptorBufferInfo{ .buffer = buffers[i],
+                                              .offset = 0u,
+                                              .range  = vk::WholeSize };
+        writes[i] = vk::WriteDescriptorSet{
+            .dstSet          = *set,
+            .dstBinding      = i,
+            .descriptorCount = 1,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo     = &infos[i],
+        };
+    }
+    device_->updateDescriptorSets(writes, {});
+    return set;
+}
+
+void compute_primitives::check_count(std::uint32_t count) const
+{
+    if (count > capacity_)
+    {
+        throw std::runtime_error("error: compute_primitives count " +
+                                 std::to_string(count) + " > capacity " +
+                                 std::to_string(capacity_));
+    }
+}
+
+void compute_primitives::record_barrier(vk::raii::CommandBuffer& cmd_buf)
+{
+    // every step reads what previous dispatch or copy wrote
+    const vk::MemoryBarrier2 barrier{
+        .srcStageMask  = vk::PipelineStageFlagBits2::eComputeShader |
+                        vk::PipelineStageFlagBits2::eTransfer,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite |
+                         vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask  = vk::PipelineStageFlagBits2::eComputeShader |
+                        vk::PipelineStageFlagBits2::eTransfer,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead |
+                         vk::AccessFlagBits2::eShaderStorageWrite |
+                         vk::AccessFlagBits2::eTransferRead |
+                         vk::AccessFlagBits2::eTransferWrite,
+    };
+    cmd_buf.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1u,
+        .pMemoryBarriers    = &barrier,
+    });
+}
+
+void compute_primitives::record_dispatch(vk::raii::CommandBuffer& cmd_buf,
+                                         vk::Pipeline             pipeline,
+                                         vk::DescriptorSet        set,
+                                         push_constants           constants,
+                                         std::uint32_t            groups)
+{
+    cmd_buf.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    cmd_buf.bindDescriptorSets(
+        vk::PipelineBindPoint::eCompute, *pipeline_layout_, 0, set, nullptr);
+    cmd_buf.pushConstants<push_constants>(
+        *pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0u, constants);
+    cmd_buf.dispatch(groups, 1u, 1u);
+    record_barrier(cmd_buf);
+}
+
+void compute_primitives::record_scan_level(vk::raii::CommandBuffer& cmd_buf,
+                                           vk::DescriptorSet        set,
+                                           std::uint32_t            level,
+                                           std::uint32_t            count)
+{
+    const std::uint32_t groups = group_count(count);
+    record_dispatch(
+        cmd_buf, scan_local_, set, { .count = count }, groups);
+    if (groups > 1u)
+    {
+        record_scan_level(cmd_buf, scan_level_sets_.at(level), level + 1u,
+                          groups);
+        record_dispatch(cmd_buf, scan_add_, set, { .count = count }, groups);
+    }
+}
+
+void compute_primitives::record_scan(vk::raii::CommandBuffer& cmd_buf,
+                                     scan_target              target,
+                                     std::uint32_t            count)
+{
+    record_scan_level(
+        cmd_buf, scan_sets_[static_cast<std::size_t>(target)], 0u, count);
+}
+
+void compute_primitives::record_exclusive_scan(
+    vk::raii::CommandBuffer& cmd_buf, std::uint32_t count)
+{
+    check_count(count);
+    if (count == 0u)
+    {
+        return;
+    }
+    record_scan(cmd_buf, scan_target::keys, count);
+}
+
+void compute_primitives::record_compact(vk::raii::CommandBuffer& cmd_buf,
+                                        std::uint32_t            count)
+{
+    check_count(count);
+    if (count == 0u)
+    {
+        cmd_buf.fillBuffer(count_.buffer, 0u, sizeof(std::uint32_t), 0u);
+        record_barrier(cmd_buf);
+        return;
+    }
+    // scan copy of flags, flags stay untouched for scatter
+    cmd_buf.copyBuffer(values_.buffer,
+                       flags_scan_.buffer,
+                       vk::BufferCopy{ .size = sizeof(std::uint32_t) * count });
+    record_barrier(cmd_buf);
+    record_scan(cmd_buf, scan_target::flags, count);
+    record_dispatch(cmd_buf,
+                    compact_scatter_,
+                    compact_set_,
+                    { .count = count },
+                    group_count(count));
+}
+
+void compute_primitives::record_radix_sort(vk::raii::CommandBuffer& cmd_buf,
+                                           std::uint32_t            count)
+{
+    check_count(count);
+    if (count == 0u)
+    {
+        return;
+    }
+    const std::uint32_t groups = group_count(count);
+
+    // 8 passes of 4 bits, even count so result ends in keys and values
+    for (std::uint32_t pass = 0; pass < 32u / radix_bits; ++pass)
+    {
+        const push_constants constants{ .count       = count,
+                                        .shift       = pass * radix_bits,
+                                        .group_count = groups };
+        record_dispatch(cmd_buf,
+                        radix_histogram_,
+                        histogram_sets_[pass % 2u],
+                        constants,
+                        groups);
+        record_scan(cmd_buf, scan_target::histogram, radix_size * groups);
+        record_dispatch(
+            cmd_buf, radix_scatter_, scatter_sets_[pass % 2u], constants, groups);
+    }
+}
+
+void compute_primitives::upload(vk::raii::CommandBuffer&       cmd_buf,
+                                std::span<const std::uint32_t> keys,
+                                std::span<const std::uint32_t> values)
+{
+    auto* mapped =
+        static_cast<std::byte*>(staging_.memory.mapMemory(0, staging_.size));
+    std::memcpy(mapped, keys.data(), keys.size_bytes());
+    std::memcpy(mapped + staging_.size / 2u, values.data(), values.size_bytes());
+    staging_.memory.unmapMemory();
+
+    if (!keys.empty())
+    {
+        cmd_buf.copyBuffer(staging_.buffer,
+                           keys_.buffer,
+                           vk::BufferCopy{ .size = keys.size_bytes() });
+    }
+    if (!values.empty())
+    {
+        cmd_buf.copyBuffer(staging_.buffer,
+                           values_.buffer,
+                           vk::BufferCopy{ .srcOffset = staging_.size / 2u,
+                                           .size = values.size_bytes() });
+    }
+    record_barrier(cmd_buf);
+}
+
+void compute_primitives::submit(
+    vk::raii::Queue&                                      queue,
+    const std::function<void(vk::raii::CommandBuffer&)>& record)
+{
+    vk::raii::CommandBuffers cmd_bufs(
+        *device_,
+        vk::CommandBufferAllocateInfo{
+            .commandPool        = *command_pool_,
+            .level              = vk::CommandBufferLevel::ePrimary,
+            .commandBufferCount = 1u,
+        });
+    vk::raii::CommandBuffer& cmd_buf = cmd_bufs.front();
+
+    cmd_buf.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    record(cmd_buf);
+    cmd_buf.end();
+
+    const vk::raii::Fence fence(*device_, vk::FenceCreateInfo{});
+    queue.submit(vk::SubmitInfo{ .commandBufferCount = 1u,
+                                 .pCommandBuffers    = &*cmd_buf },
+                 *fence);
+    while (vk::Result::eTimeout ==
+           device_->waitForFences(
+               *fence, true, std::numeric_limits<std::uint64_t>::max()))
+        ;
+}
+
+std::vector<std::uint32_t> compute_primitives::exclusive_scan(
+    vk::raii::Queue& queue, std::span<const std::uint32_t> input)
+{
+    const auto count = static_cast<std::uint32_t>(input.size());
+    check_count(count);
+
+    submit(queue,
+           [&](vk::raii::CommandBuffer& cmd_buf)
+           {
+               upload(cmd_buf, input, {});
+               record_exclusive_scan(cmd_buf, count);
+               if (count != 0u)
+               {
+                   cmd_buf.copyBuffer(
+                       keys_.buffer,
+                       staging_.buffer,
+                       vk::BufferCopy{ .size = input.size_bytes() });
+               }
+           });
+
+    std::vector<std::uint32_t> output(count);
+    const void* mapped = staging_.memory.mapMemory(0, staging_.size);
+    std::memcpy(output.data(), mapped, input.size_bytes());
+    staging_.memory.unmapMemory();
+    return output;
+}
+
+std::vector<std::uint32_t> compute_primitives::compact(
+    vk::raii::Queue&               queue,
+    std::span<const std::uint32_t> values,
+    std::span<const std::uint32_t> flags)
+{
+    if (values.size() != flags.size())
+    {
+        throw std::runtime_error("error: compact values and flags differ");
+    }
+    const auto count = static_cast<std::uint32_t>(values.size());
+    check_count(count);
+
+    submit(queue,
+           [&](vk::raii::CommandBuffer& cmd_buf)
+           {
+               upload(cmd_buf, values, flags);
+               record_compact(cmd_buf, count);
+               cmd_buf.copyBuffer(
+                   count_.buffer,
+                   staging_.buffer,
+                   vk::BufferCopy{ .size = sizeof(std::uint32_t) });
+               if (count != 0u)
+               {
+                   cmd_buf.copyBuffer(
+                       keys_tmp_.buffer,
+                       staging_.buffer,
+                       vk::BufferCopy{ .dstOffset = staging_.size / 2u,
+                                       .size      = values.size_bytes() });
+               }
+           });
+
+    const auto* mapped =
+        static_cast<std::byte*>(staging_.memory.mapMemory(0, staging_.size));
+    std::uint32_t compacted = 0u;
+    std::memcpy(&compacted, mapped, sizeof(compacted));
+    std::vector<std::uint32_t> output(std::min(compacted, count));
+    std::memcpy(output.data(),
+                mapped + staging_.size / 2u,
+                output.size() * sizeof(std::uint32_t));
+    staging_.memory.unmapMemory();
+    return output;
+}
+
+void compute_primitives::radix_sort(vk::raii::Queue&         queue,
+                                    std::span<std::uint32_t> keys,
+                                    std::span<std::uint32_t> values)
+{
+    if (keys.size() != values.size())
+    {
+        throw std::runtime_error("error: radix_sort keys and values differ");
+    }
+    const auto count = static_cast<std::uint32_t>(keys.size());
+    check_count(count);
+
+    submit(queue,
+           [&](vk::raii::CommandBuffer& cmd_buf)
+           {
+               upload(cmd_buf, keys, values);
+               record_radix_sort(cmd_buf, count);
+               if (count != 0u)
+               {
+                   cmd_buf.copyBuffer(
+                       keys_.buffer,
+                       staging_.buffer,
+                       vk::BufferCopy{ .size = keys.size_bytes() });
+                   cmd_buf.copyBuffer(
+                       values_.buffer,
+                       staging_.buffer,
+                       vk::BufferCopy{ .dstOffset = staging_.size / 2u,
+                                       .size      = values.size_bytes() });
+               }
+           });
+
+    const auto* mapped =
+        static_cast<std::byte*>(staging_.memory.mapMemory(0, staging_.size));
+    std::memcpy(keys.data(), mapped, keys.size_bytes());
+    std::memcpy(values.data(), mapped + staging_.size / 2u, values.size_bytes());
+    staging_.memory.unmapMemory();
+}
+} // namespace om::vulkan
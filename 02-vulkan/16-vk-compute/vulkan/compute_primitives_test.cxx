@@ -0,0 +1,110 @@
+#include <catch2/catch_all.hpp>
+
+import std;
+import vulkan;
+import vulkan_compute_primitives;
+import vulkan_headless_device;
+
+// NOLINTBEGIN(*)
+namespace
+{
+std::vector<std::uint32_t> random_values(std::size_t   count,
+                                         std::uint32_t max_value,
+                                         std::uint32_t seed)
+{
+    std::mt19937                                 generator(seed);
+    std::uniform_int_distribution<std::uint32_t> distribution(0, max_value);
+    std::vector<std::uint32_t>                   values(count);
+    std::ranges::generate(values, [&] { return distribution(generator); });
+    return values;
+}
+} // namespace
+
+TEST_CASE("gpu primitives match cpu reference", "compute_primitives")
+{
+    std::optional<om::vulkan::headless_device> gpu;
+    try
+    {
+        gpu.emplace("compute_primitives_test");
+    }
+    catch (const std::runtime_error& ex)
+    {
+        SKIP(ex.what());
+    }
+    const std::vector<std::byte> spir_v = om::vulkan::read_spir_v(
+        "./02-vulkan/16-vk-compute/shaders/primitives.slang.spv");
+    if (spir_v.empty())
+    {
+        SKIP("primitives.slang.spv not found, run from repository root");
+    }
+
+    constexpr std::uint32_t capacity = 70'000;
+    om::vulkan::compute_primitives primitives(
+        gpu->device, gpu->physical, gpu->family, spir_v, capacity);
+
+    const std::array<std::size_t, 6> sizes{ 0, 1, 255, 256, 1000, capacity };
+
+    SECTION("exclusive scan")
+    {
+        for (const std::size_t size : sizes)
+        {
+            // small values, so sum of 70000 elements does not overflow
+            const auto input = random_values(size, 1000, 1);
+            REQUIRE(primitives.exclusive_scan(gpu->queue, input) ==
+                    om::vulkan::exclusive_scan_reference(input));
+        }
+    }
+
+    SECTION("stream compaction")
+    {
+        for (const std::size_t size : sizes)
+        {
+            const auto values = random_values(size, ~0u, 2);
+            const auto flags  = random_values(size, 1, 3);
+            REQUIRE(primitives.compact(gpu->queue, values, flags) ==
+                    om::vulkan::compact_reference(values, flags));
+        }
+    }
+
+    SECTION("radix sort is stable")
+    {
+        for (const std::size_t size : sizes)
+        {
+            // few distinct keys, many equal keys check stability
+            auto keys   = random_values(size, 0xFFu, 4);
+            auto values = std::vector<std::uint32_t>(size);
+            std::iota(values.begin(), values.end(), 0u);
+
+            auto expected_keys   = keys;
+            auto expected_values = values;
+            om::vulkan::radix_sort_reference(expected_keys, expected_values);
+            REQUIRE(std::ranges::is_sorted(expected_keys));
+
+            primitives.radix_sort(gpu->queue, keys, values);
+            REQUIRE(keys == expected_keys);
+            REQUIRE(values == expected_values);
+        }
+    }
+
+    SECTION("radix sort full 32 bit keys")
+    {
+        auto keys   = random_values(capacity, ~0u, 5);
+        auto values = keys;
+
+        auto expected = keys;
+        std::ranges::sort(expected);
+
+        primitives.radix_sort(gpu->queue, keys, values);
+        REQUIRE(keys == expected);
+        REQUIRE(values == expected);
+    }
+
+    BENCHMARK("radix sort 70000 keys")
+    {
+        auto keys   = random_values(capacity, ~0u, 6);
+        auto values = keys;
+        primitives.radix_sort(gpu->queue, keys, values);
+        return keys.front();
+    };
+}
+// NOLINTEND(*)
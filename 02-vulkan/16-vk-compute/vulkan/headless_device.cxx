@@ -0,0 +1,92 @@
+export module vulkan_headless_device;
+
+import std;
+import vulkan;
+
+namespace om::vulkan
+{
+/// First Vulkan 1.3 device with compute queue and synchronization2, without
+/// window and swapchain. Shared by tests and benchmarks, on CI use lavapipe:
+/// VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json
+/// Constructor throws std::runtime_error if no suitable device found.
+export struct headless_device final
+{
+    explicit headless_device(const char* application_name);
+
+    vk::raii::Context        context;
+    vk::raii::Instance       instance = nullptr;
+    vk::raii::PhysicalDevice physical = nullptr;
+    vk::raii::Device         device   = nullptr;
+    vk::raii::Queue          queue    = nullptr;
+    std::uint32_t            family   = 0u;
+    std::string              name;
+};
+
+/// whole SPIR-V file, empty if file can't be opened (e.g. not run from
+/// repository root), so callers can skip GPU part
+export std::vector<std::byte> read_spir_v(const std::filesystem::path& path);
+
+headless_device::headless_device(const char* application_name)
+{
+    const vk::ApplicationInfo app_info{
+        .pApplicationName = application_name,
+        .apiVersion       = vk::ApiVersion13,
+    };
+    instance = vk::raii::Instance(
+        context, vk::InstanceCreateInfo{ .pApplicationInfo = &app_info });
+
+    for (auto& candidate : instance.enumeratePhysicalDevices())
+    {
+        if (candidate.getProperties().apiVersion < vk::ApiVersion13)
+        {
+            continue;
+        }
+        const auto families = candidate.getQueueFamilyProperties();
+        const auto compute  = std::ranges::find_if(
+            families,
+            [](const vk::QueueFamilyProperties& f)
+            { return bool(f.queueFlags & vk::QueueFlagBits::eCompute); });
+        if (compute != families.end())
+        {
+            physical = candidate;
+            family   = static_cast<std::uint32_t>(compute - families.begin());
+            break;
+        }
+    }
+    if (!*physical)
+    {
+        throw std::runtime_error(
+            "error: no Vulkan 1.3 device with compute queue");
+    }
+    name = physical.getProperties().deviceName.data();
+
+    const float                     priority = 1.0f;
+    const vk::DeviceQueueCreateInfo queue_info{
+        .queueFamilyIndex = family,
+        .queueCount       = 1,
+        .pQueuePriorities = &priority,
+    };
+    vk::PhysicalDeviceVulkan13Features features13{ .synchronization2 = true };
+    device = vk::raii::Device(physical,
+                              vk::DeviceCreateInfo{
+                                  .pNext                = &features13,
+                                  .queueCreateInfoCount = 1,
+                                  .pQueueCreateInfos    = &queue_info,
+                              });
+    queue  = vk::raii::Queue(device, family, 0);
+}
+
+std::vector<std::byte> read_spir_v(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return {};
+    }
+    std::vector<std::byte> bytes(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+    return bytes;
+}
+} // namespace om::vulkan
@@ -0,0 +1,331 @@
+export module vulkan_headless_particles;
+
+import std;
+import vulkan;
+import vulkan_render;
+import vulkan_headless_device;
+
+namespace om::vulkan
+{
+/// Runs particles update shader (shaders/compute.slang) without window and
+/// swapchain on first Vulkan 1.3 device with compute queue (lavapipe works).
+/// Used to compare and benchmark CPU particles backend against GPU one.
+/// Constructor throws std::runtime_error if no suitable device found.
+export class headless_particles final
+{
+public:
+    headless_particles(std::span<const std::byte> spir_v,
+                       std::span<const particle>  initial_data);
+
+    /// record steps dispatches in one command buffer, submit and wait,
+    /// returns wall time of submit and wait
+    std::chrono::nanoseconds update(float delta_time, std::uint32_t steps);
+
+    [[nodiscard]] std::vector<particle> get_particles();
+    [[nodiscard]] std::uint32_t get_count() const { return count_; }
+    [[nodiscard]] std::string   get_device_name() const { return gpu_.name; }
+
+private:
+    struct buffer
+    {
+        vk::raii::Buffer       handle = nullptr;
+        vk::raii::DeviceMemory memory = nullptr;
+    };
+
+    buffer create_buffer(vk::DeviceSize          size,
+                         vk::BufferUsageFlags    usage,
+                         vk::MemoryPropertyFlags properties);
+    void   submit(const std::function<void(vk::raii::CommandBuffer&)>& record);
+
+    static constexpr std::uint32_t workgroup_size = 256u; // as in shader
+
+    headless_device gpu_;
+
+    vk::raii::DescriptorSetLayout set_layout_      = nullptr;
+    vk::raii::PipelineLayout      pipeline_layout_ = nullptr;
+    vk::raii::Pipeline            pipeline_        = nullptr;
+    vk::raii::DescriptorPool      descriptor_pool_ = nullptr;
+    vk::raii::CommandPool         command_pool_    = nullptr;
+    // [0] reads storage[0] writes storage[1], [1] other way
+    std::vector<vk::raii::DescriptorSet> sets_;
+
+    buffer                ubo_;
+    std::array<buffer, 2> storage_;
+    buffer                staging_;
+    std::uint32_t         count_   = 0u;
+    std::uint32_t         current_ = 0u; // storage with latest particles
+};
+
+headless_particles::headless_particles(std::span<const std::byte> spir_v,
+                                       std::span<const particle> initial_data)
+    : gpu_{ "headless_particles" }
+    , count_{ static_cast<std::uint32_t>(initial_data.size()) }
+{
+    if (initial_data.empty())
+    {
+        throw std::runtime_error("error: headless_particles: empty data");
+    }
+
+    // same bindings as render::create_compute_descriptor_set_layout(), ubo
+    // is not dynamic here, shader does not see difference
+    const std::array<vk::DescriptorSetLayoutBinding, 3> bindings{
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 0,
+            .descriptorType  = vk::DescriptorType::eUniformBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute },
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 1,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute },
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 2,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute },
+    };
+    set_layout_ = vk::raii::DescriptorSetLayout(
+        gpu_.device,
+        vk::DescriptorSetLayoutCreateInfo{
+            .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+            .pBindings    = bindings.data(),
+        });
+    pipeline_layout_ = vk::raii::PipelineLayout(
+        gpu_.device,
+        vk::PipelineLayoutCreateInfo{ .setLayoutCount = 1,
+                                      .pSetLayouts    = &*set_layout_ });
+
+    const vk::raii::ShaderModule module(
+        gpu_.device,
+        vk::ShaderModuleCreateInfo{
+            .codeSize = spir_v.size(),
+            .pCode    = reinterpret_cast<const std::uint32_t*>(spir_v.data()),
+        });
+    pipeline_ = vk::raii::Pipeline(
+        gpu_.device,
+        nullptr,
+        vk::ComputePipelineCreateInfo{
+            .stage  = { .stage  = vk::ShaderStageFlagBits::eCompute,
+                        .module = *module,
+                        .pName  = "comp_main" },
+            .layout = *pipeline_layout_,
+        });
+
+    const vk::DeviceSize storage_size = sizeof(particle) * count_;
+    ubo_ = create_buffer(sizeof(compute_ubo),
+                         vk::BufferUsageFlagBits::eUniformBuffer,
+                         vk::MemoryPropertyFlagBits::eHostVisible |
+                             vk::MemoryPropertyFlagBits::eHostCoherent);
+    for (buffer& storage : storage_)
+    {
+        storage = create_buffer(storage_size,
+                                vk::BufferUsageFlagBits::eStorageBuffer |
+                                    vk::BufferUsageFlagBits::eTransferSrc |
+                                    vk::BufferUsageFlagBits::eTransferDst,
+                                vk::MemoryPropertyFlagBits::eDeviceLocal);
+    }
+    staging_ = create_buffer(storage_size,
+                             vk::BufferUsageFlagBits::eTransferSrc |
+                                 vk::BufferUsageFlagBits::eTransferDst,
+                             vk::MemoryPropertyFlagBits::eHostVisible |
+                                 vk::MemoryPropertyFlagBits::eHostCoherent);
+
+    const std::array<vk::DescriptorPoolSize, 2> pool_sizes{
+        vk::DescriptorPoolSize{ .type = vk::DescriptorType::eUniformBuffer,
+                                .descriptorCount = 2 },
+        vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageBuffer,
+                                .descriptorCount = 4 },
+    };
+    descriptor_pool_ = vk::raii::DescriptorPool(
+        gpu_.device,
+        vk::DescriptorPoolCreateInfo{
+            .flags   = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+            .maxSets = 2,
+            .poolSizeCount = static_cast<std::uint32_t>(pool_sizes.size()),
+            .pPoolSizes    = pool_sizes.data(),
+        });
+    const std::array<vk::DescriptorSetLayout, 2> layouts{ *set_layout_,
+                                                          *set_layout_ };
+    sets_ = gpu_.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+        .descriptorPool     = *descriptor_pool_,
+        .descriptorSetCount = 2,
+        .pSetLayouts        = layouts.data(),
+    });
+    for (std::uint32_t i = 0; i < 2; ++i)
+    {
+        const vk::DescriptorBufferInfo ubo_info{ .buffer = *ubo_.handle,
+                                                 .range  = vk::WholeSize };
+        const vk::DescriptorBufferInfo in_info{
+            .buffer = *storage_[i].handle, .range = vk::WholeSize
+        };
+        const vk::DescriptorBufferInfo out_info{
+            .buffer = *storage_[1 - i].handle, .range = vk::WholeSize
+        };
+        const std::array<vk::WriteDescriptorSet, 3> writes{
+            vk::WriteDescriptorSet{
+                .dstSet          = *sets_[i],
+                .dstBinding      = 0,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eUniformBuffer,
+                .pBufferInfo     = &ubo_info },
+            vk::WriteDescriptorSet{
+                .dstSet          = *sets_[i],
+                .dstBinding      = 1,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo     = &in_info },
+            vk::WriteDescriptorSet{
+                .dstSet          = *sets_[i],
+                .dstBinding      = 2,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo     = &out_info },
+        };
+        gpu_.device.updateDescriptorSets(writes, {});
+    }
+
+    command_pool_ = vk::raii::CommandPool(
+        gpu_.device,
+        vk::CommandPoolCreateInfo{
+            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+            .queueFamilyIndex = gpu_.family,
+        });
+
+    void* mapped = staging_.memory.mapMemory(0, storage_size);
+    std::memcpy(mapped, initial_data.data(), initial_data.size_bytes());
+    staging_.memory.unmapMemory();
+    submit(
+        [&](vk::raii::CommandBuffer& cmd_buf)
+        {
+            cmd_buf.copyBuffer(*staging_.handle,
+                               *storage_[0].handle,
+                               vk::BufferCopy{ .size = storage_size });
+        });
+}
+
+headless_particles::buffer headless_particles::create_buffer(
+    vk::DeviceSize          size,
+    vk::BufferUsageFlags    usage,
+    vk::MemoryPropertyFlags properties)
+{
+    buffer result;
+    result.handle = vk::raii::Buffer(
+        gpu_.device,
+        vk::BufferCreateInfo{ .size        = size,
+                              .usage       = usage,
+                              .sharingMode = vk::SharingMode::eExclusive });
+
+    const vk::MemoryRequirements requirements =
+        result.handle.getMemoryRequirements();
+    const vk::PhysicalDeviceMemoryProperties memory_properties =
+        gpu_.physical.getMemoryProperties();
+
+    for (std::uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+    {
+        if ((requirements.memoryTypeBits & (1u << i)) != 0u &&
+            (memory_properties.memoryTypes[i].propertyFlags & properties) ==
+                properties)
+        {
+            result.memory = vk::raii::DeviceMemory(
+                gpu_.device,
+                vk::MemoryAllocateInfo{ .allocationSize  = requirements.size,
+                                        .memoryTypeIndex = i });
+            result.handle.bindMemory(*result.memory, 0u);
+            return result;
+        }
+    }
+    throw std::runtime_error("error: headless_particles no memory type");
+}
+
+void headless_particles::submit(
+    const std::function<void(vk::raii::CommandBuffer&)>& record)
+{
+    vk::raii::CommandBuffers cmd_bufs(
+        gpu_.device,
+        vk::CommandBufferAllocateInfo{
+            .commandPool        = *command_pool_,
+            .level              = vk::CommandBufferLevel::ePrimary,
+            .commandBufferCount = 1u,
+        });
+    vk::raii::CommandBuffer& cmd_buf = cmd_bufs.front();
+
+    cmd_buf.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    record(cmd_buf);
+    cmd_buf.end();
+
+    const vk::raii::Fence fence(gpu_.device, vk::FenceCreateInfo{});
+    gpu_.queue.submit(vk::SubmitInfo{ .commandBufferCount = 1u,
+                                      .pCommandBuffers    = &*cmd_buf },
+                      *fence);
+    while (vk::Result::eTimeout ==
+           gpu_.device.waitForFences(
+               *fence, true, std::numeric_limits<std::uint64_t>::max()))
+        ;
+}
+
+std::chrono::nanoseconds headless_particles::update(float         delta_time,
+                                                    std::uint32_t steps)
+{
+    const compute_ubo ubo{ .delta_time = delta_time, .particle_count = count_ };
+    void* mapped = ubo_.memory.mapMemory(0, sizeof(ubo));
+    std::memcpy(mapped, &ubo, sizeof(ubo));
+    ubo_.memory.unmapMemory();
+
+    const std::uint32_t groups =
+        (count_ + workgroup_size - 1u) / workgroup_size;
+
+    const auto start = std::chrono::steady_clock::now();
+    submit(
+        [&](vk::raii::CommandBuffer& cmd_buf)
+        {
+            cmd_buf.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline_);
+            for (std::uint32_t step = 0; step < steps; ++step)
+            {
+                cmd_buf.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                                           *pipeline_layout_,
+                                           0,
+                                           *sets_[current_],
+                                           nullptr);
+                cmd_buf.dispatch(groups, 1u, 1u);
+                current_ = 1u - current_;
+
+                // next step reads what this one wrote
+                using stage  = vk::PipelineStageFlagBits2;
+                using access = vk::AccessFlagBits2;
+                const vk::MemoryBarrier2 barrier{
+                    .srcStageMask  = stage::eComputeShader,
+                    .srcAccessMask = access::eShaderStorageWrite,
+                    .dstStageMask  = stage::eComputeShader | stage::eTransfer,
+                    .dstAccessMask = access::eShaderStorageRead |
+                                     access::eShaderStorageWrite |
+                                     access::eTransferRead,
+                };
+                cmd_buf.pipelineBarrier2(vk::DependencyInfo{
+                    .memoryBarrierCount = 1u,
+                    .pMemoryBarriers    = &barrier,
+                });
+            }
+        });
+    return std::chrono::steady_clock::now() - start;
+}
+
+std::vector<particle> headless_particles::get_particles()
+{
+    const vk::DeviceSize size = sizeof(particle) * count_;
+    submit(
+        [&](vk::raii::CommandBuffer& cmd_buf)
+        {
+            cmd_buf.copyBuffer(*storage_[current_].handle,
+                               *staging_.handle,
+                               vk::BufferCopy{ .size = size });
+        });
+
+    std::vector<particle> result(count_);
+    const void*           mapped = staging_.memory.mapMemory(0, size);
+    std::memcpy(result.data(), mapped, size);
+    staging_.memory.unmapMemory();
+    return result;
+}
+} // namespace om::vulkan
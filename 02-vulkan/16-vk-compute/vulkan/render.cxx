@@ -25,6 +25,7 @@ import log;
 import std;
 import glm;
 import vulkan;
+import vulkan_render_graph;
 
 namespace om::vulkan
 {
@@ -161,7 +162,12 @@ private:
     [[nodiscard]] vk::Buffer get_index_buffer() const;
     [[nodiscard]] index_type get_index_type() const;
 
+    [[nodiscard]] vk::DeviceSize get_device_size() const;
+
     void cleanup() noexcept;
+    // residency: free device buffers, keep host copy to restore later
+    void evict() noexcept;
+    void restore(render& render);
 
     friend class om::vulkan::render;
 
@@ -186,6 +192,12 @@ private:
     uint32_t               num_vertexes{};
     uint32_t               num_indexes{};
     index_type             index_size = index_type::u16;
+
+    std::vector<vertex>    host_vertexes; // source of restore after evict
+    std::vector<std::byte> host_indexes;
+    std::string            debug_name_;
+    render*                render_      = nullptr;
+    std::uint64_t          residency_id = 0u; // 0 - not tracked
 };
 
 export class image final
@@ -195,14 +207,35 @@ public:
           std::filesystem::path path,
           std::string           dbg_name,
           bool                  generate_mip_levels = true);
+    image(const image& other)            = delete;
+    image& operator=(const image& other) = delete;
+    image(image&& other) noexcept;
+    image& operator=(image&& other) noexcept;
+    ~image();
 
 private:
     friend class render;
-    vk::raii::Image        img         = nullptr;
-    vk::raii::DeviceMemory img_memory  = nullptr;
-    vk::raii::ImageView    img_view    = nullptr;
-    vk::raii::Sampler      img_sampler = nullptr;
-    std::uint8_t           mip_levels  = {};
+    // decode file and upload all mip levels, used on create and restore
+    void upload(render& r);
+    void cleanup() noexcept;
+    // residency: free device image, file decoded again on restore
+    void evict() noexcept;
+    void restore(render& r);
+
+    vk::raii::Image         img         = nullptr;
+    vk::raii::DeviceMemory  img_memory  = nullptr;
+    vk::raii::ImageView     img_view    = nullptr;
+    vk::raii::Sampler       img_sampler = nullptr;
+    std::uint8_t            mip_levels  = {};
+    // ubo (dynamic offset per draw) + this image, written on create and
+    // restore only, so draws of any thread just bind it
+    vk::raii::DescriptorSet descriptor_set = nullptr;
+
+    std::filesystem::path path_;
+    std::string           dbg_name_;
+    bool                  generate_mip_levels_ = true;
+    render*               render_              = nullptr;
+    std::uint64_t         residency_id         = 0u; // 0 - not tracked
 };
 
 export class particles final
@@ -224,23 +257,66 @@ private:
         std::uint32_t frame_index) const;
     [[nodiscard]] vk::Buffer get_read_buffer(std::uint32_t frame_index) const;
     [[nodiscard]] vk::Buffer get_write_buffer(std::uint32_t frame_index) const;
-    [[nodiscard]] vk::Buffer get_uniform_buffer(
-        std::uint32_t frame_index) const;
-
-    void update_uniform_buffer(std::uint32_t        frame_index,
-                               std::span<std::byte> data) const;
 
     void create_storage_buffers(render& render);
-    void create_uniform_buffers(render& render);
     void upload_initial(std::span<const particle> initial, render& render);
     void cleanup() noexcept;
 
     std::uint32_t                       count_ = 0u;
     std::vector<vk::raii::Buffer>       storage_buffers_;
     std::vector<vk::raii::DeviceMemory> storage_memory_;
-    std::vector<vk::raii::Buffer>       uniform_buffers_;
-    std::vector<vk::raii::DeviceMemory> uniform_memory_;
-    std::vector<void*>                  uniform_mapped_;
+};
+
+/// one cullable part of mesh, std430 layout same as in cull.slang
+export struct cull_object final
+{
+    glm::vec4     sphere{}; // xyz - center in model space, w - radius
+    std::uint32_t first_index   = 0u;
+    std::uint32_t index_count   = 0u;
+    std::int32_t  vertex_offset = 0;
+    std::uint32_t padding_      = 0u;
+};
+
+/// split indexes into objects of triangles_per_object triangles and
+/// calculate bounding sphere for every object
+export std::vector<cull_object> make_cull_objects(
+    std::span<const vertex>        vertexes,
+    std::span<const std::uint32_t> indexes,
+    std::uint32_t                  triangles_per_object);
+
+/// Parts of one mesh culled on GPU against camera frustum from UBO.
+/// Visible parts written as compacted indirect commands, so CPU never
+/// touches invisible objects.
+export class culled_mesh final
+{
+public:
+    culled_mesh(std::span<const cull_object> objects, render& render);
+    culled_mesh(const culled_mesh& other)                = delete;
+    culled_mesh& operator=(const culled_mesh& other)     = delete;
+    culled_mesh(culled_mesh&& other) noexcept            = default;
+    culled_mesh& operator=(culled_mesh&& other) noexcept = default;
+    ~culled_mesh()                                       = default;
+
+    [[nodiscard]] std::uint32_t get_count() const { return count_; }
+
+private:
+    friend class render;
+
+    void create_buffers(render& render);
+    void upload_objects(std::span<const cull_object> objects, render& render);
+    void create_descriptor_sets(render& render);
+
+    std::uint32_t          count_         = 0u;
+    vk::raii::Buffer       object_buffer_ = nullptr;
+    vk::raii::DeviceMemory object_memory_ = nullptr;
+    // [frame] compacted vk::DrawIndexedIndirectCommand array
+    std::vector<vk::raii::Buffer>       command_buffers_;
+    std::vector<vk::raii::DeviceMemory> command_memory_;
+    // [frame] single std::uint32_t draw count
+    std::vector<vk::raii::Buffer>        count_buffers_;
+    std::vector<vk::raii::DeviceMemory>  count_memory_;
+    vk::raii::DescriptorPool             descriptor_pool_ = nullptr;
+    std::vector<vk::raii::DescriptorSet> descriptor_sets_; // [frame]
 };
 
 export struct platform_interface
@@ -258,8 +334,30 @@ export struct platform_interface
     };
     struct content
     {
-        std::unique_ptr<std::byte[]> memory; // NOLINT
-        std::size_t                  size{};
+        /// memory may be heap (new[]) or file mapping, release tells how to
+        /// free it, so both kinds have same lifetime semantics
+        struct deleter
+        {
+            // nullptr - delete[]
+            void (*release)(std::byte* memory, std::size_t size) noexcept =
+                nullptr;
+            std::size_t size = 0;
+
+            void operator()(std::byte* memory) const noexcept
+            {
+                if (release != nullptr)
+                {
+                    release(memory, size);
+                }
+                else
+                {
+                    delete[] memory; // NOLINT
+                }
+            }
+        };
+
+        std::unique_ptr<std::byte[], deleter> memory; // NOLINT
+        std::size_t                           size{};
 
         content(const content& other)            = delete;
         content& operator=(const content& other) = delete;
@@ -281,12 +379,23 @@ export struct platform_interface
             return *this;
         }
 
-        [[nodiscard]] std::span<std::byte> as_span() noexcept
+        // memory may be read only file mapping, so never give write access
+        [[nodiscard]] std::span<const std::byte> as_span() const noexcept
         {
             return { memory.get(), size };
         }
     }; // struct content
 
+    enum class file_access
+    {
+        // file not changed while content alive, may be mapped
+        read_only,
+        // file may be truncated and rewritten while content alive (shaders
+        // rebuilt by slangc during hot reload), so it has to be copied,
+        // access to truncated mapping raises SIGBUS
+        reloadable
+    };
+
     virtual extensions     get_vulkan_extensions() = 0;
     virtual vk::SurfaceKHR create_vulkan_surface(
         vk::Instance instance, vk::AllocationCallbacks* alloc_callbacks) = 0;
@@ -298,7 +407,8 @@ export struct platform_interface
 
     virtual std::ostream& get_logger() noexcept = 0;
 
-    virtual content get_file_content(std::string_view path) = 0;
+    virtual content get_file_content(std::string_view path,
+                                     file_access      access) = 0;
 };
 
 export class render
@@ -314,6 +424,19 @@ public:
         bool verbose                   = false;
         bool enable_validation_layers  = false;
         bool enable_debug_callback_ext = false;
+        /// number of threads that may record draws concurrently, every
+        /// thread gets own command pool per frame in flight
+        std::uint32_t recording_threads = 1u;
+        /// watch compiled SPIR-V files, rebuild changed pipelines on
+        /// background thread and swap them at begin_frame()
+        bool hot_reload_shaders = false;
+        /// generate texture mipmaps with both blit and compute paths and
+        /// log time saved by single dispatch compute path
+        bool compare_mipmap_generation = false;
+        /// bytes of device local memory for meshes and images, over it
+        /// least recently used ones evicted, 0 - VK_EXT_memory_budget
+        /// budget or 80% of device local heaps if extension not supported
+        vk::DeviceSize device_memory_budget = 0u;
     };
 
     explicit render(platform_interface& platform, hints hints);
@@ -325,13 +448,40 @@ public:
 
     /// Record viking mesh draw into the current frame command buffer.
     /// if !ubo.empty() copy graphics ubo data to buffer
+    /// same as draw(0u, mesh, image, ubo)
+    void draw(const mesh&          mesh,
+              const image&         image,
+              std::span<std::byte> ubo = {});
+
+    /// Record mesh draw into secondary command buffer of thread_index.
+    /// Safe to call from worker threads between begin_frame() and
+    /// end_frame() if every thread uses its own thread_index in range
+    /// [0, hints::recording_threads). Every thread_index has own ubo ring
+    /// per frame, every draw gets own offset in the ring and binds
+    /// descriptor set of image, no descriptor writes per draw.
+    /// Secondary buffers executed in thread_index order at end_frame(),
+    /// before draws of particles. Draw of evicted mesh or image is skipped,
+    /// data is uploaded again by next begin_frame().
+    void draw(std::uint32_t        thread_index,
+              const mesh&          mesh,
+              const image&         image,
+              std::span<std::byte> ubo = {});
+
+    /// Cull objects on GPU and draw visible ones with one indirect draw.
+    /// objects index into vertex and index buffers of mesh, so no second
+    /// copy of geometry needed. Culling dispatch recorded before render
+    /// pass begins, so call only from thread which call begin_frame(), uses
+    /// frame thread ubo ring, same as particles
     void draw(const mesh&          mesh,
               const image&         image,
+              const culled_mesh&   objects,
               std::span<std::byte> ubo = {});
 
     /// Dispatch compute particle update and record particle graphics draw.
-    /// if !compute_ubo.empty() copy compute ubo data to buffer
-    void draw(const particles& parts, std::span<std::byte> compute_ubo = {});
+    /// Call only from thread which call begin_frame(), recorded into frame
+    /// thread secondary buffer executed after all thread_index buffers
+    /// if !compute_data.empty() copy compute ubo data to buffer
+    void draw(const particles& parts, std::span<std::byte> compute_data = {});
 
     /// Submit graphics work and present the swapchain image.
     void end_frame();
@@ -349,6 +499,7 @@ private:
     friend class mesh;
     friend class image;
     friend class particles;
+    friend class culled_mesh;
 
     class one_time_submit : public vk::raii::CommandBuffer
     {
@@ -411,20 +562,49 @@ private:
     void create_particle_graphics_pipeline();
     void create_compute_descriptor_set_layout();
     void create_compute_pipeline();
+    // build functions only read render state, so can be called from shader
+    // reload thread, layouts created once in create_*_pipeline()
+    vk::raii::Pipeline build_graphics_pipeline(
+        std::span<const std::byte> spir_v);
+    vk::raii::Pipeline build_particle_graphics_pipeline(
+        std::span<const std::byte> spir_v);
+    vk::raii::Pipeline build_compute_pipeline(
+        std::span<const std::byte> spir_v);
+    void               create_cull_descriptor_set_layout();
+    void               create_cull_pipeline();
+    vk::raii::Pipeline build_cull_pipeline(std::span<const std::byte> spir_v);
+    void               create_mip_pipeline();
+    vk::raii::Pipeline build_mip_pipeline(std::span<const std::byte> spir_v);
     void create_compute_command_buffers();
     void create_compute_descriptor_pool();
     void create_compute_descriptor_sets();
     void bind_particle_compute_descriptors(const particles& parts);
+
+    // per frame linear allocator for ubo and other streaming data, every
+    // recorder allocates only from own ring region
+    struct frame_allocation
+    {
+        std::byte*    mapped = nullptr; // write only, memory is host coherent
+        std::uint32_t offset = 0u;      // dynamic offset in frame_arena.buffer
+    };
+    [[nodiscard]] frame_allocation allocate_frame_memory(
+        std::uint32_t recorder_index, vk::DeviceSize size);
+    [[nodiscard]] frame_allocation upload_frame_data(
+        std::uint32_t              recorder_index,
+        std::span<const std::byte> data,
+        vk::DeviceSize             size);
     void create_timeline_semaphore();
     void create_framebuffers();
     void create_command_pool();
-    void create_depth_resources();
+    void create_frame_graph();
+    void create_compute_graph();
     void create_command_buffers();
-    void create_uniform_buffers();
+    void create_frame_arena();
     void create_descriptor_pool();
-    void create_descriptor_sets(std::size_t frame_index, const image& image);
+    void create_secondary_command_buffers();
+    [[nodiscard]] vk::raii::DescriptorSet allocate_image_descriptor_set();
+    void write_image_descriptor(const image& image);
     void create_synchronization_objects();
-    void create_color_resources();
 
     void create_buffer(vk::DeviceSize          size,
                        vk::BufferUsageFlags    usage,
@@ -432,6 +612,32 @@ private:
                        vk::raii::Buffer&       buffer,
                        vk::raii::DeviceMemory& bufferMemory);
 
+    // Residency of mesh and image device memory. Every allocation of device
+    // local memory first evicts least recently used data over budget, on
+    // eOutOfDeviceMemory waits gpu, evicts all not used by current frame and
+    // tries again. draw() of evicted data only records a miss and skips the
+    // draw, restore submits to graphics_queue and may wait device idle, so
+    // it runs on frame thread in begin_frame() (restore_missing()) before
+    // any secondary recording, never concurrently with frame submits.
+    using resident_owner = std::variant<mesh*, image*>;
+    struct memory_budget
+    {
+        vk::DeviceSize usage  = 0u;
+        vk::DeviceSize budget = 0u;
+    };
+    [[nodiscard]] memory_budget query_memory_budget() const;
+    [[nodiscard]] vk::raii::DeviceMemory allocate_device_memory(
+        const vk::MemoryAllocateInfo& alloc_info,
+        vk::MemoryPropertyFlags       properties);
+    std::uint64_t register_resident(resident_owner owner,
+                                    vk::DeviceSize size,
+                                    std::string    name);
+    void          rebind_resident(std::uint64_t id, resident_owner owner);
+    void          unregister_resident(std::uint64_t id) noexcept;
+    [[nodiscard]] bool make_resident(std::uint64_t id);
+    void               restore_missing();
+    void evict_resources(vk::DeviceSize size, bool gpu_idle);
+
     std::pair<vk::raii::Image, vk::raii::DeviceMemory> create_image(
         std::uint32_t           width,
         std::uint32_t           height,
@@ -440,13 +646,27 @@ private:
         vk::ImageUsageFlags     usage,
         vk::MemoryPropertyFlags properties,
         std::uint8_t            mip_levels  = 1u,
-        vk::SampleCountFlagBits num_samples = vk::SampleCountFlagBits::e1);
+        vk::SampleCountFlagBits num_samples = vk::SampleCountFlagBits::e1,
+        vk::ImageCreateFlags    flags       = {});
 
     void generate_mipmaps(vk::raii::Image& image,
                           vk::Format       image_format,
                           std::uint32_t    width,
                           std::uint32_t    height,
                           std::uint8_t     mip_levels);
+    void generate_mipmaps_blit(vk::raii::Image& image,
+                               std::uint32_t    width,
+                               std::uint32_t    height,
+                               std::uint8_t     mip_levels);
+    void generate_mipmaps_compute(vk::raii::Image& image,
+                                  vk::Format       image_format,
+                                  std::uint32_t    width,
+                                  std::uint32_t    height,
+                                  std::uint8_t     mip_levels,
+                                  vk::ImageLayout  old_layout);
+    [[nodiscard]] bool compute_mipmaps_supported(vk::Format    image_format,
+                                                 std::uint32_t width,
+                                                 std::uint32_t height) const;
 
     void transition_image_layout(vk::ImageLayout        layout_old,
                                  const vk::raii::Image& img,
@@ -467,33 +687,42 @@ private:
         vk::Image            image,
         vk::Format           format,
         vk::ImageAspectFlags aspect_flags,
-        std::uint8_t         mip_levels = 1u) const;
+        std::uint8_t         mip_levels = 1u,
+        vk::ImageUsageFlags  usage      = {}) const;
 
     vk::raii::ShaderModule create_shader(std::span<const std::byte> spir_v);
 
     // record functions
-    void begin_render_pass(vk::raii::CommandBuffer& cmd_buf,
-                           std::uint32_t            image_index);
+    void begin_render_pass(vk::raii::CommandBuffer& cmd_buf);
+    vk::raii::CommandBuffer& begin_secondary(std::uint32_t thread_index);
+    void execute_secondaries(vk::raii::CommandBuffer& cmd_buf);
+    void record_mesh_bindings(vk::raii::CommandBuffer& cmd_buf,
+                              vk::DescriptorSet        descriptor_set,
+                              std::uint32_t            ubo_offset,
+                              const mesh&              mesh);
     void record_mesh_commands(vk::raii::CommandBuffer& cmd_buf,
-                              vk::raii::DescriptorSet& descriptor_set,
+                              vk::DescriptorSet        descriptor_set,
+                              std::uint32_t            ubo_offset,
                               const mesh&              mesh);
+    void record_cull_reset(vk::raii::CommandBuffer& cmd_buf,
+                           std::uint32_t            frame_index,
+                           const culled_mesh&       objects);
+    void record_cull_commands(vk::raii::CommandBuffer& cmd_buf,
+                              std::uint32_t            frame_index,
+                              std::uint32_t            ubo_offset,
+                              const culled_mesh&       objects);
     void record_particle_commands(vk::raii::CommandBuffer& cmd_buf,
                                   std::uint32_t            frame_index,
                                   const particles&         parts);
-    void end_render_pass(vk::raii::CommandBuffer& cmd_buf,
-                         std::uint32_t            image_index);
     void record_compute_commands(vk::raii::CommandBuffer& cmd_buf,
                                  std::uint32_t            frame_index,
+                                 std::uint32_t            ubo_offset,
                                  const particles&         parts);
-    void transition_image_layout(vk::raii::CommandBuffer& cmd_buf,
-                                 vk::Image                image,
-                                 vk::ImageLayout          old_layout,
-                                 vk::AccessFlags2         src_access_mask,
-                                 vk::PipelineStageFlags2  src_stage_mask,
-                                 vk::ImageLayout          new_layout,
-                                 vk::AccessFlags2         dst_access_mask,
-                                 vk::PipelineStageFlags2  dst_stage_mask,
-                                 vk::ImageAspectFlags     image_aspect_flags);
+    // shader hot reload functions
+    void start_shader_watcher();
+    void watch_shaders(std::stop_token stop);
+    void apply_reloaded_pipelines();
+
     // destroy functions
     void destroy_synchronization_objects() noexcept;
     void destroy_debug_callback() noexcept;
@@ -612,13 +841,44 @@ private:
     std::vector<vk::Image>           swapchain_images;
     std::vector<vk::raii::ImageView> swapchain_image_views;
 
-    vk::raii::Image        color_image        = nullptr;
-    vk::raii::DeviceMemory color_image_memory = nullptr;
-    vk::raii::ImageView    color_image_view   = nullptr;
-
-    vk::raii::Image        depth_image        = nullptr;
-    vk::raii::DeviceMemory depth_image_memory = nullptr;
-    vk::raii::ImageView    depth_image_view   = nullptr;
+    // Frame graph owns msaa color and depth attachments and derives all
+    // barriers around passes, rebuilt with swapchain in create_frame_graph()
+    render_graph frame_graph;
+    struct
+    {
+        resource_handle swapchain;
+        resource_handle color;
+        resource_handle depth;
+        resource_handle cull_counts;   // count buffers of frame_culls
+        resource_handle cull_commands; // indirect commands of frame_culls
+    } frame_resources;
+
+    // culled draws of current frame, dispatched by "cull" pass of frame_graph
+    // before render pass, cleared in end_frame()
+    struct pending_cull
+    {
+        const culled_mesh* objects    = nullptr;
+        std::uint32_t      ubo_offset = 0u;
+    };
+    std::vector<pending_cull> frame_culls;
+    std::vector<vk::Buffer>   frame_cull_counts;   // bound to cull_counts
+    std::vector<vk::Buffer>   frame_cull_commands; // bound to cull_commands
+
+    // Particle update graph recorded into compute_command_buffers, it is
+    // submitted on compute_queue and graphics submit waits timeline
+    // semaphore, so it can't be pass of frame_graph. It has no transient
+    // images and is compiled once in create_compute_graph().
+    render_graph compute_graph;
+    struct
+    {
+        resource_handle particles_in;  // read buffer of current frame
+        resource_handle particles_out; // write buffer, drawn as vertices
+    } compute_resources;
+    struct
+    {
+        const particles* parts      = nullptr;
+        std::uint32_t    ubo_offset = 0u;
+    } frame_particles;
 
     // vulkan pipeline
     vk::raii::DescriptorSetLayout descriptor_set_layout = nullptr;
@@ -632,6 +892,29 @@ private:
     vk::raii::PipelineLayout      compute_pipeline_layout       = nullptr;
     vk::raii::Pipeline            compute_pipeline              = nullptr;
 
+    vk::raii::DescriptorSetLayout cull_descriptor_set_layout = nullptr;
+    vk::raii::PipelineLayout      cull_pipeline_layout       = nullptr;
+    vk::raii::Pipeline            cull_pipeline              = nullptr;
+
+    // single dispatch mip generation, see shaders/mip.slang
+    static constexpr std::uint32_t mip_max_levels = 13u; // 4096 -> 1
+    struct mip_constants
+    {
+        std::uint32_t width       = 0u;
+        std::uint32_t height      = 0u;
+        std::uint32_t mip_count   = 0u;
+        std::uint32_t srgb        = 0u;
+        std::uint32_t group_count = 0u;
+    };
+    vk::raii::DescriptorSetLayout mip_descriptor_set_layout = nullptr;
+    vk::raii::PipelineLayout      mip_pipeline_layout       = nullptr;
+    vk::raii::Pipeline            mip_pipeline              = nullptr;
+    vk::raii::DescriptorPool      mip_descriptor_pool       = nullptr;
+    vk::raii::Buffer              mip_level_six_buffer      = nullptr;
+    vk::raii::DeviceMemory        mip_level_six_memory      = nullptr;
+    vk::raii::Buffer              mip_counter_buffer        = nullptr;
+    vk::raii::DeviceMemory        mip_counter_memory        = nullptr;
+
     // pools
     vk::raii::CommandPool    graphics_command_pool   = nullptr;
     vk::raii::CommandPool    compute_command_pool    = nullptr;
@@ -641,21 +924,83 @@ private:
 
     static constexpr std::uint32_t max_frames_in_flight =
         3; // <= shapchain_images.size()
+    static constexpr std::uint32_t max_images             = 64u; // set/image
     static constexpr std::uint32_t compute_workgroup_size = 256u;
+    static constexpr std::uint32_t cull_workgroup_size    = 64u;
 
     vk::raii::CommandBuffers command_buffers         = nullptr;
     vk::raii::CommandBuffers compute_command_buffers = nullptr;
 
-    // UBO should match max_frames_in_flight count
-    std::vector<vk::raii::Buffer>        uniform_buffers;
-    std::vector<vk::raii::DeviceMemory>  uniform_buffers_memory;
-    std::vector<void*>                   uniform_buffers_mapped;
-    std::vector<vk::raii::DescriptorSet> descriptor_sets;
+    // Command pools are externally synchronized, so every recording thread
+    // owns pool per frame in flight. Pool reset at begin_frame() after frame
+    // fence signaled, it is cheaper than reset every buffer.
+    struct secondary_recorder
+    {
+        std::vector<vk::raii::CommandPool>   command_pools;   // [frame]
+        std::vector<vk::raii::CommandBuffer> command_buffers; // [frame]
+        std::vector<std::byte>               last_ubo; // reused if ubo empty
+        vk::DeviceSize ubo_head  = 0u; // in own frame arena ring region
+        bool           recording = false;
+    };
+
+    // [thread_index], last one (index hints_.recording_threads) is used only
+    // by thread which call begin_frame() for culled meshes and particles,
+    // executed last
+    std::vector<secondary_recorder> recorders;
+
+    [[nodiscard]] std::uint32_t frame_recorder_index() const noexcept
+    {
+        return hints_.recording_threads;
+    }
 
     std::vector<vk::raii::DescriptorSet> compute_descriptor_sets;
+    std::vector<std::byte>               last_compute_ubo;
+
+    // One persistently mapped buffer split in max_frames_in_flight *
+    // recorders.size() ring regions of frame_arena_size bytes. Every ubo
+    // binding is dynamic and points into it, draw() bump allocates from
+    // region of current_frame and own recorder, so threads never share a
+    // head. Regions rewind in begin_frame() after frame fences signaled.
+    static constexpr vk::DeviceSize frame_arena_size = 256u * 1024u;
+    static constexpr vk::DeviceSize mesh_ubo_size = sizeof(glm::mat4) * 3;
+
+    struct
+    {
+        vk::raii::Buffer       buffer    = nullptr;
+        vk::raii::DeviceMemory memory    = nullptr;
+        std::byte*             mapped    = nullptr;
+        vk::DeviceSize         alignment = 256u;
+    } frame_arena;
+
+    struct resident_resource
+    {
+        resident_owner owner;
+        vk::DeviceSize size            = 0u;
+        std::uint64_t  last_used_frame = 0u;
+        bool           resident        = true;
+        std::string    name;
+    };
+    using resident_list = std::list<resident_resource>;
+
+    struct
+    {
+        // recursive: restore allocates memory, allocation evicts
+        std::recursive_mutex mutex;
+        resident_list        lru; // front - least recently used
+        std::unordered_map<std::uint64_t, resident_list::iterator> entries;
+        std::uint64_t  next_id           = 1u;
+        vk::DeviceSize resident_bytes    = 0u; // self tracked usage
+        vk::DeviceSize device_heap_size  = 0u; // all device local heaps
+        bool           ext_memory_budget = false;
+        std::uint64_t  evicted           = 0u;
+        std::uint64_t  restored          = 0u;
+        // ids drawn while evicted, restored by next begin_frame()
+        std::vector<std::uint64_t> misses;
+    } residency;
 
     // vulkan utilities
     vk::Format              swapchain_image_format{ vk::Format::eUndefined };
+    vk::Format              depth_format{ vk::Format::eUndefined };
     vk::Extent2D            swapchain_image_extent{};
     vk::SampleCountFlagBits msaa_samples = vk::SampleCountFlagBits::e1;
 
@@ -691,6 +1036,55 @@ private:
     std::uint64_t graphics_wait_value_   = 0u;
     std::uint64_t graphics_signal_value_ = 0u;
 
+    static constexpr std::string_view graphics_shader_path =
+        "./02-vulkan/16-vk-compute/shaders/shader.vert.frag.slang.spv";
+    static constexpr std::string_view particle_shader_path =
+        "./02-vulkan/16-vk-compute/shaders/particle.vert.frag.slang.spv";
+    static constexpr std::string_view compute_shader_path =
+        "./02-vulkan/16-vk-compute/shaders/compute.slang.spv";
+    static constexpr std::string_view cull_shader_path =
+        "./02-vulkan/16-vk-compute/shaders/cull.slang.spv";
+    static constexpr std::string_view mip_shader_path =
+        "./02-vulkan/16-vk-compute/shaders/mip.slang.spv";
+
+    std::uint64_t frame_number_ = 0u; // frames started since creation
+
+    // shader hot reload, declared last so watcher thread stops first
+    struct shader_watch_entry
+    {
+        std::string_view    path;
+        std::string         debug_name;
+        vk::raii::Pipeline* target = nullptr;
+        vk::raii::Pipeline (render::*build)(std::span<const std::byte>) =
+            nullptr;
+        std::filesystem::file_time_type last_write_time{};
+    };
+
+    struct reloaded_pipeline
+    {
+        vk::raii::Pipeline* target   = nullptr;
+        vk::raii::Pipeline  pipeline = nullptr;
+    };
+
+    struct retired_pipeline
+    {
+        std::uint64_t      frame_number = 0u;
+        vk::raii::Pipeline pipeline     = nullptr;
+    };
+
+    struct
+    {
+        // owned by watcher thread after start
+        std::vector<shader_watch_entry> entries;
+        // guards ready, messages and swapchain state used by build functions
+        std::mutex                     mutex;
+        std::vector<reloaded_pipeline> ready;
+        std::vector<std::string>       messages;
+        // main thread only, old pipelines may be used by frames in flight
+        std::vector<retired_pipeline> retired;
+        std::jthread                  thread;
+    } shader_reload;
+
     const std::vector<const char*> required_device_extensions{
         vk::KHRSwapchainExtensionName,
         vk::KHRSpirv14ExtensionName,
@@ -711,9 +1105,15 @@ mesh::mesh(std::span<vertex> vertexes,
     , num_vertexes(vertexes.size())
     , num_indexes(indexes.size())
     , index_size(sizeof(N) == 2 ? index_type::u16 : index_type::u32)
+    , host_vertexes(vertexes.begin(), vertexes.end())
+    , host_indexes(std::as_bytes(indexes).begin(), std::as_bytes(indexes).end())
+    , debug_name_(debug_name)
+    , render_(&render)
 {
     create_buffer(vertexes, render, debug_name);
     create_buffer(indexes, render, debug_name);
+    residency_id =
+        render.register_resident(this, get_device_size(), debug_name_);
 }
 
 uint32_t mesh::get_vertex_count() const
@@ -740,32 +1140,104 @@ mesh::index_type mesh::get_index_type() const
     return index_size;
 }
 
+vk::DeviceSize mesh::get_device_size() const
+{
+    return buffer_vert.getMemoryRequirements().size +
+           buffer_indx.getMemoryRequirements().size;
+}
+
 void mesh::cleanup() noexcept
 {
     using om::cout;
+    if (render_ != nullptr)
+    {
+        render_->unregister_resident(std::exchange(residency_id, 0u));
+        render_ = nullptr;
+    }
     if (!num_vertexes)
     {
         return;
     }
     cout << "mesh::cleanup" << std::endl;
+    evict();
+    cout << "destroy mesh buffers and memory" << std::endl;
+    host_vertexes.clear();
+    host_indexes.clear();
+    num_vertexes = 0;
+    num_indexes  = 0;
+}
+
+void mesh::evict() noexcept
+{
     buffer_vert.clear();
-    cout << "destroy mesh buffer" << std::endl;
+    buffer_indx.clear();
     memory_buffer_vert.clear();
-    cout << "destroy mesh vertex_buf_mem" << std::endl;
-    num_vertexes = 0;
+    memory_buffer_indx.clear();
+}
+
+void mesh::restore(render& render)
+{
+    create_buffer(std::span{ host_vertexes }, render, debug_name_);
+    if (index_size == index_type::u16)
+    {
+        create_buffer(
+            std::span{ reinterpret_cast<std::uint16_t*>(host_indexes.data()),
+                       num_indexes },
+            render,
+            debug_name_);
+    }
+    else
+    {
+        create_buffer(
+            std::span{ reinterpret_cast<std::uint32_t*>(host_indexes.data()),
+                       num_indexes },
+            render,
+            debug_name_);
+    }
 }
 
 mesh::mesh(mesh&& other)
     : buffer_vert(std::move(other.buffer_vert))
+    , buffer_indx(std::move(other.buffer_indx))
     , memory_buffer_vert(std::move(other.memory_buffer_vert))
+    , memory_buffer_indx(std::move(other.memory_buffer_indx))
     , num_vertexes(std::exchange(other.num_vertexes, 0))
+    , num_indexes(std::exchange(other.num_indexes, 0))
+    , index_size(other.index_size)
+    , host_vertexes(std::move(other.host_vertexes))
+    , host_indexes(std::move(other.host_indexes))
+    , debug_name_(std::move(other.debug_name_))
+    , render_(std::exchange(other.render_, nullptr))
+    , residency_id(std::exchange(other.residency_id, 0u))
 {
+    if (render_ != nullptr)
+    {
+        render_->rebind_resident(residency_id, this);
+    }
 }
 mesh& mesh::operator=(mesh&& other)
 {
+    if (this == &other)
+    {
+        return *this;
+    }
+    cleanup();
     buffer_vert        = std::move(other.buffer_vert);
+    buffer_indx        = std::move(other.buffer_indx);
     memory_buffer_vert = std::move(other.memory_buffer_vert);
+    memory_buffer_indx = std::move(other.memory_buffer_indx);
     num_vertexes       = std::exchange(other.num_vertexes, 0);
+    num_indexes        = std::exchange(other.num_indexes, 0);
+    index_size         = other.index_size;
+    host_vertexes      = std::move(other.host_vertexes);
+    host_indexes       = std::move(other.host_indexes);
+    debug_name_        = std::move(other.debug_name_);
+    render_            = std::exchange(other.render_, nullptr);
+    residency_id       = std::exchange(other.residency_id, 0u);
+    if (render_ != nullptr)
+    {
+        render_->rebind_resident(residency_id, this);
+    }
     return *this;
 }
 
@@ -783,7 +1255,6 @@ particles::particles(std::span<const particle> initial_data, render& render)
     }
 
     create_storage_buffers(render);
-    create_uniform_buffers(render);
     upload_initial(initial_data, render);
     render.bind_particle_compute_descriptors(*this);
 }
@@ -792,9 +1263,6 @@ particles::particles(particles&& other) noexcept
     : count_(std::exchange(other.count_, 0u))
     , storage_buffers_(std::move(other.storage_buffers_))
     , storage_memory_(std::move(other.storage_memory_))
-    , uniform_buffers_(std::move(other.uniform_buffers_))
-    , uniform_memory_(std::move(other.uniform_memory_))
-    , uniform_mapped_(std::move(other.uniform_mapped_))
 {
 }
 
@@ -806,9 +1274,6 @@ particles& particles::operator=(particles&& other) noexcept
         count_           = std::exchange(other.count_, 0u);
         storage_buffers_ = std::move(other.storage_buffers_);
         storage_memory_  = std::move(other.storage_memory_);
-        uniform_buffers_ = std::move(other.uniform_buffers_);
-        uniform_memory_  = std::move(other.uniform_memory_);
-        uniform_mapped_  = std::move(other.uniform_mapped_);
     }
     return *this;
 }
@@ -822,9 +1287,6 @@ void particles::cleanup() noexcept
 {
     storage_buffers_.clear();
     storage_memory_.clear();
-    uniform_buffers_.clear();
-    uniform_memory_.clear();
-    uniform_mapped_.clear();
     count_ = 0u;
 }
 
@@ -845,21 +1307,6 @@ vk::Buffer particles::get_write_buffer(std::uint32_t frame_index) const
     return storage_buffers_.at(frame_index);
 }
 
-vk::Buffer particles::get_uniform_buffer(std::uint32_t frame_index) const
-{
-    return uniform_buffers_.at(frame_index);
-}
-
-void particles::update_uniform_buffer(std::uint32_t        frame_index,
-                                      std::span<std::byte> data) const
-{
-    if (!data.empty())
-    {
-        void* output = uniform_mapped_.at(frame_index);
-        std::memcpy(output, data.data(), data.size());
-    }
-}
-
 void particles::create_storage_buffers(render& render)
 {
     const vk::DeviceSize buffer_size = sizeof(particle) * count_;
@@ -887,34 +1334,6 @@ void particles::create_storage_buffers(render& render)
     }
 }
 
-void particles::create_uniform_buffers(render& render)
-{
-    uniform_buffers_.clear();
-    uniform_memory_.clear();
-    uniform_mapped_.clear();
-    uniform_buffers_.reserve(render::max_frames_in_flight);
-    uniform_memory_.reserve(render::max_frames_in_flight);
-    uniform_mapped_.reserve(render::max_frames_in_flight);
-
-    for (std::uint32_t i = 0; i < render::max_frames_in_flight; ++i)
-    {
-        vk::raii::Buffer       uniform_buffer({});
-        vk::raii::DeviceMemory uniform_buffer_memory({});
-        render.create_buffer(sizeof(compute_ubo),
-                             vk::BufferUsageFlagBits::eUniformBuffer,
-                             vk::MemoryPropertyFlagBits::eHostVisible |
-                                 vk::MemoryPropertyFlagBits::eHostCoherent,
-                             uniform_buffer,
-                             uniform_buffer_memory);
-        render.set_object_name(*uniform_buffer,
-                               "particle_compute_ubo_" + std::to_string(i));
-        uniform_mapped_.emplace_back(
-            uniform_buffer_memory.mapMemory(0, sizeof(compute_ubo)));
-        uniform_buffers_.emplace_back(std::move(uniform_buffer));
-        uniform_memory_.emplace_back(std::move(uniform_buffer_memory));
-    }
-}
-
 void particles::upload_initial(std::span<const particle> initial,
                                render&                   render)
 {
@@ -940,6 +1359,224 @@ void particles::upload_initial(std::span<const particle> initial,
         render.copy_buffer(staging_buffer, buffer_size, storage_buffer);
     }
 }
+
+std::vector<cull_object> make_cull_objects(
+    std::span<const vertex>        vertexes,
+    std::span<const std::uint32_t> indexes,
+    std::uint32_t                  triangles_per_object)
+{
+    if (triangles_per_object == 0u)
+    {
+        throw std::runtime_error("error: triangles_per_object must be > 0");
+    }
+
+    const std::size_t indexes_per_object =
+        std::size_t{ triangles_per_object } * 3u;
+
+    std::vector<cull_object> objects;
+    objects.reserve((indexes.size() + indexes_per_object - 1u) /
+                    indexes_per_object);
+
+    for (std::size_t first = 0; first < indexes.size();
+         first += indexes_per_object)
+    {
+        auto part = indexes.subspan(
+            first, std::min(indexes_per_object, indexes.size() - first));
+
+        glm::vec3 min_pos{ std::numeric_limits<float>::max() };
+        glm::vec3 max_pos{ std::numeric_limits<float>::lowest() };
+        for (std::uint32_t index : part)
+        {
+            min_pos = glm::min(min_pos, vertexes[index].pos);
+            max_pos = glm::max(max_pos, vertexes[index].pos);
+        }
+
+        // sphere around AABB center is not minimal but cheap and conservative
+        const glm::vec3 center = (min_pos + max_pos) * 0.5f;
+        float           radius = 0.f;
+        for (std::uint32_t index : part)
+        {
+            radius =
+                std::max(radius, glm::distance(center, vertexes[index].pos));
+        }
+
+        objects.push_back({
+            .sphere        = glm::vec4(center, radius),
+            .first_index   = static_cast<std::uint32_t>(first),
+            .index_count   = static_cast<std::uint32_t>(part.size()),
+            .vertex_offset = 0,
+        });
+    }
+    return objects;
+}
+
+culled_mesh::culled_mesh(std::span<const cull_object> objects, render& render)
+    : count_(static_cast<std::uint32_t>(objects.size()))
+{
+    if (objects.empty())
+    {
+        throw std::runtime_error("culled_mesh: empty objects");
+    }
+
+    create_buffers(render);
+    upload_objects(objects, render);
+    create_descriptor_sets(render);
+}
+
+void culled_mesh::create_buffers(render& render)
+{
+    render.create_buffer(sizeof(cull_object) * count_,
+                         vk::BufferUsageFlagBits::eStorageBuffer |
+                             vk::BufferUsageFlagBits::eTransferDst,
+                         vk::MemoryPropertyFlagBits::eDeviceLocal,
+                         object_buffer_,
+                         object_memory_);
+    render.set_object_name(*object_buffer_, "cull_objects_ssbo");
+
+    for (std::uint32_t i = 0; i < render::max_frames_in_flight; ++i)
+    {
+        vk::raii::Buffer       command_buffer({});
+        vk::raii::DeviceMemory command_memory({});
+        render.create_buffer(sizeof(vk::DrawIndexedIndirectCommand) * count_,
+                             vk::BufferUsageFlagBits::eStorageBuffer |
+                                 vk::BufferUsageFlagBits::eIndirectBuffer,
+                             vk::MemoryPropertyFlagBits::eDeviceLocal,
+                             command_buffer,
+                             command_memory);
+        render.set_object_name(*command_buffer,
+                               "cull_indirect_commands_" + std::to_string(i));
+        command_buffers_.emplace_back(std::move(command_buffer));
+        command_memory_.emplace_back(std::move(command_memory));
+
+        vk::raii::Buffer       count_buffer({});
+        vk::raii::DeviceMemory count_memory({});
+        render.create_buffer(sizeof(std::uint32_t),
+                             vk::BufferUsageFlagBits::eStorageBuffer |
+                                 vk::BufferUsageFlagBits::eIndirectBuffer |
+                                 vk::BufferUsageFlagBits::eTransferDst,
+                             vk::MemoryPropertyFlagBits::eDeviceLocal,
+                             count_buffer,
+                             count_memory);
+        render.set_object_name(*count_buffer,
+                               "cull_draw_count_" + std::to_string(i));
+        count_buffers_.emplace_back(std::move(count_buffer));
+        count_memory_.emplace_back(std::move(count_memory));
+    }
+}
+
+void culled_mesh::upload_objects(std::span<const cull_object> objects,
+                                 render&                      render)
+{
+    const vk::DeviceSize buffer_size = sizeof(cull_object) * count_;
+
+    vk::raii::Buffer       staging_buffer({});
+    vk::raii::DeviceMemory staging_buffer_memory({});
+    render.create_buffer(buffer_size,
+                         vk::BufferUsageFlagBits::eTransferSrc,
+                         vk::MemoryPropertyFlagBits::eHostVisible |
+                             vk::MemoryPropertyFlagBits::eHostCoherent,
+                         staging_buffer,
+                         staging_buffer_memory);
+
+    void* staging_data = staging_buffer_memory.mapMemory(0, buffer_size);
+    std::memcpy(staging_data, objects.data(), objects.size_bytes());
+    staging_buffer_memory.unmapMemory();
+
+    render.copy_buffer(staging_buffer, buffer_size, object_buffer_);
+}
+
+void culled_mesh::create_descriptor_sets(render& render)
+{
+    std::array<vk::DescriptorPoolSize, 2> pool_sizes{
+        vk::DescriptorPoolSize{
+            .type            = vk::DescriptorType::eUniformBufferDynamic,
+            .descriptorCount = render::max_frames_in_flight,
+        },
+        vk::DescriptorPoolSize{
+            .type            = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = render::max_frames_in_flight * 3u,
+        },
+    };
+
+    vk::DescriptorPoolCreateInfo pool_info{
+        .flags         = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        .maxSets       = render::max_frames_in_flight,
+        .poolSizeCount = static_cast<std::uint32_t>(pool_sizes.size()),
+        .pPoolSizes    = pool_sizes.data(),
+    };
+
+    descriptor_pool_ =
+        vk::raii::DescriptorPool(render.devices.logical, pool_info);
+
+    std::vector<vk::DescriptorSetLayout> layouts(
+        render::max_frames_in_flight, *render.cull_descriptor_set_layout);
+    vk::DescriptorSetAllocateInfo alloc_info{
+        .descriptorPool     = descriptor_pool_,
+        .descriptorSetCount = static_cast<uint32_t>(layouts.size()),
+        .pSetLayouts        = layouts.data(),
+    };
+
+    descriptor_sets_ =
+        render.devices.logical.allocateDescriptorSets(alloc_info);
+
+    for (std::uint32_t i = 0; i < render::max_frames_in_flight; ++i)
+    {
+        // same camera ubo as mesh draw, offset is dynamic
+        vk::DescriptorBufferInfo ubo_info{
+            .buffer = render.frame_arena.buffer,
+            .offset = 0,
+            .range  = render::mesh_ubo_size,
+        };
+        vk::DescriptorBufferInfo objects_info{
+            .buffer = object_buffer_,
+            .offset = 0,
+            .range  = sizeof(cull_object) * count_,
+        };
+        vk::DescriptorBufferInfo commands_info{
+            .buffer = command_buffers_.at(i),
+            .offset = 0,
+            .range  = sizeof(vk::DrawIndexedIndirectCommand) * count_,
+        };
+        vk::DescriptorBufferInfo count_info{
+            .buffer = count_buffers_.at(i),
+            .offset = 0,
+            .range  = sizeof(std::uint32_t),
+        };
+
+        std::array<vk::WriteDescriptorSet, 4> writes{
+            vk::WriteDescriptorSet{
+                .dstSet          = descriptor_sets_.at(i),
+                .dstBinding      = 0,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
+                .pBufferInfo     = &ubo_info,
+            },
+            vk::WriteDescriptorSet{
+                .dstSet          = descriptor_sets_.at(i),
+                .dstBinding      = 1,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo     = &objects_info,
+            },
+            vk::WriteDescriptorSet{
+                .dstSet          = descriptor_sets_.at(i),
+                .dstBinding      = 2,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo     = &commands_info,
+            },
+            vk::WriteDescriptorSet{
+                .dstSet          = descriptor_sets_.at(i),
+                .dstBinding      = 3,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo     = &count_info,
+            },
+        };
+
+        render.devices.logical.updateDescriptorSets(writes, {});
+    }
+}
 } // namespace om::vulkan
 
 namespace om::vulkan
@@ -1071,6 +1708,10 @@ render::render(platform_interface& platform, hints hints)
     , hints_{ hints }
     , queue_family{}
 {
+    if (hints.recording_threads == 0u)
+    {
+        throw std::runtime_error("error: hints.recording_threads must be > 0");
+    }
     create_instance(hints.enable_validation_layers,
                     hints.enable_debug_callback_ext);
     create_debug_callback(hints.enable_debug_callback_ext);
@@ -1083,22 +1724,36 @@ render::render(platform_interface& platform, hints hints)
     create_command_pool();
     create_compute_descriptor_set_layout();
     create_compute_pipeline();
+    create_cull_descriptor_set_layout();
+    create_cull_pipeline();
+    create_mip_pipeline();
     create_particle_graphics_pipeline();
     create_command_buffers();
+    create_secondary_command_buffers();
     create_compute_command_buffers();
-    create_uniform_buffers();
+    create_compute_graph();
+    create_frame_arena();
+    // image descriptor sets allocated from it by image constructor
     create_descriptor_pool();
-    // create_descriptor_sets(); we need texture, so wait till start render
     create_compute_descriptor_pool();
     create_compute_descriptor_sets();
     create_timeline_semaphore();
     create_synchronization_objects();
+    if (hints_.hot_reload_shaders)
+    {
+        start_shader_watcher();
+    }
 }
 
 render::~render()
 try
 {
     om::tools::report_duration duration{ log, "render::~render()" };
+    if (shader_reload.thread.joinable())
+    {
+        shader_reload.thread.request_stop();
+        shader_reload.thread.join();
+    }
     {
         om::tools::report_duration duration{ log,
                                              "devices.logical.waitIdle()" };
@@ -1132,6 +1787,13 @@ void render::begin_frame()
                                          std::numeric_limits<uint64_t>::max()))
         ;
 
+    {
+        // budget may shrink at runtime (other processes), free old data
+        // before frame allocates anything
+        std::scoped_lock lock(residency.mutex);
+        evict_resources(0u, false);
+    }
+
     auto& present_complete =
         *sync.semaphore.present_complete[current_semaphore];
 
@@ -1157,42 +1819,138 @@ void render::begin_frame()
     devices.logical.resetFences(compute_fence);
     devices.logical.resetFences(draw_fence);
 
-    auto& cmd_buf = command_buffers[current_frame];
-    cmd_buf.reset();
-    cmd_buf.begin({});
-
-    begin_render_pass(cmd_buf, image_index);
+    // frame boundary: no command buffer recording, safe to swap pipelines
+    apply_reloaded_pipelines();
+    ++frame_number_;
 
+    // frame begins before restore, so out of memory eviction sees data
+    // restored below as used by this frame and keeps it
     frame_image_index_     = image_index;
     frame_in_progress_     = true;
     rendering_pass_active_ = true;
     particles_drawn_       = false;
-}
 
-void render::draw(const mesh&          mesh,
-                  const image&         image,
-                  std::span<std::byte> ubo)
-{
+    // upload data evicted while previous frames drew it, before any thread
+    // records draws of this frame
+    restore_missing();
+
+    // GPU finished with this frame, so all secondaries of the frame can be
+    // recycled at once
+    for (auto& recorder : recorders)
+    {
+        recorder.command_pools[current_frame].reset();
+        recorder.recording = false;
+        // GPU finished reading frame arena regions of current_frame
+        recorder.ubo_head = 0u;
+    }
+
+    // frame_graph records culling dispatch and render pass in end_frame()
+    frame_culls.clear();
+    auto& cmd_buf = command_buffers[current_frame];
+    cmd_buf.reset();
+    cmd_buf.begin({});
+}
+
+void render::draw(const mesh&          mesh,
+                  const image&         image,
+                  std::span<std::byte> ubo)
+{
+    draw(0u, mesh, image, ubo);
+}
+
+void render::draw(std::uint32_t        thread_index,
+                  const mesh&          mesh,
+                  const image&         image,
+                  std::span<std::byte> ubo)
+{
     if (!frame_in_progress_ || !rendering_pass_active_)
     {
         throw std::runtime_error("draw: begin_frame() not called");
     }
 
-    create_descriptor_sets(current_frame, image);
+    if (thread_index >= hints_.recording_threads)
+    {
+        throw std::runtime_error("draw: thread_index out of range: " +
+                                 std::to_string(thread_index));
+    }
+
+    // evicted data restored by next begin_frame(), this frame skips draw,
+    // check both so misses of mesh and image restored together
+    const bool mesh_resident  = make_resident(mesh.residency_id);
+    const bool image_resident = make_resident(image.residency_id);
+    if (!mesh_resident || !image_resident)
+    {
+        return;
+    }
 
+    // only objects owned by thread_index touched here, so no locks needed
+    // every draw gets own ubo copy, so draws of one thread do not overwrite
+    // each other, empty ubo means same as previous draw of this thread
+    auto& recorder = recorders[thread_index];
     if (!ubo.empty())
     {
-        void* output = uniform_buffers_mapped[current_frame];
-        std::uninitialized_copy_n(
-            ubo.data(), ubo.size(), static_cast<std::byte*>(output));
+        recorder.last_ubo.assign(ubo.begin(), ubo.end());
+    }
+    const frame_allocation ubo_memory =
+        upload_frame_data(thread_index, recorder.last_ubo, mesh_ubo_size);
+
+    auto& cmd_buf = begin_secondary(thread_index);
+    record_mesh_commands(
+        cmd_buf, *image.descriptor_set, ubo_memory.offset, mesh);
+}
+
+void render::draw(const mesh&          mesh,
+                  const image&         image,
+                  const culled_mesh&   objects,
+                  std::span<std::byte> ubo)
+{
+    if (!frame_in_progress_ || !rendering_pass_active_)
+    {
+        throw std::runtime_error("draw_culled: begin_frame() not called");
+    }
+
+    if (objects.get_count() == 0u)
+    {
+        return;
+    }
+
+    const bool mesh_resident  = make_resident(mesh.residency_id);
+    const bool image_resident = make_resident(image.residency_id);
+    if (!mesh_resident || !image_resident)
+    {
+        return;
     }
 
-    auto& cmd_buf   = command_buffers[current_frame];
-    auto& descr_set = descriptor_sets[current_frame];
-    record_mesh_commands(cmd_buf, descr_set, mesh);
+    // frame thread ubo ring, worker threads may record draws into own rings
+    // concurrently, cull shader reads camera from same ubo
+    const std::uint32_t recorder_index = frame_recorder_index();
+
+    auto& recorder = recorders[recorder_index];
+    if (!ubo.empty())
+    {
+        recorder.last_ubo.assign(ubo.begin(), ubo.end());
+    }
+    const frame_allocation ubo_memory =
+        upload_frame_data(recorder_index, recorder.last_ubo, mesh_ubo_size);
+
+    // dispatched by "cull" pass of frame_graph, it derives barriers from
+    // fill to dispatch and from dispatch to indirect draw
+    frame_culls.push_back(
+        pending_cull{ .objects = &objects, .ubo_offset = ubo_memory.offset });
+
+    auto& cmd_buf = begin_secondary(recorder_index);
+    record_mesh_bindings(
+        cmd_buf, *image.descriptor_set, ubo_memory.offset, mesh);
+    cmd_buf.drawIndexedIndirectCount(
+        objects.command_buffers_[current_frame], // commands
+        0u,                                      // offset
+        objects.count_buffers_[current_frame],   // written by cull shader
+        0u,                                      // count offset
+        objects.get_count(),                     // max draw count
+        sizeof(vk::DrawIndexedIndirectCommand)); // stride
 }
 
-void render::draw(const particles& parts, std::span<std::byte> compute_ubo)
+void render::draw(const particles& parts, std::span<std::byte> compute_data)
 {
     if (!frame_in_progress_ || !rendering_pass_active_)
     {
@@ -1205,19 +1963,32 @@ void render::draw(const particles& parts, std::span<std::byte> compute_ubo)
         return;
     }
 
-    if (!compute_ubo.empty())
+    if (!compute_data.empty())
     {
-        parts.update_uniform_buffer(current_frame, compute_ubo);
+        last_compute_ubo.assign(compute_data.begin(), compute_data.end());
     }
+    const frame_allocation ubo_memory = upload_frame_data(
+        frame_recorder_index(),
+        last_compute_ubo,
+        sizeof(om::vulkan::compute_ubo)); // descriptor range, not span size
 
     const std::uint64_t compute_wait_value   = timeline_value;
     const std::uint64_t compute_signal_value = ++timeline_value;
     graphics_wait_value_                     = compute_signal_value;
     graphics_signal_value_                   = ++timeline_value;
 
+    // graph adds barrier from compute write to vertex input after dispatch
+    frame_particles = { .parts = &parts, .ubo_offset = ubo_memory.offset };
+    compute_graph.bind_buffer(compute_resources.particles_in,
+                              parts.get_read_buffer(current_frame));
+    compute_graph.bind_buffer(compute_resources.particles_out,
+                              parts.get_write_buffer(current_frame));
+
     auto& compute_cmd_buf = compute_command_buffers[current_frame];
     compute_cmd_buf.reset();
-    record_compute_commands(compute_cmd_buf, current_frame, parts);
+    compute_cmd_buf.begin({});
+    compute_graph.execute(compute_cmd_buf);
+    compute_cmd_buf.end();
 
     vk::TimelineSemaphoreSubmitInfo compute_timeline_info{
         .waitSemaphoreValueCount   = 1u,
@@ -1244,7 +2015,9 @@ void render::draw(const particles& parts, std::span<std::byte> compute_ubo)
     compute_queue.submit(compute_submit_info,
                          *sync.compute_in_flight_fence[current_frame]);
 
-    auto& cmd_buf = command_buffers[current_frame];
+    // own recorder executed after mesh draws of all threads, so particles
+    // blend over opaque geometry in call order of single thread version
+    auto& cmd_buf = begin_secondary(frame_recorder_index());
     record_particle_commands(cmd_buf, current_frame, parts);
     particles_drawn_ = true;
 }
@@ -1260,7 +2033,25 @@ void render::end_frame()
     auto&      draw_fence = *sync.draw_fence[current_frame];
     vk::Result result     = vk::Result::eSuccess;
 
-    end_render_pass(cmd_buf, frame_image_index_);
+    frame_graph.bind_image(frame_resources.swapchain,
+                           swapchain_images[frame_image_index_],
+                           swapchain_image_views[frame_image_index_]);
+
+    frame_cull_counts.clear();
+    frame_cull_commands.clear();
+    for (const pending_cull& cull : frame_culls)
+    {
+        const culled_mesh& objects = *cull.objects;
+        frame_cull_counts.push_back(objects.count_buffers_[current_frame]);
+        frame_cull_commands.push_back(objects.command_buffers_[current_frame]);
+    }
+    frame_graph.bind_buffers(frame_resources.cull_counts, frame_cull_counts);
+    frame_graph.bind_buffers(frame_resources.cull_commands,
+                             frame_cull_commands);
+
+    frame_graph.execute(cmd_buf);
+    cmd_buf.end();
+    frame_culls.clear();
 
     if (particles_drawn_)
     {
@@ -1621,11 +2412,16 @@ bool render::check_device_suitable(const vk::PhysicalDevice& physical)
 
     auto features = physical.template getFeatures2<
         vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceVulkan12Features,
         vk::PhysicalDeviceVulkan13Features,
         vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
     bool supports_required_features =
         features.template get<vk::PhysicalDeviceFeatures2>()
             .features.samplerAnisotropy &&
+        features.template get<vk::PhysicalDeviceFeatures2>()
+            .features.multiDrawIndirect &&
+        features.template get<vk::PhysicalDeviceVulkan12Features>()
+            .drawIndirectCount &&
         features.template get<vk::PhysicalDeviceVulkan13Features>()
             .dynamicRendering &&
         features
@@ -2178,6 +2974,7 @@ void render::create_logical_device()
                        vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>
         feature_chain = {
             { .features = { .sampleRateShading = true,
+                            .multiDrawIndirect = true,
                             .largePoints       = true,
                             .samplerAnisotropy = true } },
             {
@@ -2185,19 +2982,44 @@ void render::create_logical_device()
                 .dynamicRendering = true,
             },
             {
+                .drawIndirectCount = true, // GPU culling
                 .timelineSemaphore = true,
             },
             { .extendedDynamicState = true },
         };
 
+    // optional: driver reported budget, without it usage tracked by render
+    std::vector<const char*> device_extensions = required_device_extensions;
+    residency.ext_memory_budget = check_device_extension_supported(
+        devices.physical, vk::EXTMemoryBudgetExtensionName);
+    if (residency.ext_memory_budget)
+    {
+        device_extensions.push_back(vk::EXTMemoryBudgetExtensionName);
+    }
+
+    const vk::PhysicalDeviceMemoryProperties memory_properties =
+        devices.physical.getMemoryProperties();
+    for (std::uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i)
+    {
+        if (memory_properties.memoryHeaps[i].flags &
+            vk::MemoryHeapFlagBits::eDeviceLocal)
+        {
+            residency.device_heap_size +=
+                memory_properties.memoryHeaps[i].size;
+        }
+    }
+    log << "device local heaps: " << residency.device_heap_size
+        << " bytes, VK_EXT_memory_budget: " << residency.ext_memory_budget
+        << '\n';
+
     vk::DeviceCreateInfo device_create_info{
         .pNext = &feature_chain.get<vk::PhysicalDeviceFeatures2>(),
         .queueCreateInfoCount = static_cast<uint32_t>(queue_infos.size()),
         .pQueueCreateInfos    = queue_infos.data(),
         //.enabledLayerCount    = 0, // in vk_1_1+ this takes from vk::instance
         .enabledExtensionCount =
-            static_cast<uint32_t>(required_device_extensions.size()),
-        .ppEnabledExtensionNames = required_device_extensions.data(),
+            static_cast<uint32_t>(device_extensions.size()),
+        .ppEnabledExtensionNames = device_extensions.data(),
     };
 
     devices.logical = vk::raii::Device(devices.physical, device_create_info);
@@ -2406,8 +3228,7 @@ void render::create_swapchain()
     log << "create swapchain_image_views count: "
         << swapchain_image_views.size() << std::endl;
 
-    create_color_resources();
-    create_depth_resources();
+    create_frame_graph();
 }
 
 void render::cleanup_swapchain()
@@ -2415,13 +3236,7 @@ void render::cleanup_swapchain()
     swapchain_image_views.clear();
     swapchain = nullptr;
 
-    color_image        = nullptr;
-    color_image_memory = nullptr;
-    color_image_view   = nullptr;
-
-    depth_image        = nullptr;
-    depth_image_memory = nullptr;
-    depth_image_view   = nullptr;
+    frame_graph = render_graph{};
 }
 
 void render::recreate_swapchain()
@@ -2437,6 +3252,9 @@ void render::recreate_swapchain()
 
     devices.logical.waitIdle();
 
+    // shader reload thread reads swapchain formats during pipeline build
+    std::lock_guard lock{ shader_reload.mutex };
+
     cleanup_swapchain();
 
     create_swapchain();
@@ -2451,10 +3269,11 @@ void render::create_descriptor_set_layout()
 {
     vk::DescriptorSetLayoutBinding layout_binding_vertex{
         .binding         = 0,                                  // binding index
-        .descriptorType  = vk::DescriptorType::eUniformBuffer, // descriptorType
-        .descriptorCount = 1,                                // descriptorCount
-        .stageFlags      = vk::ShaderStageFlagBits::eVertex, // stageFlags
-        .pImmutableSamplers = nullptr // immutableSamplers
+        .descriptorType =
+            vk::DescriptorType::eUniformBufferDynamic, // descriptorType
+        .descriptorCount    = 1,                       // descriptorCount
+        .stageFlags = vk::ShaderStageFlagBits::eVertex, // stageFlags
+        .pImmutableSamplers = nullptr                   // immutableSamplers
     };
 
     vk::DescriptorSetLayoutBinding layout_binding_sampler{
@@ -2481,14 +3300,30 @@ void render::create_descriptor_set_layout()
 
 void render::create_graphics_pipeline()
 {
-    // Static Pipeline States
+    // Pipeline layout apply descriptor sets
+    // layout does not depend on shader code, so it survive shader hot reload
+    vk::PipelineLayoutCreateInfo layout_info{ .setLayoutCount = 1,
+                                              .pSetLayouts =
+                                                  &*descriptor_set_layout,
+                                              .pushConstantRangeCount =
+                                                  0 }; // we will fill it later
+
+    pipeline_layout = vk::raii::PipelineLayout(devices.logical, layout_info);
+
     auto vertex_and_fragment_shader_code = platform.get_file_content(
-        "./02-vulkan/16-vk-compute/shaders/shader.vert.frag.slang.spv");
+        graphics_shader_path, platform_interface::file_access::reloadable);
 
-    vk::raii::ShaderModule shader_module =
-        create_shader(vertex_and_fragment_shader_code.as_span());
+    graphics_pipeline =
+        build_graphics_pipeline(vertex_and_fragment_shader_code.as_span());
+    log << "create graphics pipeline\n";
+    set_object_name(*graphics_pipeline, "om_graphics_pipeline");
+}
 
-    log << "create shader module\n";
+vk::raii::Pipeline render::build_graphics_pipeline(
+    std::span<const std::byte> spir_v)
+{
+    // Static Pipeline States
+    vk::raii::ShaderModule shader_module = create_shader(spir_v);
 
     vk::PipelineShaderStageCreateInfo stage_info_vert{
         .stage  = vk::ShaderStageFlagBits::eVertex,
@@ -2640,15 +3475,6 @@ void render::create_graphics_pipeline()
     // here, in which case the fragment colors will be written to the
     // framebuffer unmodified.
 
-    // Pipeline layout apply descriptor sets
-    vk::PipelineLayoutCreateInfo layout_info{ .setLayoutCount = 1,
-                                              .pSetLayouts =
-                                                  &*descriptor_set_layout,
-                                              .pushConstantRangeCount =
-                                                  0 }; // we will fill it later
-
-    pipeline_layout = vk::raii::PipelineLayout(devices.logical, layout_info);
-
     // Depth and Stensil testing
     vk::PipelineDepthStencilStateCreateInfo depth_stencil{
         .depthTestEnable       = vk::True,
@@ -2661,7 +3487,7 @@ void render::create_graphics_pipeline()
     vk::PipelineRenderingCreateInfo pipeline_rendering_create_info{
         .colorAttachmentCount    = 1,
         .pColorAttachmentFormats = &swapchain_image_format,
-        .depthAttachmentFormat   = find_depth_format()
+        .depthAttachmentFormat   = depth_format
     };
 
     // Graphics Pipeline creation
@@ -2694,7 +3520,7 @@ void render::create_graphics_pipeline()
     // The compilation and linking of the SPIR-V bytecode to machine code for
     // execution by the GPU doesn’t happen until the graphics pipeline is
     // created. Compile shaders from spir-v into gpu code happens here
-    graphics_pipeline = vk::raii::Pipeline(
+    return vk::raii::Pipeline(
         devices.logical,
         nullptr, // The second parameter, for which we’ve passed the
                  // nullptr argument, references an optional
@@ -2705,54 +3531,93 @@ void render::create_graphics_pipeline()
                  // makes it possible to significantly speed up pipeline
                  // creation at a later time.
         graphics_info);
-    log << "create graphics pipeline\n";
-    set_object_name(*graphics_pipeline, "om_graphics_pipeline");
 }
-void render::create_uniform_buffers()
+void render::create_frame_arena()
+{
+    const vk::PhysicalDeviceLimits limits =
+        devices.physical.getProperties().limits;
+    // both limits are power of two, so max is multiple of each
+    frame_arena.alignment = std::max(limits.minUniformBufferOffsetAlignment,
+                                     limits.minStorageBufferOffsetAlignment);
+
+    // recording threads + frame thread recorder
+    const vk::DeviceSize size = frame_arena_size * max_frames_in_flight *
+                                (hints_.recording_threads + 1u);
+    create_buffer(size,
+                  vk::BufferUsageFlagBits::eUniformBuffer |
+                      vk::BufferUsageFlagBits::eStorageBuffer,
+                  vk::MemoryPropertyFlagBits::eHostVisible |
+                      vk::MemoryPropertyFlagBits::eHostCoherent,
+                  frame_arena.buffer,
+                  frame_arena.memory);
+    set_object_name(*frame_arena.buffer, "frame_arena");
+    // This technique is called "persistent mapping" and works on all Vulkan
+    // implementations. Not having to map the buffer every time we need to
+    // update it increases performances, as mapping is not free.
+    frame_arena.mapped =
+        static_cast<std::byte*>(frame_arena.memory.mapMemory(0, size));
+}
+
+render::frame_allocation render::allocate_frame_memory(
+    std::uint32_t recorder_index, vk::DeviceSize size)
 {
-    uniform_buffers.clear();
-    uniform_buffers_memory.clear();
-    uniform_buffers_mapped.clear();
+    // no atomics, ring region and head are owned by recorder_index thread
+    secondary_recorder& recorder = recorders[recorder_index];
+
+    const vk::DeviceSize aligned_size =
+        (size + frame_arena.alignment - 1u) & ~(frame_arena.alignment - 1u);
+    const vk::DeviceSize offset = recorder.ubo_head;
 
-    for (size_t i = 0; i < max_frames_in_flight; i++)
+    if (offset + aligned_size > frame_arena_size)
     {
-        vk::DeviceSize         size = sizeof(glm::mat4) * 3; // model,view,proj
-        vk::raii::Buffer       buffer({});
-        vk::raii::DeviceMemory buffer_mem({});
-        create_buffer(size,
-                      vk::BufferUsageFlagBits::eUniformBuffer,
-                      vk::MemoryPropertyFlagBits::eHostVisible |
-                          vk::MemoryPropertyFlagBits::eHostCoherent,
-                      buffer,
-                      buffer_mem);
-        uniform_buffers.emplace_back(std::move(buffer));
-        uniform_buffers_memory.emplace_back(std::move(buffer_mem));
-        // This technique is called "persistent mapping" and works on all Vulkan
-        // implementations. Not having to map the buffer every time we need to
-        // update it increases performances, as mapping is not free.
-        uniform_buffers_mapped.emplace_back(
-            uniform_buffers_memory[i].mapMemory(0, size));
+        throw std::runtime_error(
+            "error: frame arena out of memory, increase frame_arena_size");
     }
+    recorder.ubo_head = offset + aligned_size;
+
+    const vk::DeviceSize region =
+        std::size_t{ current_frame } * recorders.size() + recorder_index;
+    const vk::DeviceSize global_offset = frame_arena_size * region + offset;
+
+    return frame_allocation{
+        .mapped = frame_arena.mapped + global_offset,
+        .offset = static_cast<std::uint32_t>(global_offset),
+    };
+}
+
+render::frame_allocation render::upload_frame_data(
+    std::uint32_t              recorder_index,
+    std::span<const std::byte> data,
+    vk::DeviceSize             size)
+{
+    // size is descriptor range, tail not covered by data is zero filled
+    frame_allocation allocation = allocate_frame_memory(recorder_index, size);
+    const std::size_t copy_size =
+        std::min(data.size(), static_cast<std::size_t>(size));
+    std::memcpy(allocation.mapped, data.data(), copy_size);
+    std::memset(allocation.mapped + copy_size, 0, size - copy_size);
+    return allocation;
 }
 
 void render::create_descriptor_pool()
 {
     vk::DescriptorPoolSize pool_vertex_size{
-        .type            = vk::DescriptorType::eUniformBuffer,
-        .descriptorCount = max_frames_in_flight
+        .type            = vk::DescriptorType::eUniformBufferDynamic,
+        .descriptorCount = max_images
     };
 
     vk::DescriptorPoolSize pool_sampler_size{
         .type            = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = max_frames_in_flight
+        .descriptorCount = max_images
     };
 
     std::array<vk::DescriptorPoolSize, 2> pools_size{ pool_vertex_size,
                                                       pool_sampler_size };
 
     vk::DescriptorPoolCreateInfo pool_info{
+        // image destructor frees own set
         .flags   = { vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet },
-        .maxSets = max_frames_in_flight,
+        .maxSets = max_images,
         .poolSizeCount = static_cast<std::uint32_t>(pools_size.size()),
         .pPoolSizes    = pools_size.data()
     };
@@ -2760,40 +3625,26 @@ void render::create_descriptor_pool()
     descriptor_pool = vk::raii::DescriptorPool(devices.logical, pool_info);
 }
 
-void render::create_descriptor_sets(std::size_t frame_index, const image& image)
+vk::raii::DescriptorSet render::allocate_image_descriptor_set()
 {
-    if (descriptor_sets.empty())
-    {
-        std::vector<vk::DescriptorSetLayout> layouts(max_frames_in_flight,
-                                                     *descriptor_set_layout);
-        vk::DescriptorSetAllocateInfo        alloc_info{
-                   .descriptorPool     = descriptor_pool,
-                   .descriptorSetCount = static_cast<uint32_t>(layouts.size()),
-                   .pSetLayouts        = layouts.data()
-        };
-
-        descriptor_sets = devices.logical.allocateDescriptorSets(alloc_info);
+    vk::DescriptorSetAllocateInfo alloc_info{
+        .descriptorPool     = descriptor_pool,
+        .descriptorSetCount = 1u,
+        .pSetLayouts        = &*descriptor_set_layout
+    };
 
-        for (size_t i = 0; i < max_frames_in_flight; i++)
-        {
-            vk::DescriptorBufferInfo buffer_info{ .buffer =
-                                                      uniform_buffers.at(i),
-                                                  .offset = 0,
-                                                  .range =
-                                                      sizeof(glm::mat4) * 3 };
-
-            vk::WriteDescriptorSet ubo_descriptor_write{
-                .dstSet          = descriptor_sets.at(i),
-                .dstBinding      = 0,
-                .dstArrayElement = 0,
-                .descriptorCount = 1,
-                .descriptorType  = vk::DescriptorType::eUniformBuffer,
-                .pBufferInfo     = &buffer_info
-            };
+    return std::move(
+        devices.logical.allocateDescriptorSets(alloc_info).front());
+}
 
-            devices.logical.updateDescriptorSets({ ubo_descriptor_write }, {});
-        }
-    }
+void render::write_image_descriptor(const image& image)
+{
+    // called when image view changes (create, restore), never while set
+    // is bound in recorded frame, so no per draw descriptor updates
+    // real offset passed to bindDescriptorSets as dynamic offset
+    vk::DescriptorBufferInfo buffer_info{ .buffer = frame_arena.buffer,
+                                          .offset = 0,
+                                          .range  = mesh_ubo_size };
 
     vk::DescriptorImageInfo image_info{
         .sampler     = image.img_sampler,
@@ -2801,16 +3652,24 @@ void render::create_descriptor_sets(std::size_t frame_index, const image& image)
         .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
     };
 
-    vk::WriteDescriptorSet sampler_descriptor_write{
-        .dstSet          = descriptor_sets.at(frame_index),
-        .dstBinding      = 1,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType  = vk::DescriptorType::eCombinedImageSampler,
-        .pImageInfo      = &image_info
+    std::array<vk::WriteDescriptorSet, 2> descriptor_writes{
+        vk::WriteDescriptorSet{
+            .dstSet          = image.descriptor_set,
+            .dstBinding      = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
+            .pBufferInfo     = &buffer_info },
+        vk::WriteDescriptorSet{
+            .dstSet          = image.descriptor_set,
+            .dstBinding      = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = vk::DescriptorType::eCombinedImageSampler,
+            .pImageInfo      = &image_info },
     };
 
-    devices.logical.updateDescriptorSets({ sampler_descriptor_write }, {});
+    devices.logical.updateDescriptorSets(descriptor_writes, {});
 }
 
 void render::bind_particle_compute_descriptors(const particles& parts)
@@ -2821,7 +3680,7 @@ void render::bind_particle_compute_descriptors(const particles& parts)
     for (std::size_t i = 0; i < max_frames_in_flight; ++i)
     {
         vk::DescriptorBufferInfo ubo_info{
-            .buffer = parts.get_uniform_buffer(static_cast<std::uint32_t>(i)),
+            .buffer = frame_arena.buffer,
             .offset = 0,
             .range  = sizeof(compute_ubo),
         };
@@ -2843,7 +3702,7 @@ void render::bind_particle_compute_descriptors(const particles& parts)
                 .dstSet          = compute_descriptor_sets.at(i),
                 .dstBinding      = 0,
                 .descriptorCount = 1,
-                .descriptorType  = vk::DescriptorType::eUniformBuffer,
+                .descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
                 .pBufferInfo     = &ubo_info,
             },
             vk::WriteDescriptorSet{
@@ -2871,7 +3730,7 @@ void render::create_compute_descriptor_set_layout()
     std::array<vk::DescriptorSetLayoutBinding, 3> bindings{
         vk::DescriptorSetLayoutBinding{
             .binding         = 0,
-            .descriptorType  = vk::DescriptorType::eUniformBuffer,
+            .descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
             .descriptorCount = 1,
             .stageFlags      = vk::ShaderStageFlagBits::eCompute,
         },
@@ -2900,11 +3759,25 @@ void render::create_compute_descriptor_set_layout()
 
 void render::create_compute_pipeline()
 {
+    vk::PipelineLayoutCreateInfo layout_info{
+        .setLayoutCount = 1,
+        .pSetLayouts    = &*compute_descriptor_set_layout,
+    };
+    compute_pipeline_layout =
+        vk::raii::PipelineLayout(devices.logical, layout_info);
+
     auto compute_shader_code = platform.get_file_content(
-        "./02-vulkan/16-vk-compute/shaders/compute.slang.spv");
+        compute_shader_path, platform_interface::file_access::reloadable);
+
+    compute_pipeline = build_compute_pipeline(compute_shader_code.as_span());
+    log << "create compute pipeline\n";
+    set_object_name(*compute_pipeline, "om_compute_pipeline");
+}
 
-    vk::raii::ShaderModule shader_module =
-        create_shader(compute_shader_code.as_span());
+vk::raii::Pipeline render::build_compute_pipeline(
+    std::span<const std::byte> spir_v)
+{
+    vk::raii::ShaderModule shader_module = create_shader(spir_v);
 
     vk::PipelineShaderStageCreateInfo compute_stage{
         .stage  = vk::ShaderStageFlagBits::eCompute,
@@ -2912,31 +3785,217 @@ void render::create_compute_pipeline()
         .pName  = "comp_main",
     };
 
+    vk::ComputePipelineCreateInfo pipeline_info{
+        .stage  = compute_stage,
+        .layout = *compute_pipeline_layout,
+    };
+
+    return vk::raii::Pipeline(devices.logical, nullptr, pipeline_info);
+}
+
+void render::create_cull_descriptor_set_layout()
+{
+    std::array<vk::DescriptorSetLayoutBinding, 4> bindings{
+        // camera ubo (model, view, proj) same as graphics pipeline use
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 0,
+            .descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        },
+        // cull_object array
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 1,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        },
+        // compacted indirect commands
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 2,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        },
+        // draw count
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 3,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        },
+    };
+
+    vk::DescriptorSetLayoutCreateInfo layout_info{
+        .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+        .pBindings    = bindings.data(),
+    };
+
+    cull_descriptor_set_layout =
+        vk::raii::DescriptorSetLayout(devices.logical, layout_info);
+}
+
+void render::create_cull_pipeline()
+{
     vk::PipelineLayoutCreateInfo layout_info{
         .setLayoutCount = 1,
-        .pSetLayouts    = &*compute_descriptor_set_layout,
+        .pSetLayouts    = &*cull_descriptor_set_layout,
     };
-    compute_pipeline_layout =
+    cull_pipeline_layout =
         vk::raii::PipelineLayout(devices.logical, layout_info);
 
+    auto cull_shader_code = platform.get_file_content(
+        cull_shader_path, platform_interface::file_access::reloadable);
+
+    cull_pipeline = build_cull_pipeline(cull_shader_code.as_span());
+    log << "create cull pipeline\n";
+    set_object_name(*cull_pipeline, "om_cull_pipeline");
+}
+
+vk::raii::Pipeline render::build_cull_pipeline(
+    std::span<const std::byte> spir_v)
+{
+    vk::raii::ShaderModule shader_module = create_shader(spir_v);
+
     vk::ComputePipelineCreateInfo pipeline_info{
-        .stage  = compute_stage,
-        .layout = *compute_pipeline_layout,
+        .stage  = { .stage  = vk::ShaderStageFlagBits::eCompute,
+                    .module = shader_module,
+                    .pName  = "cull_main" },
+        .layout = *cull_pipeline_layout,
     };
 
-    compute_pipeline =
-        vk::raii::Pipeline(devices.logical, nullptr, pipeline_info);
-    log << "create compute pipeline\n";
-    set_object_name(*compute_pipeline, "om_compute_pipeline");
+    return vk::raii::Pipeline(devices.logical, nullptr, pipeline_info);
+}
+
+void render::create_mip_pipeline()
+{
+    std::array<vk::DescriptorSetLayoutBinding, 3> bindings{
+        // storage views of all mip levels
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 0,
+            .descriptorType  = vk::DescriptorType::eStorageImage,
+            .descriptorCount = mip_max_levels,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        },
+        // level 6 copy, read by last group
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 1,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        },
+        // finished groups counter
+        vk::DescriptorSetLayoutBinding{
+            .binding         = 2,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags      = vk::ShaderStageFlagBits::eCompute,
+        },
+    };
+
+    vk::DescriptorSetLayoutCreateInfo set_layout_info{
+        .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+        .pBindings    = bindings.data(),
+    };
+    mip_descriptor_set_layout =
+        vk::raii::DescriptorSetLayout(devices.logical, set_layout_info);
+
+    vk::PushConstantRange push_range{
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset     = 0u,
+        .size       = sizeof(mip_constants),
+    };
+
+    vk::PipelineLayoutCreateInfo layout_info{
+        .setLayoutCount         = 1,
+        .pSetLayouts            = &*mip_descriptor_set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push_range,
+    };
+    mip_pipeline_layout =
+        vk::raii::PipelineLayout(devices.logical, layout_info);
+
+    auto mip_shader_code = platform.get_file_content(
+        mip_shader_path, platform_interface::file_access::reloadable);
+
+    mip_pipeline = build_mip_pipeline(mip_shader_code.as_span());
+    log << "create mip pipeline\n";
+    set_object_name(*mip_pipeline, "om_mip_pipeline");
+
+    std::array<vk::DescriptorPoolSize, 2> pool_sizes{
+        vk::DescriptorPoolSize{
+            .type            = vk::DescriptorType::eStorageImage,
+            .descriptorCount = mip_max_levels,
+        },
+        vk::DescriptorPoolSize{
+            .type            = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 2u,
+        },
+    };
+
+    // one set at a time, generate_mipmaps() is blocking
+    vk::DescriptorPoolCreateInfo pool_info{
+        .flags         = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        .maxSets       = 1u,
+        .poolSizeCount = static_cast<std::uint32_t>(pool_sizes.size()),
+        .pPoolSizes    = pool_sizes.data(),
+    };
+    mip_descriptor_pool = vk::raii::DescriptorPool(devices.logical, pool_info);
+
+    create_buffer(sizeof(glm::vec4) * 64u * 64u,
+                  vk::BufferUsageFlagBits::eStorageBuffer,
+                  vk::MemoryPropertyFlagBits::eDeviceLocal,
+                  mip_level_six_buffer,
+                  mip_level_six_memory);
+    set_object_name(*mip_level_six_buffer, "mip_level_six");
+
+    create_buffer(sizeof(std::uint32_t),
+                  vk::BufferUsageFlagBits::eStorageBuffer |
+                      vk::BufferUsageFlagBits::eTransferDst,
+                  vk::MemoryPropertyFlagBits::eDeviceLocal,
+                  mip_counter_buffer,
+                  mip_counter_memory);
+    set_object_name(*mip_counter_buffer, "mip_counter");
+}
+
+vk::raii::Pipeline render::build_mip_pipeline(
+    std::span<const std::byte> spir_v)
+{
+    vk::raii::ShaderModule shader_module = create_shader(spir_v);
+
+    vk::ComputePipelineCreateInfo pipeline_info{
+        .stage  = { .stage  = vk::ShaderStageFlagBits::eCompute,
+                    .module = shader_module,
+                    .pName  = "mip_main" },
+        .layout = *mip_pipeline_layout,
+    };
+
+    return vk::raii::Pipeline(devices.logical, nullptr, pipeline_info);
 }
 
 void render::create_particle_graphics_pipeline()
 {
+    vk::PipelineLayoutCreateInfo layout_info{
+        .setLayoutCount = 0,
+        .pSetLayouts    = nullptr,
+    };
+    particle_pipeline_layout =
+        vk::raii::PipelineLayout(devices.logical, layout_info);
+
     auto particle_shader_code = platform.get_file_content(
-        "./02-vulkan/16-vk-compute/shaders/particle.vert.frag.slang.spv");
+        particle_shader_path, platform_interface::file_access::reloadable);
+
+    particle_graphics_pipeline =
+        build_particle_graphics_pipeline(particle_shader_code.as_span());
+    log << "create particle graphics pipeline\n";
+    set_object_name(*particle_graphics_pipeline,
+                    "om_particle_graphics_pipeline");
+}
 
-    vk::raii::ShaderModule shader_module =
-        create_shader(particle_shader_code.as_span());
+vk::raii::Pipeline render::build_particle_graphics_pipeline(
+    std::span<const std::byte> spir_v)
+{
+    vk::raii::ShaderModule shader_module = create_shader(spir_v);
 
     vk::PipelineShaderStageCreateInfo stage_info_vert{
         .stage  = vk::ShaderStageFlagBits::eVertex,
@@ -3017,13 +4076,6 @@ void render::create_particle_graphics_pipeline()
         .pAttachments    = &blend_attachment,
     };
 
-    vk::PipelineLayoutCreateInfo layout_info{
-        .setLayoutCount = 0,
-        .pSetLayouts    = nullptr,
-    };
-    particle_pipeline_layout =
-        vk::raii::PipelineLayout(devices.logical, layout_info);
-
     vk::PipelineDepthStencilStateCreateInfo depth_stencil{
         .depthTestEnable  = vk::False,
         .depthWriteEnable = vk::False,
@@ -3032,7 +4084,7 @@ void render::create_particle_graphics_pipeline()
     vk::PipelineRenderingCreateInfo pipeline_rendering_create_info{
         .colorAttachmentCount    = 1,
         .pColorAttachmentFormats = &swapchain_image_format,
-        .depthAttachmentFormat   = find_depth_format(),
+        .depthAttachmentFormat   = depth_format,
     };
 
     vk::GraphicsPipelineCreateInfo graphics_info{
@@ -3050,11 +4102,7 @@ void render::create_particle_graphics_pipeline()
         .layout              = particle_pipeline_layout,
     };
 
-    particle_graphics_pipeline =
-        vk::raii::Pipeline(devices.logical, nullptr, graphics_info);
-    log << "create particle graphics pipeline\n";
-    set_object_name(*particle_graphics_pipeline,
-                    "om_particle_graphics_pipeline");
+    return vk::raii::Pipeline(devices.logical, nullptr, graphics_info);
 }
 
 void render::create_command_pool()
@@ -3125,21 +4173,131 @@ vk::Format render::find_depth_format()
         vk::FormatFeatureFlagBits::eDepthStencilAttachment);
 }
 
-void render::create_depth_resources()
+void render::create_frame_graph()
 {
-    vk::Format depth_format = find_depth_format();
+    depth_format = find_depth_format();
+
+    frame_graph = render_graph(devices.logical,
+                               devices.physical.getMemoryProperties());
+
+    frame_resources.color = frame_graph.create_image({
+        .name    = "msaa_color",
+        .format  = swapchain_image_format,
+        .extent  = swapchain_image_extent,
+        .usage   = vk::ImageUsageFlagBits::eTransientAttachment |
+                 vk::ImageUsageFlagBits::eColorAttachment,
+        .aspect  = vk::ImageAspectFlagBits::eColor,
+        .samples = msaa_samples,
+    });
+
+    frame_resources.depth = frame_graph.create_image({
+        .name    = "depth",
+        .format  = depth_format,
+        .extent  = swapchain_image_extent,
+        .usage   = vk::ImageUsageFlagBits::eTransientAttachment |
+                 vk::ImageUsageFlagBits::eDepthStencilAttachment,
+        .aspect  = vk::ImageAspectFlagBits::eDepth,
+        .samples = msaa_samples,
+    });
+
+    // acquire semaphore is waited at color attachment output stage
+    frame_resources.swapchain = frame_graph.import_image({
+        .name           = "swapchain",
+        .aspect         = vk::ImageAspectFlagBits::eColor,
+        .initial_layout = vk::ImageLayout::eUndefined,
+        .initial_stage  = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        .final_layout   = vk::ImageLayout::ePresentSrcKHR,
+    });
+
+    // per culled mesh buffers of current frame, bound in end_frame()
+    frame_resources.cull_counts =
+        frame_graph.import_buffer({ .name = "cull_counts" });
+    frame_resources.cull_commands =
+        frame_graph.import_buffer({ .name = "cull_commands" });
+
+    frame_graph
+        .add_pass("cull_reset",
+                  [this](vk::raii::CommandBuffer& cmd_buf)
+                  {
+                      for (const pending_cull& cull : frame_culls)
+                      {
+                          record_cull_reset(
+                              cmd_buf, current_frame, *cull.objects);
+                      }
+                  })
+        .write(frame_resources.cull_counts, resource_access::transfer_dst);
+
+    frame_graph
+        .add_pass("cull",
+                  [this](vk::raii::CommandBuffer& cmd_buf)
+                  {
+                      for (const pending_cull& cull : frame_culls)
+                      {
+                          record_cull_commands(cmd_buf,
+                                               current_frame,
+                                               cull.ubo_offset,
+                                               *cull.objects);
+                      }
+                  })
+        // count is atomic counter, read and written by cull shader
+        .write(frame_resources.cull_counts, resource_access::storage_write)
+        .write(frame_resources.cull_commands, resource_access::storage_write);
+
+    frame_graph
+        .add_pass("main",
+                  [this](vk::raii::CommandBuffer& cmd_buf)
+                  {
+                      begin_render_pass(cmd_buf);
+                      execute_secondaries(cmd_buf);
+                      cmd_buf.endRendering();
+                  })
+        // vkCmdDrawIndexedIndirectCount of culled meshes
+        .read(frame_resources.cull_commands, resource_access::indirect_read)
+        .read(frame_resources.cull_counts, resource_access::indirect_read)
+        .write(frame_resources.color, resource_access::color_attachment)
+        .write(frame_resources.depth, resource_access::depth_attachment)
+        // msaa resolve target
+        .write(frame_resources.swapchain, resource_access::color_attachment);
+
+    frame_graph.compile();
+
+    const auto& stats = frame_graph.get_statistics();
+    log << "frame graph: passes: " << stats.passes
+        << " culled: " << stats.culled_passes
+        << " barriers: " << stats.barriers
+        << " transient images: " << stats.transient_images
+        << " memory blocks: " << stats.memory_blocks
+        << " memory: " << stats.allocated_bytes << " of "
+        << stats.transient_bytes << " bytes\n";
+}
 
-    std::tie(depth_image, depth_image_memory) =
-        create_image(swapchain_image_extent.width,
-                     swapchain_image_extent.height,
-                     depth_format,
-                     vk::ImageTiling::eOptimal,
-                     vk::ImageUsageFlagBits::eDepthStencilAttachment,
-                     vk::MemoryPropertyFlagBits::eDeviceLocal,
-                     1, // miplevels
-                     msaa_samples);
-    depth_image_view = create_image_view(
-        depth_image, depth_format, vk::ImageAspectFlagBits::eDepth);
+void render::create_compute_graph()
+{
+    // buffers only, so graph needs no device
+    compute_graph = render_graph{};
+
+    compute_resources.particles_in =
+        compute_graph.import_buffer({ .name = "particles_last_frame" });
+    // particle draw reads it after graphics submit waits compute signal
+    compute_resources.particles_out = compute_graph.import_buffer({
+        .name         = "particles_current_frame",
+        .final_access = resource_access::vertex_read,
+    });
+
+    compute_graph
+        .add_pass("particles_update",
+                  [this](vk::raii::CommandBuffer& cmd_buf)
+                  {
+                      record_compute_commands(cmd_buf,
+                                              current_frame,
+                                              frame_particles.ubo_offset,
+                                              *frame_particles.parts);
+                  })
+        .read(compute_resources.particles_in, resource_access::storage_read)
+        .write(compute_resources.particles_out,
+               resource_access::storage_write);
+
+    compute_graph.compile();
 }
 
 void render::create_command_buffers()
@@ -3166,6 +4324,46 @@ void render::create_command_buffers()
     }
 }
 
+void render::create_secondary_command_buffers()
+{
+    log << "create secondary command buffers for "
+        << hints_.recording_threads << " recording threads\n";
+
+    recorders.clear();
+    // + frame thread recorder, see frame_recorder_index()
+    recorders.resize(hints_.recording_threads + 1u);
+
+    for (std::uint32_t thread = 0; auto& recorder : recorders)
+    {
+        for (std::uint32_t frame = 0; frame < max_frames_in_flight; ++frame)
+        {
+            vk::CommandPoolCreateInfo pool_info{
+                // buffers recorded once per frame, whole pool reset together
+                .flags            = vk::CommandPoolCreateFlagBits::eTransient,
+                .queueFamilyIndex = queue_family.index.graphics,
+            };
+
+            auto& pool = recorder.command_pools.emplace_back(devices.logical,
+                                                             pool_info);
+
+            vk::CommandBufferAllocateInfo alloc_info{
+                .commandPool        = pool,
+                .level              = vk::CommandBufferLevel::eSecondary,
+                .commandBufferCount = 1u,
+            };
+
+            recorder.command_buffers.emplace_back(std::move(
+                devices.logical.allocateCommandBuffers(alloc_info).front()));
+
+            auto suffix = std::to_string(thread) + '_' + std::to_string(frame);
+            set_object_name(*pool, "secondary_cmd_pool_" + suffix);
+            set_object_name(*recorder.command_buffers.back(),
+                            "secondary_command_buffer_" + suffix);
+        }
+        ++thread;
+    }
+}
+
 void render::create_compute_command_buffers()
 {
     vk::CommandBufferAllocateInfo alloc_info{
@@ -3203,98 +4401,43 @@ void render::create_timeline_semaphore()
 
 void render::record_compute_commands(vk::raii::CommandBuffer& cmd_buf,
                                      std::uint32_t            frame_index,
+                                     std::uint32_t            ubo_offset,
                                      const particles&         parts)
 {
-    cmd_buf.begin({});
-
     cmd_buf.bindPipeline(vk::PipelineBindPoint::eCompute, compute_pipeline);
     cmd_buf.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
                                compute_pipeline_layout,
                                0,
                                *compute_descriptor_sets[frame_index],
-                               nullptr);
+                               ubo_offset); // dynamic offset in frame arena
 
     const std::uint32_t particle_count = parts.get_count();
     const std::uint32_t group_count =
         (particle_count + compute_workgroup_size - 1u) / compute_workgroup_size;
     cmd_buf.dispatch(group_count, 1, 1);
-
-    const vk::BufferMemoryBarrier2 storage_barrier{
-        .srcStageMask  = vk::PipelineStageFlagBits2::eComputeShader,
-        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
-        .dstStageMask  = vk::PipelineStageFlagBits2::eVertexAttributeInput,
-        .dstAccessMask = vk::AccessFlagBits2::eVertexAttributeRead,
-        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .buffer              = parts.get_write_buffer(frame_index),
-        .offset              = 0,
-        .size                = sizeof(particle) * particle_count,
-    };
-
-    const vk::DependencyInfo dependency_info{
-        .bufferMemoryBarrierCount = 1u,
-        .pBufferMemoryBarriers    = &storage_barrier,
-    };
-    cmd_buf.pipelineBarrier2(dependency_info);
-
-    cmd_buf.end();
 }
 
-void render::begin_render_pass(vk::raii::CommandBuffer& cmd_buf,
-                               std::uint32_t            image_index)
-{
-    // Multisampled color target (resolved to swapchain after rendering).
-    transition_image_layout(cmd_buf,
-                            *color_image,
-                            vk::ImageLayout::eUndefined,
-                            {},
-                            vk::PipelineStageFlagBits2::eTopOfPipe,
-                            vk::ImageLayout::eColorAttachmentOptimal,
-                            vk::AccessFlagBits2::eColorAttachmentWrite,
-                            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-                            vk::ImageAspectFlagBits::eColor);
-
-    // Single-sampled swapchain image used as MSAA resolve target.
-    transition_image_layout(cmd_buf,
-                            swapchain_images[image_index],
-                            vk::ImageLayout::eUndefined,
-                            {},
-                            vk::PipelineStageFlagBits2::eTopOfPipe,
-                            vk::ImageLayout::eColorAttachmentOptimal,
-                            vk::AccessFlagBits2::eColorAttachmentWrite,
-                            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-                            vk::ImageAspectFlagBits::eColor);
-
-    // Transition depth image to depth attachment optimal layout
-    transition_image_layout(cmd_buf,
-                            *depth_image,
-                            vk::ImageLayout::eUndefined,
-                            vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
-                            vk::PipelineStageFlagBits2::eEarlyFragmentTests |
-                                vk::PipelineStageFlagBits2::eLateFragmentTests,
-                            vk::ImageLayout::eDepthAttachmentOptimal,
-                            vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
-                            vk::PipelineStageFlagBits2::eEarlyFragmentTests |
-                                vk::PipelineStageFlagBits2::eLateFragmentTests,
-                            vk::ImageAspectFlagBits::eDepth);
-
+void render::begin_render_pass(vk::raii::CommandBuffer& cmd_buf)
+{
+    // layout transitions of attachments recorded by frame_graph
     vk::ClearValue clear_color =
         vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f); // BGRA?
     vk::ClearValue clear_depth =
         vk::ClearDepthStencilValue(1.0f, // 1.0f - far view plane
                                    0u);
     vk::RenderingAttachmentInfo color_attachment_info = {
-        .imageView          = color_image_view,
-        .imageLayout        = vk::ImageLayout::eColorAttachmentOptimal,
-        .resolveMode        = vk::ResolveModeFlagBits::eAverage,
-        .resolveImageView   = swapchain_image_views[image_index],
+        .imageView   = frame_graph.get_image_view(frame_resources.color),
+        .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+        .resolveMode = vk::ResolveModeFlagBits::eAverage,
+        .resolveImageView =
+            frame_graph.get_image_view(frame_resources.swapchain),
         .resolveImageLayout = vk::ImageLayout::eColorAttachmentOptimal,
         .loadOp             = vk::AttachmentLoadOp::eClear,
         .storeOp            = vk::AttachmentStoreOp::eDontCare,
         .clearValue         = clear_color,
     };
     vk::RenderingAttachmentInfo depth_attachment_info = {
-        .imageView   = depth_image_view,
+        .imageView   = frame_graph.get_image_view(frame_resources.depth),
         .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
         .loadOp      = vk::AttachmentLoadOp::eClear,
         .storeOp     = vk::AttachmentStoreOp::eDontCare,
@@ -3302,9 +4445,11 @@ void render::begin_render_pass(vk::raii::CommandBuffer& cmd_buf,
     };
 
     vk::RenderingInfo rendering_info = {
-        .renderArea           = { .offset = { .x = 0, .y = 0 },
-                                  .extent = swapchain_image_extent },
-        .layerCount           = 1,
+        // all draws recorded into secondary buffers, see begin_secondary()
+        .flags      = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers,
+        .renderArea = { .offset = { .x = 0, .y = 0 },
+                        .extent = swapchain_image_extent },
+        .layerCount = 1,
         .colorAttachmentCount = 1,
         .pColorAttachments    = &color_attachment_info,
         .pDepthAttachment     = &depth_attachment_info
@@ -3313,8 +4458,80 @@ void render::begin_render_pass(vk::raii::CommandBuffer& cmd_buf,
     cmd_buf.beginRendering(rendering_info);
 }
 
+vk::raii::CommandBuffer& render::begin_secondary(std::uint32_t thread_index)
+{
+    secondary_recorder& recorder = recorders[thread_index];
+    vk::raii::CommandBuffer& cmd_buf =
+        recorder.command_buffers[current_frame];
+
+    if (recorder.recording)
+    {
+        return cmd_buf;
+    }
+
+    // secondary buffer has to know attachments of primary dynamic rendering
+    const vk::CommandBufferInheritanceRenderingInfo rendering_info{
+        .colorAttachmentCount    = 1u,
+        .pColorAttachmentFormats = &swapchain_image_format,
+        .depthAttachmentFormat   = depth_format,
+        .rasterizationSamples    = msaa_samples,
+    };
+
+    const vk::CommandBufferInheritanceInfo inheritance_info{
+        .pNext = &rendering_info,
+    };
+
+    const vk::CommandBufferBeginInfo begin_info{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit |
+                 vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+        .pInheritanceInfo = &inheritance_info,
+    };
+
+    cmd_buf.begin(begin_info);
+    recorder.recording = true;
+    return cmd_buf;
+}
+
+void render::execute_secondaries(vk::raii::CommandBuffer& cmd_buf)
+{
+    std::vector<vk::CommandBuffer> secondaries;
+    secondaries.reserve(recorders.size());
+
+    for (auto& recorder : recorders)
+    {
+        if (!recorder.recording)
+        {
+            continue;
+        }
+        auto& secondary = recorder.command_buffers[current_frame];
+        secondary.end();
+        secondaries.push_back(*secondary);
+        recorder.recording = false;
+    }
+
+    if (!secondaries.empty())
+    {
+        cmd_buf.executeCommands(secondaries);
+    }
+}
+
 void render::record_mesh_commands(vk::raii::CommandBuffer& cmd_buf,
-                                  vk::raii::DescriptorSet& descriptor_set,
+                                  vk::DescriptorSet        descriptor_set,
+                                  std::uint32_t            ubo_offset,
+                                  const mesh&              mesh)
+{
+    record_mesh_bindings(cmd_buf, descriptor_set, ubo_offset, mesh);
+    cmd_buf.drawIndexed(mesh.get_index_count(), // index count
+                        1,                      // instance count
+                        0,                      // first index used as offset
+                        0,                      // vertex offset
+                        0                       // first instance used as offset
+    );
+}
+
+void render::record_mesh_bindings(vk::raii::CommandBuffer& cmd_buf,
+                                  vk::DescriptorSet        descriptor_set,
+                                  std::uint32_t            ubo_offset,
                                   const mesh&              mesh)
 {
     cmd_buf.bindPipeline(vk::PipelineBindPoint::eGraphics, graphics_pipeline);
@@ -3347,14 +4564,34 @@ void render::record_mesh_commands(vk::raii::CommandBuffer& cmd_buf,
     cmd_buf.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
                                pipeline_layout,
                                0, // first set index in array
-                               *descriptor_set,
-                               nullptr);
-    cmd_buf.drawIndexed(mesh.get_index_count(), // index count
-                        1,                      // instance count
-                        0,                      // first index used as offset
-                        0,                      // vertex offset
-                        0                       // first instance used as offset
-    );
+                               descriptor_set,
+                               ubo_offset); // dynamic offset in frame arena
+}
+
+void render::record_cull_reset(vk::raii::CommandBuffer& cmd_buf,
+                               std::uint32_t            frame_index,
+                               const culled_mesh&       objects)
+{
+    const vk::Buffer count_buffer = objects.count_buffers_[frame_index];
+    cmd_buf.fillBuffer(count_buffer, 0u, sizeof(std::uint32_t), 0u);
+}
+
+void render::record_cull_commands(vk::raii::CommandBuffer& cmd_buf,
+                                  std::uint32_t            frame_index,
+                                  std::uint32_t            ubo_offset,
+                                  const culled_mesh&       objects)
+{
+    // barriers around dispatch derived by frame_graph, see "cull" pass
+    cmd_buf.bindPipeline(vk::PipelineBindPoint::eCompute, cull_pipeline);
+    cmd_buf.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                               cull_pipeline_layout,
+                               0,
+                               *objects.descriptor_sets_[frame_index],
+                               ubo_offset);
+
+    const std::uint32_t group_count =
+        (objects.get_count() + cull_workgroup_size - 1u) / cull_workgroup_size;
+    cmd_buf.dispatch(group_count, 1, 1);
 }
 
 void render::record_particle_commands(vk::raii::CommandBuffer& cmd_buf,
@@ -3386,56 +4623,6 @@ void render::record_particle_commands(vk::raii::CommandBuffer& cmd_buf,
                  0);                // first instance
 }
 
-void render::end_render_pass(vk::raii::CommandBuffer& cmd_buf,
-                             std::uint32_t            image_index)
-{
-    cmd_buf.endRendering();
-    // After rendering, transition the swapchain image to ePresentSrcKHR
-    transition_image_layout(cmd_buf,
-                            swapchain_images[image_index],
-                            vk::ImageLayout::eColorAttachmentOptimal,
-                            vk::AccessFlagBits2::eColorAttachmentWrite,
-                            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-                            vk::ImageLayout::ePresentSrcKHR,
-                            {},
-                            vk::PipelineStageFlagBits2::eBottomOfPipe,
-                            vk::ImageAspectFlagBits::eColor);
-
-    cmd_buf.end();
-}
-
-void render::transition_image_layout(vk::raii::CommandBuffer& cmd_buf,
-                                     vk::Image                image,
-                                     vk::ImageLayout          old_layout,
-                                     vk::AccessFlags2         src_access_mask,
-                                     vk::PipelineStageFlags2  src_stage_mask,
-                                     vk::ImageLayout          new_layout,
-                                     vk::AccessFlags2         dst_access_mask,
-                                     vk::PipelineStageFlags2  dst_stage_mask,
-                                     vk::ImageAspectFlags image_aspect_flags)
-{
-    vk::ImageMemoryBarrier2 barrier = {
-        .srcStageMask        = src_stage_mask,
-        .srcAccessMask       = src_access_mask,
-        .dstStageMask        = dst_stage_mask,
-        .dstAccessMask       = dst_access_mask,
-        .oldLayout           = old_layout,
-        .newLayout           = new_layout,
-        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .image               = image,
-        .subresourceRange    = { .aspectMask     = image_aspect_flags,
-                                 .baseMipLevel   = 0,
-                                 .levelCount     = 1,
-                                 .baseArrayLayer = 0,
-                                 .layerCount     = 1 }
-    };
-    vk::DependencyInfo dependencyInfo = { .dependencyFlags         = {},
-                                          .imageMemoryBarrierCount = 1,
-                                          .pImageMemoryBarriers    = &barrier };
-    cmd_buf.pipelineBarrier2(dependencyInfo);
-}
-
 void render::create_synchronization_objects()
 {
     sync.semaphore.render_finished.clear();
@@ -3479,7 +4666,7 @@ void render::create_compute_descriptor_pool()
 {
     std::array<vk::DescriptorPoolSize, 2> pool_sizes{
         vk::DescriptorPoolSize{
-            .type            = vk::DescriptorType::eUniformBuffer,
+            .type            = vk::DescriptorType::eUniformBufferDynamic,
             .descriptorCount = max_frames_in_flight,
         },
         vk::DescriptorPoolSize{
@@ -3513,28 +4700,6 @@ void render::create_compute_descriptor_sets()
         devices.logical.allocateDescriptorSets(alloc_info);
 }
 
-void render::create_color_resources()
-{
-    vk::Format color_format = swapchain_image_format;
-
-    std::tie(color_image, color_image_memory) =
-        create_image(swapchain_image_extent.width,
-                     swapchain_image_extent.height,
-                     color_format,
-                     vk::ImageTiling::eOptimal,
-                     vk::ImageUsageFlagBits::eTransientAttachment |
-                         vk::ImageUsageFlagBits::eColorAttachment,
-                     vk::MemoryPropertyFlagBits::eDeviceLocal,
-                     1, // miplevels
-                     msaa_samples);
-
-    color_image_view = create_image_view(color_image,
-                                         color_format,
-                                         vk::ImageAspectFlagBits::eColor,
-                                         1 // miplevels
-    );
-}
-
 vk::Extent2D render::choose_best_swapchain_image_resolution(
     const vk::SurfaceCapabilitiesKHR& capabilities)
 {
@@ -3635,9 +4800,15 @@ render::swapchain_details_t render::get_swapchain_details(
 vk::raii::ImageView render::create_image_view(vk::Image            image,
                                               vk::Format           format,
                                               vk::ImageAspectFlags aspect_flags,
-                                              std::uint8_t mip_levels) const
+                                              std::uint8_t         mip_levels,
+                                              vk::ImageUsageFlags  usage) const
 {
+    // restrict view usage, image with extended usage may have usage
+    // not supported by view format (storage for srgb)
+    vk::ImageViewUsageCreateInfo usage_info{ .usage = usage };
+
     vk::ImageViewCreateInfo info{
+        .pNext            = usage ? &usage_info : nullptr,
         .image            = image,
         .viewType         = vk::ImageViewType::e2D,
         .format           = format,
@@ -3655,6 +4826,144 @@ vk::raii::ImageView render::create_image_view(vk::Image            image,
     return { devices.logical, info };
 }
 
+void render::start_shader_watcher()
+{
+    shader_reload.entries = {
+        { .path       = graphics_shader_path,
+          .debug_name = "om_graphics_pipeline",
+          .target     = &graphics_pipeline,
+          .build      = &render::build_graphics_pipeline },
+        { .path       = particle_shader_path,
+          .debug_name = "om_particle_graphics_pipeline",
+          .target     = &particle_graphics_pipeline,
+          .build      = &render::build_particle_graphics_pipeline },
+        { .path       = compute_shader_path,
+          .debug_name = "om_compute_pipeline",
+          .target     = &compute_pipeline,
+          .build      = &render::build_compute_pipeline },
+        { .path       = cull_shader_path,
+          .debug_name = "om_cull_pipeline",
+          .target     = &cull_pipeline,
+          .build      = &render::build_cull_pipeline },
+        { .path       = mip_shader_path,
+          .debug_name = "om_mip_pipeline",
+          .target     = &mip_pipeline,
+          .build      = &render::build_mip_pipeline },
+    };
+
+    for (auto& entry : shader_reload.entries)
+    {
+        std::error_code err;
+        entry.last_write_time =
+            std::filesystem::last_write_time(entry.path, err);
+    }
+
+    shader_reload.thread =
+        std::jthread([this](std::stop_token stop) { watch_shaders(stop); });
+
+    log << "start shader hot reload watcher\n";
+}
+
+void render::watch_shaders(std::stop_token stop)
+{
+    using namespace std::chrono_literals;
+
+    constexpr std::uint32_t spir_v_magic = 0x07230203u;
+
+    std::mutex                  sleep_mutex;
+    std::condition_variable_any sleep;
+
+    while (!stop.stop_requested())
+    {
+        for (auto& entry : shader_reload.entries)
+        {
+            std::error_code err;
+            auto            write_time =
+                std::filesystem::last_write_time(entry.path, err);
+            if (err || write_time == entry.last_write_time)
+            {
+                continue;
+            }
+            entry.last_write_time = write_time;
+
+            // build under lock so recreate_swapchain() can't change formats,
+            // main thread only try_lock it, so frames are never blocked
+            std::lock_guard lock{ shader_reload.mutex };
+            try
+            {
+                auto content = platform.get_file_content(
+                    entry.path, platform_interface::file_access::reloadable);
+                auto spir_v  = content.as_span();
+
+                // slangc may still write file, next change will be caught
+                std::uint32_t magic = 0u;
+                if (spir_v.size() < sizeof(magic) ||
+                    spir_v.size() % sizeof(magic) != 0)
+                {
+                    throw std::runtime_error("error: bad SPIR-V size");
+                }
+                std::memcpy(&magic, spir_v.data(), sizeof(magic));
+                if (magic != spir_v_magic)
+                {
+                    throw std::runtime_error("error: bad SPIR-V magic");
+                }
+
+                vk::raii::Pipeline pipeline = (this->*entry.build)(spir_v);
+                set_object_name(*pipeline, entry.debug_name);
+
+                // newer build replaces not yet applied one
+                std::erase_if(shader_reload.ready,
+                              [&entry](const reloaded_pipeline& r)
+                              { return r.target == entry.target; });
+                shader_reload.ready.push_back(
+                    { .target = entry.target, .pipeline = std::move(pipeline) });
+                shader_reload.messages.push_back(
+                    "rebuild pipeline " + entry.debug_name + " from " +
+                    std::string(entry.path));
+            }
+            catch (const std::exception& ex)
+            {
+                shader_reload.messages.push_back(
+                    "error: can't rebuild pipeline " + entry.debug_name +
+                    " keep previous one, cause: " + ex.what());
+            }
+        }
+
+        std::unique_lock lock{ sleep_mutex };
+        sleep.wait_for(lock, stop, 250ms, [] { return false; });
+    }
+}
+
+void render::apply_reloaded_pipelines()
+{
+    // pipeline can be destroyed only after all frames using it finished
+    std::erase_if(shader_reload.retired,
+                  [this](const retired_pipeline& r) {
+                      return r.frame_number + max_frames_in_flight <=
+                             frame_number_;
+                  });
+
+    std::unique_lock lock{ shader_reload.mutex, std::try_to_lock };
+    if (!lock.owns_lock())
+    {
+        return; // watcher is building, take result next frame
+    }
+
+    for (const auto& message : shader_reload.messages)
+    {
+        log << message << '\n';
+    }
+    shader_reload.messages.clear();
+
+    for (auto& [target, pipeline] : shader_reload.ready)
+    {
+        std::swap(*target, pipeline);
+        shader_reload.retired.push_back(
+            { .frame_number = frame_number_, .pipeline = std::move(pipeline) });
+    }
+    shader_reload.ready.clear();
+}
+
 vk::raii::ShaderModule render::create_shader(std::span<const std::byte> spir_v)
 {
     vk::ShaderModuleCreateInfo create_info{
@@ -3748,14 +5057,138 @@ image::image(render&               r,
              std::filesystem::path path,
              std::string           dbg_name,
              bool                  generate_mip_levels)
+    : path_{ std::move(path) }
+    , dbg_name_{ std::move(dbg_name) }
+    , generate_mip_levels_{ generate_mip_levels }
+    , render_{ &r }
+{
+    upload(r);
+
+    vk::PhysicalDeviceProperties properties =
+        r.devices.physical.getProperties();
+
+    vk::SamplerCreateInfo sampler_info{
+        .magFilter               = vk::Filter::eLinear,
+        .minFilter               = vk::Filter::eLinear,
+        .mipmapMode              = vk::SamplerMipmapMode::eLinear,
+        .addressModeU            = vk::SamplerAddressMode::eRepeat,
+        .addressModeV            = vk::SamplerAddressMode::eRepeat,
+        .addressModeW            = vk::SamplerAddressMode::eRepeat,
+        .mipLodBias              = 0.0f,
+        .anisotropyEnable        = vk::True,
+        .maxAnisotropy           = properties.limits.maxSamplerAnisotropy,
+        .compareEnable           = vk::False,
+        .compareOp               = vk::CompareOp::eAlways,
+        .minLod                  = 0.0f,
+        .maxLod                  = vk::LodClampNone,
+        .borderColor             = vk::BorderColor::eIntOpaqueBlack,
+        .unnormalizedCoordinates = vk::False
+    };
+
+    img_sampler = vk::raii::Sampler(r.devices.logical, sampler_info);
+
+    descriptor_set = r.allocate_image_descriptor_set();
+    r.write_image_descriptor(*this);
+
+    residency_id = r.register_resident(
+        this, img.getMemoryRequirements().size, dbg_name_);
+}
+
+image::image(image&& other) noexcept
+    : img{ std::move(other.img) }
+    , img_memory{ std::move(other.img_memory) }
+    , img_view{ std::move(other.img_view) }
+    , img_sampler{ std::move(other.img_sampler) }
+    , mip_levels{ other.mip_levels }
+    , descriptor_set{ std::move(other.descriptor_set) }
+    , path_{ std::move(other.path_) }
+    , dbg_name_{ std::move(other.dbg_name_) }
+    , generate_mip_levels_{ other.generate_mip_levels_ }
+    , render_{ std::exchange(other.render_, nullptr) }
+    , residency_id{ std::exchange(other.residency_id, 0u) }
+{
+    if (render_ != nullptr)
+    {
+        render_->rebind_resident(residency_id, this);
+    }
+}
+
+image& image::operator=(image&& other) noexcept
+{
+    if (this != &other)
+    {
+        cleanup();
+        img                  = std::move(other.img);
+        img_memory           = std::move(other.img_memory);
+        img_view             = std::move(other.img_view);
+        img_sampler          = std::move(other.img_sampler);
+        mip_levels           = other.mip_levels;
+        descriptor_set       = std::move(other.descriptor_set);
+        path_                = std::move(other.path_);
+        dbg_name_            = std::move(other.dbg_name_);
+        generate_mip_levels_ = other.generate_mip_levels_;
+        render_              = std::exchange(other.render_, nullptr);
+        residency_id         = std::exchange(other.residency_id, 0u);
+        if (render_ != nullptr)
+        {
+            render_->rebind_resident(residency_id, this);
+        }
+    }
+    return *this;
+}
+
+image::~image()
+{
+    cleanup();
+}
+
+void image::cleanup() noexcept
 {
-    std::string path_str = path.generic_string();
+    if (render_ != nullptr)
+    {
+        render_->unregister_resident(std::exchange(residency_id, 0u));
+        render_ = nullptr;
+    }
+    evict();
+    descriptor_set.clear();
+    img_sampler.clear();
+}
+
+void image::evict() noexcept
+{
+    img_view.clear();
+    img.clear();
+    img_memory.clear();
+}
+
+void image::restore(render& r)
+{
+    upload(r);
+    // new image view, set is not bound by any frame while image evicted
+    r.write_image_descriptor(*this);
+}
+
+void image::upload(render& r)
+{
+    const bool  generate_mip_levels = generate_mip_levels_;
+    const auto& path                = path_;
+    std::string path_str            = path.generic_string();
     int         width    = 0;
     int         height   = 0;
     int         channels = 0;
 
-    stbi_uc* pixels =
-        stbi_load(path_str.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    // decode straight from mapped file, no stdio buffer and heap file copy
+    platform_interface::content file = r.platform.get_file_content(
+        path_str, platform_interface::file_access::read_only);
+    auto                        file_bytes = file.as_span();
+
+    stbi_uc* pixels = stbi_load_from_memory(
+        reinterpret_cast<const stbi_uc*>(file_bytes.data()),
+        static_cast<int>(file_bytes.size()),
+        &width,
+        &height,
+        &channels,
+        STBI_rgb_alpha);
 
     if (!pixels)
     {
@@ -3808,16 +5241,31 @@ image::image(render&               r,
                          .height = static_cast<uint32_t>(height),
                          .depth  = 1u };
 
+    vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eTransferSrc | // mips
+                                vk::ImageUsageFlagBits::eTransferDst |
+                                vk::ImageUsageFlagBits::eSampled;
+    vk::ImageCreateFlags flags{};
+
+    // compute mip generation writes srgb image through unorm storage views
+    if (generate_mip_levels &&
+        r.compute_mipmaps_supported(
+            vk::Format::eR8G8B8A8Srgb, extent.width, extent.height))
+    {
+        usage |= vk::ImageUsageFlagBits::eStorage;
+        flags |= vk::ImageCreateFlagBits::eMutableFormat |
+                 vk::ImageCreateFlagBits::eExtendedUsage;
+    }
+
     std::tie(img, img_memory) =
         r.create_image(extent.width,
                        extent.height,
                        vk::Format::eR8G8B8A8Srgb,
                        vk::ImageTiling::eOptimal,
-                       vk::ImageUsageFlagBits::eTransferSrc | // for mip_levels
-                           vk::ImageUsageFlagBits::eTransferDst |
-                           vk::ImageUsageFlagBits::eSampled,
+                       usage,
                        vk::MemoryPropertyFlagBits::eDeviceLocal,
-                       mip_levels);
+                       mip_levels,
+                       vk::SampleCountFlagBits::e1,
+                       flags);
 
     r.transition_image_layout(vk::ImageLayout::eUndefined,
                               img,
@@ -3846,30 +5294,8 @@ image::image(render&               r,
     img_view = r.create_image_view(img,
                                    vk::Format::eR8G8B8A8Srgb,
                                    vk::ImageAspectFlagBits::eColor,
-                                   mip_levels);
-
-    vk::PhysicalDeviceProperties properties =
-        r.devices.physical.getProperties();
-
-    vk::SamplerCreateInfo sampler_info{
-        .magFilter               = vk::Filter::eLinear,
-        .minFilter               = vk::Filter::eLinear,
-        .mipmapMode              = vk::SamplerMipmapMode::eLinear,
-        .addressModeU            = vk::SamplerAddressMode::eRepeat,
-        .addressModeV            = vk::SamplerAddressMode::eRepeat,
-        .addressModeW            = vk::SamplerAddressMode::eRepeat,
-        .mipLodBias              = 0.0f,
-        .anisotropyEnable        = vk::True,
-        .maxAnisotropy           = properties.limits.maxSamplerAnisotropy,
-        .compareEnable           = vk::False,
-        .compareOp               = vk::CompareOp::eAlways,
-        .minLod                  = 0.0f,
-        .maxLod                  = vk::LodClampNone,
-        .borderColor             = vk::BorderColor::eIntOpaqueBlack,
-        .unnormalizedCoordinates = vk::False
-    };
-
-    img_sampler = vk::raii::Sampler(r.devices.logical, sampler_info);
+                                   mip_levels,
+                                   vk::ImageUsageFlagBits::eSampled);
 }
 
 uint32_t render::find_mem_type_index(
@@ -3914,10 +5340,226 @@ void render::create_buffer(vk::DeviceSize          size,
                                         properties,
                                         devices.physical.getMemoryProperties()),
     };
-    bufferMemory = vk::raii::DeviceMemory(devices.logical, allocInfo);
+    bufferMemory = allocate_device_memory(allocInfo, properties);
     buffer.bindMemory(*bufferMemory, 0);
 }
 
+render::memory_budget render::query_memory_budget() const
+{
+    if (hints_.device_memory_budget != 0u)
+    {
+        return { .usage  = residency.resident_bytes,
+                 .budget = hints_.device_memory_budget };
+    }
+
+    if (!residency.ext_memory_budget)
+    {
+        // only meshes and images counted, rest of heap left for swapchain,
+        // frame graph attachments and other allocations
+        return { .usage  = residency.resident_bytes,
+                 .budget = residency.device_heap_size / 10u * 8u };
+    }
+
+    // budget and usage of whole process reported by driver, including
+    // memory of other allocations and other processes pressure
+    const auto chain = devices.physical.getMemoryProperties2<
+        vk::PhysicalDeviceMemoryProperties2,
+        vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+    const vk::PhysicalDeviceMemoryProperties& properties =
+        chain.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+    const auto& heaps =
+        chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+    memory_budget result;
+    for (std::uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+    {
+        if (properties.memoryHeaps[i].flags &
+            vk::MemoryHeapFlagBits::eDeviceLocal)
+        {
+            result.usage += heaps.heapUsage[i];
+            result.budget += heaps.heapBudget[i];
+        }
+    }
+    return result;
+}
+
+vk::raii::DeviceMemory render::allocate_device_memory(
+    const vk::MemoryAllocateInfo& alloc_info,
+    vk::MemoryPropertyFlags       properties)
+{
+    if (!(properties & vk::MemoryPropertyFlagBits::eDeviceLocal))
+    {
+        return vk::raii::DeviceMemory(devices.logical, alloc_info);
+    }
+
+    std::scoped_lock lock(residency.mutex);
+    evict_resources(alloc_info.allocationSize, false);
+    try
+    {
+        return vk::raii::DeviceMemory(devices.logical, alloc_info);
+    }
+    catch (const vk::OutOfDeviceMemoryError&)
+    {
+        log << "warning: out of device memory allocating "
+            << alloc_info.allocationSize
+            << " bytes, evict resources not used by current frame\n";
+    }
+    // frames in flight may use evicted resources, after wait only current
+    // frame (not submitted yet) uses them
+    devices.logical.waitIdle();
+    evict_resources(alloc_info.allocationSize, true);
+    return vk::raii::DeviceMemory(devices.logical, alloc_info);
+}
+
+std::uint64_t render::register_resident(resident_owner owner,
+                                        vk::DeviceSize size,
+                                        std::string    name)
+{
+    std::scoped_lock lock(residency.mutex);
+    const std::uint64_t id = residency.next_id++;
+    residency.lru.push_back({ .owner           = owner,
+                              .size            = size,
+                              .last_used_frame = frame_number_,
+                              .resident        = true,
+                              .name            = std::move(name) });
+    residency.entries.emplace(id, std::prev(residency.lru.end()));
+    residency.resident_bytes += size;
+    return id;
+}
+
+void render::rebind_resident(std::uint64_t id, resident_owner owner)
+{
+    std::scoped_lock lock(residency.mutex);
+    residency.entries.at(id)->owner = owner;
+}
+
+void render::unregister_resident(std::uint64_t id) noexcept
+{
+    std::scoped_lock lock(residency.mutex);
+    auto it = residency.entries.find(id);
+    if (it == residency.entries.end())
+    {
+        return;
+    }
+    if (it->second->resident)
+    {
+        residency.resident_bytes -= it->second->size;
+    }
+    residency.lru.erase(it->second);
+    residency.entries.erase(it);
+}
+
+bool render::make_resident(std::uint64_t id)
+{
+    if (id == 0u)
+    {
+        return true;
+    }
+
+    std::scoped_lock lock(residency.mutex);
+    auto entry = residency.entries.at(id);
+    // most recently used goes to back, so front is eviction candidate
+    residency.lru.splice(residency.lru.end(), residency.lru, entry);
+    entry->last_used_frame = frame_number_;
+    if (entry->resident)
+    {
+        return true;
+    }
+
+    // may be worker thread, which must not submit or wait queues used by
+    // frame thread, so only remember miss
+    if (std::ranges::find(residency.misses, id) == residency.misses.end())
+    {
+        residency.misses.push_back(id);
+    }
+    return false;
+}
+
+void render::restore_missing()
+{
+    std::scoped_lock lock(residency.mutex);
+    for (const std::uint64_t id : std::exchange(residency.misses, {}))
+    {
+        auto it = residency.entries.find(id);
+        if (it == residency.entries.end() || it->second->resident)
+        {
+            continue; // destroyed or restored after miss
+        }
+        auto entry = it->second;
+        // drawn again this frame, so allocations below do not evict it
+        residency.lru.splice(residency.lru.end(), residency.lru, entry);
+        entry->last_used_frame = frame_number_;
+
+        // restore uploads synchronously, allocation evicts other data if
+        // needed
+        try
+        {
+            std::visit([this](auto* owner) { owner->restore(*this); },
+                       entry->owner);
+        }
+        catch (const vk::OutOfDeviceMemoryError& ex)
+        {
+            std::visit([](auto* owner) { owner->evict(); }, entry->owner);
+            log << "warning: can't restore " << entry->name
+                << ", draws skipped: " << ex.what() << '\n';
+            continue;
+        }
+        entry->resident = true;
+        residency.resident_bytes += entry->size;
+        ++residency.restored;
+        log << "residency: restored " << entry->name << " (" << entry->size
+            << " bytes), restored total: " << residency.restored << '\n';
+    }
+}
+
+void render::evict_resources(vk::DeviceSize size, bool gpu_idle)
+{
+    // caller holds residency.mutex
+    const memory_budget budget = query_memory_budget();
+    vk::DeviceSize      usage  = budget.usage;
+    vk::DeviceSize      freed  = 0u;
+
+    for (resident_resource& resource : residency.lru)
+    {
+        // gpu_idle: out of memory already, budget can't be trusted, evict
+        // until freed memory fits request
+        if (gpu_idle ? freed >= size : usage + size <= budget.budget)
+        {
+            return;
+        }
+        // list sorted by last use, so rest of it is used even later
+        const bool in_use =
+            gpu_idle ? frame_in_progress_ &&
+                           resource.last_used_frame == frame_number_
+                     : resource.last_used_frame + max_frames_in_flight >
+                           frame_number_;
+        if (in_use)
+        {
+            break;
+        }
+        if (!resource.resident)
+        {
+            continue;
+        }
+
+        std::visit([](auto* owner) { owner->evict(); }, resource.owner);
+        resource.resident = false;
+        residency.resident_bytes -= resource.size;
+        usage -= std::min(usage, resource.size);
+        freed += resource.size;
+        ++residency.evicted;
+        log << "residency: evicted " << resource.name << " ("
+            << resource.size << " bytes), evicted total: "
+            << residency.evicted << '\n';
+    }
+
+    if (!gpu_idle && usage + size > budget.budget)
+    {
+        log << "warning: over device memory budget, usage: " << usage
+            << " budget: " << budget.budget << " request: " << size << '\n';
+    }
+}
+
 std::pair<vk::raii::Image, vk::raii::DeviceMemory> render::create_image(
     std::uint32_t           width,
     std::uint32_t           height,
@@ -3926,11 +5568,12 @@ std::pair<vk::raii::Image, vk::raii::DeviceMemory> render::create_image(
     vk::ImageUsageFlags     usage,
     vk::MemoryPropertyFlags properties,
     std::uint8_t            mip_levels,
-    vk::SampleCountFlagBits num_samples)
+    vk::SampleCountFlagBits num_samples,
+    vk::ImageCreateFlags    flags)
 {
     vk::ImageCreateInfo img_info{
         .pNext       = nullptr,
-        .flags       = {},
+        .flags       = flags,
         .imageType   = vk::ImageType::e2D,
         .format      = format,
         .extent      = { .width = width, .height = height, .depth = 1 },
@@ -3957,29 +5600,277 @@ std::pair<vk::raii::Image, vk::raii::DeviceMemory> render::create_image(
                                 devices.physical.getMemoryProperties())
     };
     vk::raii::DeviceMemory image_memory =
-        vk::raii::DeviceMemory(devices.logical, alloc_info);
+        allocate_device_memory(alloc_info, properties);
     image.bindMemory(*image_memory, 0);
 
     return { std::move(image), std::move(image_memory) };
 }
 
+bool render::compute_mipmaps_supported(vk::Format    image_format,
+                                       std::uint32_t width,
+                                       std::uint32_t height) const
+{
+    // shader stores rgba8 unorm, srgb encoded in shader
+    if (image_format != vk::Format::eR8G8B8A8Srgb &&
+        image_format != vk::Format::eR8G8B8A8Unorm)
+    {
+        return false;
+    }
+
+    // last group reduces level 6 of at most 64x64 texels
+    if (std::max(width, height) > (1u << (mip_max_levels - 1u)))
+    {
+        return false;
+    }
+
+    vk::FormatProperties format_properties =
+        devices.physical.getFormatProperties(vk::Format::eR8G8B8A8Unorm);
+
+    return static_cast<bool>(format_properties.optimalTilingFeatures &
+                             vk::FormatFeatureFlagBits::eStorageImage);
+}
+
 void render::generate_mipmaps(vk::raii::Image& image,
                               vk::Format       image_format,
                               std::uint32_t    width,
                               std::uint32_t    height,
                               std::uint8_t     mip_levels)
 {
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
     // Check if image format supports linear blit-ing
     vk::FormatProperties format_properties =
         devices.physical.getFormatProperties(image_format);
 
-    if (!(format_properties.optimalTilingFeatures &
-          vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
+    const bool blit_supported =
+        static_cast<bool>(format_properties.optimalTilingFeatures &
+                          vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+    const bool compute_supported =
+        compute_mipmaps_supported(image_format, width, height);
+
+    if (!compute_supported)
     {
-        throw std::runtime_error(
-            "texture image format does not support linear blitting!");
+        if (!blit_supported)
+        {
+            throw std::runtime_error(
+                "error: texture image format does not support linear "
+                "blitting or compute mip generation");
+        }
+        generate_mipmaps_blit(image, width, height, mip_levels);
+        return;
+    }
+
+    vk::ImageLayout old_layout = vk::ImageLayout::eTransferDstOptimal;
+    milliseconds    blit_time{};
+
+    if (blit_supported && hints_.compare_mipmap_generation)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        generate_mipmaps_blit(image, width, height, mip_levels);
+        blit_time  = std::chrono::steady_clock::now() - start;
+        old_layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    generate_mipmaps_compute(
+        image, image_format, width, height, mip_levels, old_layout);
+    const milliseconds compute_time = std::chrono::steady_clock::now() - start;
+
+    log << "mipmaps " << width << 'x' << height
+        << " levels: " << static_cast<std::uint32_t>(mip_levels)
+        << " compute: " << compute_time.count() << " ms";
+    if (blit_time.count() > 0.0)
+    {
+        log << " blit: " << blit_time.count()
+            << " ms saved: " << (blit_time - compute_time).count() << " ms";
+    }
+    log << '\n';
+}
+
+void render::generate_mipmaps_compute(vk::raii::Image& image,
+                                      vk::Format       image_format,
+                                      std::uint32_t    width,
+                                      std::uint32_t    height,
+                                      std::uint8_t     mip_levels,
+                                      vk::ImageLayout  old_layout)
+{
+    std::vector<vk::raii::ImageView> views;
+    views.reserve(mip_levels);
+    for (std::uint32_t level = 0; level < mip_levels; ++level)
+    {
+        vk::ImageViewUsageCreateInfo usage_info{
+            .usage = vk::ImageUsageFlagBits::eStorage,
+        };
+        vk::ImageViewCreateInfo view_info{
+            .pNext            = &usage_info,
+            .image            = *image,
+            .viewType         = vk::ImageViewType::e2D,
+            .format           = vk::Format::eR8G8B8A8Unorm,
+            .subresourceRange = { .aspectMask = vk::ImageAspectFlagBits::eColor,
+                                  .baseMipLevel   = level,
+                                  .levelCount     = 1,
+                                  .baseArrayLayer = 0,
+                                  .layerCount     = 1 },
+        };
+        views.emplace_back(devices.logical, view_info);
+    }
+
+    // without partially bound descriptors every array element must be
+    // valid, unused tail repeats last level, shader never writes it
+    std::array<vk::DescriptorImageInfo, mip_max_levels> image_infos{};
+    for (std::size_t i = 0; i < image_infos.size(); ++i)
+    {
+        image_infos[i] = vk::DescriptorImageInfo{
+            .imageView   = views[std::min<std::size_t>(i, views.size() - 1)],
+            .imageLayout = vk::ImageLayout::eGeneral,
+        };
     }
 
+    vk::DescriptorSetAllocateInfo alloc_info{
+        .descriptorPool     = mip_descriptor_pool,
+        .descriptorSetCount = 1u,
+        .pSetLayouts        = &*mip_descriptor_set_layout,
+    };
+    vk::raii::DescriptorSet descriptor_set = std::move(
+        devices.logical.allocateDescriptorSets(alloc_info).front());
+
+    vk::DescriptorBufferInfo level_six_info{
+        .buffer = mip_level_six_buffer,
+        .offset = 0,
+        .range  = vk::WholeSize,
+    };
+    vk::DescriptorBufferInfo counter_info{
+        .buffer = mip_counter_buffer,
+        .offset = 0,
+        .range  = vk::WholeSize,
+    };
+
+    std::array<vk::WriteDescriptorSet, 3> writes{
+        vk::WriteDescriptorSet{
+            .dstSet          = descriptor_set,
+            .dstBinding      = 0,
+            .descriptorCount = mip_max_levels,
+            .descriptorType  = vk::DescriptorType::eStorageImage,
+            .pImageInfo      = image_infos.data(),
+        },
+        vk::WriteDescriptorSet{
+            .dstSet          = descriptor_set,
+            .dstBinding      = 1,
+            .descriptorCount = 1,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo     = &level_six_info,
+        },
+        vk::WriteDescriptorSet{
+            .dstSet          = descriptor_set,
+            .dstBinding      = 2,
+            .descriptorCount = 1,
+            .descriptorType  = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo     = &counter_info,
+        },
+    };
+    devices.logical.updateDescriptorSets(writes, {});
+
+    // every group covers 32x32 texels of level 1
+    const std::uint32_t level_one_width  = std::max(width / 2u, 1u);
+    const std::uint32_t level_one_height = std::max(height / 2u, 1u);
+    const std::uint32_t groups_x         = (level_one_width + 31u) / 32u;
+    const std::uint32_t groups_y         = (level_one_height + 31u) / 32u;
+
+    const mip_constants constants{
+        .width       = width,
+        .height      = height,
+        .mip_count   = mip_levels - 1u,
+        .srgb        = image_format == vk::Format::eR8G8B8A8Srgb ? 1u : 0u,
+        .group_count = groups_x * groups_y,
+    };
+
+    const vk::ImageSubresourceRange all_levels{
+        .aspectMask     = vk::ImageAspectFlagBits::eColor,
+        .baseMipLevel   = 0,
+        .levelCount     = mip_levels,
+        .baseArrayLayer = 0,
+        .layerCount     = 1,
+    };
+
+    {
+        one_time_submit command_buffer(
+            devices.logical, graphics_command_pool, graphics_queue);
+
+        command_buffer.fillBuffer(
+            mip_counter_buffer, 0u, sizeof(std::uint32_t), 0u);
+
+        const vk::BufferMemoryBarrier2 counter_barrier{
+            .srcStageMask        = vk::PipelineStageFlagBits2::eTransfer,
+            .srcAccessMask       = vk::AccessFlagBits2::eTransferWrite,
+            .dstStageMask        = vk::PipelineStageFlagBits2::eComputeShader,
+            .dstAccessMask       = vk::AccessFlagBits2::eShaderStorageRead |
+                                   vk::AccessFlagBits2::eShaderStorageWrite,
+            .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .buffer              = mip_counter_buffer,
+            .offset              = 0,
+            .size                = sizeof(std::uint32_t),
+        };
+        // old_layout is transfer dst after upload or shader read after
+        // blit path, so wait for everything before
+        const vk::ImageMemoryBarrier2 to_general{
+            .srcStageMask        = vk::PipelineStageFlagBits2::eAllCommands,
+            .srcAccessMask       = vk::AccessFlagBits2::eMemoryWrite,
+            .dstStageMask        = vk::PipelineStageFlagBits2::eComputeShader,
+            .dstAccessMask       = vk::AccessFlagBits2::eShaderStorageRead |
+                                   vk::AccessFlagBits2::eShaderStorageWrite,
+            .oldLayout           = old_layout,
+            .newLayout           = vk::ImageLayout::eGeneral,
+            .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .image               = *image,
+            .subresourceRange    = all_levels,
+        };
+        command_buffer.pipelineBarrier2(vk::DependencyInfo{
+            .bufferMemoryBarrierCount = 1u,
+            .pBufferMemoryBarriers    = &counter_barrier,
+            .imageMemoryBarrierCount  = 1u,
+            .pImageMemoryBarriers     = &to_general,
+        });
+
+        command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute,
+                                    mip_pipeline);
+        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                                          mip_pipeline_layout,
+                                          0,
+                                          *descriptor_set,
+                                          nullptr);
+        command_buffer.pushConstants<mip_constants>(
+            *mip_pipeline_layout,
+            vk::ShaderStageFlagBits::eCompute,
+            0u,
+            constants);
+        command_buffer.dispatch(groups_x, groups_y, 1u);
+
+        const vk::ImageMemoryBarrier2 to_shader_read{
+            .srcStageMask        = vk::PipelineStageFlagBits2::eComputeShader,
+            .srcAccessMask       = vk::AccessFlagBits2::eShaderStorageWrite,
+            .dstStageMask        = vk::PipelineStageFlagBits2::eFragmentShader,
+            .dstAccessMask       = vk::AccessFlagBits2::eShaderSampledRead,
+            .oldLayout           = vk::ImageLayout::eGeneral,
+            .newLayout           = vk::ImageLayout::eShaderReadOnlyOptimal,
+            .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .image               = *image,
+            .subresourceRange    = all_levels,
+        };
+        command_buffer.pipelineBarrier2(vk::DependencyInfo{
+            .imageMemoryBarrierCount = 1u,
+            .pImageMemoryBarriers    = &to_shader_read,
+        });
+    } // submit and wait, views and descriptor set are released after it
+}
+
+void render::generate_mipmaps_blit(vk::raii::Image& image,
+                                   std::uint32_t    width,
+                                   std::uint32_t    height,
+                                   std::uint8_t     mip_levels)
+{
     one_time_submit command_buffer(
         devices.logical, graphics_command_pool, graphics_queue);
 
@@ -0,0 +1,1035 @@
+export module vulkan_render_graph;
+
+import std;
+import vulkan;
+
+namespace om::vulkan
+{
+/// how pass touches resource, graph derives stage, access and layout from it
+export enum class resource_access
+{
+    color_attachment, // color write or msaa resolve target
+    depth_attachment, // depth test and write
+    depth_read,       // depth test without write
+    sampled,          // sampled in fragment or compute shader
+    storage_read,     // storage buffer or image read in compute shader
+    storage_write,    // storage buffer or image write in compute shader
+    indirect_read,    // indirect draw/dispatch arguments
+    vertex_read,      // vertex attributes
+    transfer_src,
+    transfer_dst,
+};
+
+export struct resource_handle final
+{
+    static constexpr std::uint32_t invalid =
+        std::numeric_limits<std::uint32_t>::max();
+
+    std::uint32_t index = invalid;
+
+    [[nodiscard]] bool valid() const { return index != invalid; }
+    bool               operator==(const resource_handle&) const = default;
+};
+
+/// image created by graph, content lives only inside one execute(), memory
+/// may be shared with other transient images not alive at the same time
+export struct transient_image_info final
+{
+    std::string             name;
+    vk::Format              format = vk::Format::eUndefined;
+    vk::Extent2D            extent{};
+    vk::ImageUsageFlags     usage{};
+    vk::ImageAspectFlags    aspect  = vk::ImageAspectFlagBits::eColor;
+    vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+};
+
+/// image owned outside of graph (swapchain), bound with bind_image() before
+/// every execute()
+export struct external_image_info final
+{
+    std::string          name;
+    vk::ImageAspectFlags aspect         = vk::ImageAspectFlagBits::eColor;
+    vk::ImageLayout      initial_layout = vk::ImageLayout::eUndefined;
+    /// stage which last touched image before execute(), for swapchain image
+    /// same as wait stage of acquire semaphore
+    vk::PipelineStageFlags2 initial_stage =
+        vk::PipelineStageFlagBits2::eAllCommands;
+    /// eUndefined - leave image in layout of last pass
+    vk::ImageLayout final_layout = vk::ImageLayout::eUndefined;
+};
+
+/// buffer owned outside of graph, bound with bind_buffer() or bind_buffers()
+/// before every execute(). Accesses before execute() are synchronized by
+/// submitter (fence, semaphore), so first use in graph has no barrier.
+export struct external_buffer_info final
+{
+    std::string name;
+    /// access of first user after execute() (other submit waiting on
+    /// semaphore), graph adds barrier to it after last pass
+    std::optional<resource_access> final_access;
+};
+
+/// barrier derived by compile(), for tests and debug output, layouts of
+/// buffers are eUndefined
+export struct barrier_info final
+{
+    std::string_view        resource;
+    vk::PipelineStageFlags2 src_stage{};
+    vk::AccessFlags2        src_access{};
+    vk::ImageLayout         old_layout = vk::ImageLayout::eUndefined;
+    vk::PipelineStageFlags2 dst_stage{};
+    vk::AccessFlags2        dst_access{};
+    vk::ImageLayout         new_layout = vk::ImageLayout::eUndefined;
+};
+
+/// Frame graph: passes declare reads and writes of resources, compile()
+/// culls passes whose results are never used, derives barriers and layout
+/// transitions between passes and aliases memory of transient images with
+/// not overlapping lifetimes. Passes are executed in declaration order, so
+/// declare producer before consumer. Graph without transient images needs no
+/// device, so its barriers can be checked without GPU.
+export class render_graph final
+{
+public:
+    using execute_fn = std::function<void(vk::raii::CommandBuffer&)>;
+
+    class pass_builder final
+    {
+    public:
+        pass_builder& read(resource_handle resource, resource_access access);
+        pass_builder& write(resource_handle resource, resource_access access);
+        /// pass has side effect invisible to graph, never cull it
+        pass_builder& keep_alive();
+
+    private:
+        friend class render_graph;
+        pass_builder(render_graph& graph, std::uint32_t pass_index)
+            : graph_{ graph }
+            , pass_index_{ pass_index }
+        {
+        }
+
+        render_graph& graph_;
+        std::uint32_t pass_index_;
+    };
+
+    struct statistics
+    {
+        std::uint32_t  passes            = 0u;
+        std::uint32_t  culled_passes     = 0u;
+        std::uint32_t  barriers          = 0u; // per execute()
+        std::uint32_t  transient_images  = 0u;
+        std::uint32_t  memory_blocks     = 0u;
+        vk::DeviceSize transient_bytes   = 0u; // sum of all image sizes
+        vk::DeviceSize allocated_bytes   = 0u; // after aliasing
+    };
+
+    render_graph() = default;
+    render_graph(const vk::raii::Device&                   device,
+                 const vk::PhysicalDeviceMemoryProperties& memory_properties);
+
+    resource_handle create_image(transient_image_info info);
+    resource_handle import_image(external_image_info info);
+    resource_handle import_buffer(external_buffer_info info);
+
+    pass_builder add_pass(std::string name, execute_fn execute);
+
+    /// cull passes, allocate transient images and precompute barriers,
+    /// call once after all passes added
+    void compile();
+
+    void bind_image(resource_handle resource,
+                    vk::Image       image,
+                    vk::ImageView   view = {});
+    void bind_buffer(resource_handle resource, vk::Buffer buffer);
+    /// one resource may stand for several buffers used same way (per object
+    /// buffers of all culled meshes), every barrier applied to all of them,
+    /// no buffers - no barriers
+    void bind_buffers(resource_handle             resource,
+                      std::span<const vk::Buffer> buffers);
+
+    [[nodiscard]] vk::Image     get_image(resource_handle resource) const;
+    [[nodiscard]] vk::ImageView get_image_view(resource_handle resource) const;
+    /// first bound buffer or null handle
+    [[nodiscard]] vk::Buffer get_buffer(resource_handle resource) const;
+
+    [[nodiscard]] bool is_culled(std::string_view pass_name) const;
+    [[nodiscard]] const statistics& get_statistics() const { return stats_; }
+
+    /// names of not culled passes in execution order
+    [[nodiscard]] std::vector<std::string_view> get_execution_order() const;
+    /// barriers recorded before pass_name, throws if no such pass
+    [[nodiscard]] std::vector<barrier_info> get_barriers(
+        std::string_view pass_name) const;
+    /// barriers recorded after last pass (final layouts and accesses)
+    [[nodiscard]] std::vector<barrier_info> get_final_barriers() const;
+
+    /// record barriers and all not culled passes into cmd_buf
+    void execute(vk::raii::CommandBuffer& cmd_buf);
+
+private:
+    struct access_state
+    {
+        vk::PipelineStageFlags2 stage{};
+        vk::AccessFlags2        access{};
+        vk::ImageLayout         layout = vk::ImageLayout::eUndefined;
+        bool                    write  = false;
+    };
+
+    enum class resource_kind
+    {
+        transient_image,
+        external_image,
+        external_buffer,
+    };
+
+    struct resource
+    {
+        std::string          name;
+        resource_kind        kind;
+        transient_image_info transient;
+        external_image_info  external;
+        external_buffer_info external_buffer;
+
+        vk::raii::Image         owned_image = nullptr;
+        vk::raii::ImageView     owned_view  = nullptr;
+        vk::Image               image;
+        vk::ImageView           view;
+        std::vector<vk::Buffer> buffers;
+
+        std::uint32_t first_pass = resource_handle::invalid;
+        std::uint32_t last_pass  = 0u;
+        std::uint32_t readers    = 0u; // ref count for culling
+    };
+
+    struct resource_use
+    {
+        std::uint32_t   resource;
+        resource_access access;
+        bool            write;
+    };
+
+    struct barrier
+    {
+        std::uint32_t resource;
+        access_state  src;
+        access_state  dst;
+    };
+
+    struct pass
+    {
+        std::string               name;
+        execute_fn                execute;
+        std::vector<resource_use> uses;
+        std::vector<barrier>      barriers; // recorded before execute
+        std::uint32_t             writers    = 0u; // ref count for culling
+        bool                      keep_alive = false;
+        bool                      culled     = false;
+    };
+
+    struct memory_block
+    {
+        vk::raii::DeviceMemory     memory = nullptr;
+        vk::DeviceSize             size   = 0u;
+        std::uint32_t              type_bits = 0u;
+        std::vector<std::uint32_t> images; // sorted by first_pass
+    };
+
+    static access_state to_state(resource_access access, bool write);
+
+    void add_use(std::uint32_t   pass_index,
+                 resource_handle resource,
+                 resource_access access,
+                 bool            write);
+    void cull_passes();
+    void compute_lifetimes();
+    void allocate_transient_images();
+    void build_barriers();
+    [[nodiscard]] std::vector<barrier_info> to_info(
+        std::span<const barrier> barriers) const;
+    [[nodiscard]] std::uint32_t find_memory_type(
+        std::uint32_t type_bits) const;
+    [[nodiscard]] resource& get(resource_handle handle);
+    [[nodiscard]] const resource& get(resource_handle handle) const;
+
+    const vk::raii::Device*            device_ = nullptr;
+    vk::PhysicalDeviceMemoryProperties memory_properties_{};
+    std::vector<resource>              resources_;
+    std::vector<pass>                  passes_;
+    std::vector<barrier>               final_barriers_;
+    std::vector<memory_block>          memory_blocks_;
+    statistics                         stats_;
+    bool                               compiled_ = false;
+};
+
+render_graph::pass_builder& render_graph::pass_builder::read(
+    resource_handle resource, resource_access access)
+{
+    graph_.add_use(pass_index_, resource, access, false);
+    return *this;
+}
+
+render_graph::pass_builder& render_graph::pass_builder::write(
+    resource_handle resource, resource_access access)
+{
+    graph_.add_use(pass_index_, resource, access, true);
+    return *this;
+}
+
+render_graph::pass_builder& render_graph::pass_builder::keep_alive()
+{
+    graph_.passes_.at(pass_index_).keep_alive = true;
+    return *this;
+}
+
+render_graph::render_graph(
+    const vk::raii::Device&                   device,
+    const vk::PhysicalDeviceMemoryProperties& memory_properties)
+    : device_{ &device }
+    , memory_properties_{ memory_properties }
+{
+}
+
+resource_handle render_graph::create_image(transient_image_info info)
+{
+    if (compiled_)
+    {
+        throw std::runtime_error("error: render_graph already compiled");
+    }
+    resource r{ .name = info.name, .kind = resource_kind::transient_image };
+    r.transient = std::move(info);
+    resources_.push_back(std::move(r));
+    return { static_cast<std::uint32_t>(resources_.size() - 1u) };
+}
+
+resource_handle render_graph::import_image(external_image_info info)
+{
+    if (compiled_)
+    {
+        throw std::runtime_error("error: render_graph already compiled");
+    }
+    resource r{ .name = info.name, .kind = resource_kind::external_image };
+    r.external = std::move(info);
+    resources_.push_back(std::move(r));
+    return { static_cast<std::uint32_t>(resources_.size() - 1u) };
+}
+
+resource_handle render_graph::import_buffer(external_buffer_info info)
+{
+    if (compiled_)
+    {
+        throw std::runtime_error("error: render_graph already compiled");
+    }
+    resource r{ .name = info.name, .kind = resource_kind::external_buffer };
+    r.external_buffer = std::move(info);
+    resources_.push_back(std::move(r));
+    return { static_cast<std::uint32_t>(resources_.size() - 1u) };
+}
+
+render_graph::pass_builder render_graph::add_pass(std::string name,
+                                                  execute_fn  execute)
+{
+    if (compiled_)
+    {
+        throw std::runtime_error("error: render_graph already compiled");
+    }
+    passes_.push_back(
+        pass{ .name = std::move(name), .execute = std::move(execute) });
+    return pass_builder{ *this,
+                         static_cast<std::uint32_t>(passes_.size() - 1u) };
+}
+
+void render_graph::add_use(std::uint32_t   pass_index,
+                           resource_handle resource,
+                           resource_access access,
+                           bool            write)
+{
+    if (compiled_)
+    {
+        throw std::runtime_error("error: render_graph already compiled");
+    }
+    static_cast<void>(get(resource));
+    passes_.at(pass_index)
+        .uses.push_back(resource_use{ resource.index, access, write });
+}
+
+void render_graph::compile()
+{
+    cull_passes();
+    compute_lifetimes();
+    allocate_transient_images();
+    build_barriers();
+    compiled_ = true;
+}
+
+void render_graph::cull_passes()
+{
+    for (auto& r : resources_)
+    {
+        r.readers = 0u;
+    }
+
+    for (auto& p : passes_)
+    {
+        p.writers = 0u;
+        for (const auto& use : p.uses)
+        {
+            if (use.write)
+            {
+                ++p.writers;
+            }
+            else
+            {
+                ++resources_[use.resource].readers;
+            }
+        }
+    }
+
+    // external resources are consumed after graph, keep their writers
+    std::vector<std::uint32_t> unused;
+    for (std::uint32_t i = 0; i < resources_.size(); ++i)
+    {
+        if (resources_[i].kind != resource_kind::transient_image)
+        {
+            ++resources_[i].readers;
+        }
+        if (resources_[i].readers == 0u)
+        {
+            unused.push_back(i);
+        }
+    }
+
+    while (!unused.empty())
+    {
+        const std::uint32_t resource_index = unused.back();
+        unused.pop_back();
+
+        for (auto& p : passes_)
+        {
+            if (p.culled || p.keep_alive)
+            {
+                continue;
+            }
+            const bool writes_resource =
+                std::ranges::any_of(p.uses,
+                                    [&](const resource_use& use)
+                                    {
+                                        return use.write &&
+                                               use.resource == resource_index;
+                                    });
+            if (!writes_resource || --p.writers != 0u)
+            {
+                continue;
+            }
+
+            p.culled = true;
+            for (const auto& use : p.uses)
+            {
+                if (!use.write && --resources_[use.resource].readers == 0u)
+                {
+                    unused.push_back(use.resource);
+                }
+            }
+        }
+    }
+
+    stats_.passes        = static_cast<std::uint32_t>(passes_.size());
+    stats_.culled_passes = static_cast<std::uint32_t>(
+        std::ranges::count_if(passes_, &pass::culled));
+}
+
+void render_graph::compute_lifetimes()
+{
+    for (std::uint32_t pass_index = 0; pass_index < passes_.size();
+         ++pass_index)
+    {
+        if (passes_[pass_index].culled)
+        {
+            continue;
+        }
+        for (const auto& use : passes_[pass_index].uses)
+        {
+            resource& r  = resources_[use.resource];
+            r.first_pass = std::min(r.first_pass, pass_index);
+            r.last_pass  = std::max(r.last_pass, pass_index);
+        }
+    }
+}
+
+void render_graph::allocate_transient_images()
+{
+    std::vector<std::uint32_t>          transient;
+    std::vector<vk::MemoryRequirements> requirements(resources_.size());
+
+    for (std::uint32_t i = 0; i < resources_.size(); ++i)
+    {
+        resource& r = resources_[i];
+        if (r.kind != resource_kind::transient_image ||
+            r.first_pass == resource_handle::invalid)
+        {
+            continue; // not transient or used only by culled passes
+        }
+
+        if (device_ == nullptr)
+        {
+            throw std::runtime_error("error: render_graph without device");
+        }
+
+        const vk::ImageCreateInfo image_info{
+            .imageType   = vk::ImageType::e2D,
+            .format      = r.transient.format,
+            .extent      = { .width  = r.transient.extent.width,
+                             .height = r.transient.extent.height,
+                             .depth  = 1u },
+            .mipLevels   = 1u,
+            .arrayLayers = 1u,
+            .samples     = r.transient.samples,
+            .tiling      = vk::ImageTiling::eOptimal,
+            .usage       = r.transient.usage,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .initialLayout = vk::ImageLayout::eUndefined,
+        };
+        r.owned_image   = vk::raii::Image(*device_, image_info);
+        r.image         = *r.owned_image;
+        requirements[i] = r.owned_image.getMemoryRequirements();
+        stats_.transient_bytes += requirements[i].size;
+        transient.push_back(i);
+    }
+
+    // biggest first, so small images fill blocks created by big ones
+    std::ranges::sort(transient,
+                      std::greater{},
+                      [&](std::uint32_t i) { return requirements[i].size; });
+
+    const auto overlaps = [this](std::uint32_t a, std::uint32_t b)
+    {
+        return resources_[a].first_pass <= resources_[b].last_pass &&
+               resources_[b].first_pass <= resources_[a].last_pass;
+    };
+
+    for (const std::uint32_t image_index : transient)
+    {
+        const vk::MemoryRequirements& req = requirements[image_index];
+
+        auto block = std::ranges::find_if(
+            memory_blocks_,
+            [&](const memory_block& b)
+            {
+                // every image bound at offset 0, so alignment always ok
+                return (b.type_bits & req.memoryTypeBits) != 0u &&
+                       std::ranges::none_of(
+                           b.images,
+                           [&](std::uint32_t other)
+                           { return overlaps(image_index, other); });
+            });
+
+        if (block == memory_blocks_.end())
+        {
+            memory_blocks_.push_back(
+                memory_block{ .type_bits = req.memoryTypeBits });
+            block = std::prev(memory_blocks_.end());
+        }
+
+        block->size = std::max(block->size, req.size);
+        block->type_bits &= req.memoryTypeBits;
+        block->images.push_back(image_index);
+    }
+
+    for (auto& block : memory_blocks_)
+    {
+        const vk::MemoryAllocateInfo alloc_info{
+            .allocationSize  = block.size,
+            .memoryTypeIndex = find_memory_type(block.type_bits),
+        };
+        block.memory = vk::raii::DeviceMemory(*device_, alloc_info);
+        stats_.allocated_bytes += block.size;
+
+        std::ranges::sort(block.images,
+                          std::less{},
+                          [this](std::uint32_t i)
+                          { return resources_[i].first_pass; });
+
+        for (const std::uint32_t image_index : block.images)
+        {
+            resource& r = resources_[image_index];
+            r.owned_image.bindMemory(*block.memory, 0u);
+
+            const vk::ImageViewCreateInfo view_info{
+                .image            = r.image,
+                .viewType         = vk::ImageViewType::e2D,
+                .format           = r.transient.format,
+                .subresourceRange = { .aspectMask     = r.transient.aspect,
+                                      .baseMipLevel   = 0u,
+                                      .levelCount     = 1u,
+                                      .baseArrayLayer = 0u,
+                                      .layerCount     = 1u },
+            };
+            r.owned_view = vk::raii::ImageView(*device_, view_info);
+            r.view       = *r.owned_view;
+        }
+    }
+
+    stats_.transient_images = static_cast<std::uint32_t>(transient.size());
+    stats_.memory_blocks = static_cast<std::uint32_t>(memory_blocks_.size());
+}
+
+render_graph::access_state render_graph::to_state(resource_access access,
+                                                  bool            write)
+{
+    using stage  = vk::PipelineStageFlagBits2;
+    using flag   = vk::AccessFlagBits2;
+    using layout = vk::ImageLayout;
+
+    access_state state{ .write = write };
+    switch (access)
+    {
+        case resource_access::color_attachment:
+            state.stage  = stage::eColorAttachmentOutput;
+            state.access = flag::eColorAttachmentRead |
+                           flag::eColorAttachmentWrite;
+            state.layout = layout::eColorAttachmentOptimal;
+            break;
+        case resource_access::depth_attachment:
+            state.stage = stage::eEarlyFragmentTests |
+                          stage::eLateFragmentTests;
+            state.access = flag::eDepthStencilAttachmentRead |
+                           flag::eDepthStencilAttachmentWrite;
+            state.layout = layout::eDepthAttachmentOptimal;
+            break;
+        case resource_access::depth_read:
+            state.stage = stage::eEarlyFragmentTests |
+                          stage::eLateFragmentTests;
+            state.access = flag::eDepthStencilAttachmentRead;
+            state.layout = layout::eDepthReadOnlyOptimal;
+            break;
+        case resource_access::sampled:
+            state.stage  = stage::eFragmentShader | stage::eComputeShader;
+            state.access = flag::eShaderSampledRead;
+            state.layout = layout::eShaderReadOnlyOptimal;
+            break;
+        case resource_access::storage_read:
+            state.stage  = stage::eComputeShader;
+            state.access = flag::eShaderStorageRead;
+            state.layout = layout::eGeneral;
+            break;
+        case resource_access::storage_write:
+            state.stage  = stage::eComputeShader;
+            state.access = flag::eShaderStorageRead | flag::eShaderStorageWrite;
+            state.layout = layout::eGeneral;
+            break;
+        case resource_access::indirect_read:
+            state.stage  = stage::eDrawIndirect;
+            state.access = flag::eIndirectCommandRead;
+            break;
+        case resource_access::vertex_read:
+            state.stage  = stage::eVertexAttributeInput;
+            state.access = flag::eVertexAttributeRead;
+            break;
+        case resource_access::transfer_src:
+            state.stage  = stage::eTransfer;
+            state.access = flag::eTransferRead;
+            state.layout = layout::eTransferSrcOptimal;
+            break;
+        case resource_access::transfer_dst:
+            state.stage  = stage::eTransfer;
+            state.access = flag::eTransferWrite;
+            state.layout = layout::eTransferDstOptimal;
+            break;
+    }
+    return state;
+}
+
+void render_graph::build_barriers()
+{
+    std::vector<access_state> current(resources_.size());
+
+    for (std::uint32_t i = 0; i < resources_.size(); ++i)
+    {
+        const resource& r = resources_[i];
+        if (r.kind == resource_kind::external_image)
+        {
+            current[i] = access_state{ .stage  = r.external.initial_stage,
+                                       .layout = r.external.initial_layout };
+        }
+    }
+
+    // Transient image content is discarded every frame, so first use starts
+    // from eUndefined. Its memory was last touched by previous image in the
+    // same block, or by last image of the block in previous frame (frames in
+    // flight share transient memory), wait for that access.
+    for (const auto& block : memory_blocks_)
+    {
+        for (std::size_t i = 0; i < block.images.size(); ++i)
+        {
+            const std::size_t previous =
+                (i + block.images.size() - 1u) % block.images.size();
+            const resource& prev = resources_[block.images[previous]];
+            const pass&     prev_last_pass = passes_[prev.last_pass];
+
+            access_state state{};
+            for (const auto& use : prev_last_pass.uses)
+            {
+                if (use.resource == block.images[previous])
+                {
+                    const access_state s = to_state(use.access, use.write);
+                    state.stage |= s.stage;
+                    state.access |= s.access;
+                    state.write = state.write || s.write;
+                }
+            }
+            state.layout             = vk::ImageLayout::eUndefined;
+            current[block.images[i]] = state;
+        }
+    }
+
+    stats_.barriers = 0u;
+
+    for (auto& p : passes_)
+    {
+        p.barriers.clear();
+        if (p.culled)
+        {
+            continue;
+        }
+
+        // merge all uses of one resource inside pass
+        std::vector<std::pair<std::uint32_t, access_state>> merged;
+        for (const auto& use : p.uses)
+        {
+            const access_state s = to_state(use.access, use.write);
+            auto it = std::ranges::find(merged, use.resource, [](auto& m)
+                                        { return m.first; });
+            if (it == merged.end())
+            {
+                merged.emplace_back(use.resource, s);
+                continue;
+            }
+            const bool is_buffer =
+                resources_[it->first].kind == resource_kind::external_buffer;
+            if (!is_buffer && it->second.layout != s.layout)
+            {
+                throw std::runtime_error("error: render_graph pass " + p.name +
+                                         " uses " + resources_[it->first].name +
+                                         " in two layouts");
+            }
+            it->second.stage |= s.stage;
+            it->second.access |= s.access;
+            it->second.write = it->second.write || s.write;
+        }
+
+        for (const auto& [resource_index, next] : merged)
+        {
+            access_state& prev = current[resource_index];
+            const bool is_image =
+                resources_[resource_index].kind !=
+                resource_kind::external_buffer;
+
+            if (!is_image && !prev.stage)
+            {
+                // first use of buffer, earlier accesses synchronized by
+                // submitter, see external_buffer_info
+                prev = next;
+                continue;
+            }
+
+            const bool layout_change = is_image && prev.layout != next.layout;
+            const bool hazard        = prev.write || next.write;
+
+            if (!layout_change && !hazard)
+            {
+                // read after read, accumulate readers so next write waits
+                // all of them
+                prev.stage |= next.stage;
+                prev.access |= next.access;
+                continue;
+            }
+
+            access_state src = prev;
+            if (!prev.write)
+            {
+                src.access = {}; // write after read: execution dependency
+            }
+            p.barriers.push_back(barrier{ resource_index, src, next });
+            prev = next;
+        }
+        stats_.barriers += static_cast<std::uint32_t>(p.barriers.size());
+    }
+
+    final_barriers_.clear();
+    for (std::uint32_t i = 0; i < resources_.size(); ++i)
+    {
+        const resource& r = resources_[i];
+        if (r.kind == resource_kind::external_buffer &&
+            r.external_buffer.final_access.has_value())
+        {
+            const access_state next =
+                to_state(*r.external_buffer.final_access, false);
+            // read after read or buffer not touched by graph
+            if (!current[i].write && !next.write)
+            {
+                continue;
+            }
+            access_state src = current[i];
+            if (!src.write)
+            {
+                src.access = {};
+            }
+            final_barriers_.push_back(barrier{ i, src, next });
+            continue;
+        }
+
+        const auto wish = r.external.final_layout;
+        if (r.kind != resource_kind::external_image ||
+            wish == vk::ImageLayout::eUndefined ||
+            wish == current[i].layout)
+        {
+            continue;
+        }
+        access_state src = current[i];
+        if (!src.write)
+        {
+            src.access = {};
+        }
+        // presentation engine waits semaphore, no dst stage needed
+        final_barriers_.push_back(barrier{
+            i,
+            src,
+            access_state{ .stage  = vk::PipelineStageFlagBits2::eBottomOfPipe,
+                          .layout = wish } });
+    }
+    stats_.barriers += static_cast<std::uint32_t>(final_barriers_.size());
+}
+
+std::uint32_t render_graph::find_memory_type(std::uint32_t type_bits) const
+{
+    // prefer lazily allocated memory for transient attachments (tile GPU)
+    const std::array preferred{
+        vk::MemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal |
+                                 vk::MemoryPropertyFlagBits::eLazilyAllocated },
+        vk::MemoryPropertyFlags{ vk::MemoryPropertyFlagBits::eDeviceLocal },
+    };
+
+    for (const auto properties : preferred)
+    {
+        for (std::uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i)
+        {
+            if ((type_bits & (1u << i)) != 0u &&
+                (memory_properties_.memoryTypes[i].propertyFlags &
+                 properties) == properties)
+            {
+                return i;
+            }
+        }
+    }
+    throw std::runtime_error("error: render_graph no memory type for " +
+                             std::to_string(type_bits));
+}
+
+void render_graph::bind_image(resource_handle resource,
+                              vk::Image       image,
+                              vk::ImageView   view)
+{
+    auto& r = get(resource);
+    if (r.kind != resource_kind::external_image)
+    {
+        throw std::runtime_error("error: render_graph bind_image on " +
+                                 r.name + " which is not external image");
+    }
+    r.image = image;
+    r.view  = view;
+}
+
+void render_graph::bind_buffer(resource_handle resource, vk::Buffer buffer)
+{
+    bind_buffers(resource, std::span{ &buffer, 1u });
+}
+
+void render_graph::bind_buffers(resource_handle             resource,
+                                std::span<const vk::Buffer> buffers)
+{
+    auto& r = get(resource);
+    if (r.kind != resource_kind::external_buffer)
+    {
+        throw std::runtime_error("error: render_graph bind_buffer on " +
+                                 r.name + " which is not buffer");
+    }
+    r.buffers.assign(buffers.begin(), buffers.end());
+}
+
+vk::Image render_graph::get_image(resource_handle resource) const
+{
+    return get(resource).image;
+}
+
+vk::ImageView render_graph::get_image_view(resource_handle resource) const
+{
+    return get(resource).view;
+}
+
+vk::Buffer render_graph::get_buffer(resource_handle resource) const
+{
+    const auto& buffers = get(resource).buffers;
+    return buffers.empty() ? vk::Buffer{} : buffers.front();
+}
+
+bool render_graph::is_culled(std::string_view pass_name) const
+{
+    auto it = std::ranges::find(passes_, pass_name, &pass::name);
+    return it == passes_.end() || it->culled;
+}
+
+std::vector<std::string_view> render_graph::get_execution_order() const
+{
+    std::vector<std::string_view> order;
+    for (const auto& p : passes_)
+    {
+        if (!p.culled)
+        {
+            order.push_back(p.name);
+        }
+    }
+    return order;
+}
+
+std::vector<barrier_info> render_graph::get_barriers(
+    std::string_view pass_name) const
+{
+    auto it = std::ranges::find(passes_, pass_name, &pass::name);
+    if (it == passes_.end())
+    {
+        throw std::runtime_error("error: render_graph no pass " +
+                                 std::string{ pass_name });
+    }
+    return to_info(it->barriers);
+}
+
+std::vector<barrier_info> render_graph::get_final_barriers() const
+{
+    return to_info(final_barriers_);
+}
+
+std::vector<barrier_info> render_graph::to_info(
+    std::span<const barrier> barriers) const
+{
+    std::vector<barrier_info> result;
+    result.reserve(barriers.size());
+    for (const auto& b : barriers)
+    {
+        const resource& r        = resources_[b.resource];
+        const bool      is_image = r.kind != resource_kind::external_buffer;
+        result.push_back(barrier_info{
+            .resource   = r.name,
+            .src_stage  = b.src.stage,
+            .src_access = b.src.access,
+            .old_layout = is_image ? b.src.layout : vk::ImageLayout::eUndefined,
+            .dst_stage  = b.dst.stage,
+            .dst_access = b.dst.access,
+            .new_layout = is_image ? b.dst.layout : vk::ImageLayout::eUndefined,
+        });
+    }
+    return result;
+}
+
+render_graph::resource& render_graph::get(resource_handle handle)
+{
+    if (!handle.valid() || handle.index >= resources_.size())
+    {
+        throw std::runtime_error("error: render_graph invalid resource");
+    }
+    return resources_[handle.index];
+}
+
+const render_graph::resource& render_graph::get(resource_handle handle) const
+{
+    if (!handle.valid() || handle.index >= resources_.size())
+    {
+        throw std::runtime_error("error: render_graph invalid resource");
+    }
+    return resources_[handle.index];
+}
+
+void render_graph::execute(vk::raii::CommandBuffer& cmd_buf)
+{
+    if (!compiled_)
+    {
+        throw std::runtime_error("error: render_graph not compiled");
+    }
+
+    std::vector<vk::ImageMemoryBarrier2>  image_barriers;
+    std::vector<vk::BufferMemoryBarrier2> buffer_barriers;
+
+    const auto record = [&](std::span<const barrier> barriers)
+    {
+        if (barriers.empty())
+        {
+            return;
+        }
+        image_barriers.clear();
+        buffer_barriers.clear();
+        for (const auto& b : barriers)
+        {
+            const resource& r = resources_[b.resource];
+            if (r.kind == resource_kind::external_buffer)
+            {
+                for (const vk::Buffer buffer : r.buffers)
+                {
+                    buffer_barriers.push_back(vk::BufferMemoryBarrier2{
+                        .srcStageMask        = b.src.stage,
+                        .srcAccessMask       = b.src.access,
+                        .dstStageMask        = b.dst.stage,
+                        .dstAccessMask       = b.dst.access,
+                        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+                        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+                        .buffer              = buffer,
+                        .offset              = 0u,
+                        .size                = vk::WholeSize,
+                    });
+                }
+                continue;
+            }
+            const vk::ImageAspectFlags aspect =
+                r.kind == resource_kind::transient_image ? r.transient.aspect
+                                                         : r.external.aspect;
+            image_barriers.push_back(vk::ImageMemoryBarrier2{
+                .srcStageMask        = b.src.stage,
+                .srcAccessMask       = b.src.access,
+                .dstStageMask        = b.dst.stage,
+                .dstAccessMask       = b.dst.access,
+                .oldLayout           = b.src.layout,
+                .newLayout           = b.dst.layout,
+                .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+                .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+                .image               = r.image,
+                .subresourceRange    = { .aspectMask     = aspect,
+                                         .baseMipLevel   = 0u,
+                                         .levelCount     = 1u,
+                                         .baseArrayLayer = 0u,
+                                         .layerCount     = 1u },
+            });
+        }
+        if (image_barriers.empty() && buffer_barriers.empty())
+        {
+            return; // buffer resources without bound buffers
+        }
+        cmd_buf.pipelineBarrier2(vk::DependencyInfo{
+            .bufferMemoryBarrierCount =
+                static_cast<std::uint32_t>(buffer_barriers.size()),
+            .pBufferMemoryBarriers = buffer_barriers.data(),
+            .imageMemoryBarrierCount =
+                static_cast<std::uint32_t>(image_barriers.size()),
+            .pImageMemoryBarriers = image_barriers.data(),
+        });
+    };
+
+    for (const auto& p : passes_)
+    {
+        if (p.culled)
+        {
+            continue;
+        }
+        record(p.barriers);
+        p.execute(cmd_buf);
+    }
+    record(final_barriers_);
+}
+} // namespace om::vulkan
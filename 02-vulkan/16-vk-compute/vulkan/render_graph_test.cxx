@@ -0,0 +1,172 @@
+#include <catch2/catch_all.hpp>
+
+import std;
+import vulkan;
+import vulkan_render_graph;
+
+// NOLINTBEGIN(*)
+namespace
+{
+using om::vulkan::barrier_info;
+using om::vulkan::render_graph;
+using om::vulkan::resource_access;
+using stage  = vk::PipelineStageFlagBits2;
+using access = vk::AccessFlagBits2;
+using layout = vk::ImageLayout;
+
+void no_commands(vk::raii::CommandBuffer&) {}
+
+const barrier_info& find_barrier(const std::vector<barrier_info>& barriers,
+                                 std::string_view                 resource)
+{
+    auto it = std::ranges::find(barriers, resource, &barrier_info::resource);
+    REQUIRE(it != barriers.end());
+    return *it;
+}
+} // namespace
+
+// graphs below have no transient images in not culled passes, so compile()
+// needs no device and barriers are checked without GPU
+
+TEST_CASE("frame graph orders cull passes and derives barriers",
+          "render_graph")
+{
+    // same passes as render::create_frame_graph()
+    render_graph graph;
+
+    auto swapchain = graph.import_image({
+        .name           = "swapchain",
+        .initial_layout = layout::eUndefined,
+        .initial_stage  = stage::eColorAttachmentOutput,
+        .final_layout   = layout::ePresentSrcKHR,
+    });
+    auto counts   = graph.import_buffer({ .name = "cull_counts" });
+    auto commands = graph.import_buffer({ .name = "cull_commands" });
+    auto overlay  = graph.create_image({ .name = "debug_overlay" });
+
+    graph.add_pass("cull_reset", no_commands)
+        .write(counts, resource_access::transfer_dst);
+    graph.add_pass("cull", no_commands)
+        .write(counts, resource_access::storage_write)
+        .write(commands, resource_access::storage_write);
+    // nobody reads overlay, so pass is culled and image never created
+    graph.add_pass("overlay", no_commands)
+        .write(overlay, resource_access::color_attachment);
+    graph.add_pass("main", no_commands)
+        .read(commands, resource_access::indirect_read)
+        .read(counts, resource_access::indirect_read)
+        .write(swapchain, resource_access::color_attachment);
+
+    graph.compile();
+
+    REQUIRE(graph.get_execution_order() ==
+            std::vector<std::string_view>{ "cull_reset", "cull", "main" });
+    REQUIRE(graph.is_culled("overlay"));
+    REQUIRE(graph.get_statistics().transient_images == 0u);
+
+    SECTION("first use of buffer has no barrier")
+    {
+        REQUIRE(graph.get_barriers("cull_reset").empty());
+    }
+
+    SECTION("fill before dispatch")
+    {
+        const auto barriers = graph.get_barriers("cull");
+        REQUIRE(barriers.size() == 1u);
+        const auto& b = find_barrier(barriers, "cull_counts");
+        REQUIRE(b.src_stage == stage::eTransfer);
+        REQUIRE(b.src_access == access::eTransferWrite);
+        REQUIRE(b.dst_stage == stage::eComputeShader);
+        REQUIRE(b.dst_access ==
+                (access::eShaderStorageRead | access::eShaderStorageWrite));
+        REQUIRE(b.old_layout == layout::eUndefined);
+        REQUIRE(b.new_layout == layout::eUndefined);
+    }
+
+    SECTION("dispatch before indirect draw and attachment transition")
+    {
+        const auto barriers = graph.get_barriers("main");
+        REQUIRE(barriers.size() == 3u);
+        for (const auto name : { "cull_commands", "cull_counts" })
+        {
+            const auto& b = find_barrier(barriers, name);
+            REQUIRE(b.src_stage == stage::eComputeShader);
+            REQUIRE(b.src_access ==
+                    (access::eShaderStorageRead | access::eShaderStorageWrite));
+            REQUIRE(b.dst_stage == stage::eDrawIndirect);
+            REQUIRE(b.dst_access == access::eIndirectCommandRead);
+        }
+        const auto& image = find_barrier(barriers, "swapchain");
+        REQUIRE(image.src_stage == stage::eColorAttachmentOutput);
+        REQUIRE(image.old_layout == layout::eUndefined);
+        REQUIRE(image.new_layout == layout::eColorAttachmentOptimal);
+    }
+
+    SECTION("swapchain presented after last pass")
+    {
+        const auto barriers = graph.get_final_barriers();
+        REQUIRE(barriers.size() == 1u);
+        const auto& b = find_barrier(barriers, "swapchain");
+        REQUIRE(b.old_layout == layout::eColorAttachmentOptimal);
+        REQUIRE(b.new_layout == layout::ePresentSrcKHR);
+        REQUIRE(b.dst_stage == stage::eBottomOfPipe);
+    }
+}
+
+TEST_CASE("buffer final access adds barrier after last pass", "render_graph")
+{
+    // same pass as render::create_compute_graph()
+    render_graph graph;
+
+    auto in  = graph.import_buffer({ .name = "particles_last_frame" });
+    auto out = graph.import_buffer({
+        .name         = "particles_current_frame",
+        .final_access = resource_access::vertex_read,
+    });
+
+    graph.add_pass("particles_update", no_commands)
+        .read(in, resource_access::storage_read)
+        .write(out, resource_access::storage_write);
+
+    graph.compile();
+
+    REQUIRE(graph.get_barriers("particles_update").empty());
+
+    const auto barriers = graph.get_final_barriers();
+    REQUIRE(barriers.size() == 1u);
+    const auto& b = find_barrier(barriers, "particles_current_frame");
+    REQUIRE(b.src_stage == stage::eComputeShader);
+    REQUIRE(b.dst_stage == stage::eVertexAttributeInput);
+    REQUIRE(b.dst_access == access::eVertexAttributeRead);
+}
+
+TEST_CASE("write after reads waits all readers", "render_graph")
+{
+    render_graph graph;
+
+    auto buffer = graph.import_buffer({ .name = "arguments" });
+
+    graph.add_pass("dispatch", no_commands)
+        .read(buffer, resource_access::storage_read);
+    graph.add_pass("draw", no_commands)
+        .read(buffer, resource_access::indirect_read);
+    graph.add_pass("update", no_commands)
+        .write(buffer, resource_access::transfer_dst);
+
+    graph.compile();
+
+    REQUIRE(graph.get_execution_order() ==
+            std::vector<std::string_view>{ "dispatch", "draw", "update" });
+    // read after read needs no barrier
+    REQUIRE(graph.get_barriers("draw").empty());
+
+    const auto barriers = graph.get_barriers("update");
+    REQUIRE(barriers.size() == 1u);
+    const auto& b = find_barrier(barriers, "arguments");
+    // execution dependency on both readers, nothing to make available
+    REQUIRE(b.src_stage == (stage::eComputeShader | stage::eDrawIndirect));
+    REQUIRE(b.src_access == vk::AccessFlags2{});
+    REQUIRE(b.dst_stage == stage::eTransfer);
+    REQUIRE(b.dst_access == access::eTransferWrite);
+}
+// NOLINTEND(*)